@@ -0,0 +1,126 @@
+/***************************************************************************
+* Copyright (c) 2017, Sylvain Corlay and Johan Mabille                     *
+*                                                                          *
+* Distributed under the terms of the BSD 3-Clause License.                 *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+// Counts the allocations made when serializing and deserializing a data
+// property holding size doubles, with the former implementation of the
+// json conversions of xboxed_container, which copied the values to a
+// temporary container, and with the current one.
+//
+// usage: benchmark_xplot [size]
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "xplot/xboxed_container.hpp"
+
+// GCC does not see that the replaced operator new allocates with malloc.
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+namespace
+{
+    std::atomic<std::size_t> allocation_count(0);
+    std::atomic<std::size_t> allocated_bytes(0);
+}
+
+void* operator new(std::size_t size)
+{
+    ++allocation_count;
+    allocated_bytes += size;
+    if (void* p = std::malloc(size == 0 ? 1 : size))
+    {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+namespace
+{
+    using boxed_type = xpl::xboxed_container<std::vector<double>>;
+
+    namespace former
+    {
+        void to_json(nl::json& j, const boxed_type& o)
+        {
+            j["values"] = std::vector<double>(o);
+            j["type"] = xpl::type_to_string<double>();
+        }
+
+        void from_json(const nl::json& j, boxed_type& o)
+        {
+            std::vector<double>& values = o;
+            values = j.at("values").get<std::vector<double>>();
+        }
+    }
+
+    template <class F>
+    void measure(const char* name, F&& f)
+    {
+        std::size_t count = allocation_count;
+        std::size_t bytes = allocated_bytes;
+        auto start = std::chrono::steady_clock::now();
+        f();
+        auto stop = std::chrono::steady_clock::now();
+        std::printf("%-32s %10zu allocations %12.1f MB %10.1f ms\n", name,
+                    allocation_count - count,
+                    static_cast<double>(allocated_bytes - bytes) / (1 << 20),
+                    std::chrono::duration<double, std::milli>(stop - start).count());
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    std::size_t size = argc > 1 ? std::stoul(argv[1]) : std::size_t(10000000);
+    std::vector<double> data(size);
+    for (std::size_t i = 0; i < size; ++i)
+    {
+        data[i] = static_cast<double>(i);
+    }
+    std::printf("%zu doubles\n\n", size);
+
+    // Destroying a large json array allocates, the states are therefore
+    // destroyed out of the measures.
+    boxed_type owned(data);
+    nl::json former_state;
+    measure("to_json, former", [&]() { former::to_json(former_state, owned); });
+    nl::json state;
+    measure("to_json", [&]() { xpl::to_json(state, owned); });
+
+    boxed_type patched;
+    measure("from_json, former", [&]() { former::from_json(state, patched); });
+    measure("from_json", [&]() { xpl::from_json(state, patched); });
+
+    boxed_type viewed = xpl::data_view(data.data(), data.size());
+    measure("from_json into a view, former", [&]() { former::from_json(state, viewed); });
+    viewed = xpl::data_view(data.data(), data.size());
+    measure("from_json into a view", [&]() { xpl::from_json(state, viewed); });
+
+    xpl::default_data_encoding() = xpl::xdata_encoding::binary;
+    nl::json binary_state;
+    xeus::buffer_sequence buffers;
+    measure("binary serialization", [&]() { xpl::xwidgets_serialize(owned, binary_state, buffers); });
+    measure("binary deserialization", [&]() { xpl::xwidgets_deserialize(patched, binary_state, buffers); });
+    return 0;
+}
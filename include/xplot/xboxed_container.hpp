@@ -10,7 +10,13 @@
 #define XBOXED_CONTAINER_HPP
 
 #include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
 #include <string>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
@@ -18,14 +24,90 @@
 
 #include "xeus/xjson.hpp"
 
+#include "xtl/xoptional.hpp"
+
+#include "xwidgets/xbinary.hpp"
+
 namespace nl = nlohmann;
 
 namespace xpl
 {
+    /****************************
+     * xdata_source declaration *
+     ****************************/
+
+    /**
+     * Type-erased reference to contiguous values, with an optional
+     * keep-alive pointer sharing their ownership. Numeric values are sent
+     * to the front-end with their own dtype, e.g. int32 counters are not
+     * widened to float64, except 64-bit integers (see xdata_encoding).
+     */
+    class xdata_source
+    {
+    public:
+
+        using keep_alive_type = std::shared_ptr<const void>;
+
+        xdata_source() = default;
+
+        template <class T>
+        xdata_source(const T* data, std::size_t size, keep_alive_type keep_alive = keep_alive_type());
+
+        bool valid() const noexcept;
+        const void* data() const noexcept;
+        std::size_t size() const noexcept;
+        const std::string& dtype() const noexcept;
+
+        template <class T>
+        bool holds() const noexcept;
+
+        template <class T>
+        void copy_to(std::vector<T>& values) const;
+        void write_values(nl::json::array_t& values) const;
+        void serialize(nl::json& j, xeus::buffer_sequence& buffers) const;
+
+    private:
+
+        template <class F>
+        void visit(F&& f) const;
+
+        const void* p_data = nullptr;
+        std::size_t m_size = 0;
+        const void* p_type = nullptr;
+        std::string m_dtype;
+        keep_alive_type m_keep_alive;
+    };
+
+    template <class T>
+    xdata_source data_view(const T* data, std::size_t size,
+                           std::shared_ptr<const void> keep_alive = std::shared_ptr<const void>());
+
+    template <class C>
+    xdata_source data_view(std::shared_ptr<C> owner);
+
+    template <class T>
+    xdata_source typed_data(std::vector<T>&& values);
+
     /********************************
      * xboxed_container declaration *
      ********************************/
 
+    /**
+     * Container of the data properties of the marks.
+     *
+     * A boxed container either owns its values, or holds a data source:
+     * a view of contiguous values owned by the caller, created with view
+     * or data_view, or values of another numeric type than value_type,
+     * created with typed_data. The caller must keep the viewed values
+     * alive and unchanged as long as the view or one of its copies
+     * exists, unless a keep-alive pointer is passed, in which case the
+     * view shares the ownership of the values. Sources are serialized
+     * directly from their memory, with their own dtype, and views of
+     * value_type are read through data(), size() and the const
+     * iterators; reading a source of another type, or converting a
+     * source to a container reference, copies its values in the
+     * container first.
+     */
     template <class C>
     class xboxed_container
     {
@@ -34,6 +116,10 @@ namespace xpl
         using container_type = C;
         using reference = container_type&;
         using const_reference = const container_type&;
+        using value_type = typename container_type::value_type;
+        using size_type = std::size_t;
+        using const_iterator = const value_type*;
+        using keep_alive_type = xdata_source::keep_alive_type;
 
         xboxed_container() = default;
         ~xboxed_container() = default;
@@ -48,18 +134,41 @@ namespace xpl
         template <class T>
         xboxed_container(const T& c);
         xboxed_container(container_type&& c);
+        xboxed_container(xdata_source source);
 
         xboxed_container& operator=(const_reference c);
         xboxed_container& operator=(container_type&& c);
         template <class T>
         xboxed_container& operator=(const T& c);
+        xboxed_container& operator=(xdata_source source);
+
+        operator reference();
+        operator const_reference() const;
 
-        operator reference() noexcept;
-        operator const_reference() const noexcept;
+        static xboxed_container view(const value_type* data, size_type size,
+                                     keep_alive_type keep_alive = keep_alive_type());
+
+        bool is_view() const noexcept;
+        const xdata_source& source() const noexcept;
+        void detach() const;
+
+        const value_type* data() const;
+        size_type size() const noexcept;
+        bool empty() const noexcept;
+        const value_type& operator[](size_type i) const;
+        const_iterator begin() const;
+        const_iterator end() const;
 
     private:
 
-        container_type m_container;
+        void reset_view() noexcept;
+        void copy_source(std::true_type) const;
+        void copy_source(std::false_type) const;
+
+        // The container is filled on demand when a source is converted to
+        // a const reference.
+        mutable container_type m_container;
+        mutable xdata_source m_source;
     };
 
     template <class C>
@@ -70,6 +179,73 @@ namespace xpl
     template <class T>
     std::string type_to_string() noexcept;
 
+    /*****************
+     * data encoding *
+     *****************/
+
+    /**
+     * Wire encoding of numeric data containers.
+     *
+     * With ``json``, values are written as a JSON array. With ``binary``,
+     * values are appended to the message buffers as a raw little-endian
+     * typed array and the JSON state only holds a ``{value, dtype, shape}``
+     * descriptor, where ``value`` is a buffer reference. ``binary_float32``
+     * is the lossy flavor of ``binary`` where double values are sent as
+     * float32, halving their size on the wire. In both, 64-bit integers
+     * are widened to float64, since the front-end deserializer has no
+     * 64-bit integer arrays; integers above 2^53 lose precision.
+     */
+    enum class xdata_encoding
+    {
+        json,
+        binary,
+        binary_float32
+    };
+
+    xdata_encoding& default_data_encoding() noexcept;
+
+    /**
+     * True for the value types that have a dtype, i.e. a specialization of
+     * type_to_dtype; other arithmetic types (long double, char, wchar_t,
+     * long long when it is not int64_t) are serialized as JSON.
+     */
+    template <class T>
+    struct is_typed_buffer_value
+        : std::integral_constant<bool,
+                                 std::is_same<T, double>::value || std::is_same<T, float>::value ||
+                                 std::is_same<T, std::int8_t>::value || std::is_same<T, std::int16_t>::value ||
+                                 std::is_same<T, std::int32_t>::value || std::is_same<T, std::int64_t>::value ||
+                                 std::is_same<T, std::uint8_t>::value || std::is_same<T, std::uint16_t>::value ||
+                                 std::is_same<T, std::uint32_t>::value || std::is_same<T, std::uint64_t>::value>
+    {
+    };
+
+    template <class T>
+    std::string type_to_dtype() noexcept;
+
+    template <class T>
+    void serialize_typed_buffer(const T* data, std::size_t size, nl::json& j, xeus::buffer_sequence& buffers);
+    template <class T>
+    void serialize_typed_buffer(const T* data, const std::vector<std::size_t>& shape, nl::json& j, xeus::buffer_sequence& buffers);
+
+    bool is_typed_buffer(const nl::json& j);
+
+    template <class T>
+    void serialize_data_range(const T* data, std::size_t size, nl::json& j, xeus::buffer_sequence& buffers);
+
+    template <class T>
+    void deserialize_typed_buffer(std::vector<T>& values, const nl::json& j, const xeus::buffer_sequence& buffers);
+
+    template <class C>
+    void xwidgets_serialize(const xboxed_container<C>& o, nl::json& j, xeus::buffer_sequence& buffers);
+    template <class C>
+    void xwidgets_deserialize(xboxed_container<C>& o, const nl::json& j, const xeus::buffer_sequence& buffers);
+
+    template <class C>
+    void xwidgets_serialize(const xtl::xoptional<xboxed_container<C>>& o, nl::json& j, xeus::buffer_sequence& buffers);
+    template <class C>
+    void xwidgets_deserialize(xtl::xoptional<xboxed_container<C>>& o, const nl::json& j, const xeus::buffer_sequence& buffers);
+
     /***********************************
      * xboxed_container implementation *
      ***********************************/
@@ -93,9 +269,16 @@ namespace xpl
     {
     }
 
+    template <class C>
+    inline xboxed_container<C>::xboxed_container(xdata_source source)
+        : m_source(std::move(source))
+    {
+    }
+
     template <class C>
     inline xboxed_container<C>& xboxed_container<C>::operator=(const_reference c)
     {
+        reset_view();
         m_container = c;
         return *this;
     }
@@ -103,6 +286,7 @@ namespace xpl
     template <class C>
     inline xboxed_container<C>& xboxed_container<C>::operator=(container_type&& c)
     {
+        reset_view();
         m_container = std::move(c);
         return *this;
     }
@@ -111,55 +295,769 @@ namespace xpl
     template <class T>
     inline xboxed_container<C>& xboxed_container<C>::operator=(const T& c)
     {
+        reset_view();
         m_container.resize(c.size());
         std::copy(c.begin(), c.end(), m_container.begin());
         return *this;
     }
 
     template <class C>
-    inline xboxed_container<C>::operator reference() noexcept
+    inline xboxed_container<C>& xboxed_container<C>::operator=(xdata_source source)
     {
+        m_container = container_type();
+        m_source = std::move(source);
+        return *this;
+    }
+
+    template <class C>
+    inline xboxed_container<C>::operator reference()
+    {
+        detach();
         return m_container;
     }
 
     template <class C>
-    inline xboxed_container<C>::operator const_reference() const noexcept
+    inline xboxed_container<C>::operator const_reference() const
     {
+        detach();
         return m_container;
     }
 
+    /**
+     * Returns a view of the size values starting at data.
+     */
+    template <class C>
+    inline xboxed_container<C> xboxed_container<C>::view(const value_type* data, size_type size,
+                                                         keep_alive_type keep_alive)
+    {
+        return xboxed_container(xdata_source(data, size, std::move(keep_alive)));
+    }
+
+    /**
+     * Returns true when the values are held by a data source rather than
+     * by the container.
+     */
+    template <class C>
+    inline bool xboxed_container<C>::is_view() const noexcept
+    {
+        return m_source.valid();
+    }
+
+    template <class C>
+    inline const xdata_source& xboxed_container<C>::source() const noexcept
+    {
+        return m_source;
+    }
+
+    /**
+     * Copies the values of the data source in the container, which then
+     * owns them.
+     */
+    template <class C>
+    inline void xboxed_container<C>::detach() const
+    {
+        if (m_source.valid())
+        {
+            copy_source(is_typed_buffer_value<value_type>());
+            m_source = xdata_source();
+        }
+    }
+
+    template <class C>
+    inline auto xboxed_container<C>::data() const -> const value_type*
+    {
+        if (m_source.valid())
+        {
+            if (m_source.template holds<value_type>())
+            {
+                return static_cast<const value_type*>(m_source.data());
+            }
+            detach();
+        }
+        return m_container.data();
+    }
+
+    template <class C>
+    inline auto xboxed_container<C>::size() const noexcept -> size_type
+    {
+        return m_source.valid() ? m_source.size() : m_container.size();
+    }
+
+    template <class C>
+    inline bool xboxed_container<C>::empty() const noexcept
+    {
+        return size() == 0;
+    }
+
+    template <class C>
+    inline auto xboxed_container<C>::operator[](size_type i) const -> const value_type&
+    {
+        return data()[i];
+    }
+
+    template <class C>
+    inline auto xboxed_container<C>::begin() const -> const_iterator
+    {
+        return data();
+    }
+
+    template <class C>
+    inline auto xboxed_container<C>::end() const -> const_iterator
+    {
+        return data() + size();
+    }
+
+    template <class C>
+    inline void xboxed_container<C>::reset_view() noexcept
+    {
+        m_source = xdata_source();
+    }
+
+    template <class C>
+    inline void xboxed_container<C>::copy_source(std::true_type) const
+    {
+        m_source.copy_to(m_container);
+    }
+
+    template <class C>
+    inline void xboxed_container<C>::copy_source(std::false_type) const
+    {
+        if (!m_source.template holds<value_type>())
+        {
+            throw std::logic_error("data source of unexpected type");
+        }
+        const value_type* values = static_cast<const value_type*>(m_source.data());
+        m_container.assign(values, values + m_source.size());
+    }
+
+    /**
+     * Writes the values to the json array directly from the stored
+     * container or from the viewed memory, without copying them to an
+     * intermediate container.
+     */
     template <class C>
     inline void to_json(nl::json& j, const xboxed_container<C>& o)
     {
         using container_type = typename xboxed_container<C>::container_type;
-        j["values"] = container_type(o);
-        j["type"] = type_to_string<typename container_type::value_type>();
+        using value_type = typename container_type::value_type;
+        nl::json::array_t values;
+        if (o.is_view() && !o.source().template holds<value_type>())
+        {
+            o.source().write_values(values);
+        }
+        else
+        {
+            values.reserve(o.size());
+            for (const auto& value : o)
+            {
+                values.emplace_back(value);
+            }
+        }
+        j["values"] = std::move(values);
+        j["type"] = type_to_string<value_type>();
     }
 
+    /**
+     * Moves the decoded values in place; a view is replaced without
+     * copying the viewed values.
+     */
     template <class C>
     inline void from_json(const nl::json& j, xboxed_container<C>& o)
     {
         using container_type = typename xboxed_container<C>::container_type;
-        container_type& values = o;
-        values = j.at("values").get<container_type>();
+        container_type values = j.at("values").template get<container_type>();
+        o = std::move(values);
+    }
+
+    namespace detail
+    {
+        // Numeric values are all sent as the "float" json type.
+        template <class T, class = void>
+        struct json_type_name;
+
+        template <class T>
+        struct json_type_name<T, std::enable_if_t<std::is_arithmetic<T>::value>>
+        {
+            static std::string get()
+            {
+                return "float";
+            }
+        };
+
+        template <>
+        struct json_type_name<std::vector<double>>
+        {
+            static std::string get()
+            {
+                return "float";
+            }
+        };
+
+        template <>
+        struct json_type_name<std::string>
+        {
+            static std::string get()
+            {
+                return "<U5";
+            }
+        };
+    }
+
+    template <class T>
+    inline std::string type_to_string() noexcept
+    {
+        return detail::json_type_name<T>::get();
+    }
+
+    /********************************
+     * data encoding implementation *
+     ********************************/
+
+    inline xdata_encoding& default_data_encoding() noexcept
+    {
+        static xdata_encoding encoding = xdata_encoding::json;
+        return encoding;
+    }
+
+    template <>
+    inline std::string type_to_dtype<double>() noexcept
+    {
+        return "float64";
     }
 
     template <>
-    inline std::string type_to_string<double>() noexcept
+    inline std::string type_to_dtype<float>() noexcept
     {
-        return "float";
+        return "float32";
     }
 
     template <>
-    inline std::string type_to_string<std::vector<double>>() noexcept
+    inline std::string type_to_dtype<std::int8_t>() noexcept
     {
-        return "float";
+        return "int8";
     }
 
     template <>
-    inline std::string type_to_string<std::string>() noexcept
+    inline std::string type_to_dtype<std::int16_t>() noexcept
+    {
+        return "int16";
+    }
+
+    template <>
+    inline std::string type_to_dtype<std::int32_t>() noexcept
+    {
+        return "int32";
+    }
+
+    template <>
+    inline std::string type_to_dtype<std::int64_t>() noexcept
+    {
+        return "int64";
+    }
+
+    template <>
+    inline std::string type_to_dtype<std::uint8_t>() noexcept
+    {
+        return "uint8";
+    }
+
+    template <>
+    inline std::string type_to_dtype<std::uint16_t>() noexcept
+    {
+        return "uint16";
+    }
+
+    template <>
+    inline std::string type_to_dtype<std::uint32_t>() noexcept
+    {
+        return "uint32";
+    }
+
+    template <>
+    inline std::string type_to_dtype<std::uint64_t>() noexcept
+    {
+        return "uint64";
+    }
+
+    namespace detail
+    {
+        inline bool is_little_endian() noexcept
+        {
+            const std::uint16_t probe = 1;
+            return *reinterpret_cast<const unsigned char*>(&probe) == 1;
+        }
+
+        inline void swap_bytes(char* data, std::size_t size, std::size_t item_size) noexcept
+        {
+            for (std::size_t i = 0; i < size; ++i)
+            {
+                std::reverse(data + i * item_size, data + (i + 1) * item_size);
+            }
+        }
+
+        inline std::size_t buffer_reference_index(const std::string& reference)
+        {
+            const std::string prefix = xw::xbuffer_reference_prefix();
+            if (reference.compare(0, prefix.size(), prefix) != 0)
+            {
+                throw std::runtime_error("invalid buffer reference: " + reference);
+            }
+            return std::stoul(reference.substr(prefix.size()));
+        }
+
+        template <class S, class T>
+        inline void decode_buffer(const char* data, std::size_t size, std::vector<T>& values)
+        {
+            const bool swap = !is_little_endian();
+            values.resize(size);
+            if (std::is_same<S, T>::value && !swap)
+            {
+                std::memcpy(values.data(), data, size * sizeof(T));
+                return;
+            }
+            for (std::size_t i = 0; i < size; ++i)
+            {
+                S item;
+                std::memcpy(&item, data + i * sizeof(S), sizeof(S));
+                if (swap)
+                {
+                    swap_bytes(reinterpret_cast<char*>(&item), 1, sizeof(S));
+                }
+                values[i] = static_cast<T>(item);
+            }
+        }
+
+        /**
+         * Calls f with a value of the type of dtype, returns false when
+         * dtype is not supported.
+         */
+        template <class F>
+        inline bool visit_dtype(const std::string& dtype, F&& f)
+        {
+            if (dtype == type_to_dtype<double>())
+            {
+                f(double());
+            }
+            else if (dtype == type_to_dtype<float>())
+            {
+                f(float());
+            }
+            else if (dtype == type_to_dtype<std::int8_t>())
+            {
+                f(std::int8_t());
+            }
+            else if (dtype == type_to_dtype<std::int16_t>())
+            {
+                f(std::int16_t());
+            }
+            else if (dtype == type_to_dtype<std::int32_t>())
+            {
+                f(std::int32_t());
+            }
+            else if (dtype == type_to_dtype<std::int64_t>())
+            {
+                f(std::int64_t());
+            }
+            else if (dtype == type_to_dtype<std::uint8_t>())
+            {
+                f(std::uint8_t());
+            }
+            else if (dtype == type_to_dtype<std::uint16_t>())
+            {
+                f(std::uint16_t());
+            }
+            else if (dtype == type_to_dtype<std::uint32_t>())
+            {
+                f(std::uint32_t());
+            }
+            else if (dtype == type_to_dtype<std::uint64_t>())
+            {
+                f(std::uint64_t());
+            }
+            else
+            {
+                return false;
+            }
+            return true;
+        }
+
+        template <class T>
+        inline const void* type_tag() noexcept
+        {
+            static const char tag = 0;
+            return &tag;
+        }
+
+        template <class T>
+        inline std::string dtype_of(std::true_type)
+        {
+            return type_to_dtype<T>();
+        }
+
+        template <class T>
+        inline std::string dtype_of(std::false_type)
+        {
+            return std::string();
+        }
+
+        inline std::size_t shape_size(const std::vector<std::size_t>& shape) noexcept
+        {
+            std::size_t size = 1;
+            for (auto extent : shape)
+            {
+                size *= extent;
+            }
+            return size;
+        }
+
+        template <class T>
+        struct is_wide_integer
+            : std::integral_constant<bool, std::is_integral<T>::value && (sizeof(T) > sizeof(std::int32_t))>
+        {
+        };
+
+        /**
+         * Serializes the values as a typed buffer, narrowing double values
+         * to float32 with the binary_float32 encoding and widening 64-bit
+         * integers to float64.
+         */
+        inline void serialize_encoded(const double* data, const std::vector<std::size_t>& shape, nl::json& j, xeus::buffer_sequence& buffers)
+        {
+            if (default_data_encoding() != xdata_encoding::binary_float32)
+            {
+                serialize_typed_buffer(data, shape, j, buffers);
+                return;
+            }
+            std::vector<float> values(data, data + shape_size(shape));
+            serialize_typed_buffer(values.data(), shape, j, buffers);
+        }
+
+        template <class T>
+        inline void serialize_encoded(const T* data, const std::vector<std::size_t>& shape, nl::json& j, xeus::buffer_sequence& buffers, std::false_type)
+        {
+            serialize_typed_buffer(data, shape, j, buffers);
+        }
+
+        template <class T>
+        inline void serialize_encoded(const T* data, const std::vector<std::size_t>& shape, nl::json& j, xeus::buffer_sequence& buffers, std::true_type)
+        {
+            std::vector<double> values(data, data + shape_size(shape));
+            serialize_encoded(values.data(), shape, j, buffers);
+        }
+
+        template <class T>
+        inline void serialize_encoded(const T* data, const std::vector<std::size_t>& shape, nl::json& j, xeus::buffer_sequence& buffers)
+        {
+            serialize_encoded(data, shape, j, buffers, is_wide_integer<T>());
+        }
+
+        template <class T>
+        inline void serialize_data_range(const T* data, std::size_t size, nl::json& j, xeus::buffer_sequence&, std::false_type)
+        {
+            nl::json::array_t values;
+            values.reserve(size);
+            for (std::size_t i = 0; i < size; ++i)
+            {
+                values.emplace_back(data[i]);
+            }
+            j = nl::json::object();
+            j["values"] = std::move(values);
+            j["type"] = type_to_string<T>();
+        }
+
+        template <class T>
+        inline void serialize_data_range(const T* data, std::size_t size, nl::json& j, xeus::buffer_sequence& buffers, std::true_type)
+        {
+            if (default_data_encoding() != xdata_encoding::json)
+            {
+                serialize_encoded(data, {size}, j, buffers);
+            }
+            else
+            {
+                serialize_data_range(data, size, j, buffers, std::false_type());
+            }
+        }
+
+        template <class C>
+        inline void serialize_boxed(const xboxed_container<C>& o, nl::json& j, xeus::buffer_sequence& buffers, std::true_type)
+        {
+            if (default_data_encoding() == xdata_encoding::json)
+            {
+                j = o;
+            }
+            else if (o.is_view())
+            {
+                o.source().serialize(j, buffers);
+            }
+            else
+            {
+                serialize_encoded(o.data(), {o.size()}, j, buffers);
+            }
+        }
+
+        template <class C>
+        inline void serialize_boxed(const xboxed_container<C>& o, nl::json& j, xeus::buffer_sequence&, std::false_type)
+        {
+            j = o;
+        }
+
+        template <class C>
+        inline void deserialize_boxed(xboxed_container<C>& o, const nl::json& j, const xeus::buffer_sequence& buffers, std::true_type)
+        {
+            // The viewed values are replaced, there is no need to copy them.
+            if (o.is_view())
+            {
+                o = C();
+            }
+            if (is_typed_buffer(j))
+            {
+                C& values = o;
+                deserialize_typed_buffer(values, j, buffers);
+            }
+            else
+            {
+                from_json(j, o);
+            }
+        }
+
+        template <class C>
+        inline void deserialize_boxed(xboxed_container<C>& o, const nl::json& j, const xeus::buffer_sequence&, std::false_type)
+        {
+            from_json(j, o);
+        }
+    }
+
+    template <class T>
+    inline void serialize_typed_buffer(const T* data, std::size_t size, nl::json& j, xeus::buffer_sequence& buffers)
+    {
+        serialize_typed_buffer(data, std::vector<std::size_t>({size}), j, buffers);
+    }
+
+    template <class T>
+    inline void serialize_typed_buffer(const T* data, const std::vector<std::size_t>& shape, nl::json& j, xeus::buffer_sequence& buffers)
+    {
+        static_assert(is_typed_buffer_value<T>::value, "typed buffers only hold values with a dtype");
+        std::size_t size = 1;
+        for (auto extent : shape)
+        {
+            size *= extent;
+        }
+
+        j = nl::json::object();
+        j["value"] = xw::xbuffer_reference_prefix() + std::to_string(buffers.size());
+        j["dtype"] = type_to_dtype<T>();
+        j["shape"] = shape;
+
+        if (detail::is_little_endian())
+        {
+            buffers.emplace_back(data, size * sizeof(T));
+        }
+        else
+        {
+            std::vector<char> swapped(reinterpret_cast<const char*>(data),
+                                      reinterpret_cast<const char*>(data + size));
+            detail::swap_bytes(swapped.data(), size, sizeof(T));
+            buffers.emplace_back(swapped.data(), swapped.size());
+        }
+    }
+
+    inline bool is_typed_buffer(const nl::json& j)
+    {
+        if (!j.is_object())
+        {
+            return false;
+        }
+        auto it = j.find("value");
+        return it != j.end() && it->is_string() && j.find("dtype") != j.end();
+    }
+
+    template <class T>
+    inline void deserialize_typed_buffer(std::vector<T>& values, const nl::json& j, const xeus::buffer_sequence& buffers)
+    {
+        std::size_t index = detail::buffer_reference_index(j.at("value").template get<std::string>());
+        const auto& buffer = buffers.at(index);
+        const char* data = static_cast<const char*>(buffer.data());
+        const std::string dtype = j.at("dtype").template get<std::string>();
+        bool decoded = detail::visit_dtype(dtype, [data, &buffer, &values](auto item) {
+            using item_type = decltype(item);
+            detail::decode_buffer<item_type>(data, buffer.size() / sizeof(item_type), values);
+        });
+        if (!decoded)
+        {
+            throw std::runtime_error("unsupported dtype: " + dtype);
+        }
+    }
+
+    /**
+     * Serializes the ``size`` values starting at ``data`` with the current
+     * default encoding, the same way a boxed container holding them would be.
+     */
+    template <class T>
+    inline void serialize_data_range(const T* data, std::size_t size, nl::json& j, xeus::buffer_sequence& buffers)
+    {
+        detail::serialize_data_range(data, size, j, buffers, is_typed_buffer_value<T>());
+    }
+
+    /*******************************
+     * xdata_source implementation *
+     *******************************/
+
+    template <class T>
+    inline xdata_source::xdata_source(const T* data, std::size_t size, keep_alive_type keep_alive)
+        : p_data(data), m_size(size), p_type(detail::type_tag<T>()),
+          m_dtype(detail::dtype_of<T>(is_typed_buffer_value<T>())), m_keep_alive(std::move(keep_alive))
+    {
+    }
+
+    inline bool xdata_source::valid() const noexcept
+    {
+        return p_type != nullptr;
+    }
+
+    inline const void* xdata_source::data() const noexcept
+    {
+        return p_data;
+    }
+
+    inline std::size_t xdata_source::size() const noexcept
+    {
+        return m_size;
+    }
+
+    /**
+     * Returns the dtype of numeric values, or an empty string.
+     */
+    inline const std::string& xdata_source::dtype() const noexcept
+    {
+        return m_dtype;
+    }
+
+    template <class T>
+    inline bool xdata_source::holds() const noexcept
+    {
+        return p_type == detail::type_tag<T>();
+    }
+
+    /**
+     * Converts the numeric values to T.
+     */
+    template <class T>
+    inline void xdata_source::copy_to(std::vector<T>& values) const
+    {
+        std::size_t size = m_size;
+        visit([&values, size](const auto* data) { values.assign(data, data + size); });
+    }
+
+    inline void xdata_source::write_values(nl::json::array_t& values) const
+    {
+        std::size_t size = m_size;
+        visit([&values, size](const auto* data) {
+            values.reserve(size);
+            for (std::size_t i = 0; i < size; ++i)
+            {
+                values.emplace_back(data[i]);
+            }
+        });
+    }
+
+    /**
+     * Serializes the numeric values with the current default encoding,
+     * as a typed buffer of their own dtype in binary.
+     */
+    inline void xdata_source::serialize(nl::json& j, xeus::buffer_sequence& buffers) const
+    {
+        std::size_t size = m_size;
+        visit([&j, &buffers, size](const auto* data) {
+            detail::serialize_data_range(data, size, j, buffers, std::true_type());
+        });
+    }
+
+    template <class F>
+    inline void xdata_source::visit(F&& f) const
+    {
+        const void* data = p_data;
+        bool visited = detail::visit_dtype(m_dtype, [data, &f](auto item) {
+            f(static_cast<const decltype(item)*>(data));
+        });
+        if (!visited)
+        {
+            throw std::logic_error("data source of non-numeric values");
+        }
+    }
+
+    /**
+     * Returns a view of the size values starting at data, to be assigned
+     * to a data property of a mark without copying them.
+     */
+    template <class T>
+    inline xdata_source data_view(const T* data, std::size_t size, std::shared_ptr<const void> keep_alive)
+    {
+        return xdata_source(data, size, std::move(keep_alive));
+    }
+
+    /**
+     * Returns a view of the values of the contiguous container owned by
+     * owner, which the view keeps alive.
+     */
+    template <class C>
+    inline xdata_source data_view(std::shared_ptr<C> owner)
+    {
+        const auto* data = owner->data();
+        std::size_t size = owner->size();
+        return xdata_source(data, size, std::move(owner));
+    }
+
+    /**
+     * Returns a data source owning the values, which are stored and sent
+     * with their own type, e.g. float or std::int32_t.
+     */
+    template <class T>
+    inline xdata_source typed_data(std::vector<T>&& values)
+    {
+        auto owner = std::make_shared<const std::vector<T>>(std::move(values));
+        return data_view(std::move(owner));
+    }
+
+    template <class C>
+    inline void xwidgets_serialize(const xboxed_container<C>& o, nl::json& j, xeus::buffer_sequence& buffers)
+    {
+        using value_type = typename C::value_type;
+        detail::serialize_boxed(o, j, buffers, is_typed_buffer_value<value_type>());
+    }
+
+    template <class C>
+    inline void xwidgets_deserialize(xboxed_container<C>& o, const nl::json& j, const xeus::buffer_sequence& buffers)
+    {
+        using value_type = typename C::value_type;
+        detail::deserialize_boxed(o, j, buffers, is_typed_buffer_value<value_type>());
+    }
+
+    template <class C>
+    inline void xwidgets_serialize(const xtl::xoptional<xboxed_container<C>>& o, nl::json& j, xeus::buffer_sequence& buffers)
+    {
+        if (o.has_value())
+        {
+            xwidgets_serialize(o.value(), j, buffers);
+        }
+        else
+        {
+            j = nullptr;
+        }
+    }
+
+    template <class C>
+    inline void xwidgets_deserialize(xtl::xoptional<xboxed_container<C>>& o, const nl::json& j, const xeus::buffer_sequence& buffers)
     {
-        return "<U5";
+        if (j.is_null())
+        {
+            o = xtl::missing<xboxed_container<C>>();
+        }
+        else
+        {
+            xboxed_container<C> value;
+            xwidgets_deserialize(value, j, buffers);
+            o = std::move(value);
+        }
     }
 }
 
@@ -0,0 +1,360 @@
+/***************************************************************************
+* Copyright (c) 2017, Sylvain Corlay and Johan Mabille                     *
+*                                                                          *
+* Distributed under the terms of the BSD 3-Clause License.                 *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#ifndef XPLOT_COLOR_SCHEMES_HPP
+#define XPLOT_COLOR_SCHEMES_HPP
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "xscale_transform.hpp"
+
+namespace xpl
+{
+    /*****************************
+     * color scheme declarations *
+     *****************************/
+
+    /**
+     * Colors of a color map sampled at 256 evenly spaced positions, as
+     * packed 0xAARRGGBB values.
+     */
+    struct xcolor_lut
+    {
+        static constexpr std::size_t size = 256;
+
+        std::uint32_t colors[size];
+
+        constexpr std::uint32_t operator[](std::size_t i) const
+        {
+            return colors[i];
+        }
+    };
+
+    constexpr xcolor_lut make_color_lut(const std::uint32_t* colors, std::size_t size);
+
+    const xcolor_lut& color_scheme_lut(const std::string& scheme);
+    std::vector<std::string> color_scheme_colors(const std::string& scheme);
+    std::vector<std::string> color_scheme_names();
+
+    /*************************
+     * xcolormap declaration *
+     *************************/
+
+    /**
+     * Maps values to packed colors through a lookup table, the server-side
+     * counterpart of a color scale. The domain is mapped as in
+     * xcolor_transform; NaN values are mapped to 0, i.e. transparent.
+     */
+    class xcolormap
+    {
+    public:
+
+        using packed_color = std::uint32_t;
+
+        xcolormap(const xcolor_lut& lut, double min, double max, bool log = false);
+        xcolormap(const xcolor_lut& lut, double min, double mid, double max, bool log = false);
+
+        packed_color operator()(double value) const noexcept;
+
+        template <class T>
+        void colorize(const T* values, std::size_t size, packed_color* colors) const noexcept;
+
+        template <class C>
+        std::vector<packed_color> colorize(const C& values) const;
+
+        const xcolor_lut& lut() const noexcept;
+
+    private:
+
+        double position(double value) const noexcept;
+
+        xcolor_lut m_lut;
+        bool m_log;
+        double m_mid;
+        double m_offset;
+        double m_lower_scale;
+        double m_upper_scale;
+    };
+
+    /*****************************************
+     * color scheme functions implementation *
+     *****************************************/
+
+    /**
+     * Samples the colors, evenly spaced over [0, 1], at the positions of
+     * the lookup table, interpolating their RGB components.
+     */
+    constexpr xcolor_lut make_color_lut(const std::uint32_t* colors, std::size_t size)
+    {
+        xcolor_lut res = {};
+        for (std::size_t i = 0; i < xcolor_lut::size; ++i)
+        {
+            double position = static_cast<double>(i * (size - 1)) / static_cast<double>(xcolor_lut::size - 1);
+            std::size_t j = static_cast<std::size_t>(position);
+            std::size_t k = j + 1 < size ? j + 1 : j;
+            double w = position - static_cast<double>(j);
+            std::uint32_t color = 0xff000000u;
+            for (unsigned shift = 0; shift < 24; shift += 8)
+            {
+                double a = static_cast<double>((colors[j] >> shift) & 0xffu);
+                double b = static_cast<double>((colors[k] >> shift) & 0xffu);
+                color |= static_cast<std::uint32_t>(a + (b - a) * w + 0.5) << shift;
+            }
+            res.colors[i] = color;
+        }
+        return res;
+    }
+
+    namespace detail
+    {
+        struct color_scheme_def
+        {
+            const char* name;
+            std::size_t size;
+            std::uint32_t colors[12];
+        };
+
+        // The ColorBrewer schemes supported by bqplot: the 9-class
+        // sequential, 11-class diverging and qualitative schemes.
+        template <class T = void>
+        struct color_schemes
+        {
+            static constexpr std::size_t count = 35;
+            static constexpr color_scheme_def defs[count] = {
+                {"Blues", 9, {0xfff7fbff, 0xffdeebf7, 0xffc6dbef, 0xff9ecae1, 0xff6baed6, 0xff4292c6, 0xff2171b5, 0xff08519c, 0xff08306b}},
+                {"BuGn", 9, {0xfff7fcfd, 0xffe5f5f9, 0xffccece6, 0xff99d8c9, 0xff66c2a4, 0xff41ae76, 0xff238b45, 0xff006d2c, 0xff00441b}},
+                {"BuPu", 9, {0xfff7fcfd, 0xffe0ecf4, 0xffbfd3e6, 0xff9ebcda, 0xff8c96c6, 0xff8c6bb1, 0xff88419d, 0xff810f7c, 0xff4d004b}},
+                {"GnBu", 9, {0xfff7fcf0, 0xffe0f3db, 0xffccebc5, 0xffa8ddb5, 0xff7bccc4, 0xff4eb3d3, 0xff2b8cbe, 0xff0868ac, 0xff084081}},
+                {"Greens", 9, {0xfff7fcf5, 0xffe5f5e0, 0xffc7e9c0, 0xffa1d99b, 0xff74c476, 0xff41ab5d, 0xff238b45, 0xff006d2c, 0xff00441b}},
+                {"Greys", 9, {0xffffffff, 0xfff0f0f0, 0xffd9d9d9, 0xffbdbdbd, 0xff969696, 0xff737373, 0xff525252, 0xff252525, 0xff000000}},
+                {"Oranges", 9, {0xfffff5eb, 0xfffee6ce, 0xfffdd0a2, 0xfffdae6b, 0xfffd8d3c, 0xfff16913, 0xffd94801, 0xffa63603, 0xff7f2704}},
+                {"OrRd", 9, {0xfffff7ec, 0xfffee8c8, 0xfffdd49e, 0xfffdbb84, 0xfffc8d59, 0xffef6548, 0xffd7301f, 0xffb30000, 0xff7f0000}},
+                {"PuBu", 9, {0xfffff7fb, 0xffece7f2, 0xffd0d1e6, 0xffa6bddb, 0xff74a9cf, 0xff3690c0, 0xff0570b0, 0xff045a8d, 0xff023858}},
+                {"PuBuGn", 9, {0xfffff7fb, 0xffece2f0, 0xffd0d1e6, 0xffa6bddb, 0xff67a9cf, 0xff3690c0, 0xff02818a, 0xff016c59, 0xff014636}},
+                {"PuRd", 9, {0xfff7f4f9, 0xffe7e1ef, 0xffd4b9da, 0xffc994c7, 0xffdf65b0, 0xffe7298a, 0xffce1256, 0xff980043, 0xff67001f}},
+                {"Purples", 9, {0xfffcfbfd, 0xffefedf5, 0xffdadaeb, 0xffbcbddc, 0xff9e9ac8, 0xff807dba, 0xff6a51a3, 0xff54278f, 0xff3f007d}},
+                {"RdPu", 9, {0xfffff7f3, 0xfffde0dd, 0xfffcc5c0, 0xfffa9fb5, 0xfff768a1, 0xffdd3497, 0xffae017e, 0xff7a0177, 0xff49006a}},
+                {"Reds", 9, {0xfffff5f0, 0xfffee0d2, 0xfffcbba1, 0xfffc9272, 0xfffb6a4a, 0xffef3b2c, 0xffcb181d, 0xffa50f15, 0xff67000d}},
+                {"YlGn", 9, {0xffffffe5, 0xfff7fcb9, 0xffd9f0a3, 0xffaddd8e, 0xff78c679, 0xff41ab5d, 0xff238443, 0xff006837, 0xff004529}},
+                {"YlGnBu", 9, {0xffffffd9, 0xffedf8b1, 0xffc7e9b4, 0xff7fcdbb, 0xff41b6c4, 0xff1d91c0, 0xff225ea8, 0xff253494, 0xff081d58}},
+                {"YlOrBr", 9, {0xffffffe5, 0xfffff7bc, 0xfffee391, 0xfffec44f, 0xfffe9929, 0xffec7014, 0xffcc4c02, 0xff993404, 0xff662506}},
+                {"YlOrRd", 9, {0xffffffcc, 0xffffeda0, 0xfffed976, 0xfffeb24c, 0xfffd8d3c, 0xfffc4e2a, 0xffe31a1c, 0xffbd0026, 0xff800026}},
+                {"BrBG", 11, {0xff543005, 0xff8c510a, 0xffbf812d, 0xffdfc27d, 0xfff6e8c3, 0xfff5f5f5, 0xffc7eae5, 0xff80cdc1, 0xff35978f, 0xff01665e, 0xff003c30}},
+                {"PiYG", 11, {0xff8e0152, 0xffc51b7d, 0xffde77ae, 0xfff1b6da, 0xfffde0ef, 0xfff7f7f7, 0xffe6f5d0, 0xffb8e186, 0xff7fbc41, 0xff4d9221, 0xff276419}},
+                {"PRGn", 11, {0xff40004b, 0xff762a83, 0xff9970ab, 0xffc2a5cf, 0xffe7d4e8, 0xfff7f7f7, 0xffd9f0d3, 0xffa6dba0, 0xff5aae61, 0xff1b7837, 0xff00441b}},
+                {"PuOr", 11, {0xff7f3b08, 0xffb35806, 0xffe08214, 0xfffdb863, 0xfffee0b6, 0xfff7f7f7, 0xffd8daeb, 0xffb2abd2, 0xff8073ac, 0xff542788, 0xff2d004b}},
+                {"RdBu", 11, {0xff67001f, 0xffb2182b, 0xffd6604d, 0xfff4a582, 0xfffddbc7, 0xfff7f7f7, 0xffd1e5f0, 0xff92c5de, 0xff4393c3, 0xff2166ac, 0xff053061}},
+                {"RdGy", 11, {0xff67001f, 0xffb2182b, 0xffd6604d, 0xfff4a582, 0xfffddbc7, 0xffffffff, 0xffe0e0e0, 0xffbababa, 0xff878787, 0xff4d4d4d, 0xff1a1a1a}},
+                {"RdYlBu", 11, {0xffa50026, 0xffd73027, 0xfff46d43, 0xfffdae61, 0xfffee090, 0xffffffbf, 0xffe0f3f8, 0xffabd9e9, 0xff74add1, 0xff4575b4, 0xff313695}},
+                {"RdYlGn", 11, {0xffa50026, 0xffd73027, 0xfff46d43, 0xfffdae61, 0xfffee08b, 0xffffffbf, 0xffd9ef8b, 0xffa6d96a, 0xff66bd63, 0xff1a9850, 0xff006837}},
+                {"Spectral", 11, {0xff9e0142, 0xffd53e4f, 0xfff46d43, 0xfffdae61, 0xfffee08b, 0xffffffbf, 0xffe6f598, 0xffabdda4, 0xff66c2a5, 0xff3288bd, 0xff5e4fa2}},
+                {"Accent", 8, {0xff7fc97f, 0xffbeaed4, 0xfffdc086, 0xffffff99, 0xff386cb0, 0xfff0027f, 0xffbf5b17, 0xff666666}},
+                {"Dark2", 8, {0xff1b9e77, 0xffd95f02, 0xff7570b3, 0xffe7298a, 0xff66a61e, 0xffe6ab02, 0xffa6761d, 0xff666666}},
+                {"Paired", 12, {0xffa6cee3, 0xff1f78b4, 0xffb2df8a, 0xff33a02c, 0xfffb9a99, 0xffe31a1c, 0xfffdbf6f, 0xffff7f00, 0xffcab2d6, 0xff6a3d9a, 0xffffff99, 0xffb15928}},
+                {"Pastel1", 9, {0xfffbb4ae, 0xffb3cde3, 0xffccebc5, 0xffdecbe4, 0xfffed9a6, 0xffffffcc, 0xffe5d8bd, 0xfffddaec, 0xfff2f2f2}},
+                {"Pastel2", 8, {0xffb3e2cd, 0xfffdcdac, 0xffcbd5e8, 0xfff4cae4, 0xffe6f5c9, 0xfffff2ae, 0xfff1e2cc, 0xffcccccc}},
+                {"Set1", 9, {0xffe41a1c, 0xff377eb8, 0xff4daf4a, 0xff984ea3, 0xffff7f00, 0xffffff33, 0xffa65628, 0xfff781bf, 0xff999999}},
+                {"Set2", 8, {0xff66c2a5, 0xfffc8d62, 0xff8da0cb, 0xffe78ac3, 0xffa6d854, 0xffffd92f, 0xffe5c494, 0xffb3b3b3}},
+                {"Set3", 12, {0xff8dd3c7, 0xffffffb3, 0xffbebada, 0xfffb8072, 0xff80b1d3, 0xfffdb462, 0xffb3de69, 0xfffccde5, 0xffd9d9d9, 0xffbc80bd, 0xffccebc5, 0xffffed6f}}};
+
+            struct lut_table
+            {
+                xcolor_lut luts[count];
+            };
+
+            template <std::size_t... I>
+            static constexpr lut_table make_luts(std::index_sequence<I...>)
+            {
+                return {{make_color_lut(defs[I].colors, defs[I].size)...}};
+            }
+
+            static constexpr lut_table luts = make_luts(std::make_index_sequence<count>());
+        };
+
+        template <class T>
+        constexpr std::size_t color_schemes<T>::count;
+
+        template <class T>
+        constexpr color_scheme_def color_schemes<T>::defs[count];
+
+        template <class T>
+        constexpr typename color_schemes<T>::lut_table color_schemes<T>::luts;
+
+        inline std::size_t color_scheme_index(const std::string& scheme)
+        {
+            using schemes = color_schemes<>;
+            for (std::size_t i = 0; i < schemes::count; ++i)
+            {
+                if (std::strcmp(schemes::defs[i].name, scheme.c_str()) == 0)
+                {
+                    return i;
+                }
+            }
+            throw std::invalid_argument("unknown color scheme: " + scheme);
+        }
+    }
+
+    /**
+     * Returns the lookup table of a color scheme supported by the
+     * front-end, generated at compile time.
+     */
+    inline const xcolor_lut& color_scheme_lut(const std::string& scheme)
+    {
+        return detail::color_schemes<>::luts.luts[detail::color_scheme_index(scheme)];
+    }
+
+    /**
+     * Returns the colors defining a color scheme, as #rrggbb strings.
+     */
+    inline std::vector<std::string> color_scheme_colors(const std::string& scheme)
+    {
+        const detail::color_scheme_def& def = detail::color_schemes<>::defs[detail::color_scheme_index(scheme)];
+        std::vector<std::string> res;
+        res.reserve(def.size);
+        for (std::size_t i = 0; i < def.size; ++i)
+        {
+            res.push_back(format_color(def.colors[i]));
+        }
+        return res;
+    }
+
+    inline std::vector<std::string> color_scheme_names()
+    {
+        using schemes = detail::color_schemes<>;
+        std::vector<std::string> res;
+        res.reserve(schemes::count);
+        for (std::size_t i = 0; i < schemes::count; ++i)
+        {
+            res.emplace_back(schemes::defs[i].name);
+        }
+        return res;
+    }
+
+    /****************************
+     * xcolormap implementation *
+     ****************************/
+
+    inline xcolormap::xcolormap(const xcolor_lut& lut, double min, double max, bool log)
+        : xcolormap(lut, min, detail::nan, max, log)
+    {
+    }
+
+    inline xcolormap::xcolormap(const xcolor_lut& lut, double min, double mid, double max, bool log)
+        : m_lut(lut), m_log(log)
+    {
+        if (log && (!(min > 0.) || !(max > 0.) || mid <= 0.))
+        {
+            throw std::invalid_argument("the domain of a log scale must be positive");
+        }
+        if (log)
+        {
+            min = std::log(min);
+            mid = std::log(mid);
+            max = std::log(max);
+        }
+
+        // Positions in the table are offset + (value - mid) * scale, with
+        // a scale on each side of the middle value.
+        double last = static_cast<double>(xcolor_lut::size - 1);
+        auto scale = [](double extent, double a, double b) { return a == b ? 0. : extent / (b - a); };
+        if (std::isnan(mid))
+        {
+            m_mid = min;
+            m_offset = min == max ? last / 2. : 0.;
+            m_lower_scale = m_upper_scale = scale(last, min, max);
+        }
+        else
+        {
+            m_mid = mid;
+            m_offset = last / 2.;
+            m_lower_scale = scale(last / 2., min, mid);
+            m_upper_scale = scale(last / 2., mid, max);
+        }
+    }
+
+    inline auto xcolormap::operator()(double value) const noexcept -> packed_color
+    {
+        double p = position(value);
+        return std::isnan(p) ? 0u : m_lut[static_cast<std::size_t>(p + 0.5)];
+    }
+
+    /**
+     * Writes the packed colors of the values into colors, which must hold
+     * size elements.
+     */
+    template <class T>
+    inline void xcolormap::colorize(const T* values, std::size_t size, packed_color* colors) const noexcept
+    {
+        if (m_log)
+        {
+            for (std::size_t i = 0; i < size; ++i)
+            {
+                colors[i] = (*this)(static_cast<double>(values[i]));
+            }
+            return;
+        }
+
+        // Linear color maps: the position of NaN values is clamped to 0,
+        // their color being replaced afterwards.
+        const packed_color* lut = m_lut.colors;
+        double last = static_cast<double>(xcolor_lut::size - 1);
+        double mid = m_mid;
+        double offset = m_offset;
+        double lower_scale = m_lower_scale;
+        double upper_scale = m_upper_scale;
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            double value = static_cast<double>(values[i]);
+            double delta = value - mid;
+            double p = offset + delta * (delta < 0. ? lower_scale : upper_scale);
+            p = p > 0. ? (p < last ? p : last) : 0.;
+            packed_color color = lut[static_cast<std::size_t>(p + 0.5)];
+            colors[i] = value == value ? color : 0u;
+        }
+    }
+
+    template <class C>
+    inline auto xcolormap::colorize(const C& values) const -> std::vector<packed_color>
+    {
+        std::vector<packed_color> res(values.size());
+        colorize(values.data(), values.size(), res.data());
+        return res;
+    }
+
+    inline const xcolor_lut& xcolormap::lut() const noexcept
+    {
+        return m_lut;
+    }
+
+    // Position of the value in the table, clamped to its bounds; NaN for
+    // NaN values and non-positive values of a log color map.
+    inline double xcolormap::position(double value) const noexcept
+    {
+        if (m_log)
+        {
+            value = value > 0. ? std::log(value) : detail::nan;
+        }
+        if (std::isnan(value))
+        {
+            return detail::nan;
+        }
+        double delta = value - m_mid;
+        double p = m_offset + delta * (delta < 0. ? m_lower_scale : m_upper_scale);
+        double last = static_cast<double>(xcolor_lut::size - 1);
+        return p > 0. ? (p < last ? p : last) : 0.;
+    }
+}
+
+#endif
@@ -0,0 +1,363 @@
+/***************************************************************************
+* Copyright (c) 2017, Sylvain Corlay and Johan Mabille                     *
+*                                                                          *
+* Distributed under the terms of the BSD 3-Clause License.                 *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#ifndef XPLOT_DECIMATION_HPP
+#define XPLOT_DECIMATION_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "xparallel.hpp"
+
+namespace xpl
+{
+    /*****************************
+     * downsampling declarations *
+     *****************************/
+
+    /**
+     * Algorithms selecting the points of a curve that are sent to the
+     * front-end:
+     * - lttb keeps one point per bucket, the one forming the largest
+     *   triangle with its neighbours (Largest-Triangle-Three-Buckets),
+     * - minmax keeps the minimum and the maximum of each bucket,
+     * - m4 keeps the first, minimum, maximum and last points of each
+     *   bucket, which renders a line chart without visual error when
+     *   there is one bucket per pixel column.
+     */
+    enum class xdownsampling_method
+    {
+        lttb,
+        minmax,
+        m4
+    };
+
+    xdownsampling_method downsampling_method(const std::string& name);
+
+    template <class T>
+    void lttb_indices(const T* x, const T* y, std::size_t size, std::size_t max_points,
+                      std::vector<std::size_t>& indices);
+
+    template <class T>
+    void minmax_indices(const T* y, std::size_t size, std::size_t max_points,
+                        std::vector<std::size_t>& indices);
+
+    template <class T>
+    void m4_indices(const T* y, std::size_t size, std::size_t max_points,
+                    std::vector<std::size_t>& indices);
+
+    template <class T>
+    void downsample_indices(xdownsampling_method method, const T* x, const T* y, std::size_t size,
+                            std::size_t max_points, std::vector<std::size_t>& indices);
+
+    template <class T>
+    std::vector<std::vector<std::size_t>> downsample_curves(xdownsampling_method method, const T* x,
+                                                            const std::vector<const T*>& ys, std::size_t size,
+                                                            std::size_t max_points);
+
+    template <class T>
+    void gather(const T* values, const std::vector<std::size_t>& indices, std::vector<T>& res);
+
+    /*******************************
+     * downsampling implementation *
+     *******************************/
+
+    namespace detail
+    {
+        // Buckets processed by a task of the parallel kernels are grouped
+        // so that each task scans at least this number of points.
+        constexpr std::size_t downsampling_grain = std::size_t(1) << 15;
+
+        inline void identity_indices(std::size_t size, std::vector<std::size_t>& indices)
+        {
+            indices.resize(size);
+            for (std::size_t i = 0; i < size; ++i)
+            {
+                indices[i] = i;
+            }
+        }
+
+        inline std::size_t bucket_begin(std::size_t bucket, std::size_t size, std::size_t nb_buckets)
+        {
+            return static_cast<std::size_t>(static_cast<unsigned long long>(size) * bucket / nb_buckets);
+        }
+
+        /**
+         * Computes the indices of the minimum and the maximum of y over
+         * [first, last). The extrema are computed first so that the loop
+         * has no index dependency and can be vectorized; NaNs are ignored
+         * unless the range holds only NaNs.
+         */
+        template <class T>
+        inline void argminmax(const T* y, std::size_t first, std::size_t last,
+                              std::size_t& imin, std::size_t& imax)
+        {
+            T lo = std::numeric_limits<T>::has_infinity ? std::numeric_limits<T>::infinity() : (std::numeric_limits<T>::max)();
+            T hi = -lo;
+            for (std::size_t i = first; i < last; ++i)
+            {
+                lo = y[i] < lo ? y[i] : lo;
+                hi = y[i] > hi ? y[i] : hi;
+            }
+            imin = first;
+            imax = first;
+            for (std::size_t i = first; i < last; ++i)
+            {
+                if (y[i] == lo)
+                {
+                    imin = i;
+                    break;
+                }
+            }
+            for (std::size_t i = first; i < last; ++i)
+            {
+                if (y[i] == hi)
+                {
+                    imax = i;
+                    break;
+                }
+            }
+        }
+
+        constexpr std::size_t no_index = (std::numeric_limits<std::size_t>::max)();
+
+        inline void compact_indices(const std::vector<std::size_t>& slots, std::vector<std::size_t>& indices)
+        {
+            indices.clear();
+            for (std::size_t index : slots)
+            {
+                if (index != no_index && (indices.empty() || indices.back() != index))
+                {
+                    indices.push_back(index);
+                }
+            }
+        }
+
+        /**
+         * Applies f(bucket, first, last) to the nb_buckets buckets of
+         * [0, size), in parallel for large ranges.
+         */
+        template <class F>
+        inline void for_each_bucket(std::size_t size, std::size_t nb_buckets, F&& f)
+        {
+            std::size_t bucket_size = (std::max)(size / nb_buckets, std::size_t(1));
+            std::size_t grain = (std::max)(downsampling_grain / bucket_size, std::size_t(1));
+            parallel_for(0, nb_buckets, grain, [&f, size, nb_buckets](std::size_t first, std::size_t last) {
+                for (std::size_t b = first; b < last; ++b)
+                {
+                    f(b, bucket_begin(b, size, nb_buckets), bucket_begin(b + 1, size, nb_buckets));
+                }
+            });
+        }
+    }
+
+    /**
+     * Returns the downsampling method named name, that is one of "lttb",
+     * "minmax" or "m4".
+     */
+    inline xdownsampling_method downsampling_method(const std::string& name)
+    {
+        if (name == "lttb")
+        {
+            return xdownsampling_method::lttb;
+        }
+        else if (name == "minmax")
+        {
+            return xdownsampling_method::minmax;
+        }
+        else if (name == "m4")
+        {
+            return xdownsampling_method::m4;
+        }
+        throw std::invalid_argument("unknown downsampling method: " + name);
+    }
+
+    /**
+     * Selects at most max_points indices of the curve (x, y) with the
+     * Largest-Triangle-Three-Buckets algorithm. The first and last points
+     * are always kept. When the curve has at most max_points points, or
+     * when max_points is 0, all the indices are selected.
+     */
+    template <class T>
+    inline void lttb_indices(const T* x, const T* y, std::size_t size, std::size_t max_points,
+                             std::vector<std::size_t>& indices)
+    {
+        if (max_points == 0 || size <= max_points)
+        {
+            detail::identity_indices(size, indices);
+            return;
+        }
+        if (max_points < 3)
+        {
+            indices.assign({0, size - 1});
+            indices.resize(max_points);
+            return;
+        }
+
+        indices.clear();
+        indices.reserve(max_points);
+        indices.push_back(0);
+
+        double every = static_cast<double>(size - 2) / static_cast<double>(max_points - 2);
+        std::size_t a = 0;
+        for (std::size_t i = 0; i < max_points - 2; ++i)
+        {
+            std::size_t avg_first = static_cast<std::size_t>(std::floor((i + 1) * every)) + 1;
+            std::size_t avg_last = (std::min)(static_cast<std::size_t>(std::floor((i + 2) * every)) + 1, size);
+            double avg_x = 0.;
+            double avg_y = 0.;
+            for (std::size_t j = avg_first; j < avg_last; ++j)
+            {
+                avg_x += static_cast<double>(x[j]);
+                avg_y += static_cast<double>(y[j]);
+            }
+            double avg_size = static_cast<double>(avg_last - avg_first);
+            avg_x /= avg_size;
+            avg_y /= avg_size;
+
+            std::size_t first = static_cast<std::size_t>(std::floor(i * every)) + 1;
+            std::size_t last = avg_first;
+            double ax = static_cast<double>(x[a]);
+            double ay = static_cast<double>(y[a]);
+            double max_area = -1.;
+            std::size_t selected = first;
+            for (std::size_t j = first; j < last; ++j)
+            {
+                double area = std::abs((ax - avg_x) * (static_cast<double>(y[j]) - ay) -
+                                       (ax - static_cast<double>(x[j])) * (avg_y - ay));
+                if (area > max_area)
+                {
+                    max_area = area;
+                    selected = j;
+                }
+            }
+            indices.push_back(selected);
+            a = selected;
+        }
+        indices.push_back(size - 1);
+    }
+
+    /**
+     * Selects the indices of the minimum and the maximum of y in
+     * max_points / 2 buckets of equal size, in increasing order.
+     */
+    template <class T>
+    inline void minmax_indices(const T* y, std::size_t size, std::size_t max_points,
+                               std::vector<std::size_t>& indices)
+    {
+        if (max_points == 0 || size <= max_points)
+        {
+            detail::identity_indices(size, indices);
+            return;
+        }
+
+        std::size_t nb_buckets = (std::max)(max_points / 2, std::size_t(1));
+        std::vector<std::size_t> slots(2 * nb_buckets, detail::no_index);
+        detail::for_each_bucket(size, nb_buckets, [y, &slots](std::size_t b, std::size_t first, std::size_t last) {
+            if (first == last)
+            {
+                return;
+            }
+            std::size_t imin, imax;
+            detail::argminmax(y, first, last, imin, imax);
+            slots[2 * b] = (std::min)(imin, imax);
+            slots[2 * b + 1] = (std::max)(imin, imax);
+        });
+        detail::compact_indices(slots, indices);
+    }
+
+    /**
+     * Selects the indices of the first, minimum, maximum and last points
+     * of y in max_points / 4 buckets of equal size, in increasing order.
+     */
+    template <class T>
+    inline void m4_indices(const T* y, std::size_t size, std::size_t max_points,
+                           std::vector<std::size_t>& indices)
+    {
+        if (max_points < 4)
+        {
+            minmax_indices(y, size, max_points, indices);
+            return;
+        }
+        if (size <= max_points)
+        {
+            detail::identity_indices(size, indices);
+            return;
+        }
+
+        std::size_t nb_buckets = max_points / 4;
+        std::vector<std::size_t> slots(4 * nb_buckets, detail::no_index);
+        detail::for_each_bucket(size, nb_buckets, [y, &slots](std::size_t b, std::size_t first, std::size_t last) {
+            if (first == last)
+            {
+                return;
+            }
+            std::size_t imin, imax;
+            detail::argminmax(y, first, last, imin, imax);
+            slots[4 * b] = first;
+            slots[4 * b + 1] = (std::min)(imin, imax);
+            slots[4 * b + 2] = (std::max)(imin, imax);
+            slots[4 * b + 3] = last - 1;
+        });
+        detail::compact_indices(slots, indices);
+    }
+
+    template <class T>
+    inline void downsample_indices(xdownsampling_method method, const T* x, const T* y, std::size_t size,
+                                   std::size_t max_points, std::vector<std::size_t>& indices)
+    {
+        switch (method)
+        {
+        case xdownsampling_method::lttb:
+            lttb_indices(x, y, size, max_points, indices);
+            break;
+        case xdownsampling_method::minmax:
+            minmax_indices(y, size, max_points, indices);
+            break;
+        case xdownsampling_method::m4:
+            m4_indices(y, size, max_points, indices);
+            break;
+        }
+    }
+
+    /**
+     * Downsamples several curves sharing the same abscissa, one curve per
+     * task.
+     */
+    template <class T>
+    inline std::vector<std::vector<std::size_t>> downsample_curves(xdownsampling_method method, const T* x,
+                                                                   const std::vector<const T*>& ys, std::size_t size,
+                                                                   std::size_t max_points)
+    {
+        std::vector<std::vector<std::size_t>> res(ys.size());
+        parallel_for(0, ys.size(), 1, [&](std::size_t first, std::size_t last) {
+            for (std::size_t i = first; i < last; ++i)
+            {
+                downsample_indices(method, x, ys[i], size, max_points, res[i]);
+            }
+        });
+        return res;
+    }
+
+    template <class T>
+    inline void gather(const T* values, const std::vector<std::size_t>& indices, std::vector<T>& res)
+    {
+        res.resize(indices.size());
+        for (std::size_t i = 0; i < indices.size(); ++i)
+        {
+            res[i] = values[indices[i]];
+        }
+    }
+}
+
+#endif
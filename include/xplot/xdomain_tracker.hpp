@@ -0,0 +1,614 @@
+/***************************************************************************
+* Copyright (c) 2017, Sylvain Corlay and Johan Mabille                     *
+*                                                                          *
+* Distributed under the terms of the BSD 3-Clause License.                 *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#ifndef XPLOT_DOMAIN_TRACKER_HPP
+#define XPLOT_DOMAIN_TRACKER_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <limits>
+#include <map>
+#include <string>
+#include <utility>
+
+#include "xeus/xguid.hpp"
+
+namespace xpl
+{
+    class xdomain_contributor;
+    class xdomain_listener;
+
+    /***********************
+     * xextent declaration *
+     ***********************/
+
+    /**
+     * Bounds of a set of values, NaN values being ignored. The extent of
+     * an empty set has min > max.
+     */
+    struct xextent
+    {
+        double min = std::numeric_limits<double>::infinity();
+        double max = -std::numeric_limits<double>::infinity();
+
+        bool empty() const noexcept;
+        void merge(const xextent& rhs) noexcept;
+    };
+
+    bool operator==(const xextent& lhs, const xextent& rhs) noexcept;
+    bool operator!=(const xextent& lhs, const xextent& rhs) noexcept;
+
+    template <class T>
+    xextent compute_extent(const T* values, std::size_t size) noexcept;
+
+    /*******************************
+     * xdomain_tracker declaration *
+     *******************************/
+
+    /**
+     * Merges the extents of the data that the marks bind to each scale,
+     * and sends the resulting domain to the scale listening to it. Scales
+     * and marks are identified as in xscale_event_hub. The extents bound
+     * to a scale without listener are only computed when one subscribes.
+     */
+    class xdomain_tracker
+    {
+    public:
+
+        using handler_type = std::function<void(const xextent&)>;
+        using provider_type = std::function<xextent()>;
+
+        xextent domain(const xeus::xguid& scale_id) const;
+        bool listened(const xeus::xguid& scale_id) const;
+
+    private:
+
+        using key_type = std::pair<const xdomain_contributor*, std::string>;
+
+        struct scale_entry
+        {
+            std::map<key_type, xextent> extents;
+            std::map<key_type, provider_type> deferred;
+            xextent domain;
+            const xdomain_listener* listener = nullptr;
+            handler_type handler;
+        };
+
+        void set_extent(const xeus::xguid& scale_id, const key_type& key, const xextent& extent);
+        void defer_extent(const xeus::xguid& scale_id, const key_type& key, provider_type provider);
+        void remove_extent(const xeus::xguid& scale_id, const key_type& key);
+        void listen(const xeus::xguid& scale_id, const xdomain_listener* listener, handler_type handler);
+        void unlisten(const xeus::xguid& scale_id, const xdomain_listener* listener);
+        void update_domain(const xeus::xguid& scale_id);
+
+        std::map<xeus::xguid, scale_entry> m_scales;
+
+        friend class xdomain_contributor;
+        friend class xdomain_listener;
+    };
+
+    xdomain_tracker& get_domain_tracker();
+
+    /***********************************
+     * xdomain_contributor declaration *
+     ***********************************/
+
+    /**
+     * Extents of the data properties of a mark, registered to the scales
+     * they are bound to until the contributor is destroyed. Copies and
+     * moves contribute the extents of their source, the deferred ones
+     * being computed since their providers refer to the source; the
+     * source of a move no longer contributes.
+     */
+    class xdomain_contributor
+    {
+    public:
+
+        using provider_type = xdomain_tracker::provider_type;
+
+        xdomain_contributor() = default;
+        ~xdomain_contributor();
+
+        xdomain_contributor(const xdomain_contributor&);
+        xdomain_contributor(xdomain_contributor&&);
+
+        xdomain_contributor& operator=(const xdomain_contributor&);
+        xdomain_contributor& operator=(xdomain_contributor&&);
+
+        void set(const std::string& name, const xeus::xguid& scale_id, const xextent& extent);
+        void defer(const std::string& name, const xeus::xguid& scale_id, provider_type provider);
+        void bind(const std::string& name, const xeus::xguid& scale_id);
+        void reset();
+
+        bool contains(const std::string& name) const;
+        xextent extent(const std::string& name) const;
+        std::map<std::string, xeus::xguid> bindings() const;
+
+    private:
+
+        struct entry
+        {
+            xeus::xguid scale_id;
+            xextent extent;
+            provider_type provider;
+        };
+
+        void assign(const xdomain_contributor& rhs);
+        void publish(const std::string& name, const entry& e);
+        void withdraw(const std::string& name, const entry& e);
+
+        std::map<std::string, entry> m_entries;
+    };
+
+    /********************************
+     * xdomain_listener declaration *
+     ********************************/
+
+    /**
+     * Listener of the domain tracked for a scale. A scale has at most one
+     * listener; the handler is called with the current domain when the
+     * listener subscribes, and each time it changes.
+     */
+    class xdomain_listener
+    {
+    public:
+
+        using handler_type = xdomain_tracker::handler_type;
+
+        xdomain_listener() = default;
+        ~xdomain_listener();
+
+        xdomain_listener(const xdomain_listener&) noexcept;
+        xdomain_listener(xdomain_listener&&) noexcept;
+
+        xdomain_listener& operator=(const xdomain_listener&);
+        xdomain_listener& operator=(xdomain_listener&&);
+
+        void subscribe(const xeus::xguid& scale_id, handler_type handler);
+        void reset();
+
+        bool subscribed() const noexcept;
+
+    private:
+
+        xeus::xguid m_scale_id;
+        bool m_subscribed = false;
+    };
+
+    /**************************
+     * xextent implementation *
+     **************************/
+
+    inline bool xextent::empty() const noexcept
+    {
+        return !(min <= max);
+    }
+
+    inline void xextent::merge(const xextent& rhs) noexcept
+    {
+        min = std::min(min, rhs.min);
+        max = std::max(max, rhs.max);
+    }
+
+    inline bool operator==(const xextent& lhs, const xextent& rhs) noexcept
+    {
+        return (lhs.empty() && rhs.empty()) || (lhs.min == rhs.min && lhs.max == rhs.max);
+    }
+
+    inline bool operator!=(const xextent& lhs, const xextent& rhs) noexcept
+    {
+        return !(lhs == rhs);
+    }
+
+    /**
+     * Computes the extent of the values, skipping NaN. The values are
+     * reduced in independent lanes so that the loop is vectorized.
+     */
+    template <class T>
+    inline xextent compute_extent(const T* values, std::size_t size) noexcept
+    {
+        constexpr std::size_t lanes = 4;
+        double lower[lanes];
+        double upper[lanes];
+        std::fill(lower, lower + lanes, std::numeric_limits<double>::infinity());
+        std::fill(upper, upper + lanes, -std::numeric_limits<double>::infinity());
+
+        std::size_t i = 0;
+        for (; i + lanes <= size; i += lanes)
+        {
+            for (std::size_t j = 0; j < lanes; ++j)
+            {
+                // A comparison with NaN is false, NaN values are skipped.
+                double value = static_cast<double>(values[i + j]);
+                lower[j] = value < lower[j] ? value : lower[j];
+                upper[j] = value > upper[j] ? value : upper[j];
+            }
+        }
+        for (; i < size; ++i)
+        {
+            double value = static_cast<double>(values[i]);
+            lower[0] = value < lower[0] ? value : lower[0];
+            upper[0] = value > upper[0] ? value : upper[0];
+        }
+
+        xextent res;
+        for (std::size_t j = 0; j < lanes; ++j)
+        {
+            res.min = std::min(res.min, lower[j]);
+            res.max = std::max(res.max, upper[j]);
+        }
+        return res;
+    }
+
+    /**********************************
+     * xdomain_tracker implementation *
+     **********************************/
+
+    /**
+     * Returns the union of the extents bound to the scale, the deferred
+     * ones excluded.
+     */
+    inline xextent xdomain_tracker::domain(const xeus::xguid& scale_id) const
+    {
+        auto it = m_scales.find(scale_id);
+        return it != m_scales.end() ? it->second.domain : xextent();
+    }
+
+    /**
+     * Returns whether a listener is subscribed to the domain of the scale.
+     */
+    inline bool xdomain_tracker::listened(const xeus::xguid& scale_id) const
+    {
+        auto it = m_scales.find(scale_id);
+        return it != m_scales.end() && it->second.listener != nullptr;
+    }
+
+    inline void xdomain_tracker::set_extent(const xeus::xguid& scale_id, const key_type& key, const xextent& extent)
+    {
+        scale_entry& entry = m_scales[scale_id];
+        entry.deferred.erase(key);
+        auto it = entry.extents.find(key);
+        if (it != entry.extents.end() && it->second == extent)
+        {
+            return;
+        }
+        entry.extents[key] = extent;
+        update_domain(scale_id);
+    }
+
+    /**
+     * Binds the extent computed by provider to the scale. The provider is
+     * called right away if the scale has a listener, and when one
+     * subscribes otherwise.
+     */
+    inline void xdomain_tracker::defer_extent(const xeus::xguid& scale_id, const key_type& key, provider_type provider)
+    {
+        scale_entry& entry = m_scales[scale_id];
+        if (entry.listener != nullptr)
+        {
+            set_extent(scale_id, key, provider());
+            return;
+        }
+        entry.deferred[key] = std::move(provider);
+        if (entry.extents.erase(key) != 0)
+        {
+            update_domain(scale_id);
+        }
+    }
+
+    inline void xdomain_tracker::remove_extent(const xeus::xguid& scale_id, const key_type& key)
+    {
+        auto it = m_scales.find(scale_id);
+        if (it == m_scales.end())
+        {
+            return;
+        }
+        bool deferred = it->second.deferred.erase(key) != 0;
+        if (it->second.extents.erase(key) != 0 || deferred)
+        {
+            update_domain(scale_id);
+        }
+    }
+
+    inline void xdomain_tracker::listen(const xeus::xguid& scale_id, const xdomain_listener* listener, handler_type handler)
+    {
+        scale_entry& entry = m_scales[scale_id];
+        entry.listener = listener;
+        entry.handler = std::move(handler);
+        for (const auto& deferred : entry.deferred)
+        {
+            entry.extents[deferred.first] = deferred.second();
+        }
+        entry.deferred.clear();
+        entry.domain = xextent();
+        for (const auto& extent : entry.extents)
+        {
+            entry.domain.merge(extent.second);
+        }
+        if (!entry.domain.empty())
+        {
+            handler_type callback = entry.handler;
+            callback(entry.domain);
+        }
+    }
+
+    inline void xdomain_tracker::unlisten(const xeus::xguid& scale_id, const xdomain_listener* listener)
+    {
+        auto it = m_scales.find(scale_id);
+        if (it != m_scales.end() && it->second.listener == listener)
+        {
+            it->second.listener = nullptr;
+            it->second.handler = nullptr;
+            if (it->second.extents.empty() && it->second.deferred.empty())
+            {
+                m_scales.erase(it);
+            }
+        }
+    }
+
+    /**
+     * Merges the extents bound to the scale, and sends the domain to its
+     * listener if it changed. An empty domain is not sent, the scale
+     * keeping its last bounds.
+     */
+    inline void xdomain_tracker::update_domain(const xeus::xguid& scale_id)
+    {
+        auto it = m_scales.find(scale_id);
+        scale_entry& entry = it->second;
+        if (entry.extents.empty() && entry.deferred.empty() && entry.listener == nullptr)
+        {
+            m_scales.erase(it);
+            return;
+        }
+
+        xextent domain;
+        for (const auto& extent : entry.extents)
+        {
+            domain.merge(extent.second);
+        }
+        if (domain == entry.domain)
+        {
+            return;
+        }
+        entry.domain = domain;
+        if (entry.handler && !domain.empty())
+        {
+            // The handler may modify the tracker.
+            handler_type handler = entry.handler;
+            handler(domain);
+        }
+    }
+
+    inline xdomain_tracker& get_domain_tracker()
+    {
+        static xdomain_tracker tracker;
+        return tracker;
+    }
+
+    /**************************************
+     * xdomain_contributor implementation *
+     **************************************/
+
+    inline xdomain_contributor::~xdomain_contributor()
+    {
+        reset();
+    }
+
+    inline xdomain_contributor::xdomain_contributor(const xdomain_contributor& rhs)
+    {
+        assign(rhs);
+    }
+
+    inline xdomain_contributor::xdomain_contributor(xdomain_contributor&& rhs)
+    {
+        assign(rhs);
+        rhs.reset();
+    }
+
+    inline xdomain_contributor& xdomain_contributor::operator=(const xdomain_contributor& rhs)
+    {
+        if (this != &rhs)
+        {
+            reset();
+            assign(rhs);
+        }
+        return *this;
+    }
+
+    inline xdomain_contributor& xdomain_contributor::operator=(xdomain_contributor&& rhs)
+    {
+        if (this != &rhs)
+        {
+            reset();
+            assign(rhs);
+            rhs.reset();
+        }
+        return *this;
+    }
+
+    /**
+     * Sets the extent of the property name, bound to the scale scale_id;
+     * a null id means that the property is not bound to any scale.
+     */
+    inline void xdomain_contributor::set(const std::string& name, const xeus::xguid& scale_id, const xextent& extent)
+    {
+        entry& e = m_entries[name];
+        if (e.scale_id != scale_id)
+        {
+            withdraw(name, e);
+            e.scale_id = scale_id;
+        }
+        e.extent = extent;
+        e.provider = nullptr;
+        publish(name, e);
+    }
+
+    /**
+     * Sets the extent of the property name to the result of provider,
+     * called only when the scale scale_id has a listener or when the
+     * extent is queried.
+     */
+    inline void xdomain_contributor::defer(const std::string& name, const xeus::xguid& scale_id, provider_type provider)
+    {
+        entry& e = m_entries[name];
+        if (e.scale_id != scale_id)
+        {
+            withdraw(name, e);
+            e.scale_id = scale_id;
+        }
+        e.extent = xextent();
+        e.provider = std::move(provider);
+        publish(name, e);
+    }
+
+    /**
+     * Binds the property name to another scale, keeping its extent.
+     */
+    inline void xdomain_contributor::bind(const std::string& name, const xeus::xguid& scale_id)
+    {
+        auto it = m_entries.find(name);
+        if (it != m_entries.end() && it->second.scale_id != scale_id)
+        {
+            withdraw(name, it->second);
+            it->second.scale_id = scale_id;
+            publish(name, it->second);
+        }
+    }
+
+    inline void xdomain_contributor::reset()
+    {
+        for (const auto& e : m_entries)
+        {
+            withdraw(e.first, e.second);
+        }
+        m_entries.clear();
+    }
+
+    /**
+     * Returns whether the extent of the property name is computed.
+     */
+    inline bool xdomain_contributor::contains(const std::string& name) const
+    {
+        auto it = m_entries.find(name);
+        return it != m_entries.end() && !it->second.provider;
+    }
+
+    inline xextent xdomain_contributor::extent(const std::string& name) const
+    {
+        auto it = m_entries.find(name);
+        if (it == m_entries.end())
+        {
+            return xextent();
+        }
+        return it->second.provider ? it->second.provider() : it->second.extent;
+    }
+
+    inline std::map<std::string, xeus::xguid> xdomain_contributor::bindings() const
+    {
+        std::map<std::string, xeus::xguid> res;
+        for (const auto& e : m_entries)
+        {
+            res.emplace(e.first, e.second.scale_id);
+        }
+        return res;
+    }
+
+    /**
+     * Contributes the extents of rhs. The providers of the deferred ones
+     * refer to the properties of the owner of rhs, which are not copied
+     * or moved yet when the contributor is, so they are called now.
+     */
+    inline void xdomain_contributor::assign(const xdomain_contributor& rhs)
+    {
+        for (const auto& item : rhs.m_entries)
+        {
+            entry& e = m_entries[item.first];
+            e.scale_id = item.second.scale_id;
+            e.extent = item.second.provider ? item.second.provider() : item.second.extent;
+            publish(item.first, e);
+        }
+    }
+
+    inline void xdomain_contributor::publish(const std::string& name, const entry& e)
+    {
+        if (e.scale_id == xeus::xguid())
+        {
+            return;
+        }
+        if (e.provider)
+        {
+            get_domain_tracker().defer_extent(e.scale_id, {this, name}, e.provider);
+        }
+        else
+        {
+            get_domain_tracker().set_extent(e.scale_id, {this, name}, e.extent);
+        }
+    }
+
+    inline void xdomain_contributor::withdraw(const std::string& name, const entry& e)
+    {
+        if (e.scale_id != xeus::xguid())
+        {
+            get_domain_tracker().remove_extent(e.scale_id, {this, name});
+        }
+    }
+
+    /***********************************
+     * xdomain_listener implementation *
+     ***********************************/
+
+    inline xdomain_listener::~xdomain_listener()
+    {
+        reset();
+    }
+
+    inline xdomain_listener::xdomain_listener(const xdomain_listener&) noexcept
+    {
+    }
+
+    inline xdomain_listener::xdomain_listener(xdomain_listener&&) noexcept
+    {
+    }
+
+    inline xdomain_listener& xdomain_listener::operator=(const xdomain_listener&)
+    {
+        reset();
+        return *this;
+    }
+
+    inline xdomain_listener& xdomain_listener::operator=(xdomain_listener&&)
+    {
+        reset();
+        return *this;
+    }
+
+    inline void xdomain_listener::subscribe(const xeus::xguid& scale_id, handler_type handler)
+    {
+        reset();
+        m_scale_id = scale_id;
+        m_subscribed = true;
+        get_domain_tracker().listen(scale_id, this, std::move(handler));
+    }
+
+    inline void xdomain_listener::reset()
+    {
+        if (m_subscribed)
+        {
+            get_domain_tracker().unlisten(m_scale_id, this);
+            m_subscribed = false;
+        }
+    }
+
+    inline bool xdomain_listener::subscribed() const noexcept
+    {
+        return m_subscribed;
+    }
+}
+
+#endif
@@ -9,7 +9,12 @@
 #ifndef XPLOT_FIGURE_HPP
 #define XPLOT_FIGURE_HPP
 
+#include <algorithm>
+#include <cstddef>
+#include <memory>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 #include <utility>
 
@@ -24,6 +29,7 @@
 #include "xmarks.hpp"
 #include "xplot_config.hpp"
 #include "xscales.hpp"
+#include "xsync.hpp"
 
 namespace nl = nlohmann;
 
@@ -34,17 +40,18 @@ namespace xpl
      ***********************/
 
     template <class D>
-    class xfigure : public xw::xwidget<D>
+    class xfigure : public xsynced<D, xw::xwidget>
     {
     public:
 
-        using base_type = xw::xwidget<D>;
+        using base_type = xsynced<D, xw::xwidget>;
         using derived_type = D;
 
         using axes_type = std::vector<xw::xholder<xaxis>>;
         using marks_type = std::vector<xw::xholder<xmark>>;
         using scales_type = xw::xholder<xscale>;
         using interaction_type = xw::xholder<xinteraction>;
+        using version_type = typename base_type::version_type;
 
         void serialize_state(nl::json&, xeus::buffer_sequence&) const;
         void apply_patch(const nl::json&, const xeus::buffer_sequence&);
@@ -79,6 +86,18 @@ namespace xpl
         template <class T>
         void remove_mark(const xmark<T>& w);
 
+        template <class It>
+        void add_marks(It first, It last);
+
+        template <class R>
+        void remove_marks(const R& ids);
+
+        template <class It>
+        void replace_marks(It first, It last);
+
+        template <class R>
+        void replace_marks(const R& marks);
+
         void clear_marks();
 
         template <class T>
@@ -93,6 +112,9 @@ namespace xpl
         template <class T>
         void remove_axis(const xaxis<T>& w);
 
+        template <class It>
+        void add_axes(It first, It last);
+
         void clear_axes();
 
     protected:
@@ -105,7 +127,34 @@ namespace xpl
 
         void set_defaults();
         void send_marks_patch() const;
+        void append_mark(xw::xholder<xmark>&& holder);
         void send_axes_patch() const;
+
+        template <class T>
+        static xw::xholder<xmark> make_mark_holder(const xmark<T>& w);
+
+        template <class T>
+        static enable_xmark_t<T, xw::xholder<xmark>> make_mark_holder(std::shared_ptr<T> w);
+
+        static xw::xholder<xmark> make_mark_holder(const xw::xholder<xmark>& w);
+
+        template <class T>
+        static xw::xholder<xaxis> make_axis_holder(const xaxis<T>& w);
+
+        template <class T>
+        static enable_xaxis_t<T, xw::xholder<xaxis>> make_axis_holder(std::shared_ptr<T> w);
+
+        static xw::xholder<xaxis> make_axis_holder(const xw::xholder<xaxis>& w);
+
+        using mark_index_type = std::unordered_map<xeus::xguid, std::size_t>;
+
+        bool mark_index_valid() const;
+        void rebuild_mark_index() const;
+        void index_marks(std::size_t first) const;
+
+        mutable mark_index_type m_mark_index;
+        mutable std::size_t m_mark_index_size = 0;
+        mutable version_type m_mark_index_version = 0;
     };
 
     using figure = xw::xmaterialize<xfigure>;
@@ -173,40 +222,126 @@ namespace xpl
     template <class T>
     inline void xfigure<D>::add_mark(const xmark<T>& w)
     {
-        this->marks().emplace_back(xw::make_id_holder<xmark>(w.id()));
-        send_marks_patch();
+        append_mark(xw::make_id_holder<xmark>(w.id()));
     }
 
     template <class D>
     template <class T>
     inline void xfigure<D>::add_mark(xmark<T>&& w)
     {
-        this->marks().emplace_back(xw::make_owning_holder(std::move(w)));
-        send_marks_patch();
+        append_mark(xw::make_owning_holder(std::move(w)));
     }
 
     template <class D>
     template <class T>
     inline enable_xmark_t<T> xfigure<D>::add_mark(std::shared_ptr<T> w)
     {
-        this->marks().emplace_back(xw::make_shared_holder<xmark, T>(w));
-        send_marks_patch();
+        append_mark(xw::make_shared_holder<xmark, T>(w));
     }
 
     template <class D>
     template <class T>
     inline void xfigure<D>::remove_mark(const xmark<T>& w)
     {
-        this->marks().erase(
-            std::remove_if(
-                this->marks().begin(), this->marks().end(),
-                [&w](const xw::xholder<xmark>& element) {
-                    return element.id() == w.id();
-                }
-            ),
-            this->marks().end()
-        );
+        remove_marks(std::vector<xeus::xguid>(1, w.id()));
+    }
+
+    /**
+     * Appends the marks of the range [first, last) and sends a single
+     * patch. The range may hold mark widgets, shared pointers to mark
+     * widgets or mark holders.
+     */
+    template <class D>
+    template <class It>
+    inline void xfigure<D>::add_marks(It first, It last)
+    {
+        bool valid = mark_index_valid();
+        std::size_t size = this->marks().size();
+        for (; first != last; ++first)
+        {
+            this->marks().emplace_back(make_mark_holder(*first));
+        }
+        send_marks_patch();
+        if (valid)
+        {
+            index_marks(size);
+        }
+    }
+
+    /**
+     * Removes all the marks whose id is in ids and sends a single patch,
+     * which is sent even if none of the ids is found.
+     * Only the marks following the first removed one are moved, so that
+     * removing recently added marks does not depend on the number of
+     * marks in the figure.
+     */
+    template <class D>
+    template <class R>
+    inline void xfigure<D>::remove_marks(const R& ids)
+    {
+        if (!mark_index_valid())
+        {
+            rebuild_mark_index();
+        }
+
+        marks_type& m = this->marks();
+        std::unordered_set<xeus::xguid> removed;
+        std::size_t first = m.size();
+        for (const auto& id : ids)
+        {
+            auto it = m_mark_index.find(id);
+            if (it != m_mark_index.end())
+            {
+                removed.insert(id);
+                first = (std::min)(first, it->second);
+            }
+        }
+
+        if (removed.empty())
+        {
+            send_marks_patch();
+            index_marks(m.size());
+            return;
+        }
+
+        for (const auto& id : removed)
+        {
+            m_mark_index.erase(id);
+        }
+        auto new_end = std::remove_if(m.begin() + static_cast<std::ptrdiff_t>(first), m.end(),
+            [&removed](const xw::xholder<xmark>& element) {
+                return removed.count(element.id()) != 0;
+            });
+        m.erase(new_end, m.end());
+        send_marks_patch();
+        index_marks(first);
+    }
+
+    /**
+     * Replaces the marks of the figure with the ones of the range
+     * [first, last) and sends a single patch.
+     */
+    template <class D>
+    template <class It>
+    inline void xfigure<D>::replace_marks(It first, It last)
+    {
+        marks_type m;
+        for (; first != last; ++first)
+        {
+            m.emplace_back(make_mark_holder(*first));
+        }
+        this->marks() = std::move(m);
         send_marks_patch();
+        rebuild_mark_index();
+    }
+
+    template <class D>
+    template <class R>
+    inline void xfigure<D>::replace_marks(const R& marks)
+    {
+        using std::begin;
+        using std::end;
+        replace_marks(begin(marks), end(marks));
     }
 
     template <class D>
@@ -263,6 +398,21 @@ namespace xpl
         send_axes_patch();
     }
 
+    /**
+     * Appends the axes of the range [first, last) and sends a single
+     * patch.
+     */
+    template <class D>
+    template <class It>
+    inline void xfigure<D>::add_axes(It first, It last)
+    {
+        for (; first != last; ++first)
+        {
+            this->axes().emplace_back(make_axis_holder(*first));
+        }
+        send_axes_patch();
+    }
+
     template <class D>
     inline xfigure<D>::xfigure()
         : base_type()
@@ -297,21 +447,106 @@ namespace xpl
     template <class D>
     inline void xfigure<D>::send_marks_patch() const
     {
-        using xw::xwidgets_serialize;
-        nl::json state;
-        xeus::buffer_sequence buffers;
-        xwidgets_serialize(marks, state["marks"], buffers);
-        this->send_patch(std::move(state), std::move(buffers));
+        this->notify(marks);
     }
 
     template <class D>
     inline void xfigure<D>::send_axes_patch() const
     {
-        using xw::xwidgets_serialize;
-        nl::json state;
-        xeus::buffer_sequence buffers;
-        xwidgets_serialize(axes, state["axes"], buffers);
-        this->send_patch(std::move(state), std::move(buffers));
+        this->notify(axes);
+    }
+
+    template <class D>
+    template <class T>
+    inline xw::xholder<xmark> xfigure<D>::make_mark_holder(const xmark<T>& w)
+    {
+        return xw::make_id_holder<xmark>(w.id());
+    }
+
+    template <class D>
+    template <class T>
+    inline auto xfigure<D>::make_mark_holder(std::shared_ptr<T> w) -> enable_xmark_t<T, xw::xholder<xmark>>
+    {
+        return xw::make_shared_holder<xmark, T>(w);
+    }
+
+    template <class D>
+    inline xw::xholder<xmark> xfigure<D>::make_mark_holder(const xw::xholder<xmark>& w)
+    {
+        return w;
+    }
+
+    template <class D>
+    template <class T>
+    inline xw::xholder<xaxis> xfigure<D>::make_axis_holder(const xaxis<T>& w)
+    {
+        return xw::make_id_holder<xaxis>(w.id());
+    }
+
+    template <class D>
+    template <class T>
+    inline auto xfigure<D>::make_axis_holder(std::shared_ptr<T> w) -> enable_xaxis_t<T, xw::xholder<xaxis>>
+    {
+        return xw::make_shared_holder<xaxis, T>(w);
+    }
+
+    template <class D>
+    inline xw::xholder<xaxis> xfigure<D>::make_axis_holder(const xw::xholder<xaxis>& w)
+    {
+        return w;
+    }
+
+    /**
+     * The id to index map of the marks is kept up to date by the methods
+     * adding and removing marks; it is rebuilt when the marks were changed
+     * through other means, which is detected from their size and their
+     * version.
+     */
+    template <class D>
+    inline bool xfigure<D>::mark_index_valid() const
+    {
+        return m_mark_index_size == this->marks().size() &&
+            m_mark_index_version == this->property_version("marks");
+    }
+
+    /**
+     * Appends the mark and indexes it if the index was up to date, so
+     * that alternating additions and removals do not rebuild it.
+     */
+    template <class D>
+    inline void xfigure<D>::append_mark(xw::xholder<xmark>&& holder)
+    {
+        bool valid = mark_index_valid();
+        std::size_t size = this->marks().size();
+        this->marks().emplace_back(std::move(holder));
+        send_marks_patch();
+        if (valid)
+        {
+            index_marks(size);
+        }
+    }
+
+    template <class D>
+    inline void xfigure<D>::rebuild_mark_index() const
+    {
+        m_mark_index.clear();
+        index_marks(0);
+    }
+
+    template <class D>
+    inline void xfigure<D>::index_marks(std::size_t first) const
+    {
+        const marks_type& m = this->marks();
+        for (std::size_t i = first; i < m.size(); ++i)
+        {
+            auto res = m_mark_index.emplace(m[i].id(), i);
+            if (!res.second && res.first->second >= first)
+            {
+                res.first->second = (std::min)(res.first->second, i);
+            }
+        }
+        m_mark_index_size = m.size();
+        m_mark_index_version = this->property_version("marks");
     }
 }
 
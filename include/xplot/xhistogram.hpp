@@ -0,0 +1,448 @@
+/***************************************************************************
+* Copyright (c) 2017, Sylvain Corlay and Johan Mabille                     *
+*                                                                          *
+* Distributed under the terms of the BSD 3-Clause License.                 *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#ifndef XPLOT_HISTOGRAM_HPP
+#define XPLOT_HISTOGRAM_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <mutex>
+#include <vector>
+
+#include "xparallel.hpp"
+
+namespace xpl
+{
+    /**************************
+     * histogram declarations *
+     **************************/
+
+    template <class T>
+    bool histogram_range(const T* values, std::size_t size, double& min, double& max);
+
+    template <class T>
+    void histogram_counts(const T* values, std::size_t size, double min, double max,
+                          std::size_t bins, std::vector<double>& counts);
+
+    void histogram_midpoints(double min, double max, std::size_t bins, std::vector<double>& midpoints);
+
+    void normalize_histogram(double min, double max, std::vector<double>& counts);
+
+    /************************************
+     * xstreaming_histogram declaration *
+     ************************************/
+
+    /**
+     * Histogram with fixed bins updated by batches of samples.
+     *
+     * By default the counts accumulate all the samples. They can instead
+     * be exponentially decayed with a given half-life, or restricted to a
+     * sliding time window, which is split into slots holding their own
+     * counts so that expiring a slot does not require the samples. Each
+     * update reports the bins whose count changed.
+     */
+    class xstreaming_histogram
+    {
+    public:
+
+        using clock_type = std::chrono::steady_clock;
+        using time_point = clock_type::time_point;
+        using duration = clock_type::duration;
+
+        xstreaming_histogram() = default;
+        xstreaming_histogram(double min, double max, std::size_t bins);
+
+        void set_decay(duration half_life);
+        void set_window(duration window, std::size_t nb_slots = 16);
+
+        template <class T>
+        void add(const T* values, std::size_t size, time_point now, std::vector<std::size_t>& changed);
+
+        void advance(time_point now, std::vector<std::size_t>& changed);
+        void resize(std::size_t bins);
+        void reset();
+
+        double min() const noexcept;
+        double max() const noexcept;
+        std::size_t bins() const noexcept;
+        std::size_t dropped() const noexcept;
+        const std::vector<double>& counts() const noexcept;
+
+    private:
+
+        void expire(time_point now, std::vector<std::size_t>& changed);
+        void clear_changed(const std::vector<std::size_t>& changed, std::size_t first);
+        void mark_changed(std::size_t bin, std::vector<std::size_t>& changed);
+        void mark_nonzero_changed(const std::vector<double>& counts, std::vector<std::size_t>& changed);
+
+        double m_min = 0.;
+        double m_max = 1.;
+        std::vector<double> m_counts;
+        std::vector<char> m_changed;
+        std::size_t m_dropped = 0;
+
+        duration m_half_life = duration::zero();
+        time_point m_last_decay;
+        bool m_started = false;
+
+        duration m_slot_duration = duration::zero();
+        std::vector<std::vector<double>> m_slots;
+        std::size_t m_current_slot = 0;
+        time_point m_slot_end;
+    };
+
+    /****************************
+     * histogram implementation *
+     ****************************/
+
+    namespace detail
+    {
+        // Number of samples processed by a task of the histogram kernels.
+        constexpr std::size_t histogram_grain = std::size_t(1) << 16;
+
+        // Samples are binned by batches: the bin indices of a batch are
+        // computed first, in a loop free of dependencies that the
+        // compiler can vectorize, then the counts are incremented.
+        constexpr std::size_t histogram_batch = 256;
+
+        inline std::size_t histogram_bin(double value, double min, double scale, std::size_t bins) noexcept
+        {
+            double pos = (value - min) * scale;
+            std::size_t bin = static_cast<std::size_t>(pos < 0. ? 0. : pos);
+            return bin < bins ? bin : bins - 1;
+        }
+
+        template <class T>
+        inline void accumulate_histogram(const T* values, std::size_t first, std::size_t last,
+                                         double min, double max, std::size_t bins, std::vector<double>& counts)
+        {
+            double scale = max > min ? static_cast<double>(bins) / (max - min) : 0.;
+            std::size_t indices[histogram_batch];
+            bool inside[histogram_batch];
+            for (std::size_t begin = first; begin < last; begin += histogram_batch)
+            {
+                std::size_t n = (std::min)(histogram_batch, last - begin);
+                for (std::size_t i = 0; i < n; ++i)
+                {
+                    double v = static_cast<double>(values[begin + i]);
+                    // false for NaNs and values out of [min, max]
+                    inside[i] = v >= min && v <= max;
+                    indices[i] = histogram_bin(inside[i] ? v : min, min, scale, bins);
+                }
+                for (std::size_t i = 0; i < n; ++i)
+                {
+                    counts[indices[i]] += inside[i] ? 1. : 0.;
+                }
+            }
+        }
+    }
+
+    /**
+     * Computes the range of the finite values, returns false if there is
+     * none.
+     */
+    template <class T>
+    inline bool histogram_range(const T* values, std::size_t size, double& min, double& max)
+    {
+        double lo = std::numeric_limits<double>::infinity();
+        double hi = -lo;
+        std::mutex mutex;
+        parallel_for(0, size, detail::histogram_grain, [values, &lo, &hi, &mutex](std::size_t first, std::size_t last) {
+            double local_lo = std::numeric_limits<double>::infinity();
+            double local_hi = -local_lo;
+            for (std::size_t i = first; i < last; ++i)
+            {
+                double v = static_cast<double>(values[i]);
+                bool finite = v - v == 0.;
+                local_lo = finite && v < local_lo ? v : local_lo;
+                local_hi = finite && v > local_hi ? v : local_hi;
+            }
+            std::lock_guard<std::mutex> lock(mutex);
+            lo = (std::min)(lo, local_lo);
+            hi = (std::max)(hi, local_hi);
+        });
+        if (lo > hi)
+        {
+            return false;
+        }
+        min = lo;
+        max = hi;
+        return true;
+    }
+
+    /**
+     * Counts the values in bins equal-width bins over [min, max]. As with
+     * numpy, the last bin includes max; NaNs and values out of the range
+     * are ignored. Each task fills its own counts, which are then summed.
+     */
+    template <class T>
+    inline void histogram_counts(const T* values, std::size_t size, double min, double max,
+                                 std::size_t bins, std::vector<double>& counts)
+    {
+        counts.assign(bins, 0.);
+        if (bins == 0)
+        {
+            return;
+        }
+        std::mutex mutex;
+        parallel_for(0, size, detail::histogram_grain, [&](std::size_t first, std::size_t last) {
+            std::vector<double> local(bins, 0.);
+            detail::accumulate_histogram(values, first, last, min, max, bins, local);
+            std::lock_guard<std::mutex> lock(mutex);
+            for (std::size_t i = 0; i < bins; ++i)
+            {
+                counts[i] += local[i];
+            }
+        });
+    }
+
+    inline void histogram_midpoints(double min, double max, std::size_t bins, std::vector<double>& midpoints)
+    {
+        midpoints.resize(bins);
+        double width = bins != 0 ? (max - min) / static_cast<double>(bins) : 0.;
+        for (std::size_t i = 0; i < bins; ++i)
+        {
+            midpoints[i] = min + (static_cast<double>(i) + 0.5) * width;
+        }
+    }
+
+    /**
+     * Turns counts into a probability density, so that the area of the
+     * histogram is 1.
+     */
+    inline void normalize_histogram(double min, double max, std::vector<double>& counts)
+    {
+        double total = 0.;
+        for (double c : counts)
+        {
+            total += c;
+        }
+        double width = counts.empty() ? 0. : (max - min) / static_cast<double>(counts.size());
+        double factor = total * width;
+        if (factor > 0.)
+        {
+            for (double& c : counts)
+            {
+                c /= factor;
+            }
+        }
+    }
+
+    /***************************************
+     * xstreaming_histogram implementation *
+     ***************************************/
+
+    inline xstreaming_histogram::xstreaming_histogram(double min, double max, std::size_t bins)
+        : m_min(min), m_max(max), m_counts((std::max)(bins, std::size_t(1)), 0.), m_changed(m_counts.size(), 0)
+    {
+    }
+
+    /**
+     * Decays the counts by half every half_life; a zero half-life disables
+     * the decay. Clears the counts and disables the sliding window.
+     */
+    inline void xstreaming_histogram::set_decay(duration half_life)
+    {
+        m_slot_duration = duration::zero();
+        m_slots.clear();
+        m_half_life = half_life;
+        reset();
+    }
+
+    /**
+     * Only counts the samples added during the last window, with the
+     * resolution of window / nb_slots; a zero window disables it. Clears
+     * the counts and disables the decay.
+     */
+    inline void xstreaming_histogram::set_window(duration window, std::size_t nb_slots)
+    {
+        m_half_life = duration::zero();
+        nb_slots = (std::max)(nb_slots, std::size_t(1));
+        m_slot_duration = window / static_cast<duration::rep>(nb_slots);
+        m_slots.assign(m_slot_duration > duration::zero() ? nb_slots : 0, std::vector<double>(m_counts.size(), 0.));
+        reset();
+    }
+
+    /**
+     * Adds size samples at time now and appends the bins whose count
+     * changed to changed. Without decay, this costs O(size) plus O(bins)
+     * per expired slot of the window.
+     */
+    template <class T>
+    inline void xstreaming_histogram::add(const T* values, std::size_t size, time_point now, std::vector<std::size_t>& changed)
+    {
+        std::size_t first = changed.size();
+        expire(now, changed);
+        std::size_t nb_bins = m_counts.size();
+        double scale = m_max > m_min ? static_cast<double>(nb_bins) / (m_max - m_min) : 0.;
+        std::vector<double>* slot = m_slots.empty() ? nullptr : &m_slots[m_current_slot];
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            double v = static_cast<double>(values[i]);
+            if (!(v >= m_min && v <= m_max))
+            {
+                ++m_dropped;
+                continue;
+            }
+            std::size_t bin = detail::histogram_bin(v, m_min, scale, nb_bins);
+            m_counts[bin] += 1.;
+            if (slot != nullptr)
+            {
+                (*slot)[bin] += 1.;
+            }
+            mark_changed(bin, changed);
+        }
+        clear_changed(changed, first);
+    }
+
+    /**
+     * Applies the decay or expires the slots of the window up to now, and
+     * appends the bins whose count changed to changed.
+     */
+    inline void xstreaming_histogram::advance(time_point now, std::vector<std::size_t>& changed)
+    {
+        std::size_t first = changed.size();
+        expire(now, changed);
+        clear_changed(changed, first);
+    }
+
+    /**
+     * Changes the number of bins and clears the counts.
+     */
+    inline void xstreaming_histogram::resize(std::size_t bins)
+    {
+        bins = (std::max)(bins, std::size_t(1));
+        m_counts.resize(bins);
+        m_changed.assign(bins, 0);
+        for (auto& slot : m_slots)
+        {
+            slot.resize(bins);
+        }
+        reset();
+    }
+
+    inline void xstreaming_histogram::reset()
+    {
+        std::fill(m_counts.begin(), m_counts.end(), 0.);
+        for (auto& slot : m_slots)
+        {
+            std::fill(slot.begin(), slot.end(), 0.);
+        }
+        m_current_slot = 0;
+        m_dropped = 0;
+        m_started = false;
+    }
+
+    inline double xstreaming_histogram::min() const noexcept
+    {
+        return m_min;
+    }
+
+    inline double xstreaming_histogram::max() const noexcept
+    {
+        return m_max;
+    }
+
+    inline std::size_t xstreaming_histogram::bins() const noexcept
+    {
+        return m_counts.size();
+    }
+
+    /**
+     * Returns the number of samples which were out of [min, max] or NaN.
+     */
+    inline std::size_t xstreaming_histogram::dropped() const noexcept
+    {
+        return m_dropped;
+    }
+
+    inline const std::vector<double>& xstreaming_histogram::counts() const noexcept
+    {
+        return m_counts;
+    }
+
+    /**
+     * Applies the decay or expires the slots of the window up to now. The
+     * changed bins are flagged until clear_changed is called, so that a
+     * bin is reported once per add or advance.
+     */
+    inline void xstreaming_histogram::expire(time_point now, std::vector<std::size_t>& changed)
+    {
+        if (!m_started)
+        {
+            m_started = true;
+            m_last_decay = now;
+            m_slot_end = now + m_slot_duration;
+            return;
+        }
+
+        if (m_half_life > duration::zero() && now > m_last_decay)
+        {
+            double elapsed = std::chrono::duration<double>(now - m_last_decay).count();
+            double half_life = std::chrono::duration<double>(m_half_life).count();
+            double factor = std::exp2(-elapsed / half_life);
+            mark_nonzero_changed(m_counts, changed);
+            for (double& c : m_counts)
+            {
+                c *= factor;
+            }
+            m_last_decay = now;
+        }
+
+        if (!m_slots.empty() && now >= m_slot_end)
+        {
+            auto nb_elapsed = static_cast<std::size_t>((now - m_slot_end) / m_slot_duration) + 1;
+            std::size_t nb_expired = (std::min)(nb_elapsed, m_slots.size());
+            for (std::size_t k = 0; k < nb_expired; ++k)
+            {
+                m_current_slot = (m_current_slot + 1) % m_slots.size();
+                std::vector<double>& slot = m_slots[m_current_slot];
+                mark_nonzero_changed(slot, changed);
+                for (std::size_t bin = 0; bin < slot.size(); ++bin)
+                {
+                    m_counts[bin] -= slot[bin];
+                    slot[bin] = 0.;
+                }
+            }
+            m_slot_end += m_slot_duration * static_cast<duration::rep>(nb_elapsed);
+        }
+    }
+
+    inline void xstreaming_histogram::clear_changed(const std::vector<std::size_t>& changed, std::size_t first)
+    {
+        for (std::size_t i = first; i < changed.size(); ++i)
+        {
+            m_changed[changed[i]] = 0;
+        }
+    }
+
+    inline void xstreaming_histogram::mark_changed(std::size_t bin, std::vector<std::size_t>& changed)
+    {
+        if (!m_changed[bin])
+        {
+            m_changed[bin] = 1;
+            changed.push_back(bin);
+        }
+    }
+
+    inline void xstreaming_histogram::mark_nonzero_changed(const std::vector<double>& counts, std::vector<std::size_t>& changed)
+    {
+        for (std::size_t bin = 0; bin < counts.size(); ++bin)
+        {
+            if (counts[bin] != 0.)
+            {
+                mark_changed(bin, changed);
+            }
+        }
+    }
+}
+
+#endif
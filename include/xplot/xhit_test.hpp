@@ -0,0 +1,232 @@
+/***************************************************************************
+* Copyright (c) 2017, Sylvain Corlay and Johan Mabille                     *
+*                                                                          *
+* Distributed under the terms of the BSD 3-Clause License.                 *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#ifndef XPLOT_HIT_TEST_HPP
+#define XPLOT_HIT_TEST_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+namespace xpl
+{
+    /**************************
+     * hit tests declarations *
+     **************************/
+
+    template <class T>
+    std::vector<int> select_interval(const T* values, std::size_t size, double bound1, double bound2);
+
+    template <class T>
+    std::vector<int> select_rectangle(const T* x, const T* y, std::size_t size,
+                                      double x1, double x2, double y1, double y2);
+
+    template <class T>
+    std::vector<int> select_polygon(const T* x, const T* y, std::size_t size,
+                                    const std::vector<double>& vertices_x, const std::vector<double>& vertices_y);
+
+    /****************************
+     * hit tests implementation *
+     ****************************/
+
+    namespace detail
+    {
+        // Points are tested by blocks: a mask is computed for the block by
+        // loops without branches, which are vectorized, and the indices of
+        // the selected points are then appended.
+        constexpr std::size_t hit_test_block_size = 1024;
+
+        using hit_mask_type = unsigned char[hit_test_block_size];
+
+        inline void append_hits(const hit_mask_type& mask, std::size_t first, std::size_t size, std::vector<int>& res)
+        {
+            std::size_t count = res.size();
+            res.resize(count + size);
+            int* out = res.data();
+            for (std::size_t i = 0; i < size; ++i)
+            {
+                out[count] = static_cast<int>(first + i);
+                count += mask[i];
+            }
+            res.resize(count);
+        }
+
+        template <class T>
+        inline std::size_t interval_mask(const T* values, std::size_t size, double min, double max,
+                                         hit_mask_type& mask) noexcept
+        {
+            std::size_t count = 0;
+            for (std::size_t i = 0; i < size; ++i)
+            {
+                double v = static_cast<double>(values[i]);
+                unsigned char hit = (v >= min) & (v <= max);
+                mask[i] = hit;
+                count += hit;
+            }
+            return count;
+        }
+
+        template <class T>
+        inline std::size_t rectangle_mask(const T* x, const T* y, std::size_t size, double x_min, double x_max,
+                                          double y_min, double y_max, hit_mask_type& mask) noexcept
+        {
+            std::size_t count = 0;
+            for (std::size_t i = 0; i < size; ++i)
+            {
+                double px = static_cast<double>(x[i]);
+                double py = static_cast<double>(y[i]);
+                unsigned char hit = (px >= x_min) & (px <= x_max) & (py >= y_min) & (py <= y_max);
+                mask[i] = hit;
+                count += hit;
+            }
+            return count;
+        }
+
+        inline void check_hit_test_size(std::size_t size)
+        {
+            if (size > static_cast<std::size_t>(std::numeric_limits<int>::max()))
+            {
+                throw std::invalid_argument("hit tests are limited to INT_MAX points");
+            }
+        }
+    }
+
+    /**
+     * Returns the indices of the values in the interval bounded by bound1
+     * and bound2, in any order. NaN values are never selected.
+     */
+    template <class T>
+    inline std::vector<int> select_interval(const T* values, std::size_t size, double bound1, double bound2)
+    {
+        detail::check_hit_test_size(size);
+        double min = std::min(bound1, bound2);
+        double max = std::max(bound1, bound2);
+        std::vector<int> res;
+        detail::hit_mask_type mask;
+        for (std::size_t first = 0; first < size; first += detail::hit_test_block_size)
+        {
+            std::size_t n = std::min(detail::hit_test_block_size, size - first);
+            if (detail::interval_mask(values + first, n, min, max, mask) != 0)
+            {
+                detail::append_hits(mask, first, n, res);
+            }
+        }
+        return res;
+    }
+
+    /**
+     * Returns the indices of the points in the rectangle [x1, x2] x [y1, y2],
+     * whose bounds may be given in any order.
+     */
+    template <class T>
+    inline std::vector<int> select_rectangle(const T* x, const T* y, std::size_t size,
+                                             double x1, double x2, double y1, double y2)
+    {
+        detail::check_hit_test_size(size);
+        double x_min = std::min(x1, x2);
+        double x_max = std::max(x1, x2);
+        double y_min = std::min(y1, y2);
+        double y_max = std::max(y1, y2);
+        std::vector<int> res;
+        detail::hit_mask_type mask;
+        for (std::size_t first = 0; first < size; first += detail::hit_test_block_size)
+        {
+            std::size_t n = std::min(detail::hit_test_block_size, size - first);
+            if (detail::rectangle_mask(x + first, y + first, n, x_min, x_max, y_min, y_max, mask) != 0)
+            {
+                detail::append_hits(mask, first, n, res);
+            }
+        }
+        return res;
+    }
+
+    /**
+     * Returns the indices of the points inside the polygon, closed by the
+     * edge from its last vertex to the first one, with the even-odd rule.
+     *
+     * The points of a block are first tested against the bounding box of
+     * the polygon, and the crossing test of each edge is only run on the
+     * blocks having points in it.
+     */
+    template <class T>
+    inline std::vector<int> select_polygon(const T* x, const T* y, std::size_t size,
+                                           const std::vector<double>& vertices_x, const std::vector<double>& vertices_y)
+    {
+        detail::check_hit_test_size(size);
+        if (vertices_x.size() != vertices_y.size())
+        {
+            throw std::invalid_argument("the coordinates of the vertices must have the same size");
+        }
+        std::vector<int> res;
+        std::size_t nb_vertices = vertices_x.size();
+        if (nb_vertices < 3)
+        {
+            return res;
+        }
+
+        auto x_bounds = std::minmax_element(vertices_x.begin(), vertices_x.end());
+        auto y_bounds = std::minmax_element(vertices_y.begin(), vertices_y.end());
+
+        // x coordinate of the crossing of each edge with a horizontal line
+        // is x0 + (y - y0) * slope; horizontal edges never cross.
+        std::vector<double> slopes(nb_vertices);
+        for (std::size_t i = 0, j = nb_vertices - 1; i < nb_vertices; j = i++)
+        {
+            double dy = vertices_y[i] - vertices_y[j];
+            slopes[j] = dy != 0. ? (vertices_x[i] - vertices_x[j]) / dy : 0.;
+        }
+
+        detail::hit_mask_type mask;
+        detail::hit_mask_type inside;
+        for (std::size_t first = 0; first < size; first += detail::hit_test_block_size)
+        {
+            std::size_t n = std::min(detail::hit_test_block_size, size - first);
+            const T* bx = x + first;
+            const T* by = y + first;
+            if (detail::rectangle_mask(bx, by, n, *x_bounds.first, *x_bounds.second,
+                                       *y_bounds.first, *y_bounds.second, mask) == 0)
+            {
+                continue;
+            }
+
+            std::fill(inside, inside + n, static_cast<unsigned char>(0));
+            for (std::size_t j = 0; j < nb_vertices; ++j)
+            {
+                std::size_t k = j + 1 < nb_vertices ? j + 1 : 0;
+                double x0 = vertices_x[j];
+                double y0 = vertices_y[j];
+                double y1 = vertices_y[k];
+                double slope = slopes[j];
+                for (std::size_t i = 0; i < n; ++i)
+                {
+                    double px = static_cast<double>(bx[i]);
+                    double py = static_cast<double>(by[i]);
+                    unsigned char straddles = (y0 > py) != (y1 > py);
+                    unsigned char left = px < x0 + (py - y0) * slope;
+                    inside[i] ^= straddles & left;
+                }
+            }
+
+            std::size_t count = 0;
+            for (std::size_t i = 0; i < n; ++i)
+            {
+                mask[i] &= inside[i];
+                count += mask[i];
+            }
+            if (count != 0)
+            {
+                detail::append_hits(mask, first, n, res);
+            }
+        }
+        return res;
+    }
+}
+
+#endif
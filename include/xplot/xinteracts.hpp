@@ -9,11 +9,24 @@
 #ifndef XPLOT_INTERACTS_HPP
 #define XPLOT_INTERACTS_HPP
 
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
 #include <utility>
+#include <vector>
 
 #include "nlohmann/json.hpp"
 
+#include "xtl/xoptional.hpp"
+
+#include "xwidgets/xeither.hpp"
+
+#include "xhit_test.hpp"
+#include "xmarks.hpp"
 #include "xplot.hpp"
+#include "xscales.hpp"
 
 namespace nl = nlohmann;
 
@@ -88,6 +101,196 @@ namespace xpl
 
     using pan_zoom = xw::xmaterialize<xpan_zoom>;
 
+    /*************************
+     * xselector declaration *
+     *************************/
+
+    /**
+     * Base class of the selectors computing the selection of their marks
+     * in C++, on the full resolution data, rather than on the points held
+     * by the front-end. Unless stated otherwise, the selector owns the
+     * selection of its marks: the selected patches computed by the
+     * front-end views are ignored. The marks destroyed before the
+     * selector are skipped.
+     */
+    template <class D>
+    class xselector : public xinteraction<D>
+    {
+    public:
+
+        using base_type = xinteraction<D>;
+        using derived_type = D;
+
+        using marks_type = std::vector<xw::xholder<xmark>>;
+        using scale_type = xtl::xoptional<xw::xholder<xscale>>;
+        using hit_test_type = std::function<std::vector<int>(const double*, const double*, std::size_t)>;
+
+        void serialize_state(nl::json&, xeus::buffer_sequence&) const;
+        void apply_patch(const nl::json&, const xeus::buffer_sequence&);
+
+        template <class T>
+        void add_mark(xmark<T>& mark);
+        void clear_marks();
+
+        XPROPERTY(marks_type, derived_type, marks);
+
+    protected:
+
+        xselector() = default;
+
+        using base_type::base_type;
+
+        void select(const hit_test_type& hit_test) const;
+        void clear_selection() const;
+
+        bool m_owns_selection = true;
+
+    private:
+
+        struct target_type
+        {
+            std::weak_ptr<const void> lifetime;
+            std::function<void(const hit_test_type*)> select;
+        };
+
+        void select_targets(const hit_test_type* hit_test) const;
+
+        std::vector<target_type> m_targets;
+        std::shared_ptr<const void> m_owner = std::make_shared<char>();
+    };
+
+    /****************************************
+     * xbrush_interval_selector declaration *
+     ****************************************/
+
+    template <class D>
+    class xbrush_interval_selector : public xselector<D>
+    {
+    public:
+
+        using base_type = xselector<D>;
+        using derived_type = D;
+
+        using scale_type = typename base_type::scale_type;
+        using selected_type = std::vector<double>;
+
+        void serialize_state(nl::json&, xeus::buffer_sequence&) const;
+        void apply_patch(const nl::json&, const xeus::buffer_sequence&);
+
+        template <class P>
+        void notify(const P& property) const;
+
+        XPROPERTY(scale_type, derived_type, scale);
+        XPROPERTY(selected_type, derived_type, selected);
+        XPROPERTY(std::string, derived_type, orientation, "horizontal", XEITHER("horizontal", "vertical"));
+        XPROPERTY(bool, derived_type, brushing, false);
+        XPROPERTY(xtl::xoptional<color_type>, derived_type, color);
+
+    protected:
+
+        xbrush_interval_selector();
+
+        using base_type::base_type;
+
+    private:
+
+        void set_defaults();
+        void update_selection() const;
+    };
+
+    using brush_interval_selector = xw::xmaterialize<xbrush_interval_selector>;
+
+    /*******************************
+     * xbrush_selector declaration *
+     *******************************/
+
+    template <class D>
+    class xbrush_selector : public xselector<D>
+    {
+    public:
+
+        using base_type = xselector<D>;
+        using derived_type = D;
+
+        using scale_type = typename base_type::scale_type;
+        using selected_type = std::vector<double>;
+
+        void serialize_state(nl::json&, xeus::buffer_sequence&) const;
+        void apply_patch(const nl::json&, const xeus::buffer_sequence&);
+
+        template <class P>
+        void notify(const P& property) const;
+
+        XPROPERTY(scale_type, derived_type, x_scale);
+        XPROPERTY(scale_type, derived_type, y_scale);
+        XPROPERTY(selected_type, derived_type, selected_x);
+        XPROPERTY(selected_type, derived_type, selected_y);
+        XPROPERTY(bool, derived_type, brushing, false);
+        XPROPERTY(bool, derived_type, clear, false);
+        XPROPERTY(xtl::xoptional<color_type>, derived_type, color);
+
+    protected:
+
+        xbrush_selector();
+
+        using base_type::base_type;
+
+    private:
+
+        void set_defaults();
+        void update_selection() const;
+    };
+
+    using brush_selector = xw::xmaterialize<xbrush_selector>;
+
+    /*******************************
+     * xlasso_selector declaration *
+     *******************************/
+
+    /**
+     * The front-end does not send the lasso, the selection is computed
+     * from the polygon set in vertices_x and vertices_y from C++. Since a
+     * lasso drawn in the front-end never reaches the server, the selector
+     * does not own the selection of its marks: the selection computed by
+     * the front-end view, on the points it holds, is kept.
+     */
+    template <class D>
+    class xlasso_selector : public xselector<D>
+    {
+    public:
+
+        using base_type = xselector<D>;
+        using derived_type = D;
+
+        using scale_type = typename base_type::scale_type;
+        using vertices_type = std::vector<double>;
+
+        void serialize_state(nl::json&, xeus::buffer_sequence&) const;
+        void apply_patch(const nl::json&, const xeus::buffer_sequence&);
+
+        template <class P>
+        void notify(const P& property) const;
+
+        XPROPERTY(scale_type, derived_type, x_scale);
+        XPROPERTY(scale_type, derived_type, y_scale);
+        XPROPERTY(vertices_type, derived_type, vertices_x);
+        XPROPERTY(vertices_type, derived_type, vertices_y);
+        XPROPERTY(xtl::xoptional<color_type>, derived_type, color);
+
+    protected:
+
+        xlasso_selector();
+
+        using base_type::base_type;
+
+    private:
+
+        void set_defaults();
+        void update_selection() const;
+    };
+
+    using lasso_selector = xw::xmaterialize<xlasso_selector>;
+
     /*******************************
      * xinteraction implementation *
      *******************************/
@@ -157,5 +360,374 @@ namespace xpl
         this->_view_name() = "PanZoom";
         this->_model_name() = "PanZoomModel";
     }
+
+    /****************************
+     * xselector implementation *
+     ****************************/
+
+    namespace detail
+    {
+        inline void set_selection(xtl::xoptional<std::vector<int>>& selected, std::vector<int>* indices)
+        {
+            if (indices != nullptr)
+            {
+                selected = std::move(*indices);
+            }
+            else
+            {
+                selected = xtl::missing<std::vector<int>>();
+            }
+        }
+
+        inline void set_selection(std::vector<int>& selected, std::vector<int>* indices)
+        {
+            selected = indices != nullptr ? std::move(*indices) : std::vector<int>();
+        }
+
+        template <class T>
+        inline void select_points(xmark<T>& mark, std::vector<int>* indices)
+        {
+            typename T::selected_type selected;
+            set_selection(selected, indices);
+            // Some marks hide the selected property of xmark.
+            static_cast<T&>(mark).selected = std::move(selected);
+        }
+
+        /**
+         * The front-end of a downsampled curve only holds a subset of its
+         * points, whose indices differ from the full resolution ones: the
+         * selection is kept in selected_points, and cleared on the
+         * front-end.
+         */
+        template <class T>
+        inline void select_points(xlines<T>& line, std::vector<int>* indices)
+        {
+            typename T::selected_type selected;
+            set_selection(selected, indices);
+            if (line.is_downsampled())
+            {
+                static_cast<T&>(line).selected = typename T::selected_type();
+            }
+            else
+            {
+                static_cast<T&>(line).selected = selected;
+            }
+            line.selected_points = std::move(selected);
+        }
+    }
+
+    template <class D>
+    inline void xselector<D>::apply_patch(const nl::json& patch, const xeus::buffer_sequence& buffers)
+    {
+        using xw::set_property_from_patch;
+        base_type::apply_patch(patch, buffers);
+        set_property_from_patch(marks, patch, buffers);
+    }
+
+    template <class D>
+    inline void xselector<D>::serialize_state(nl::json& state, xeus::buffer_sequence& buffers) const
+    {
+        using xw::xwidgets_serialize;
+        base_type::serialize_state(state, buffers);
+        xwidgets_serialize(marks, state["marks"], buffers);
+    }
+
+    /**
+     * Adds a mark whose x and y data are hit-tested by the selector. The
+     * indices of the points in the selection are written in its selected
+     * property, and in the selected_points property of the lines.
+     */
+    template <class D>
+    template <class T>
+    inline void xselector<D>::add_mark(xmark<T>& mark)
+    {
+        T* target = &static_cast<T&>(mark);
+        auto select = [target](const hit_test_type* hit_test) {
+            if (hit_test != nullptr)
+            {
+                std::size_t size = std::min(target->x().size(), target->y().size());
+                std::vector<int> indices = (*hit_test)(target->x().data(), target->y().data(), size);
+                detail::select_points(*target, &indices);
+            }
+            else
+            {
+                detail::select_points(*target, nullptr);
+            }
+        };
+        m_targets.push_back({mark.lifetime(), std::move(select)});
+        if (m_owns_selection)
+        {
+            mark.add_selection_owner(m_owner);
+        }
+        this->marks().emplace_back(xw::make_id_holder<xmark>(mark.id()));
+        this->notify(marks);
+    }
+
+    template <class D>
+    inline void xselector<D>::clear_marks()
+    {
+        m_targets.clear();
+        m_owner = std::make_shared<char>();
+        this->marks = marks_type();
+    }
+
+    template <class D>
+    inline void xselector<D>::select(const hit_test_type& hit_test) const
+    {
+        select_targets(&hit_test);
+    }
+
+    template <class D>
+    inline void xselector<D>::clear_selection() const
+    {
+        select_targets(nullptr);
+    }
+
+    template <class D>
+    inline void xselector<D>::select_targets(const hit_test_type* hit_test) const
+    {
+        for (const auto& target : m_targets)
+        {
+            if (!target.lifetime.expired())
+            {
+                target.select(hit_test);
+            }
+        }
+    }
+
+    /*******************************************
+     * xbrush_interval_selector implementation *
+     *******************************************/
+
+    template <class D>
+    inline void xbrush_interval_selector<D>::apply_patch(const nl::json& patch, const xeus::buffer_sequence& buffers)
+    {
+        using xw::set_property_from_patch;
+        base_type::apply_patch(patch, buffers);
+        set_property_from_patch(scale, patch, buffers);
+        set_property_from_patch(selected, patch, buffers);
+        set_property_from_patch(orientation, patch, buffers);
+        set_property_from_patch(brushing, patch, buffers);
+        set_property_from_patch(color, patch, buffers);
+    }
+
+    template <class D>
+    inline void xbrush_interval_selector<D>::serialize_state(nl::json& state, xeus::buffer_sequence& buffers) const
+    {
+        using xw::xwidgets_serialize;
+        base_type::serialize_state(state, buffers);
+        xwidgets_serialize(scale, state["scale"], buffers);
+        xwidgets_serialize(selected, state["selected"], buffers);
+        xwidgets_serialize(orientation, state["orientation"], buffers);
+        xwidgets_serialize(brushing, state["brushing"], buffers);
+        xwidgets_serialize(color, state["color"], buffers);
+    }
+
+    template <class D>
+    template <class P>
+    inline void xbrush_interval_selector<D>::notify(const P& property) const
+    {
+        base_type::notify(property);
+        const void* p = &property;
+        if (p == &selected || p == &orientation)
+        {
+            update_selection();
+        }
+    }
+
+    template <class D>
+    inline xbrush_interval_selector<D>::xbrush_interval_selector()
+        : base_type()
+    {
+        set_defaults();
+    }
+
+    template <class D>
+    inline void xbrush_interval_selector<D>::set_defaults()
+    {
+        this->_view_name() = "BrushIntervalSelector";
+        this->_model_name() = "BrushIntervalSelectorModel";
+    }
+
+    template <class D>
+    inline void xbrush_interval_selector<D>::update_selection() const
+    {
+        const selected_type& bounds = selected();
+        if (bounds.size() < 2)
+        {
+            this->clear_selection();
+            return;
+        }
+        double bound1 = bounds[0];
+        double bound2 = bounds[1];
+        bool horizontal = orientation() == "horizontal";
+        this->select([bound1, bound2, horizontal](const double* x, const double* y, std::size_t size) {
+            return select_interval(horizontal ? x : y, size, bound1, bound2);
+        });
+    }
+
+    /**********************************
+     * xbrush_selector implementation *
+     **********************************/
+
+    template <class D>
+    inline void xbrush_selector<D>::apply_patch(const nl::json& patch, const xeus::buffer_sequence& buffers)
+    {
+        using xw::set_property_from_patch;
+        base_type::apply_patch(patch, buffers);
+        set_property_from_patch(x_scale, patch, buffers);
+        set_property_from_patch(y_scale, patch, buffers);
+        set_property_from_patch(selected_x, patch, buffers);
+        set_property_from_patch(selected_y, patch, buffers);
+        set_property_from_patch(brushing, patch, buffers);
+        set_property_from_patch(clear, patch, buffers);
+        set_property_from_patch(color, patch, buffers);
+    }
+
+    template <class D>
+    inline void xbrush_selector<D>::serialize_state(nl::json& state, xeus::buffer_sequence& buffers) const
+    {
+        using xw::xwidgets_serialize;
+        base_type::serialize_state(state, buffers);
+        xwidgets_serialize(x_scale, state["x_scale"], buffers);
+        xwidgets_serialize(y_scale, state["y_scale"], buffers);
+        xwidgets_serialize(selected_x, state["selected_x"], buffers);
+        xwidgets_serialize(selected_y, state["selected_y"], buffers);
+        xwidgets_serialize(brushing, state["brushing"], buffers);
+        xwidgets_serialize(clear, state["clear"], buffers);
+        xwidgets_serialize(color, state["color"], buffers);
+    }
+
+    template <class D>
+    template <class P>
+    inline void xbrush_selector<D>::notify(const P& property) const
+    {
+        base_type::notify(property);
+        const void* p = &property;
+        if (p == &selected_x || p == &selected_y)
+        {
+            update_selection();
+        }
+    }
+
+    template <class D>
+    inline xbrush_selector<D>::xbrush_selector()
+        : base_type()
+    {
+        set_defaults();
+    }
+
+    template <class D>
+    inline void xbrush_selector<D>::set_defaults()
+    {
+        this->_view_name() = "BrushSelector";
+        this->_model_name() = "BrushSelectorModel";
+    }
+
+    /**
+     * A brush with a single dimension, when the selector has only one
+     * scale, selects an interval.
+     */
+    template <class D>
+    inline void xbrush_selector<D>::update_selection() const
+    {
+        const selected_type& xs = selected_x();
+        const selected_type& ys = selected_y();
+        bool has_x = xs.size() >= 2;
+        bool has_y = ys.size() >= 2;
+        if (has_x && has_y)
+        {
+            double x1 = xs[0], x2 = xs[1], y1 = ys[0], y2 = ys[1];
+            this->select([x1, x2, y1, y2](const double* x, const double* y, std::size_t size) {
+                return select_rectangle(x, y, size, x1, x2, y1, y2);
+            });
+        }
+        else if (has_x || has_y)
+        {
+            const selected_type& bounds = has_x ? xs : ys;
+            double bound1 = bounds[0], bound2 = bounds[1];
+            this->select([bound1, bound2, has_x](const double* x, const double* y, std::size_t size) {
+                return select_interval(has_x ? x : y, size, bound1, bound2);
+            });
+        }
+        else
+        {
+            this->clear_selection();
+        }
+    }
+
+    /**********************************
+     * xlasso_selector implementation *
+     **********************************/
+
+    template <class D>
+    inline void xlasso_selector<D>::apply_patch(const nl::json& patch, const xeus::buffer_sequence& buffers)
+    {
+        using xw::set_property_from_patch;
+        base_type::apply_patch(patch, buffers);
+        set_property_from_patch(x_scale, patch, buffers);
+        set_property_from_patch(y_scale, patch, buffers);
+        set_property_from_patch(vertices_x, patch, buffers);
+        set_property_from_patch(vertices_y, patch, buffers);
+        set_property_from_patch(color, patch, buffers);
+    }
+
+    template <class D>
+    inline void xlasso_selector<D>::serialize_state(nl::json& state, xeus::buffer_sequence& buffers) const
+    {
+        using xw::xwidgets_serialize;
+        base_type::serialize_state(state, buffers);
+        xwidgets_serialize(x_scale, state["x_scale"], buffers);
+        xwidgets_serialize(y_scale, state["y_scale"], buffers);
+        xwidgets_serialize(vertices_x, state["vertices_x"], buffers);
+        xwidgets_serialize(vertices_y, state["vertices_y"], buffers);
+        xwidgets_serialize(color, state["color"], buffers);
+    }
+
+    /**
+     * The selection is updated once both coordinates of the vertices have
+     * the same size, so that they can be set one after the other.
+     */
+    template <class D>
+    template <class P>
+    inline void xlasso_selector<D>::notify(const P& property) const
+    {
+        base_type::notify(property);
+        const void* p = &property;
+        if ((p == &vertices_x || p == &vertices_y) && vertices_x().size() == vertices_y().size())
+        {
+            update_selection();
+        }
+    }
+
+    template <class D>
+    inline xlasso_selector<D>::xlasso_selector()
+        : base_type()
+    {
+        set_defaults();
+    }
+
+    template <class D>
+    inline void xlasso_selector<D>::set_defaults()
+    {
+        this->m_owns_selection = false;
+        this->_view_name() = "LassoSelector";
+        this->_model_name() = "LassoSelectorModel";
+    }
+
+    template <class D>
+    inline void xlasso_selector<D>::update_selection() const
+    {
+        if (vertices_x().size() < 3)
+        {
+            this->clear_selection();
+            return;
+        }
+        const vertices_type& vx = vertices_x();
+        const vertices_type& vy = vertices_y();
+        this->select([&vx, &vy](const double* x, const double* y, std::size_t size) {
+            return select_polygon(x, y, size, vx, vy);
+        });
+    }
 }
 #endif
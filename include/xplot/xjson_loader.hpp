@@ -0,0 +1,525 @@
+/***************************************************************************
+* Copyright (c) 2017, Sylvain Corlay and Johan Mabille                     *
+*                                                                          *
+* Distributed under the terms of the BSD 3-Clause License.                 *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#ifndef XPLOT_JSON_LOADER_HPP
+#define XPLOT_JSON_LOADER_HPP
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "nlohmann/json.hpp"
+
+#include "xmapped_file.hpp"
+
+namespace nl = nlohmann;
+
+namespace xpl
+{
+    /**
+     * TopoJSON topology whose arcs are stored in flat arrays rather than
+     * in JSON arrays, which take an order of magnitude more memory.
+     *
+     * - header: the members of the topology other than arcs.
+     * - arc_offsets: the index of the first position of each arc,
+     *   followed by the number of positions.
+     * - arc_positions: the x, y pairs of the positions, as stored in the
+     *   file, i.e. delta-encoded when the topology is quantized. Other
+     *   dimensions of the positions are dropped.
+     */
+    struct xtopology
+    {
+        nl::json header = nl::json::object();
+        std::vector<std::size_t> arc_offsets = {0};
+        std::vector<double> arc_positions;
+
+        std::size_t arc_count() const noexcept;
+        nl::json to_topojson() const;
+    };
+
+    using xjson_columns = std::map<std::string, std::vector<double>>;
+
+    nl::json load_json_file(const std::string& path);
+
+    xtopology parse_topology(const char* first, const char* last);
+    xtopology load_topology_file(const std::string& path);
+
+    xjson_columns parse_json_columns(const char* first, const char* last);
+    xjson_columns load_json_columns(const std::string& path);
+
+    /****************************
+     * xtopology implementation *
+     ****************************/
+
+    inline std::size_t xtopology::arc_count() const noexcept
+    {
+        return arc_offsets.size() - 1;
+    }
+
+    /**
+     * Rebuilds the TopoJSON topology.
+     */
+    inline nl::json xtopology::to_topojson() const
+    {
+        bool quantized = header.count("transform") != 0;
+        nl::json res = header;
+        nl::json& arcs = res["arcs"] = nl::json::array();
+        for (std::size_t i = 0; i < arc_count(); ++i)
+        {
+            nl::json arc = nl::json::array();
+            for (std::size_t j = arc_offsets[i]; j < arc_offsets[i + 1]; ++j)
+            {
+                double x = arc_positions[2 * j];
+                double y = arc_positions[2 * j + 1];
+                if (quantized)
+                {
+                    arc.push_back({static_cast<std::int64_t>(x), static_cast<std::int64_t>(y)});
+                }
+                else
+                {
+                    arc.push_back({x, y});
+                }
+            }
+            arcs.push_back(std::move(arc));
+        }
+        return res;
+    }
+
+    /*******************************
+     * SAX handlers implementation *
+     *******************************/
+
+    namespace detail
+    {
+        /**
+         * SAX handler building a JSON document, used for the parts of the
+         * files which are not loaded in flat arrays.
+         */
+        class json_dom_builder
+        {
+        public:
+
+            explicit json_dom_builder(nl::json& root)
+                : m_root(root)
+            {
+            }
+
+            bool null()
+            {
+                add(nullptr);
+                return true;
+            }
+
+            bool boolean(bool value)
+            {
+                add(value);
+                return true;
+            }
+
+            bool number_integer(nl::json::number_integer_t value)
+            {
+                add(value);
+                return true;
+            }
+
+            bool number_unsigned(nl::json::number_unsigned_t value)
+            {
+                add(value);
+                return true;
+            }
+
+            bool number_float(nl::json::number_float_t value, const nl::json::string_t&)
+            {
+                add(value);
+                return true;
+            }
+
+            bool string(nl::json::string_t& value)
+            {
+                add(std::move(value));
+                return true;
+            }
+
+            bool binary(nl::json::binary_t& value)
+            {
+                add(nl::json::binary(std::move(value)));
+                return true;
+            }
+
+            bool start_object(std::size_t)
+            {
+                m_stack.push_back(add(nl::json::object()));
+                return true;
+            }
+
+            bool key(nl::json::string_t& value)
+            {
+                p_member = &(*m_stack.back())[value];
+                return true;
+            }
+
+            bool end_object()
+            {
+                m_stack.pop_back();
+                return true;
+            }
+
+            bool start_array(std::size_t)
+            {
+                m_stack.push_back(add(nl::json::array()));
+                return true;
+            }
+
+            bool end_array()
+            {
+                m_stack.pop_back();
+                return true;
+            }
+
+            std::size_t depth() const noexcept
+            {
+                return m_stack.size();
+            }
+
+        private:
+
+            // The value added last is the only one of its parent which may
+            // still be modified, so the pointers of the stack stay valid.
+            nl::json* add(nl::json value)
+            {
+                if (m_stack.empty())
+                {
+                    m_root = std::move(value);
+                    return &m_root;
+                }
+                nl::json& parent = *m_stack.back();
+                if (parent.is_array())
+                {
+                    parent.push_back(std::move(value));
+                    return &parent.back();
+                }
+                *p_member = std::move(value);
+                return p_member;
+            }
+
+            nl::json& m_root;
+            std::vector<nl::json*> m_stack;
+            nl::json* p_member = nullptr;
+        };
+
+        [[noreturn]] inline void throw_parse_error(const nl::json::exception& ex)
+        {
+            throw std::runtime_error(ex.what());
+        }
+
+        /**
+         * SAX handler of TopoJSON files, loading the arcs in flat arrays
+         * and the other members in a JSON document.
+         */
+        class topology_sax
+        {
+        public:
+
+            explicit topology_sax(xtopology& topology)
+                : m_topology(topology), m_dom(topology.header)
+            {
+            }
+
+            bool null()
+            {
+                return in_dom() ? m_dom.null() : invalid_arcs();
+            }
+
+            bool boolean(bool value)
+            {
+                return in_dom() ? m_dom.boolean(value) : invalid_arcs();
+            }
+
+            bool number_integer(nl::json::number_integer_t value)
+            {
+                return in_dom() ? m_dom.number_integer(value) : add_coordinate(static_cast<double>(value));
+            }
+
+            bool number_unsigned(nl::json::number_unsigned_t value)
+            {
+                return in_dom() ? m_dom.number_unsigned(value) : add_coordinate(static_cast<double>(value));
+            }
+
+            bool number_float(nl::json::number_float_t value, const nl::json::string_t& str)
+            {
+                return in_dom() ? m_dom.number_float(value, str) : add_coordinate(value);
+            }
+
+            bool string(nl::json::string_t& value)
+            {
+                return in_dom() ? m_dom.string(value) : invalid_arcs();
+            }
+
+            bool binary(nl::json::binary_t& value)
+            {
+                return in_dom() ? m_dom.binary(value) : invalid_arcs();
+            }
+
+            bool start_object(std::size_t size)
+            {
+                return in_dom() ? m_dom.start_object(size) : invalid_arcs();
+            }
+
+            bool key(nl::json::string_t& value)
+            {
+                if (m_level == 0 && m_dom.depth() == 1 && value == "arcs")
+                {
+                    m_arcs_pending = true;
+                    return true;
+                }
+                return m_dom.key(value);
+            }
+
+            bool end_object()
+            {
+                return m_dom.end_object();
+            }
+
+            bool start_array(std::size_t size)
+            {
+                if (in_dom())
+                {
+                    return m_dom.start_array(size);
+                }
+                m_arcs_pending = false;
+                if (++m_level > 3)
+                {
+                    return invalid_arcs();
+                }
+                m_dimension = 0;
+                return true;
+            }
+
+            bool end_array()
+            {
+                if (m_level == 0)
+                {
+                    return m_dom.end_array();
+                }
+                if (m_level == 3 && m_dimension < 2)
+                {
+                    return invalid_arcs();
+                }
+                if (m_level == 2)
+                {
+                    m_topology.arc_offsets.push_back(m_topology.arc_positions.size() / 2);
+                }
+                --m_level;
+                return true;
+            }
+
+            bool parse_error(std::size_t, const std::string&, const nl::json::exception& ex)
+            {
+                throw_parse_error(ex);
+            }
+
+        private:
+
+            bool in_dom() const noexcept
+            {
+                return m_level == 0 && !m_arcs_pending;
+            }
+
+            bool add_coordinate(double value)
+            {
+                if (m_level != 3 || m_arcs_pending)
+                {
+                    return invalid_arcs();
+                }
+                if (m_dimension++ < 2)
+                {
+                    m_topology.arc_positions.push_back(value);
+                }
+                return true;
+            }
+
+            [[noreturn]] bool invalid_arcs()
+            {
+                throw std::runtime_error("invalid TopoJSON arcs");
+            }
+
+            xtopology& m_topology;
+            json_dom_builder m_dom;
+            bool m_arcs_pending = false;
+            std::size_t m_level = 0;
+            std::size_t m_dimension = 0;
+        };
+
+        /**
+         * SAX handler of JSON column files: an object whose members are
+         * arrays of numbers, null values being loaded as NaN.
+         */
+        class columns_sax
+        {
+        public:
+
+            explicit columns_sax(xjson_columns& columns)
+                : m_columns(columns)
+            {
+            }
+
+            bool null()
+            {
+                return add(std::numeric_limits<double>::quiet_NaN());
+            }
+
+            bool boolean(bool)
+            {
+                return invalid();
+            }
+
+            bool number_integer(nl::json::number_integer_t value)
+            {
+                return add(static_cast<double>(value));
+            }
+
+            bool number_unsigned(nl::json::number_unsigned_t value)
+            {
+                return add(static_cast<double>(value));
+            }
+
+            bool number_float(nl::json::number_float_t value, const nl::json::string_t&)
+            {
+                return add(value);
+            }
+
+            bool string(nl::json::string_t&)
+            {
+                return invalid();
+            }
+
+            bool binary(nl::json::binary_t&)
+            {
+                return invalid();
+            }
+
+            bool start_object(std::size_t)
+            {
+                return m_level++ == 0 ? true : invalid();
+            }
+
+            bool key(nl::json::string_t& value)
+            {
+                p_column = &m_columns[value];
+                p_column->clear();
+                return true;
+            }
+
+            bool end_object()
+            {
+                --m_level;
+                return true;
+            }
+
+            bool start_array(std::size_t)
+            {
+                return m_level++ == 1 ? true : invalid();
+            }
+
+            bool end_array()
+            {
+                --m_level;
+                return true;
+            }
+
+            bool parse_error(std::size_t, const std::string&, const nl::json::exception& ex)
+            {
+                throw_parse_error(ex);
+            }
+
+        private:
+
+            bool add(double value)
+            {
+                if (m_level != 2)
+                {
+                    return invalid();
+                }
+                p_column->push_back(value);
+                return true;
+            }
+
+            [[noreturn]] bool invalid()
+            {
+                throw std::runtime_error("JSON column files must hold an object of numeric arrays");
+            }
+
+            xjson_columns& m_columns;
+            std::vector<double>* p_column = nullptr;
+            std::size_t m_level = 0;
+        };
+    }
+
+    /**************************
+     * loaders implementation *
+     **************************/
+
+    /**
+     * Parses a JSON file from its memory mapping, without copying it in
+     * memory first.
+     */
+    inline nl::json load_json_file(const std::string& path)
+    {
+        xmapped_file file(path);
+        return nl::json::parse(file.data(), file.data() + file.size());
+    }
+
+    /**
+     * Parses a TopoJSON topology with a SAX parser, the arcs being loaded
+     * straight into flat arrays.
+     */
+    inline xtopology parse_topology(const char* first, const char* last)
+    {
+        xtopology res;
+        detail::topology_sax handler(res);
+        nl::json::sax_parse(first, last, &handler);
+        if (!res.header.is_object() || res.header.value("type", std::string()) != "Topology")
+        {
+            throw std::invalid_argument("not a TopoJSON topology");
+        }
+        return res;
+    }
+
+    inline xtopology load_topology_file(const std::string& path)
+    {
+        xmapped_file file(path);
+        return parse_topology(file.data(), file.data() + file.size());
+    }
+
+    /**
+     * Parses a JSON column file, an object of numeric arrays such as
+     * {"x": [0, 1, 2], "y": [1.5, null, 3]}, with a SAX parser writing
+     * straight into the columns.
+     */
+    inline xjson_columns parse_json_columns(const char* first, const char* last)
+    {
+        xjson_columns res;
+        detail::columns_sax handler(res);
+        nl::json::sax_parse(first, last, &handler);
+        return res;
+    }
+
+    inline xjson_columns load_json_columns(const std::string& path)
+    {
+        xmapped_file file(path);
+        return parse_json_columns(file.data(), file.data() + file.size());
+    }
+}
+
+#endif
@@ -0,0 +1,1040 @@
+/***************************************************************************
+* Copyright (c) 2017, Sylvain Corlay and Johan Mabille                     *
+*                                                                          *
+* Distributed under the terms of the BSD 3-Clause License.                 *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#ifndef XPLOT_MAP_BINARY_HPP
+#define XPLOT_MAP_BINARY_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <sys/stat.h>
+
+#include "nlohmann/json.hpp"
+
+#include "xboxed_container.hpp"
+#include "xjson_loader.hpp"
+#include "xmapped_file.hpp"
+
+namespace nl = nlohmann;
+
+namespace xpl
+{
+    /**
+     * Options of the conversion of TopoJSON to the binary map format.
+     * Topologies which are not quantized are quantized on a grid of
+     * quantization x quantization points.
+     */
+    struct xbinary_map_options
+    {
+        std::size_t quantization = 100000;
+    };
+
+    /**
+     * Size and modification time of the TopoJSON file a binary map is
+     * converted from, stored in its header to check that it is up to date.
+     */
+    struct xmap_source
+    {
+        std::uint64_t size = 0;
+        std::int64_t mtime = 0;
+    };
+
+    bool map_source_status(const std::string& path, xmap_source& source);
+
+    void write_binary_map(const nl::json& topology, std::ostream& out,
+                          const xmap_source& source = xmap_source(),
+                          const xbinary_map_options& options = xbinary_map_options());
+
+    void write_binary_map(const xtopology& topology, std::ostream& out,
+                          const xmap_source& source = xmap_source(),
+                          const xbinary_map_options& options = xbinary_map_options());
+
+    void convert_map_file(const std::string& topojson_path, const std::string& binary_path,
+                          const xbinary_map_options& options = xbinary_map_options());
+
+    std::string binary_map_path(const std::string& topojson_path);
+
+    /***************************
+     * xbinary_map declaration *
+     ***************************/
+
+    /**
+     * Map in the binary map format. The arcs are read in place from the
+     * mapped file and can be sent to the front-end as typed buffers; the
+     * TopoJSON topology is only reconstructed on demand.
+     */
+    class xbinary_map
+    {
+    public:
+
+        explicit xbinary_map(const std::string& path);
+
+        bool has_transform() const noexcept;
+        const double* scale() const noexcept;
+        const double* translate() const noexcept;
+        const xmap_source& source() const noexcept;
+
+        std::size_t arc_count() const noexcept;
+        std::size_t point_count() const noexcept;
+        const std::uint32_t* arc_offsets() const noexcept;
+        const std::int32_t* points() const noexcept;
+
+        nl::json objects() const;
+        nl::json arcs() const;
+        nl::json to_topojson() const;
+
+        void serialize(nl::json& j, xeus::buffer_sequence& buffers) const;
+
+    private:
+
+        nl::json header_json() const;
+
+        xmapped_file m_file;
+        std::uint32_t m_flags;
+        double m_transform[4];
+        double m_bbox[4];
+        xmap_source m_source;
+        std::size_t m_arc_count;
+        std::size_t m_point_count;
+        const std::uint32_t* p_offsets;
+        const std::int32_t* p_points;
+        const char* p_objects;
+    };
+
+    bool read_binary_map_source(const std::string& path, xmap_source& source);
+
+    /************************************
+     * binary map format implementation *
+     ************************************/
+
+    namespace detail
+    {
+        constexpr char binary_map_magic[8] = {'X', 'P', 'L', 'M', 'A', 'P', '\0', '\0'};
+        constexpr std::uint32_t binary_map_version = 2;
+        constexpr std::uint32_t binary_map_transform = 1;
+        constexpr std::uint32_t binary_map_bbox = 2;
+        constexpr std::size_t binary_map_header_size = 104;
+        constexpr std::size_t binary_map_source_offset = 80;
+
+        enum class map_geometry_type : std::uint8_t
+        {
+            null,
+            point,
+            multi_point,
+            line_string,
+            multi_line_string,
+            polygon,
+            multi_polygon,
+            geometry_collection
+        };
+
+        enum class map_id_type : std::uint8_t
+        {
+            none,
+            integer,
+            number,
+            string,
+            null
+        };
+
+        inline map_geometry_type geometry_type(const nl::json& geometry)
+        {
+            auto it = geometry.find("type");
+            if (it == geometry.end() || it->is_null())
+            {
+                return map_geometry_type::null;
+            }
+            const std::string type = it->get<std::string>();
+            if (type == "Point")
+            {
+                return map_geometry_type::point;
+            }
+            if (type == "MultiPoint")
+            {
+                return map_geometry_type::multi_point;
+            }
+            if (type == "LineString")
+            {
+                return map_geometry_type::line_string;
+            }
+            if (type == "MultiLineString")
+            {
+                return map_geometry_type::multi_line_string;
+            }
+            if (type == "Polygon")
+            {
+                return map_geometry_type::polygon;
+            }
+            if (type == "MultiPolygon")
+            {
+                return map_geometry_type::multi_polygon;
+            }
+            if (type == "GeometryCollection")
+            {
+                return map_geometry_type::geometry_collection;
+            }
+            throw std::invalid_argument("unsupported geometry type: " + type);
+        }
+
+        inline const char* geometry_type_name(map_geometry_type type)
+        {
+            switch (type)
+            {
+            case map_geometry_type::point:
+                return "Point";
+            case map_geometry_type::multi_point:
+                return "MultiPoint";
+            case map_geometry_type::line_string:
+                return "LineString";
+            case map_geometry_type::multi_line_string:
+                return "MultiLineString";
+            case map_geometry_type::polygon:
+                return "Polygon";
+            case map_geometry_type::multi_polygon:
+                return "MultiPolygon";
+            case map_geometry_type::geometry_collection:
+                return "GeometryCollection";
+            default:
+                return nullptr;
+            }
+        }
+
+        /**
+         * Depth of the nested lists of arc indices of the geometry types
+         * made of arcs.
+         */
+        inline std::size_t arcs_depth(map_geometry_type type)
+        {
+            switch (type)
+            {
+            case map_geometry_type::line_string:
+                return 1;
+            case map_geometry_type::multi_line_string:
+            case map_geometry_type::polygon:
+                return 2;
+            case map_geometry_type::multi_polygon:
+                return 3;
+            default:
+                return 0;
+            }
+        }
+
+        inline bool is_geometry_member(const std::string& key)
+        {
+            return key == "type" || key == "id" || key == "properties" || key == "arcs" ||
+                key == "coordinates" || key == "geometries";
+        }
+
+        class binary_map_writer
+        {
+        public:
+
+            template <class T>
+            void write(T value)
+            {
+                char bytes[sizeof(T)];
+                std::memcpy(bytes, &value, sizeof(T));
+                if (!is_little_endian())
+                {
+                    std::reverse(bytes, bytes + sizeof(T));
+                }
+                m_bytes.append(bytes, sizeof(T));
+            }
+
+            void write_size(std::size_t size)
+            {
+                if (size > (std::numeric_limits<std::uint32_t>::max)())
+                {
+                    throw std::invalid_argument("map too large for the binary map format");
+                }
+                write(static_cast<std::uint32_t>(size));
+            }
+
+            void write_string(const std::string& str)
+            {
+                write_size(str.size());
+                m_bytes.append(str);
+            }
+
+            const std::string& bytes() const noexcept
+            {
+                return m_bytes;
+            }
+
+        private:
+
+            std::string m_bytes;
+        };
+
+        class binary_map_reader
+        {
+        public:
+
+            binary_map_reader(const char* first, const char* last)
+                : p_current(first), p_last(last)
+            {
+            }
+
+            template <class T>
+            T read()
+            {
+                check(sizeof(T));
+                char bytes[sizeof(T)];
+                std::memcpy(bytes, p_current, sizeof(T));
+                if (!is_little_endian())
+                {
+                    std::reverse(bytes, bytes + sizeof(T));
+                }
+                p_current += sizeof(T);
+                T value;
+                std::memcpy(&value, bytes, sizeof(T));
+                return value;
+            }
+
+            std::size_t read_size()
+            {
+                return read<std::uint32_t>();
+            }
+
+            std::string read_string()
+            {
+                std::size_t size = read_size();
+                check(size);
+                std::string str(p_current, size);
+                p_current += size;
+                return str;
+            }
+
+            const char* position() const noexcept
+            {
+                return p_current;
+            }
+
+        private:
+
+            void check(std::size_t size) const
+            {
+                if (static_cast<std::size_t>(p_last - p_current) < size)
+                {
+                    throw std::runtime_error("corrupted binary map");
+                }
+            }
+
+            const char* p_current;
+            const char* p_last;
+        };
+
+        /**
+         * Maps the coordinates of a topology which is not quantized to the
+         * quantization grid.
+         */
+        struct map_quantizer
+        {
+            bool enabled = false;
+            double scale[2] = {1., 1.};
+            double translate[2] = {0., 0.};
+
+            double operator()(double value, std::size_t dim) const
+            {
+                return enabled ? std::round((value - translate[dim]) / scale[dim]) : value;
+            }
+        };
+
+        inline void write_arc_list(const nl::json& arcs, std::size_t depth, binary_map_writer& writer)
+        {
+            writer.write_size(arcs.size());
+            for (const auto& item : arcs)
+            {
+                if (depth == 1)
+                {
+                    writer.write(item.get<std::int32_t>());
+                }
+                else
+                {
+                    write_arc_list(item, depth - 1, writer);
+                }
+            }
+        }
+
+        inline void write_position(const nl::json& position, const map_quantizer& quantizer, binary_map_writer& writer)
+        {
+            writer.write_size(position.size());
+            for (std::size_t i = 0; i < position.size(); ++i)
+            {
+                double value = position[i].get<double>();
+                writer.write(i < 2 ? quantizer(value, i) : value);
+            }
+        }
+
+        inline void write_geometry(const nl::json& geometry, const map_quantizer& quantizer, binary_map_writer& writer)
+        {
+            map_geometry_type type = geometry_type(geometry);
+            writer.write(static_cast<std::uint8_t>(type));
+
+            auto id = geometry.find("id");
+            if (id == geometry.end())
+            {
+                writer.write(static_cast<std::uint8_t>(map_id_type::none));
+            }
+            else if (id->is_null())
+            {
+                writer.write(static_cast<std::uint8_t>(map_id_type::null));
+            }
+            else if (id->is_number_integer())
+            {
+                writer.write(static_cast<std::uint8_t>(map_id_type::integer));
+                writer.write(id->get<std::int64_t>());
+            }
+            else if (id->is_number())
+            {
+                writer.write(static_cast<std::uint8_t>(map_id_type::number));
+                writer.write(id->get<double>());
+            }
+            else
+            {
+                writer.write(static_cast<std::uint8_t>(map_id_type::string));
+                writer.write_string(id->is_string() ? id->get<std::string>() : id->dump());
+            }
+
+            auto properties = geometry.find("properties");
+            writer.write_string(properties == geometry.end() ? std::string() : properties->dump());
+
+            nl::json members = nl::json::object();
+            for (auto it = geometry.begin(); it != geometry.end(); ++it)
+            {
+                if (!is_geometry_member(it.key()))
+                {
+                    members[it.key()] = it.value();
+                }
+            }
+            writer.write_string(members.empty() ? std::string() : members.dump());
+
+            switch (type)
+            {
+            case map_geometry_type::null:
+                break;
+            case map_geometry_type::point:
+                write_position(geometry.at("coordinates"), quantizer, writer);
+                break;
+            case map_geometry_type::multi_point:
+            {
+                const nl::json& coordinates = geometry.at("coordinates");
+                writer.write_size(coordinates.size());
+                for (const auto& position : coordinates)
+                {
+                    write_position(position, quantizer, writer);
+                }
+                break;
+            }
+            case map_geometry_type::geometry_collection:
+            {
+                const nl::json& geometries = geometry.at("geometries");
+                writer.write_size(geometries.size());
+                for (const auto& child : geometries)
+                {
+                    write_geometry(child, quantizer, writer);
+                }
+                break;
+            }
+            default:
+                write_arc_list(geometry.at("arcs"), arcs_depth(type), writer);
+                break;
+            }
+        }
+
+        inline nl::json read_arc_list(binary_map_reader& reader, std::size_t depth)
+        {
+            std::size_t size = reader.read_size();
+            nl::json::array_t res;
+            res.reserve(size);
+            for (std::size_t i = 0; i < size; ++i)
+            {
+                if (depth == 1)
+                {
+                    res.emplace_back(reader.read<std::int32_t>());
+                }
+                else
+                {
+                    res.emplace_back(read_arc_list(reader, depth - 1));
+                }
+            }
+            return res;
+        }
+
+        inline nl::json read_position(binary_map_reader& reader)
+        {
+            std::size_t size = reader.read_size();
+            nl::json::array_t res;
+            res.reserve(size);
+            for (std::size_t i = 0; i < size; ++i)
+            {
+                double value = reader.read<double>();
+                double integral;
+                if (std::modf(value, &integral) == 0. && std::abs(value) < 9007199254740992.)
+                {
+                    res.emplace_back(static_cast<std::int64_t>(value));
+                }
+                else
+                {
+                    res.emplace_back(value);
+                }
+            }
+            return res;
+        }
+
+        inline nl::json read_geometry(binary_map_reader& reader)
+        {
+            map_geometry_type type = static_cast<map_geometry_type>(reader.read<std::uint8_t>());
+            nl::json res = nl::json::object();
+            const char* name = geometry_type_name(type);
+            res["type"] = name != nullptr ? nl::json(name) : nl::json(nullptr);
+
+            switch (static_cast<map_id_type>(reader.read<std::uint8_t>()))
+            {
+            case map_id_type::none:
+                break;
+            case map_id_type::integer:
+                res["id"] = reader.read<std::int64_t>();
+                break;
+            case map_id_type::number:
+                res["id"] = reader.read<double>();
+                break;
+            case map_id_type::string:
+                res["id"] = reader.read_string();
+                break;
+            case map_id_type::null:
+                res["id"] = nullptr;
+                break;
+            default:
+                throw std::runtime_error("corrupted binary map");
+            }
+
+            std::string properties = reader.read_string();
+            if (!properties.empty())
+            {
+                res["properties"] = nl::json::parse(properties);
+            }
+            std::string members = reader.read_string();
+            if (!members.empty())
+            {
+                res.update(nl::json::parse(members));
+            }
+
+            switch (type)
+            {
+            case map_geometry_type::null:
+                break;
+            case map_geometry_type::point:
+                res["coordinates"] = read_position(reader);
+                break;
+            case map_geometry_type::multi_point:
+            {
+                std::size_t size = reader.read_size();
+                nl::json::array_t coordinates;
+                for (std::size_t i = 0; i < size; ++i)
+                {
+                    coordinates.emplace_back(read_position(reader));
+                }
+                res["coordinates"] = std::move(coordinates);
+                break;
+            }
+            case map_geometry_type::geometry_collection:
+            {
+                std::size_t size = reader.read_size();
+                nl::json::array_t geometries;
+                for (std::size_t i = 0; i < size; ++i)
+                {
+                    geometries.emplace_back(read_geometry(reader));
+                }
+                res["geometries"] = std::move(geometries);
+                break;
+            }
+            case map_geometry_type::line_string:
+            case map_geometry_type::multi_line_string:
+            case map_geometry_type::polygon:
+            case map_geometry_type::multi_polygon:
+                res["arcs"] = read_arc_list(reader, arcs_depth(type));
+                break;
+            default:
+                throw std::runtime_error("corrupted binary map");
+            }
+            return res;
+        }
+
+        /**
+         * Computes the quantization grid of the positions of arcs holding
+         * absolute coordinates.
+         */
+        inline map_quantizer make_quantizer(const std::vector<double>& positions, std::size_t quantization)
+        {
+            map_quantizer res;
+            double lower[2] = {std::numeric_limits<double>::infinity(), std::numeric_limits<double>::infinity()};
+            double upper[2] = {-std::numeric_limits<double>::infinity(), -std::numeric_limits<double>::infinity()};
+            for (std::size_t i = 0; i < positions.size(); ++i)
+            {
+                std::size_t dim = i % 2;
+                lower[dim] = (std::min)(lower[dim], positions[i]);
+                upper[dim] = (std::max)(upper[dim], positions[i]);
+            }
+            res.enabled = true;
+            for (std::size_t dim = 0; dim < 2; ++dim)
+            {
+                if (lower[dim] > upper[dim])
+                {
+                    lower[dim] = upper[dim] = 0.;
+                }
+                double extent = upper[dim] - lower[dim];
+                res.translate[dim] = lower[dim];
+                res.scale[dim] = extent > 0. && quantization > 1 ? extent / static_cast<double>(quantization - 1) : 1.;
+            }
+            return res;
+        }
+
+        inline std::int32_t to_int32(double value)
+        {
+            if (!(value >= (std::numeric_limits<std::int32_t>::min)() && value <= (std::numeric_limits<std::int32_t>::max)()) ||
+                std::round(value) != value)
+            {
+                throw std::invalid_argument("quantized arc coordinates must be 32-bit integers");
+            }
+            return static_cast<std::int32_t>(value);
+        }
+
+        inline void write_binary_map(const nl::json& topology, const std::vector<std::size_t>& arc_offsets,
+                                     const std::vector<double>& arc_positions, std::ostream& out,
+                                     const xmap_source& source, const xbinary_map_options& options)
+        {
+            if (topology.value("type", std::string()) != "Topology")
+            {
+                throw std::invalid_argument("not a TopoJSON topology");
+            }
+
+            auto transform = topology.find("transform");
+            bool quantized = transform != topology.end() && !transform->is_null();
+            map_quantizer quantizer;
+            if (!quantized)
+            {
+                quantizer = make_quantizer(arc_positions, options.quantization);
+            }
+
+            std::uint32_t flags = binary_map_transform;
+            double transform_values[4] = {quantizer.scale[0], quantizer.scale[1], quantizer.translate[0], quantizer.translate[1]};
+            if (quantized)
+            {
+                const nl::json& scale = transform->at("scale");
+                const nl::json& translate = transform->at("translate");
+                transform_values[0] = scale.at(0).get<double>();
+                transform_values[1] = scale.at(1).get<double>();
+                transform_values[2] = translate.at(0).get<double>();
+                transform_values[3] = translate.at(1).get<double>();
+            }
+            double bbox[4] = {0., 0., 0., 0.};
+            auto bbox_it = topology.find("bbox");
+            if (bbox_it != topology.end() && bbox_it->is_array() && bbox_it->size() == 4)
+            {
+                flags |= binary_map_bbox;
+                for (std::size_t i = 0; i < 4; ++i)
+                {
+                    bbox[i] = bbox_it->at(i).get<double>();
+                }
+            }
+
+            std::size_t arc_count = arc_offsets.size() - 1;
+            std::vector<std::uint32_t> offsets(arc_offsets.cbegin(), arc_offsets.cend());
+            std::vector<std::int32_t> points;
+            points.reserve(arc_positions.size());
+            for (std::size_t i = 0; i < arc_count; ++i)
+            {
+                std::int32_t previous[2] = {0, 0};
+                for (std::size_t j = 2 * arc_offsets[i]; j < 2 * arc_offsets[i + 1]; ++j)
+                {
+                    std::size_t dim = j % 2;
+                    if (quantized)
+                    {
+                        points.push_back(to_int32(arc_positions[j]));
+                    }
+                    else
+                    {
+                        std::int32_t current = to_int32(quantizer(arc_positions[j], dim));
+                        points.push_back(current - previous[dim]);
+                        previous[dim] = current;
+                    }
+                }
+            }
+
+            binary_map_writer writer;
+            for (char c : binary_map_magic)
+            {
+                writer.write(c);
+            }
+            writer.write(binary_map_version);
+            writer.write(flags);
+            for (double value : transform_values)
+            {
+                writer.write(value);
+            }
+            for (double value : bbox)
+            {
+                writer.write(value);
+            }
+            writer.write(source.size);
+            writer.write(source.mtime);
+            writer.write_size(arc_count);
+            writer.write_size(points.size() / 2);
+            for (std::uint32_t offset : offsets)
+            {
+                writer.write(offset);
+            }
+            for (std::int32_t value : points)
+            {
+                writer.write(value);
+            }
+
+            const nl::json& objects = topology.at("objects");
+            writer.write_size(objects.size());
+            for (auto it = objects.begin(); it != objects.end(); ++it)
+            {
+                writer.write_string(it.key());
+                write_geometry(it.value(), quantizer, writer);
+            }
+
+            const std::string& bytes = writer.bytes();
+            out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+        }
+    }
+
+    /**
+     * Writes the TopoJSON topology in the binary map format. source
+     * describes the TopoJSON file, to check that a binary map is up to
+     * date.
+     *
+     * All the values are little-endian. The header is followed by the
+     * arcs, stored as quantized and delta-encoded int32 points as in
+     * TopoJSON, and by the objects:
+     *
+     * - char[8] magic "XPLMAP\0\0", uint32 version, uint32 flags
+     *   (1: transform, 2: bbox)
+     * - float64 scale[2], translate[2] and bbox[4]
+     * - uint64 size and int64 modification time, in seconds since the
+     *   epoch, of the source TopoJSON file
+     * - uint32 number of arcs and number of points
+     * - uint32 offsets of the first point of each arc, followed by the
+     *   number of points
+     * - int32 x, y pairs of the points
+     * - uint32 number of objects, then the name and the geometry of each
+     *   object
+     *
+     * A geometry is its uint8 type, its id (uint8 tag followed by an
+     * int64, a float64 or a string), its properties and its other
+     * members, such as bbox, as JSON strings, empty when there are none,
+     * and its arcs, coordinates or child geometries. Lists and strings
+     * are prefixed by their uint32 size.
+     */
+    inline void write_binary_map(const nl::json& topology, std::ostream& out,
+                                 const xmap_source& source, const xbinary_map_options& options)
+    {
+        std::vector<std::size_t> arc_offsets = {0};
+        std::vector<double> arc_positions;
+        for (const auto& arc : topology.at("arcs"))
+        {
+            for (const auto& point : arc)
+            {
+                arc_positions.push_back(point.at(0).get<double>());
+                arc_positions.push_back(point.at(1).get<double>());
+            }
+            arc_offsets.push_back(arc_positions.size() / 2);
+        }
+        detail::write_binary_map(topology, arc_offsets, arc_positions, out, source, options);
+    }
+
+    /**
+     * Writes a topology loaded with load_topology_file in the binary map
+     * format, without building the JSON arrays of its arcs.
+     */
+    inline void write_binary_map(const xtopology& topology, std::ostream& out,
+                                 const xmap_source& source, const xbinary_map_options& options)
+    {
+        detail::write_binary_map(topology.header, topology.arc_offsets, topology.arc_positions,
+                                 out, source, options);
+    }
+
+    /**
+     * Converts the TopoJSON file to the binary map format. The file is
+     * parsed from its memory mapping with a SAX parser, so that large
+     * maps can be converted without holding their JSON arcs in memory.
+     */
+    inline void convert_map_file(const std::string& topojson_path, const std::string& binary_path,
+                                 const xbinary_map_options& options)
+    {
+        xmap_source source;
+        if (!map_source_status(topojson_path, source))
+        {
+            throw std::runtime_error("cannot open map file: " + topojson_path);
+        }
+        xmapped_file file(topojson_path);
+        xtopology topology = parse_topology(file.data(), file.data() + file.size());
+
+        std::ofstream out(binary_path, std::ios::binary | std::ios::trunc);
+        if (!out)
+        {
+            throw std::runtime_error("cannot write binary map file: " + binary_path);
+        }
+        write_binary_map(topology, out, source, options);
+        if (!out)
+        {
+            throw std::runtime_error("cannot write binary map file: " + binary_path);
+        }
+    }
+
+    /**
+     * Returns the path of the binary map converted from the TopoJSON
+     * file, with the .xmap extension.
+     */
+    inline std::string binary_map_path(const std::string& topojson_path)
+    {
+        std::size_t separator = topojson_path.find_last_of("/\\");
+        std::size_t dot = topojson_path.find_last_of('.');
+        if (dot == std::string::npos || (separator != std::string::npos && dot < separator))
+        {
+            return topojson_path + ".xmap";
+        }
+        return topojson_path.substr(0, dot) + ".xmap";
+    }
+
+    /**
+     * Reads the size and the modification time of the file at path,
+     * returns false if it cannot be accessed.
+     */
+    inline bool map_source_status(const std::string& path, xmap_source& source)
+    {
+        struct stat info;
+        if (::stat(path.c_str(), &info) != 0)
+        {
+            return false;
+        }
+        source.size = static_cast<std::uint64_t>(info.st_size);
+        source.mtime = static_cast<std::int64_t>(info.st_mtime);
+        return true;
+    }
+
+    /**
+     * Reads the description of the TopoJSON file stored in the header of
+     * the binary map, returns false if the file is not a binary map of
+     * the current version.
+     */
+    inline bool read_binary_map_source(const std::string& path, xmap_source& source)
+    {
+        std::ifstream in(path, std::ios::binary);
+        char header[detail::binary_map_header_size];
+        if (!in.read(header, sizeof(header)) || std::memcmp(header, detail::binary_map_magic, 8) != 0)
+        {
+            return false;
+        }
+        detail::binary_map_reader reader(header + 8, header + sizeof(header));
+        if (reader.read<std::uint32_t>() != detail::binary_map_version)
+        {
+            return false;
+        }
+        detail::binary_map_reader source_reader(header + detail::binary_map_source_offset, header + sizeof(header));
+        source.size = source_reader.read<std::uint64_t>();
+        source.mtime = source_reader.read<std::int64_t>();
+        return true;
+    }
+
+    /******************************
+     * xbinary_map implementation *
+     ******************************/
+
+    inline xbinary_map::xbinary_map(const std::string& path)
+        : m_file(path)
+    {
+        const char* first = m_file.data();
+        const char* last = first + m_file.size();
+        if (m_file.size() < detail::binary_map_header_size || std::memcmp(first, detail::binary_map_magic, 8) != 0)
+        {
+            throw std::runtime_error("not a binary map file: " + path);
+        }
+        if (!detail::is_little_endian())
+        {
+            throw std::runtime_error("binary maps are not supported on big-endian platforms");
+        }
+
+        detail::binary_map_reader reader(first + 8, last);
+        if (reader.read<std::uint32_t>() != detail::binary_map_version)
+        {
+            throw std::runtime_error("unsupported binary map version: " + path);
+        }
+        m_flags = reader.read<std::uint32_t>();
+        for (double& value : m_transform)
+        {
+            value = reader.read<double>();
+        }
+        for (double& value : m_bbox)
+        {
+            value = reader.read<double>();
+        }
+        m_source.size = reader.read<std::uint64_t>();
+        m_source.mtime = reader.read<std::int64_t>();
+        m_arc_count = reader.read_size();
+        m_point_count = reader.read_size();
+
+        // The arrays are 4-byte aligned since the header size is a
+        // multiple of 4 and the mapping is page-aligned.
+        const char* offsets = reader.position();
+        std::size_t arrays_size = (m_arc_count + 1) * sizeof(std::uint32_t) + 2 * m_point_count * sizeof(std::int32_t);
+        if (static_cast<std::size_t>(last - offsets) < arrays_size)
+        {
+            throw std::runtime_error("corrupted binary map: " + path);
+        }
+        p_offsets = reinterpret_cast<const std::uint32_t*>(offsets);
+        p_points = reinterpret_cast<const std::int32_t*>(offsets + (m_arc_count + 1) * sizeof(std::uint32_t));
+        p_objects = offsets + arrays_size;
+        if (p_offsets[m_arc_count] != m_point_count)
+        {
+            throw std::runtime_error("corrupted binary map: " + path);
+        }
+    }
+
+    inline bool xbinary_map::has_transform() const noexcept
+    {
+        return (m_flags & detail::binary_map_transform) != 0;
+    }
+
+    inline const double* xbinary_map::scale() const noexcept
+    {
+        return m_transform;
+    }
+
+    inline const double* xbinary_map::translate() const noexcept
+    {
+        return m_transform + 2;
+    }
+
+    inline const xmap_source& xbinary_map::source() const noexcept
+    {
+        return m_source;
+    }
+
+    inline std::size_t xbinary_map::arc_count() const noexcept
+    {
+        return m_arc_count;
+    }
+
+    inline std::size_t xbinary_map::point_count() const noexcept
+    {
+        return m_point_count;
+    }
+
+    /**
+     * Returns the offsets of the first point of each arc, followed by the
+     * number of points.
+     */
+    inline const std::uint32_t* xbinary_map::arc_offsets() const noexcept
+    {
+        return p_offsets;
+    }
+
+    /**
+     * Returns the x, y pairs of the quantized points of the arcs; the
+     * first point of an arc is absolute, the next ones are deltas.
+     */
+    inline const std::int32_t* xbinary_map::points() const noexcept
+    {
+        return p_points;
+    }
+
+    /**
+     * Reconstructs the objects of the TopoJSON topology.
+     */
+    inline nl::json xbinary_map::objects() const
+    {
+        detail::binary_map_reader reader(p_objects, m_file.data() + m_file.size());
+        nl::json res = nl::json::object();
+        std::size_t size = reader.read_size();
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            std::string name = reader.read_string();
+            res[name] = detail::read_geometry(reader);
+        }
+        return res;
+    }
+
+    /**
+     * Reconstructs the arcs of the TopoJSON topology.
+     */
+    inline nl::json xbinary_map::arcs() const
+    {
+        nl::json::array_t res;
+        res.reserve(m_arc_count);
+        for (std::size_t i = 0; i < m_arc_count; ++i)
+        {
+            nl::json::array_t arc;
+            arc.reserve(p_offsets[i + 1] - p_offsets[i]);
+            for (std::size_t k = p_offsets[i]; k < p_offsets[i + 1]; ++k)
+            {
+                arc.emplace_back(nl::json::array({p_points[2 * k], p_points[2 * k + 1]}));
+            }
+            res.emplace_back(std::move(arc));
+        }
+        return res;
+    }
+
+    inline nl::json xbinary_map::to_topojson() const
+    {
+        nl::json res = header_json();
+        res["objects"] = objects();
+        res["arcs"] = arcs();
+        return res;
+    }
+
+    /**
+     * Serializes the topology with its arcs as typed buffers: points is
+     * the int32 array of the quantized and delta-encoded points, with
+     * shape (points, 2), and offsets the uint32 offsets of the first
+     * point of each arc, followed by the number of points. The result is
+     * not a TopoJSON topology, maps only send it when their typed arcs
+     * are enabled.
+     */
+    inline void xbinary_map::serialize(nl::json& j, xeus::buffer_sequence& buffers) const
+    {
+        j = header_json();
+        j["objects"] = objects();
+        nl::json& arcs = j["arcs"];
+        arcs["encoding"] = "delta";
+        serialize_typed_buffer(p_points, {m_point_count, std::size_t(2)}, arcs["points"], buffers);
+        serialize_typed_buffer(p_offsets, m_arc_count + 1, arcs["offsets"], buffers);
+    }
+
+    inline nl::json xbinary_map::header_json() const
+    {
+        nl::json res = nl::json::object();
+        res["type"] = "Topology";
+        if (has_transform())
+        {
+            res["transform"] = {{"scale", {m_transform[0], m_transform[1]}},
+                                {"translate", {m_transform[2], m_transform[3]}}};
+        }
+        if ((m_flags & detail::binary_map_bbox) != 0)
+        {
+            res["bbox"] = {m_bbox[0], m_bbox[1], m_bbox[2], m_bbox[3]};
+        }
+        return res;
+    }
+}
+
+#endif
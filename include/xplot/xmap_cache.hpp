@@ -0,0 +1,252 @@
+/***************************************************************************
+* Copyright (c) 2017, Sylvain Corlay and Johan Mabille                     *
+*                                                                          *
+* Distributed under the terms of the BSD 3-Clause License.                 *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#ifndef XPLOT_MAP_CACHE_HPP
+#define XPLOT_MAP_CACHE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include <sys/stat.h>
+
+#include "nlohmann/json.hpp"
+
+#include "xjson_loader.hpp"
+#include "xmap_binary.hpp"
+#include "xmap_filter.hpp"
+
+namespace nl = nlohmann;
+
+namespace xpl
+{
+    /*****************************
+     * xmap_document declaration *
+     *****************************/
+
+    /**
+     * Immutable parsed map file, shared by the maps displaying it, so that
+     * the file is read and parsed once. A document loaded from a binary map
+     * only reconstructs its TopoJSON topology when data() is first called.
+     */
+    class xmap_document
+    {
+    public:
+
+        using binary_map_ptr = std::shared_ptr<const xbinary_map>;
+
+        explicit xmap_document(nl::json data);
+        explicit xmap_document(binary_map_ptr binary);
+
+        xmap_document(const xmap_document&) = delete;
+        xmap_document& operator=(const xmap_document&) = delete;
+
+        const nl::json& data() const;
+        const binary_map_ptr& binary() const noexcept;
+
+    private:
+
+        binary_map_ptr m_binary;
+        mutable nl::json m_data;
+        mutable std::once_flag m_data_flag;
+    };
+
+    using map_document_ptr = std::shared_ptr<const xmap_document>;
+
+    /**************************
+     * xmap_cache declaration *
+     **************************/
+
+    /**
+     * Process-wide cache of the parsed map files, keyed by their path and
+     * invalidated when their modification time or size changes. The cache
+     * can be used from several threads; a file loaded concurrently by two
+     * threads may be parsed twice, the last document being kept. Filtered
+     * topologies are cached as well, per file and filter.
+     */
+    class xmap_cache
+    {
+    public:
+
+        map_document_ptr load(const std::string& path, const xmap_filter& filter = xmap_filter());
+
+        void clear();
+        std::size_t size() const;
+
+    private:
+
+        struct entry
+        {
+            std::time_t mtime;
+            std::size_t file_size;
+            map_document_ptr document;
+        };
+
+        map_document_ptr find(const std::string& key, std::time_t mtime, std::size_t file_size) const;
+        void store(const std::string& key, std::time_t mtime, std::size_t file_size, map_document_ptr document);
+
+        static bool file_status(const std::string& path, std::time_t& mtime, std::size_t& file_size);
+        static map_document_ptr open_document(const std::string& path, std::time_t mtime, std::size_t file_size);
+
+        mutable std::mutex m_mutex;
+        std::map<std::string, entry> m_entries;
+    };
+
+    xmap_cache& get_map_cache();
+
+    /********************************
+     * xmap_document implementation *
+     ********************************/
+
+    inline xmap_document::xmap_document(nl::json data)
+        : m_data(std::move(data))
+    {
+    }
+
+    inline xmap_document::xmap_document(binary_map_ptr binary)
+        : m_binary(std::move(binary))
+    {
+    }
+
+    inline const nl::json& xmap_document::data() const
+    {
+        if (m_binary != nullptr)
+        {
+            std::call_once(m_data_flag, [this]() { m_data = m_binary->to_topojson(); });
+        }
+        return m_data;
+    }
+
+    /**
+     * Returns the binary map the document was loaded from, if any.
+     */
+    inline auto xmap_document::binary() const noexcept -> const binary_map_ptr&
+    {
+        return m_binary;
+    }
+
+    /*****************************
+     * xmap_cache implementation *
+     *****************************/
+
+    /**
+     * Returns the parsed document of the map file at path, parsing it only
+     * if it is not cached or if it changed since it was cached. A TopoJSON
+     * file is loaded from the binary map converted from it, with the same
+     * name and the .xmap extension, when it exists and is up to date. When
+     * filter is not empty, the document holds the filtered topology.
+     */
+    inline map_document_ptr xmap_cache::load(const std::string& path, const xmap_filter& filter)
+    {
+        std::time_t mtime;
+        std::size_t file_size;
+        if (!file_status(path, mtime, file_size))
+        {
+            throw std::runtime_error("cannot open map file: " + path);
+        }
+
+        std::string key = filter.empty() ? path : path + '\n' + filter.key();
+        map_document_ptr document = find(key, mtime, file_size);
+        if (document != nullptr)
+        {
+            return document;
+        }
+
+        // Parsing is done without holding the lock so that loading a large
+        // map does not block the other ones.
+        if (filter.empty())
+        {
+            document = open_document(path, mtime, file_size);
+        }
+        else
+        {
+            document = std::make_shared<const xmap_document>(filter_topology(load(path)->data(), filter));
+        }
+        store(key, mtime, file_size, document);
+        return document;
+    }
+
+    /**
+     * Removes the cached documents; they are released once the maps using
+     * them are destroyed.
+     */
+    inline void xmap_cache::clear()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_entries.clear();
+    }
+
+    inline std::size_t xmap_cache::size() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_entries.size();
+    }
+
+    inline map_document_ptr xmap_cache::find(const std::string& key, std::time_t mtime, std::size_t file_size) const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_entries.find(key);
+        if (it != m_entries.end() && it->second.mtime == mtime && it->second.file_size == file_size)
+        {
+            return it->second.document;
+        }
+        return nullptr;
+    }
+
+    inline void xmap_cache::store(const std::string& key, std::time_t mtime, std::size_t file_size, map_document_ptr document)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_entries[key] = entry{mtime, file_size, std::move(document)};
+    }
+
+    inline bool xmap_cache::file_status(const std::string& path, std::time_t& mtime, std::size_t& file_size)
+    {
+        struct stat info;
+        if (::stat(path.c_str(), &info) != 0)
+        {
+            return false;
+        }
+        mtime = info.st_mtime;
+        file_size = static_cast<std::size_t>(info.st_size);
+        return true;
+    }
+
+    /**
+     * The binary map of a TopoJSON file is used when its header records
+     * the current size and modification time of the file.
+     */
+    inline map_document_ptr xmap_cache::open_document(const std::string& path, std::time_t mtime, std::size_t file_size)
+    {
+        std::string binary_path = binary_map_path(path);
+        xmap_source source;
+        if (binary_path == path)
+        {
+            return std::make_shared<const xmap_document>(std::make_shared<const xbinary_map>(path));
+        }
+        else if (read_binary_map_source(binary_path, source) && source.size == file_size &&
+                 source.mtime == static_cast<std::int64_t>(mtime))
+        {
+            return std::make_shared<const xmap_document>(std::make_shared<const xbinary_map>(binary_path));
+        }
+        return std::make_shared<const xmap_document>(load_json_file(path));
+    }
+
+    inline xmap_cache& get_map_cache()
+    {
+        static xmap_cache cache;
+        return cache;
+    }
+}
+
+#endif
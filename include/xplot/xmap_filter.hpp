@@ -0,0 +1,661 @@
+/***************************************************************************
+* Copyright (c) 2017, Sylvain Corlay and Johan Mabille                     *
+*                                                                          *
+* Distributed under the terms of the BSD 3-Clause License.                 *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#ifndef XPLOT_MAP_FILTER_HPP
+#define XPLOT_MAP_FILTER_HPP
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "nlohmann/json.hpp"
+
+namespace nl = nlohmann;
+
+namespace xpl
+{
+    /**
+     * Subset of a TopoJSON topology to display.
+     *
+     * - ids: the ids of the features to keep, all of them when empty.
+     * - bbox: [x0, y0, x1, y1], in the coordinates of the map; the
+     *   features and the parts of multi-geometries outside of it are
+     *   removed. No bounding box is applied when empty.
+     * - simplification: the minimum area, in squared map units, of the
+     *   triangle formed by a point of an arc and its neighbours; smaller
+     *   ones are removed (Visvalingam-Whyatt). Disabled when 0.
+     */
+    struct xmap_filter
+    {
+        std::vector<nl::json> ids;
+        std::vector<double> bbox;
+        double simplification = 0.;
+
+        bool empty() const noexcept;
+        std::string key() const;
+    };
+
+    nl::json filter_topology(const nl::json& topology, const xmap_filter& filter);
+
+    /******************************
+     * xmap_filter implementation *
+     ******************************/
+
+    inline bool xmap_filter::empty() const noexcept
+    {
+        return ids.empty() && bbox.empty() && !(simplification > 0.);
+    }
+
+    /**
+     * Returns a string identifying the filter, used to cache the filtered
+     * topologies.
+     */
+    inline std::string xmap_filter::key() const
+    {
+        nl::json j;
+        j["ids"] = ids;
+        j["bbox"] = bbox;
+        j["simplification"] = simplification;
+        return j.dump();
+    }
+
+    /**********************************
+     * topology filter implementation *
+     **********************************/
+
+    namespace detail
+    {
+        using map_bounds = std::array<double, 4>;
+
+        inline map_bounds empty_map_bounds()
+        {
+            constexpr double inf = std::numeric_limits<double>::infinity();
+            return {{inf, inf, -inf, -inf}};
+        }
+
+        inline void extend_bounds(map_bounds& bounds, const map_bounds& other)
+        {
+            bounds[0] = std::min(bounds[0], other[0]);
+            bounds[1] = std::min(bounds[1], other[1]);
+            bounds[2] = std::max(bounds[2], other[2]);
+            bounds[3] = std::max(bounds[3], other[3]);
+        }
+
+        inline void extend_bounds(map_bounds& bounds, double x, double y)
+        {
+            extend_bounds(bounds, map_bounds{{x, y, x, y}});
+        }
+
+        inline bool is_empty(const map_bounds& bounds)
+        {
+            return bounds[0] > bounds[2];
+        }
+
+        /**
+         * Arcs of a topology, with absolute positions in the units they are
+         * stored in, and their bounds in map coordinates.
+         */
+        struct map_arcs
+        {
+            bool quantized = false;
+            std::array<double, 2> scale = {{1., 1.}};
+            std::array<double, 2> translate = {{0., 0.}};
+            std::vector<std::size_t> offsets;
+            std::vector<double> points;
+            std::vector<map_bounds> bounds;
+
+            std::size_t size() const noexcept
+            {
+                return bounds.size();
+            }
+
+            double map_x(double x) const noexcept
+            {
+                return x * scale[0] + translate[0];
+            }
+
+            double map_y(double y) const noexcept
+            {
+                return y * scale[1] + translate[1];
+            }
+        };
+
+        inline map_arcs decode_arcs(const nl::json& topology)
+        {
+            map_arcs res;
+            auto transform = topology.find("transform");
+            if (transform != topology.end())
+            {
+                res.quantized = true;
+                for (std::size_t i = 0; i < 2; ++i)
+                {
+                    res.scale[i] = transform->at("scale").at(i).get<double>();
+                    res.translate[i] = transform->at("translate").at(i).get<double>();
+                }
+            }
+
+            const nl::json& arcs = topology.at("arcs");
+            res.offsets.reserve(arcs.size() + 1);
+            res.bounds.reserve(arcs.size());
+            res.offsets.push_back(0);
+            for (const auto& arc : arcs)
+            {
+                double x = 0.;
+                double y = 0.;
+                map_bounds bounds = empty_map_bounds();
+                for (const auto& position : arc)
+                {
+                    double px = position.at(0).get<double>();
+                    double py = position.at(1).get<double>();
+                    x = res.quantized ? x + px : px;
+                    y = res.quantized ? y + py : py;
+                    res.points.push_back(x);
+                    res.points.push_back(y);
+                    extend_bounds(bounds, res.map_x(x), res.map_y(y));
+                }
+                res.offsets.push_back(res.points.size() / 2);
+                res.bounds.push_back(bounds);
+            }
+            return res;
+        }
+
+        inline std::size_t arc_index(std::int64_t index)
+        {
+            return static_cast<std::size_t>(index < 0 ? ~index : index);
+        }
+
+        /**
+         * Selection of the geometries of a topology matching a filter,
+         * recording the arcs they use.
+         */
+        class map_subset
+        {
+        public:
+
+            map_subset(const map_arcs& arcs, const xmap_filter& filter)
+                : m_arcs(arcs), m_ids(filter.ids.cbegin(), filter.ids.cend()),
+                  m_has_bbox(!filter.bbox.empty()), m_used(arcs.size(), 0),
+                  m_extent(empty_map_bounds())
+            {
+                if (m_has_bbox)
+                {
+                    if (filter.bbox.size() != 4)
+                    {
+                        throw std::invalid_argument("map filter bbox must hold 4 values");
+                    }
+                    std::copy(filter.bbox.cbegin(), filter.bbox.cend(), m_bbox.begin());
+                }
+            }
+
+            /**
+             * Removes the parts of an object of the topology which are
+             * filtered out. The object itself is always kept, a geometry
+             * filtered out being replaced with a null geometry.
+             */
+            void filter_object(nl::json& object)
+            {
+                if (!keep(object, m_ids.empty()) && object.at("type") != "GeometryCollection")
+                {
+                    object = nl::json::object();
+                    object["type"] = nullptr;
+                }
+            }
+
+            const std::vector<char>& used_arcs() const noexcept
+            {
+                return m_used;
+            }
+
+            const map_bounds& extent() const noexcept
+            {
+                return m_extent;
+            }
+
+        private:
+
+            bool matches_id(const nl::json& geometry) const
+            {
+                auto id = geometry.find("id");
+                return id != geometry.end() && m_ids.count(*id) != 0;
+            }
+
+            bool intersects(const map_bounds& bounds) const
+            {
+                return !m_has_bbox ||
+                    (!is_empty(bounds) && bounds[0] <= m_bbox[2] && bounds[2] >= m_bbox[0] &&
+                     bounds[1] <= m_bbox[3] && bounds[3] >= m_bbox[1]);
+            }
+
+            map_bounds arcs_bounds(const nl::json& arcs) const
+            {
+                map_bounds res = empty_map_bounds();
+                if (arcs.is_array())
+                {
+                    for (const auto& item : arcs)
+                    {
+                        extend_bounds(res, arcs_bounds(item));
+                    }
+                }
+                else
+                {
+                    std::size_t index = arc_index(arcs.get<std::int64_t>());
+                    if (index >= m_arcs.size())
+                    {
+                        throw std::invalid_argument("map geometry references an unknown arc");
+                    }
+                    extend_bounds(res, m_arcs.bounds[index]);
+                }
+                return res;
+            }
+
+            map_bounds position_bounds(const nl::json& position) const
+            {
+                double x = m_arcs.map_x(position.at(0).get<double>());
+                double y = m_arcs.map_y(position.at(1).get<double>());
+                return map_bounds{{x, y, x, y}};
+            }
+
+            // Keeps the parts of a multi-geometry intersecting the bounding box.
+            template <class F>
+            bool keep_parts(nl::json& parts, F&& bounds)
+            {
+                if (m_has_bbox)
+                {
+                    nl::json kept = nl::json::array();
+                    for (auto& part : parts)
+                    {
+                        if (intersects(bounds(part)))
+                        {
+                            kept.push_back(std::move(part));
+                        }
+                    }
+                    parts = std::move(kept);
+                }
+                return !parts.empty();
+            }
+
+            void use_arcs(const nl::json& arcs)
+            {
+                if (arcs.is_array())
+                {
+                    for (const auto& item : arcs)
+                    {
+                        use_arcs(item);
+                    }
+                }
+                else
+                {
+                    std::size_t index = arc_index(arcs.get<std::int64_t>());
+                    m_used[index] = 1;
+                    extend_bounds(m_extent, m_arcs.bounds[index]);
+                }
+            }
+
+            bool keep(nl::json& geometry, bool id_matched)
+            {
+                id_matched = id_matched || matches_id(geometry);
+                const nl::json& type = geometry.at("type");
+                if (type.is_null())
+                {
+                    return id_matched && !m_has_bbox;
+                }
+
+                const std::string& name = type.get_ref<const std::string&>();
+                if (name == "GeometryCollection")
+                {
+                    nl::json& geometries = geometry.at("geometries");
+                    nl::json kept = nl::json::array();
+                    for (auto& child : geometries)
+                    {
+                        if (keep(child, id_matched))
+                        {
+                            kept.push_back(std::move(child));
+                        }
+                    }
+                    geometries = std::move(kept);
+                    return !geometries.empty();
+                }
+                if (!id_matched)
+                {
+                    return false;
+                }
+
+                bool kept = false;
+                if (name == "Point")
+                {
+                    map_bounds bounds = position_bounds(geometry.at("coordinates"));
+                    kept = intersects(bounds);
+                    if (kept)
+                    {
+                        extend_bounds(m_extent, bounds);
+                    }
+                }
+                else if (name == "MultiPoint")
+                {
+                    nl::json& coordinates = geometry.at("coordinates");
+                    kept = keep_parts(coordinates, [this](const nl::json& p) { return position_bounds(p); });
+                    for (const auto& position : coordinates)
+                    {
+                        extend_bounds(m_extent, position_bounds(position));
+                    }
+                }
+                else if (name == "MultiLineString" || name == "MultiPolygon")
+                {
+                    nl::json& arcs = geometry.at("arcs");
+                    kept = keep_parts(arcs, [this](const nl::json& p) { return arcs_bounds(p); });
+                    use_arcs(arcs);
+                }
+                else
+                {
+                    const nl::json& arcs = geometry.at("arcs");
+                    kept = intersects(arcs_bounds(arcs));
+                    if (kept)
+                    {
+                        use_arcs(arcs);
+                    }
+                }
+                return kept;
+            }
+
+            const map_arcs& m_arcs;
+            std::set<nl::json> m_ids;
+            bool m_has_bbox;
+            map_bounds m_bbox;
+            std::vector<char> m_used;
+            map_bounds m_extent;
+        };
+
+        inline void remap_arcs(nl::json& arcs, const std::vector<std::int64_t>& indices)
+        {
+            if (arcs.is_array())
+            {
+                for (auto& item : arcs)
+                {
+                    remap_arcs(item, indices);
+                }
+            }
+            else
+            {
+                std::int64_t index = arcs.get<std::int64_t>();
+                std::int64_t mapped = indices[arc_index(index)];
+                arcs = index < 0 ? ~mapped : mapped;
+            }
+        }
+
+        inline void remap_geometry(nl::json& geometry, const std::vector<std::int64_t>& indices)
+        {
+            auto geometries = geometry.find("geometries");
+            if (geometries != geometry.end())
+            {
+                for (auto& child : *geometries)
+                {
+                    remap_geometry(child, indices);
+                }
+            }
+            auto arcs = geometry.find("arcs");
+            if (arcs != geometry.end())
+            {
+                remap_arcs(*arcs, indices);
+            }
+        }
+
+        /**
+         * Calls f with the arc indices of each ring of the polygons of a
+         * geometry.
+         */
+        template <class F>
+        inline void for_each_ring(const nl::json& geometry, F&& f)
+        {
+            auto geometries = geometry.find("geometries");
+            if (geometries != geometry.end())
+            {
+                for (const auto& child : *geometries)
+                {
+                    for_each_ring(child, f);
+                }
+            }
+            auto arcs = geometry.find("arcs");
+            auto type = geometry.find("type");
+            if (arcs == geometry.end() || type == geometry.end())
+            {
+                return;
+            }
+            if (*type == "Polygon")
+            {
+                for (const auto& ring : *arcs)
+                {
+                    f(ring);
+                }
+            }
+            else if (*type == "MultiPolygon")
+            {
+                for (const auto& polygon : *arcs)
+                {
+                    for (const auto& ring : polygon)
+                    {
+                        f(ring);
+                    }
+                }
+            }
+        }
+
+        /**
+         * Visvalingam-Whyatt simplification of the n points of an arc:
+         * flags the points to keep. The end points of the arcs are always
+         * kept, so that arcs shared by several geometries still join, as
+         * well as at least min_points points, and 4 for closed arcs.
+         */
+        inline std::vector<char> simplify_arc(const double* points, std::size_t n,
+                                              const map_arcs& arcs, double min_area,
+                                              std::size_t min_points = 2)
+        {
+            std::vector<char> keep(n, 1);
+            bool ring = n > 3 && points[0] == points[2 * n - 2] && points[1] == points[2 * n - 1];
+            min_points = std::max(min_points, std::size_t(ring ? 4 : 2));
+            if (n <= min_points)
+            {
+                return keep;
+            }
+
+            std::vector<std::size_t> previous(n);
+            std::vector<std::size_t> next(n);
+            for (std::size_t i = 0; i < n; ++i)
+            {
+                previous[i] = i - 1;
+                next[i] = i + 1;
+            }
+            const double unit_area = std::abs(arcs.scale[0] * arcs.scale[1]) / 2.;
+            auto triangle_area = [&](std::size_t i) {
+                const double* a = points + 2 * previous[i];
+                const double* b = points + 2 * i;
+                const double* c = points + 2 * next[i];
+                return std::abs((b[0] - a[0]) * (c[1] - a[1]) - (c[0] - a[0]) * (b[1] - a[1])) * unit_area;
+            };
+
+            using item_type = std::pair<double, std::size_t>;
+            std::priority_queue<item_type, std::vector<item_type>, std::greater<item_type>> heap;
+            std::vector<double> area(n);
+            for (std::size_t i = 1; i + 1 < n; ++i)
+            {
+                area[i] = triangle_area(i);
+                heap.emplace(area[i], i);
+            }
+
+            std::size_t remaining = n;
+            while (!heap.empty() && remaining > min_points)
+            {
+                item_type top = heap.top();
+                heap.pop();
+                std::size_t i = top.second;
+                if (!keep[i] || top.first != area[i])
+                {
+                    continue;
+                }
+                if (top.first >= min_area)
+                {
+                    break;
+                }
+                keep[i] = 0;
+                --remaining;
+                next[previous[i]] = next[i];
+                previous[next[i]] = previous[i];
+                // The area of a point is never less than the area of the
+                // points removed before it, so that the order of removal
+                // does not depend on the threshold.
+                for (std::size_t j : {previous[i], next[i]})
+                {
+                    if (j != 0 && j != n - 1)
+                    {
+                        area[j] = std::max(triangle_area(j), top.first);
+                        heap.emplace(area[j], j);
+                    }
+                }
+            }
+            return keep;
+        }
+
+        inline nl::json encode_arc(const double* points, std::size_t n,
+                                   const std::vector<char>& keep, bool quantized)
+        {
+            nl::json res = nl::json::array();
+            double x = 0.;
+            double y = 0.;
+            for (std::size_t i = 0; i < n; ++i)
+            {
+                if (!keep.empty() && !keep[i])
+                {
+                    continue;
+                }
+                const double* p = points + 2 * i;
+                if (quantized)
+                {
+                    res.push_back({std::llround(p[0] - x), std::llround(p[1] - y)});
+                    x = p[0];
+                    y = p[1];
+                }
+                else
+                {
+                    res.push_back({p[0], p[1]});
+                }
+            }
+            return res;
+        }
+    }
+
+    /**
+     * Returns the subset of a TopoJSON topology described by filter: the
+     * objects only hold the selected geometries and the arcs they use,
+     * simplified if required. As the arcs are shared, their simplification
+     * preserves the borders between neighbouring geometries, and the rings
+     * of the polygons keep at least 4 points.
+     */
+    inline nl::json filter_topology(const nl::json& topology, const xmap_filter& filter)
+    {
+        detail::map_arcs arcs = detail::decode_arcs(topology);
+        detail::map_subset subset(arcs, filter);
+
+        nl::json res = nl::json::object();
+        for (auto it = topology.cbegin(); it != topology.cend(); ++it)
+        {
+            if (it.key() != "arcs" && it.key() != "objects")
+            {
+                res[it.key()] = it.value();
+            }
+        }
+
+        nl::json& objects = res["objects"] = topology.at("objects");
+        for (auto& object : objects)
+        {
+            subset.filter_object(object);
+        }
+
+        const std::vector<char>& used = subset.used_arcs();
+        auto arc_points = [&arcs](std::size_t i) { return arcs.points.data() + 2 * arcs.offsets[i]; };
+        auto arc_size = [&arcs](std::size_t i) { return arcs.offsets[i + 1] - arcs.offsets[i]; };
+        std::vector<std::vector<char>> keep(arcs.size());
+        if (filter.simplification > 0.)
+        {
+            std::vector<std::size_t> counts(arcs.size(), 0);
+            for (std::size_t i = 0; i < arcs.size(); ++i)
+            {
+                if (used[i])
+                {
+                    keep[i] = detail::simplify_arc(arc_points(i), arc_size(i), arcs, filter.simplification);
+                    counts[i] = static_cast<std::size_t>(std::count(keep[i].cbegin(), keep[i].cend(), 1));
+                }
+            }
+            // The arcs are simplified independently: a ring made of several
+            // arcs gets back the points it needs, one arc at a time. As the
+            // order of removal does not depend on the threshold, the arcs
+            // simplified again only gain points.
+            auto restore_ring = [&](const nl::json& ring) {
+                std::size_t size = 1;
+                for (const auto& index : ring)
+                {
+                    size += counts[detail::arc_index(index.get<std::int64_t>())] - 1;
+                }
+                bool grown = true;
+                while (size < 4 && grown)
+                {
+                    grown = false;
+                    for (auto it = ring.cbegin(); it != ring.cend() && size < 4; ++it)
+                    {
+                        std::size_t i = detail::arc_index(it->get<std::int64_t>());
+                        if (counts[i] < arc_size(i))
+                        {
+                            ++counts[i];
+                            ++size;
+                            keep[i] = detail::simplify_arc(arc_points(i), arc_size(i), arcs,
+                                                           filter.simplification, counts[i]);
+                            grown = true;
+                        }
+                    }
+                }
+            };
+            for (const auto& object : objects)
+            {
+                detail::for_each_ring(object, restore_ring);
+            }
+        }
+
+        std::vector<std::int64_t> indices(arcs.size(), -1);
+        nl::json& res_arcs = res["arcs"] = nl::json::array();
+        for (std::size_t i = 0; i < arcs.size(); ++i)
+        {
+            if (used[i])
+            {
+                indices[i] = static_cast<std::int64_t>(res_arcs.size());
+                res_arcs.push_back(detail::encode_arc(arc_points(i), arc_size(i), keep[i], arcs.quantized));
+            }
+        }
+
+        for (auto& object : objects)
+        {
+            detail::remap_geometry(object, indices);
+        }
+
+        if (res.count("bbox") != 0 && !detail::is_empty(subset.extent()))
+        {
+            const detail::map_bounds& extent = subset.extent();
+            res["bbox"] = {extent[0], extent[1], extent[2], extent[3]};
+        }
+        return res;
+    }
+}
+
+#endif
@@ -0,0 +1,121 @@
+/***************************************************************************
+* Copyright (c) 2017, Sylvain Corlay and Johan Mabille                     *
+*                                                                          *
+* Distributed under the terms of the BSD 3-Clause License.                 *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#ifndef XPLOT_MAPPED_FILE_HPP
+#define XPLOT_MAPPED_FILE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace xpl
+{
+    /****************************
+     * xmapped_file declaration *
+     ****************************/
+
+    /**
+     * Read-only memory mapping of a file. The file is read in memory on
+     * platforms where it is not mapped.
+     */
+    class xmapped_file
+    {
+    public:
+
+        explicit xmapped_file(const std::string& path);
+        ~xmapped_file();
+
+        xmapped_file(const xmapped_file&) = delete;
+        xmapped_file& operator=(const xmapped_file&) = delete;
+
+        const char* data() const noexcept;
+        std::size_t size() const noexcept;
+
+    private:
+
+        const char* p_data = nullptr;
+        std::size_t m_size = 0;
+        std::vector<std::uint64_t> m_buffer;
+    };
+
+    /*******************************
+     * xmapped_file implementation *
+     *******************************/
+
+    inline xmapped_file::xmapped_file(const std::string& path)
+    {
+#ifndef _WIN32
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+        {
+            throw std::runtime_error("cannot open file: " + path);
+        }
+        struct stat info;
+        if (::fstat(fd, &info) != 0)
+        {
+            ::close(fd);
+            throw std::runtime_error("cannot open file: " + path);
+        }
+        m_size = static_cast<std::size_t>(info.st_size);
+        if (m_size != 0)
+        {
+            void* addr = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (addr == MAP_FAILED)
+            {
+                ::close(fd);
+                throw std::runtime_error("cannot map file: " + path);
+            }
+            p_data = static_cast<const char*>(addr);
+        }
+        ::close(fd);
+#else
+        std::ifstream in(path, std::ios::binary | std::ios::ate);
+        if (!in)
+        {
+            throw std::runtime_error("cannot open file: " + path);
+        }
+        m_size = static_cast<std::size_t>(in.tellg());
+        m_buffer.resize((m_size + sizeof(std::uint64_t) - 1) / sizeof(std::uint64_t));
+        in.seekg(0);
+        in.read(reinterpret_cast<char*>(m_buffer.data()), static_cast<std::streamsize>(m_size));
+        p_data = reinterpret_cast<const char*>(m_buffer.data());
+#endif
+    }
+
+    inline xmapped_file::~xmapped_file()
+    {
+#ifndef _WIN32
+        if (p_data != nullptr)
+        {
+            ::munmap(const_cast<char*>(p_data), m_size);
+        }
+#endif
+    }
+
+    inline const char* xmapped_file::data() const noexcept
+    {
+        return p_data;
+    }
+
+    inline std::size_t xmapped_file::size() const noexcept
+    {
+        return m_size;
+    }
+}
+
+#endif
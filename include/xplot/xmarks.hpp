@@ -9,9 +9,13 @@
 #ifndef XPLOT_MARKS_HPP
 #define XPLOT_MARKS_HPP
 
-#include <fstream>
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
 #include <list>
 #include <map>
+#include <memory>
+#include <stdexcept>
 #include <streambuf>
 #include <string>
 #include <vector>
@@ -26,8 +30,15 @@
 #include "xwidgets/xwidget.hpp"
 
 #include "xboxed_container.hpp"
+#include "xdecimation.hpp"
+#include "xdomain_tracker.hpp"
+#include "xhistogram.hpp"
+#include "xmap_cache.hpp"
 #include "xmaps_config.hpp"
+#include "xmatrix.hpp"
 #include "xplot.hpp"
+#include "xpyramid.hpp"
+#include "xquantiles.hpp"
 #include "xscales.hpp"
 
 namespace nl = nlohmann;
@@ -57,6 +68,89 @@ namespace xpl
         return output;
     }
 
+    namespace detail
+    {
+        template <class S>
+        std::size_t tail_size(const S& tail);
+
+        template <class T, class S>
+        void append_values(xboxed_container<std::vector<T>>& values, std::shared_ptr<void>& window,
+                           const S& tail, std::size_t max_length);
+
+        template <class T>
+        struct has_data_extent : std::false_type
+        {
+        };
+
+        template <>
+        struct has_data_extent<xboxed_container<std::vector<double>>> : std::true_type
+        {
+        };
+
+        template <>
+        struct has_data_extent<xmatrix<double>> : std::true_type
+        {
+        };
+
+        template <class T>
+        struct has_data_extent<xtl::xoptional<T>> : has_data_extent<T>
+        {
+        };
+
+        xextent data_extent(const xboxed_container<std::vector<double>>& values);
+        xextent data_extent(const xmatrix<double>& values);
+        template <class T>
+        xextent data_extent(const xtl::xoptional<T>& values);
+
+        /**
+         * Token expiring with the object owning it. As for
+         * xdomain_subscription, copies and moves get their own token,
+         * since the objects watching it refer to the owner.
+         */
+        class xlifetime
+        {
+        public:
+
+            xlifetime();
+
+            xlifetime(const xlifetime&);
+            xlifetime(xlifetime&&);
+
+            xlifetime& operator=(const xlifetime&) noexcept;
+            xlifetime& operator=(xlifetime&&) noexcept;
+
+            std::weak_ptr<const void> watch() const noexcept;
+
+        private:
+
+            std::shared_ptr<const void> m_token;
+        };
+
+        /**
+         * Tokens of the selectors computing the selection of a mark. As for
+         * xlifetime, copies and moves are not owned.
+         */
+        class xselection_owners
+        {
+        public:
+
+            xselection_owners() = default;
+
+            xselection_owners(const xselection_owners&) noexcept;
+            xselection_owners(xselection_owners&&) noexcept;
+
+            xselection_owners& operator=(const xselection_owners&) noexcept;
+            xselection_owners& operator=(xselection_owners&&) noexcept;
+
+            void add(std::weak_ptr<const void> owner);
+            bool empty() const noexcept;
+
+        private:
+
+            std::vector<std::weak_ptr<const void>> m_owners;
+        };
+    }
+
     /*********************
      * xmark declaration *
      *********************/
@@ -81,6 +175,15 @@ namespace xpl
         void serialize_state(nl::json&, xeus::buffer_sequence&) const;
         void apply_patch(const nl::json&, const xeus::buffer_sequence&);
 
+        template <class P>
+        void notify(const P& property) const;
+
+        xextent extent(const std::string& name) const;
+        std::weak_ptr<const void> lifetime() const noexcept;
+
+        void add_selection_owner(std::weak_ptr<const void> owner);
+        bool has_selection_owner() const noexcept;
+
         XPROPERTY(scales_type, derived_type, scales);
         XPROPERTY(::nl::json, derived_type, scales_metadata);
         XPROPERTY(preserve_domain_type, derived_type, preserve_domain);
@@ -103,9 +206,38 @@ namespace xpl
 
         using base_type::base_type;
 
+        template <class P, class S>
+        std::size_t append_data(P& property, const S& tail, std::size_t max_length);
+
+        xeus::xguid scale_id(const std::string& name) const;
+
+        template <class P>
+        void apply_selection_patch(P& property, const nl::json& patch, const xeus::buffer_sequence& buffers);
+
     private:
 
         void set_defaults();
+
+        template <class T>
+        void update_extent(const std::string& name, const T& values) const;
+        template <class T>
+        void update_extent(const std::string& name, const T& values, std::true_type) const;
+        template <class T>
+        void update_extent(const std::string& name, const T& values, std::false_type) const;
+        xextent leading_extent(const xboxed_container<std::vector<double>>& values, std::size_t size) const;
+        template <class T>
+        xextent leading_extent(const T& values, std::size_t size) const;
+        void extend_extent(const std::string& name, const xboxed_container<std::vector<double>>& values,
+                           std::size_t offset, const xextent& dropped) const;
+        template <class T>
+        void extend_extent(const std::string& name, const T& values, std::size_t offset, const xextent& dropped) const;
+        void bind_extents() const;
+
+        mutable xdomain_contributor m_extents;
+        std::map<std::string, std::shared_ptr<void>> m_windows;
+        bool m_appending = false;
+        detail::xlifetime m_lifetime;
+        detail::xselection_owners m_selection_owners;
     };
 
     template <class T, class R = void>
@@ -133,12 +265,32 @@ namespace xpl
         using colors_type = std::vector<color_type>;
         using opacities_type = std::vector<double>;
         using curves_subset_type = std::vector<int>;
+        using pyramid_type = xminmax_pyramid<double>;
+        using selected_type = typename base_type::selected_type;
 
         void serialize_state(nl::json&, xeus::buffer_sequence&) const;
         void apply_patch(const nl::json&, const xeus::buffer_sequence&);
 
+        template <class XS, class YS>
+        void append(const XS& xs, const YS& ys, std::size_t max_length = 0);
+
+        bool is_downsampled() const noexcept;
+
+        void build_pyramid(std::size_t block_size = 64);
+        void drop_pyramid();
+        bool has_pyramid() const noexcept;
+        const pyramid_type& pyramid() const noexcept;
+
+        template <class P>
+        void notify(const P& property) const;
+
+        template <class P>
+        void serialize_property(const P& property, nl::json& state, xeus::buffer_sequence& buffers) const;
+
         XPROPERTY(data_type, derived_type, x);
         XPROPERTY(data_type, derived_type, y);
+        XPROPERTY(std::size_t, derived_type, max_points, 0);
+        XPROPERTY(std::string, derived_type, downsampling, "lttb", XEITHER("lttb", "minmax", "m4"));
         XPROPERTY(colors_type, derived_type, color);
         XPROPERTY(colors_type, derived_type, colors, category10());
         XPROPERTY(colors_type, derived_type, fill_colors);
@@ -153,6 +305,7 @@ namespace xpl
         XPROPERTY(int, derived_type, marker_size, 64);
         XPROPERTY(opacities_type, derived_type, opacities);
         XPROPERTY(opacities_type, derived_type, fill_opacities);
+        XPROPERTY(selected_type, derived_type, selected_points);
 
     protected:
 
@@ -164,6 +317,35 @@ namespace xpl
     private:
 
         void set_defaults();
+
+        bool is_downsampling_property(const void* property) const noexcept;
+        void serialize_xy(nl::json& state, xeus::buffer_sequence& buffers) const;
+
+        void watch_x_domain() const;
+        void on_x_domain(const xtl::xoptional<double>& min, const xtl::xoptional<double>& max) const;
+        bool is_x_sorted(const data_type& x_values, std::size_t size) const;
+        bool visible_range(std::size_t size, std::size_t& first, std::size_t& last) const;
+        bool needs_refresh() const;
+        void sync_pyramid() const;
+
+        struct viewport_type
+        {
+            bool has_domain = false;
+            double min = 0.;
+            double max = 0.;
+            std::size_t first = 0;
+            std::size_t last = 0;
+            std::size_t visible = 0;
+            bool sorted = false;
+            std::size_t sorted_size = 0;
+            xsync_state::version_type sorted_version = 0;
+        };
+
+        mutable viewport_type m_viewport;
+        mutable xdomain_subscription m_x_domain;
+        mutable pyramid_type m_pyramid;
+        mutable xsync_state::version_type m_pyramid_version = 0;
+        bool m_has_pyramid = false;
     };
 
     using lines = xw::xmaterialize<xlines>;
@@ -194,6 +376,9 @@ namespace xpl
         void on_drag_end(callback_type);
         void handle_custom_message(const nl::json&);
 
+        template <class XS, class YS>
+        void append(const XS& xs, const YS& ys, std::size_t max_length = 0);
+
         XPROPERTY(data_type, derived_type, x);
         XPROPERTY(data_type, derived_type, y);
         XPROPERTY(data_type, derived_type, color);
@@ -360,6 +545,11 @@ namespace xpl
         void serialize_state(nl::json&, xeus::buffer_sequence&) const;
         void apply_patch(const nl::json&, const xeus::buffer_sequence&);
 
+        using base_type::append;
+
+        template <class XS, class YS, class TS>
+        void append(const XS& xs, const YS& ys, const TS& texts, std::size_t max_length = 0);
+
         XPROPERTY(std::string, derived_type, align, "start", XEITHER("start", "middle", "end"));
         XPROPERTY(std::vector<color_type>, derived_type, colors);
         XPROPERTY(double, derived_type, default_size, 16.0);
@@ -400,6 +590,7 @@ namespace xpl
         using data_type = xboxed_container<std::vector<double>>;
         using colors_type = std::vector<color_type>;
         using opacity_type = std::vector<double>;
+        using midpoints_type = std::vector<double>;
 
         void serialize_state(nl::json&, xeus::buffer_sequence&) const;
         void apply_patch(const nl::json&, const xeus::buffer_sequence&);
@@ -407,7 +598,7 @@ namespace xpl
         XPROPERTY(int, derived_type, bins, 10);
         XPROPERTY(colors_type, derived_type, colors);
         XPROPERTY(data_type, derived_type, count);
-        XPROPERTY(colors_type, derived_type, midpoints);
+        XPROPERTY(midpoints_type, derived_type, midpoints);
         XPROPERTY(bool, derived_type, normalized);
         XPROPERTY(std::vector<double>, derived_type, opacities);
         XPROPERTY(data_type, derived_type, sample);
@@ -442,10 +633,29 @@ namespace xpl
 
         using data_type_x = xboxed_container<std::vector<double>>;
         using data_type_y = xboxed_container<std::vector<std::vector<double>>>;
+        using sketches_type = std::vector<xbox_sketch>;
 
         void serialize_state(nl::json&, xeus::buffer_sequence&) const;
         void apply_patch(const nl::json&, const xeus::buffer_sequence&);
 
+        std::vector<xbox_summary> summaries() const;
+
+        void start_streaming(std::size_t nb_boxes, std::size_t k = 200);
+        void stop_streaming();
+        bool streaming() const noexcept;
+        const sketches_type& sketches() const noexcept;
+
+        template <class S>
+        void add_samples(std::size_t box, const S& samples);
+
+        void merge_samples(std::size_t box, const xbox_sketch& sketch);
+
+        template <class P>
+        void notify(const P& property) const;
+
+        template <class P>
+        void serialize_property(const P& property, nl::json& state, xeus::buffer_sequence& buffers) const;
+
         XPROPERTY(color_type, derived_type, box_fill_color, "dodgerblue");
         XPROPERTY(std::vector<double>, derived_type, opacities);
         XPROPERTY(color_type, derived_type, outlier_fill_color, "gray");
@@ -453,6 +663,8 @@ namespace xpl
         XPROPERTY(xtl::xoptional<color_type>, derived_type, stroke);
         XPROPERTY(data_type_x, derived_type, x);
         XPROPERTY(data_type_y, derived_type, y);
+        XPROPERTY(bool, derived_type, server_summary, false);
+        XPROPERTY(std::size_t, derived_type, max_outliers, 100);
 
     protected:
 
@@ -464,6 +676,12 @@ namespace xpl
     private:
 
         void set_defaults();
+
+        bool is_summary_property(const void* property) const noexcept;
+        void serialize_y(nl::json& state, xeus::buffer_sequence& buffers) const;
+
+        sketches_type m_sketches;
+        bool m_streaming = false;
     };
 
     using boxplot = xw::xmaterialize<xboxplot>;
@@ -514,6 +732,73 @@ namespace xpl
 
     using bars = xw::xmaterialize<xbars>;
 
+    /****************************
+     * xbinned_hist declaration *
+     ****************************/
+
+    /**
+     * Histogram binned in C++ and drawn by the bars model of the
+     * front-end: x holds the midpoints of the bins and y their counts.
+     *
+     * The sample stays on the server and is never sent; a change of the
+     * sample, of the number of bins or of the normalization recomputes x
+     * and y, which are sent in the same patch, so that a bins patch from
+     * the front-end rebins automatically.
+     */
+    template <class D>
+    class xbinned_hist : public xbars<D>
+    {
+    public:
+
+        using base_type = xbars<D>;
+        using derived_type = D;
+
+        using data_type = typename base_type::data_type;
+        using time_point = xstreaming_histogram::time_point;
+
+        void serialize_state(nl::json&, xeus::buffer_sequence&) const;
+        void apply_patch(const nl::json&, const xeus::buffer_sequence&);
+
+        void start_streaming(const xstreaming_histogram& histogram, bool retain_samples = false);
+        void stop_streaming();
+        bool streaming() const noexcept;
+        const xstreaming_histogram& streaming_histogram() const noexcept;
+
+        template <class S>
+        void add_samples(const S& samples);
+
+        template <class S>
+        void add_samples(const S& samples, time_point now);
+
+        template <class P>
+        void notify(const P& property) const;
+
+        XPROPERTY(int, derived_type, bins, 10);
+        XPROPERTY(bool, derived_type, normalized);
+        XPROPERTY(data_type, derived_type, sample);
+
+    protected:
+
+        template <class XS, class YS>
+        xbinned_hist(XS&&, YS&&);
+
+        using base_type::base_type;
+
+    private:
+
+        void set_defaults();
+
+        void rebin() const;
+        void restart_stream() const;
+        void set_stream_counts() const;
+
+        mutable xstreaming_histogram m_stream;
+        bool m_streaming = false;
+        bool m_retain_samples = false;
+    };
+
+    using binned_hist = xw::xmaterialize<xbinned_hist>;
+
     /*************************
      * xheat_map declaration *
      *************************/
@@ -528,7 +813,7 @@ namespace xpl
 
         using coord_type = xboxed_container<std::vector<double>>;
         using array = std::vector<std::vector<double>>;
-        using data_type = xboxed_container<array>;
+        using data_type = xmatrix<double>;
 
         void serialize_state(nl::json&, xeus::buffer_sequence&) const;
         void apply_patch(const nl::json&, const xeus::buffer_sequence&);
@@ -551,6 +836,16 @@ namespace xpl
                   std::vector<std::vector<double>>&,
                   XS&&, YS&&, CS&&);
 
+        template <class XS, class YS, class CS>
+        xheat_map(data_type,
+                  XS&&, YS&&, CS&&);
+
+        template <class XS, class YS, class CS>
+        xheat_map(std::vector<double>&,
+                  std::vector<double>&,
+                  data_type,
+                  XS&&, YS&&, CS&&);
+
         using base_type::base_type;
 
     private:
@@ -574,11 +869,21 @@ namespace xpl
 
         using selected_type = std::vector<std::vector<int>>;
         using data1d_type = xboxed_container<std::vector<double>>;
-        using data2d_type = xboxed_container<std::vector<std::vector<double>>>;
+        using data2d_type = xmatrix<double>;
+        using pyramid_type = xmatrix_pyramid;
 
         void serialize_state(nl::json&, xeus::buffer_sequence&) const;
         void apply_patch(const nl::json&, const xeus::buffer_sequence&);
 
+        const pyramid_type& pyramid() const noexcept;
+        std::size_t tile_level() const noexcept;
+
+        template <class P>
+        void notify(const P& property) const;
+
+        template <class P>
+        void serialize_property(const P& property, nl::json& state, xeus::buffer_sequence& buffers) const;
+
         XPROPERTY(::nl::json, derived_type, anchor_style, ::nl::json::object());
         XPROPERTY(data2d_type, derived_type, color);
         XPROPERTY(data1d_type, derived_type, column);
@@ -590,6 +895,9 @@ namespace xpl
         XPROPERTY(::nl::json, derived_type, scales_metadata);
         XPROPERTY(xtl::xoptional<color_type>, derived_type, stroke, "black");
         XPROPERTY(selected_type, derived_type, selected);
+        XPROPERTY(std::size_t, derived_type, max_rows, 0);
+        XPROPERTY(std::size_t, derived_type, max_columns, 0);
+        XPROPERTY(std::string, derived_type, pooling, "mean", XEITHER("mean", "max"));
 
     protected:
 
@@ -603,11 +911,55 @@ namespace xpl
         xgrid_heat_map(std::vector<std::vector<double>>&,
                        XS&&, YS&&, CS&&);
 
+        template <class XS, class YS, class CS>
+        xgrid_heat_map(std::vector<double>&,
+                       std::vector<double>&,
+                       data2d_type,
+                       XS&&, YS&&, CS&&);
+
+        template <class XS, class YS, class CS>
+        xgrid_heat_map(data2d_type,
+                       XS&&, YS&&, CS&&);
+
         using base_type::base_type;
 
     private:
 
+        struct axis_viewport_type
+        {
+            bool has_domain = false;
+            double min = 0.;
+            double max = 0.;
+            std::size_t first = 0;
+            std::size_t last = 0;
+            bool sorted = false;
+            std::size_t sorted_size = 0;
+            xsync_state::version_type sorted_version = 0;
+        };
+
         void set_defaults();
+
+        bool tiling_enabled() const noexcept;
+        bool is_tiling_property(const void* property) const noexcept;
+        void serialize_tiles(nl::json& state, xeus::buffer_sequence& buffers) const;
+
+        void watch_domains() const;
+        void on_domain(axis_viewport_type& view, const xtl::xoptional<double>& min, const xtl::xoptional<double>& max) const;
+        void visible_ranges(std::size_t nb_rows, std::size_t nb_columns, std::size_t& first_row, std::size_t& last_row,
+                            std::size_t& first_column, std::size_t& last_column) const;
+        bool needs_refresh() const;
+        void sync_pyramid() const;
+
+        static constexpr std::size_t tile_size = 32;
+
+        mutable axis_viewport_type m_row_view;
+        mutable axis_viewport_type m_column_view;
+        mutable std::size_t m_tile_level = 0;
+        mutable xdomain_subscription m_row_domain;
+        mutable xdomain_subscription m_column_domain;
+        mutable pyramid_type m_pyramid;
+        mutable xsync_state::version_type m_pyramid_version = 0;
+        mutable bool m_pyramid_built = false;
     };
 
     using grid_heat_map = xw::xmaterialize<xgrid_heat_map>;
@@ -616,6 +968,13 @@ namespace xpl
      * xmap declaration *
      ********************/
 
+    /**
+     * Map of the features of a TopoJSON file.
+     *
+     * The parsed file is shared with the other maps displaying it and is
+     * returned by map_document; map_data is null unless assigned, in
+     * which case it is sent instead of the shared document.
+     */
     template <class D>
     class xmap : public xmark<D>
     {
@@ -627,6 +986,20 @@ namespace xpl
         void serialize_state(nl::json&, xeus::buffer_sequence&) const;
         void apply_patch(const nl::json&, const xeus::buffer_sequence&);
 
+        const map_document_ptr& map_document() const noexcept;
+
+        void set_map_filter(const xmap_filter& filter);
+        const xmap_filter& map_filter() const noexcept;
+
+        void set_typed_arcs(bool typed_arcs);
+        bool typed_arcs() const noexcept;
+
+        template <class P>
+        void notify(const P& property) const;
+
+        template <class P>
+        void serialize_property(const P& property, nl::json& state, xeus::buffer_sequence& buffers) const;
+
         XPROPERTY(xtl::xoptional<::nl::json>, derived_type, color, ::nl::json::object());
         XPROPERTY(::nl::json, derived_type, colors, ::nl::json::object());
         XPROPERTY(bool, derived_type, hover_highlight, true);
@@ -659,7 +1032,13 @@ namespace xpl
     private:
 
         void set_defaults();
-        nl::json read_map(std::string filename);
+        void load_map(const std::string& filename);
+        void serialize_map_data(nl::json& j, xeus::buffer_sequence& buffers) const;
+
+        std::string m_filename;
+        xmap_filter m_filter;
+        map_document_ptr m_document;
+        bool m_typed_arcs = false;
     };
 
     using map = xw::xmaterialize<xmap>;
@@ -683,7 +1062,7 @@ namespace xpl
         set_property_from_patch(visible, patch, buffers);
         set_property_from_patch(selected_style, patch, buffers);
         set_property_from_patch(unselected_style, patch, buffers);
-        set_property_from_patch(selected, patch, buffers);
+        apply_selection_patch(selected, patch, buffers);
         set_property_from_patch(tooltip, patch, buffers);
         set_property_from_patch(tooltip_style, patch, buffers);
         set_property_from_patch(enable_hover, patch, buffers);
@@ -727,170 +1106,829 @@ namespace xpl
         this->_model_name() = "MarkModel";
     }
 
-    /*************************
-     * xlines implementation *
-     *************************/
-
+    /**
+     * Appends tail to the data property, keeping its max_length trailing
+     * values when max_length is not zero, and notifies the change, which
+     * sends the whole property. The extent of the property is updated from
+     * the appended and the dropped values only when possible. Returns the
+     * number of dropped values.
+     */
     template <class D>
-    inline void xlines<D>::apply_patch(const nl::json& patch, const xeus::buffer_sequence& buffers)
+    template <class P, class S>
+    inline std::size_t xmark<D>::append_data(P& property, const S& tail, std::size_t max_length)
     {
-        using xw::set_property_from_patch;
-        base_type::apply_patch(patch, buffers);
+        auto& values = property();
+        std::size_t size = values.size();
+        std::size_t added = detail::tail_size(tail);
+        std::size_t dropped = max_length != 0 && size + added > max_length ? size + added - max_length : 0;
+        xextent dropped_extent = leading_extent(values, std::min(dropped, size));
 
-        set_property_from_patch(x, patch, buffers);
-        set_property_from_patch(y, patch, buffers);
-        set_property_from_patch(color, patch, buffers);
-        set_property_from_patch(colors, patch, buffers);
-        set_property_from_patch(fill_colors, patch, buffers);
-        set_property_from_patch(stroke_width, patch, buffers);
-        set_property_from_patch(labels_visibility, patch, buffers);
-        set_property_from_patch(curves_subset, patch, buffers);
-        set_property_from_patch(line_style, patch, buffers);
-        set_property_from_patch(interpolation, patch, buffers);
-        set_property_from_patch(close_path, patch, buffers);
-        set_property_from_patch(fill, patch, buffers);
-        set_property_from_patch(marker, patch, buffers);
-        set_property_from_patch(marker_size, patch, buffers);
-        set_property_from_patch(opacities, patch, buffers);
-        set_property_from_patch(fill_opacities, patch, buffers);
+        detail::append_values(values, m_windows[property.name()], tail, max_length);
+        std::size_t offset = values.size() - std::min(added, values.size());
+        extend_extent(property.name(), values, offset, dropped_extent);
+
+        m_appending = true;
+        this->derived_cast().notify(property);
+        m_appending = false;
+        return dropped;
     }
 
+    /**
+     * Tracks the extent of the data properties, which contributes to the
+     * domain of the scale of the same name.
+     */
     template <class D>
-    inline void xlines<D>::serialize_state(nl::json& state, xeus::buffer_sequence& buffers) const
+    template <class P>
+    inline void xmark<D>::notify(const P& property) const
     {
-        using xw::xwidgets_serialize;
-        base_type::serialize_state(state, buffers);
-
-        xwidgets_serialize(x, state["x"], buffers);
-        xwidgets_serialize(y, state["y"], buffers);
-        xwidgets_serialize(color, state["color"], buffers);
-        xwidgets_serialize(colors, state["colors"], buffers);
-        xwidgets_serialize(fill_colors, state["fill_colors"], buffers);
-        xwidgets_serialize(stroke_width, state["stroke_width"], buffers);
-        xwidgets_serialize(labels_visibility, state["labels_visibility"], buffers);
-        xwidgets_serialize(curves_subset, state["curves_subset"], buffers);
-        xwidgets_serialize(line_style, state["line_style"], buffers);
-        xwidgets_serialize(interpolation, state["interpolation"], buffers);
-        xwidgets_serialize(close_path, state["close_path"], buffers);
-        xwidgets_serialize(fill, state["fill"], buffers);
-        xwidgets_serialize(marker, state["marker"], buffers);
-        xwidgets_serialize(marker_size, state["marker_size"], buffers);
-        xwidgets_serialize(opacities, state["opacities"], buffers);
-        xwidgets_serialize(fill_opacities, state["fill_opacities"], buffers);
+        base_type::notify(property);
+        const void* p = &property;
+        if (p == &scales)
+        {
+            bind_extents();
+        }
+        else if (!m_appending)
+        {
+            update_extent(property.name(), property());
+        }
     }
 
+    /**
+     * Returns the extent of the data property name, NaN values excluded.
+     */
     template <class D>
-    template <class XS, class YS>
-    inline xlines<D>::xlines(XS&& xs, YS&& ys)
-        : base_type()
+    inline xextent xmark<D>::extent(const std::string& name) const
     {
-        set_defaults();
-
-        this->scales()["x"] = std::forward<XS>(xs);
-        this->scales()["y"] = std::forward<YS>(ys);
+        return m_extents.extent(name);
     }
 
+    /**
+     * Returns a handle expiring when the mark is destroyed, so that the
+     * objects referring to it, e.g. the selectors, can detect it.
+     */
     template <class D>
-    inline void xlines<D>::set_defaults()
+    inline std::weak_ptr<const void> xmark<D>::lifetime() const noexcept
     {
-        this->_model_name() = "LinesModel";
-        this->_view_name() = "Lines";
-        this->scales_metadata() = {
-            {"x", {{"orientation", "horizontal"}, {"dimension", "x"}}},
-            {"y", {{"orientation", "vertical"}, {"dimension", "y"}}},
-            {"color", {{"dimension", "color"}}}};
+        return m_lifetime.watch();
     }
 
-    /********************************
-     * xscatter_base implementation *
-     ********************************/
-
+    /**
+     * Registers a selector computing the selection of the mark on the
+     * server, for as long as owner is alive. Meanwhile, the selected
+     * property is not overwritten by the front-end, whose selectors
+     * compute it on the points they hold.
+     */
     template <class D>
-    inline void xscatter_base<D>::apply_patch(const nl::json& patch, const xeus::buffer_sequence& buffers)
+    inline void xmark<D>::add_selection_owner(std::weak_ptr<const void> owner)
     {
-        using xw::set_property_from_patch;
-        base_type::apply_patch(patch, buffers);
-
-        set_property_from_patch(x, patch, buffers);
-        set_property_from_patch(y, patch, buffers);
-        set_property_from_patch(color, patch, buffers);
-        set_property_from_patch(opacity, patch, buffers);
-        set_property_from_patch(size, patch, buffers);
-        set_property_from_patch(rotation, patch, buffers);
-        set_property_from_patch(default_opacities, patch, buffers);
-        set_property_from_patch(hovered_style, patch, buffers);
-        set_property_from_patch(unhovered_style, patch, buffers);
-        set_property_from_patch(hovered_point, patch, buffers);
-        set_property_from_patch(enable_move, patch, buffers);
-        set_property_from_patch(enable_delete, patch, buffers);
-        set_property_from_patch(restrict_x, patch, buffers);
-        set_property_from_patch(restrict_y, patch, buffers);
-        set_property_from_patch(update_on_move, patch, buffers);
-        set_property_from_patch(selected, patch, buffers);
+        m_selection_owners.add(std::move(owner));
     }
 
     template <class D>
-    inline void xscatter_base<D>::serialize_state(nl::json& state, xeus::buffer_sequence& buffers) const
+    inline bool xmark<D>::has_selection_owner() const noexcept
     {
-        using xw::xwidgets_serialize;
-        base_type::serialize_state(state, buffers);
-
-        xwidgets_serialize(x, state["x"], buffers);
-        xwidgets_serialize(y, state["y"], buffers);
-        xwidgets_serialize(color, state["color"], buffers);
-        xwidgets_serialize(opacity, state["opacity"], buffers);
-        xwidgets_serialize(size, state["size"], buffers);
-        xwidgets_serialize(rotation, state["rotation"], buffers);
-        xwidgets_serialize(default_opacities, state["default_opacities"], buffers);
-        xwidgets_serialize(hovered_style, state["hovered_style"], buffers);
-        xwidgets_serialize(unhovered_style, state["unhovered_style"], buffers);
-        xwidgets_serialize(hovered_point, state["hovered_point"], buffers);
-        xwidgets_serialize(enable_move, state["enable_move"], buffers);
-        xwidgets_serialize(enable_delete, state["enable_delete"], buffers);
-        xwidgets_serialize(restrict_x, state["restrict_x"], buffers);
-        xwidgets_serialize(restrict_y, state["restrict_y"], buffers);
-        xwidgets_serialize(update_on_move, state["update_on_move"], buffers);
-        xwidgets_serialize(selected, state["selected"], buffers);
+        return !m_selection_owners.empty();
     }
 
+    /**
+     * Applies the selected property of a patch, unless a selector owns the
+     * selection, in which case its value is sent back to the front-end.
+     */
     template <class D>
-    template <class XS, class YS>
-    inline xscatter_base<D>::xscatter_base(XS&& xs, YS&& ys)
-        : base_type()
+    template <class P>
+    inline void xmark<D>::apply_selection_patch(P& property, const nl::json& patch, const xeus::buffer_sequence& buffers)
     {
-        set_defaults();
-
-        this->scales()["x"] = std::forward<XS>(xs);
-        this->scales()["y"] = std::forward<YS>(ys);
+        if (!has_selection_owner())
+        {
+            xw::set_property_from_patch(property, patch, buffers);
+        }
+        else if (patch.find(property.name()) != patch.end())
+        {
+            this->resend(property);
+        }
     }
 
     template <class D>
-    template <class XS, class YS, class CS>
-    inline xscatter_base<D>::xscatter_base(XS&& xs, YS&& ys, CS&& cs)
-        : base_type()
+    inline xeus::xguid xmark<D>::scale_id(const std::string& name) const
     {
-        set_defaults();
-
-        this->scales()["x"] = std::forward<XS>(xs);
-        this->scales()["y"] = std::forward<YS>(ys);
-        this->scales()["color"] = std::forward<CS>(cs);
+        auto it = scales().find(name);
+        return it != scales().end() ? it->second.id() : xeus::xguid();
     }
 
     template <class D>
-    template <class XS, class YS, class SS, class OS>
-    inline xscatter_base<D>::xscatter_base(XS&& xs, YS&& ys, SS&& ss, OS&& os)
-        : base_type()
+    template <class T>
+    inline void xmark<D>::update_extent(const std::string& name, const T& values) const
     {
-        set_defaults();
-
-        this->scales()["x"] = std::forward<XS>(xs);
-        this->scales()["y"] = std::forward<YS>(ys);
-        this->scales()["size"] = std::forward<SS>(ss);
-        this->scales()["opacities"] = std::forward<OS>(os);
+        update_extent(name, values, detail::has_data_extent<T>());
     }
 
+    /**
+     * Updates the extent of the data property name. The values are only
+     * scanned when the scale of the property tracks its domain, or when
+     * the extent is queried.
+     */
     template <class D>
-    inline void xscatter_base<D>::set_defaults()
+    template <class T>
+    inline void xmark<D>::update_extent(const std::string& name, const T& values, std::true_type) const
+    {
+        m_extents.defer(name, scale_id(name), [&values]() { return detail::data_extent(values); });
+    }
+
+    template <class D>
+    template <class T>
+    inline void xmark<D>::update_extent(const std::string&, const T&, std::false_type) const
+    {
+    }
+
+    template <class D>
+    inline xextent xmark<D>::leading_extent(const xboxed_container<std::vector<double>>& values, std::size_t size) const
+    {
+        return compute_extent(values.data(), size);
+    }
+
+    template <class D>
+    template <class T>
+    inline xextent xmark<D>::leading_extent(const T&, std::size_t) const
+    {
+        return xextent();
+    }
+
+    /**
+     * Updates the extent of the data property name, whose values from
+     * offset were appended and whose dropped leading values had the given
+     * extent. The kept values are only scanned again when the dropped ones
+     * reached the previous bounds. The extent is deferred as in
+     * update_extent when the scale does not track its domain.
+     */
+    template <class D>
+    inline void xmark<D>::extend_extent(const std::string& name, const xboxed_container<std::vector<double>>& values,
+                                        std::size_t offset, const xextent& dropped) const
+    {
+        xeus::xguid id = scale_id(name);
+        if (!get_domain_tracker().listened(id))
+        {
+            update_extent(name, values);
+            return;
+        }
+        xextent extent = compute_extent(values.data() + offset, values.size() - offset);
+        if (offset != 0)
+        {
+            bool computed = m_extents.contains(name);
+            xextent previous = computed ? m_extents.extent(name) : xextent();
+            bool kept = computed &&
+                (dropped.empty() || (previous.min < dropped.min && dropped.max < previous.max));
+            extent.merge(kept ? previous : compute_extent(values.data(), offset));
+        }
+        m_extents.set(name, id, extent);
+    }
+
+    template <class D>
+    template <class T>
+    inline void xmark<D>::extend_extent(const std::string&, const T&, std::size_t, const xextent&) const
+    {
+    }
+
+    template <class D>
+    inline void xmark<D>::bind_extents() const
+    {
+        for (const auto& binding : m_extents.bindings())
+        {
+            m_extents.bind(binding.first, scale_id(binding.first));
+        }
+    }
+
+    namespace detail
+    {
+        template <class S>
+        inline std::size_t tail_size(const S& tail)
+        {
+            return static_cast<std::size_t>(std::distance(std::begin(tail), std::end(tail)));
+        }
+
+        inline xextent data_extent(const xboxed_container<std::vector<double>>& values)
+        {
+            return compute_extent(values.data(), values.size());
+        }
+
+        inline xextent data_extent(const xmatrix<double>& values)
+        {
+            return compute_extent(values.data(), values.size());
+        }
+
+        template <class T>
+        inline xextent data_extent(const xtl::xoptional<T>& values)
+        {
+            return values.has_value() ? data_extent(values.value()) : xextent();
+        }
+
+        inline xlifetime::xlifetime()
+            : m_token(std::make_shared<char>())
+        {
+        }
+
+        inline xlifetime::xlifetime(const xlifetime&)
+            : xlifetime()
+        {
+        }
+
+        inline xlifetime::xlifetime(xlifetime&&)
+            : xlifetime()
+        {
+        }
+
+        inline xlifetime& xlifetime::operator=(const xlifetime&) noexcept
+        {
+            return *this;
+        }
+
+        inline xlifetime& xlifetime::operator=(xlifetime&&) noexcept
+        {
+            return *this;
+        }
+
+        inline std::weak_ptr<const void> xlifetime::watch() const noexcept
+        {
+            return m_token;
+        }
+
+        inline xselection_owners::xselection_owners(const xselection_owners&) noexcept
+        {
+        }
+
+        inline xselection_owners::xselection_owners(xselection_owners&&) noexcept
+        {
+        }
+
+        inline xselection_owners& xselection_owners::operator=(const xselection_owners&) noexcept
+        {
+            return *this;
+        }
+
+        inline xselection_owners& xselection_owners::operator=(xselection_owners&&) noexcept
+        {
+            return *this;
+        }
+
+        inline void xselection_owners::add(std::weak_ptr<const void> owner)
+        {
+            m_owners.erase(std::remove_if(m_owners.begin(), m_owners.end(),
+                                          [](const std::weak_ptr<const void>& o) { return o.expired(); }),
+                           m_owners.end());
+            m_owners.push_back(std::move(owner));
+        }
+
+        inline bool xselection_owners::empty() const noexcept
+        {
+            return std::none_of(m_owners.cbegin(), m_owners.cend(),
+                                [](const std::weak_ptr<const void>& o) { return !o.expired(); });
+        }
+
+        /**
+         * Buffer backing the window of a data property appended with a
+         * max_length. The property views the values of the window, and new
+         * values are written after them. A new buffer is allocated when the
+         * buffer is full, hence the values viewed by copies of the property
+         * never change.
+         */
+        template <class T>
+        struct xwindow_buffer
+        {
+            std::vector<T> values;
+            std::size_t end = 0;
+        };
+
+        /**
+         * Appends tail to values and drops the leading values exceeding a
+         * non-zero max_length. Dropping values costs O(max_length) once
+         * every max_length appended values, instead of erasing them from
+         * the front of the container at each append.
+         */
+        template <class T, class S>
+        inline void append_values(xboxed_container<std::vector<T>>& values, std::shared_ptr<void>& window,
+                                  const S& tail, std::size_t max_length)
+        {
+            using buffer_type = xwindow_buffer<T>;
+            std::size_t added = tail_size(tail);
+            if (max_length == 0)
+            {
+                std::vector<T>& container = values;
+                container.insert(container.end(), std::begin(tail), std::end(tail));
+                window.reset();
+                return;
+            }
+
+            std::size_t size = values.size();
+            std::size_t new_size = std::min(size + added, max_length);
+            std::size_t kept = new_size > added ? new_size - added : 0;
+            std::size_t written = new_size - kept;
+            const T* data = values.data();
+            auto buffer = std::static_pointer_cast<buffer_type>(window);
+            bool attached = buffer != nullptr && values.is_view() && size <= buffer->end &&
+                            data == buffer->values.data() + (buffer->end - size);
+            if (!attached || buffer->end + written > buffer->values.size())
+            {
+                auto fresh = std::make_shared<buffer_type>();
+                fresh->values.resize(2 * max_length);
+                std::copy(data + (size - kept), data + size, fresh->values.begin());
+                fresh->end = kept;
+                buffer = std::move(fresh);
+                window = buffer;
+            }
+            auto first = std::next(std::begin(tail), static_cast<std::ptrdiff_t>(added - written));
+            std::copy(first, std::end(tail), buffer->values.begin() + static_cast<std::ptrdiff_t>(buffer->end));
+            buffer->end += written;
+            values = xboxed_container<std::vector<T>>::view(buffer->values.data() + (buffer->end - new_size),
+                                                            new_size, buffer);
+        }
+    }
+
+    /*************************
+     * xlines implementation *
+     *************************/
+
+    template <class D>
+    inline void xlines<D>::apply_patch(const nl::json& patch, const xeus::buffer_sequence& buffers)
+    {
+        using xw::set_property_from_patch;
+        base_type::apply_patch(patch, buffers);
+
+        set_property_from_patch(x, patch, buffers);
+        set_property_from_patch(y, patch, buffers);
+        set_property_from_patch(color, patch, buffers);
+        set_property_from_patch(colors, patch, buffers);
+        set_property_from_patch(fill_colors, patch, buffers);
+        set_property_from_patch(stroke_width, patch, buffers);
+        set_property_from_patch(labels_visibility, patch, buffers);
+        set_property_from_patch(curves_subset, patch, buffers);
+        set_property_from_patch(line_style, patch, buffers);
+        set_property_from_patch(interpolation, patch, buffers);
+        set_property_from_patch(close_path, patch, buffers);
+        set_property_from_patch(fill, patch, buffers);
+        set_property_from_patch(marker, patch, buffers);
+        set_property_from_patch(marker_size, patch, buffers);
+        set_property_from_patch(opacities, patch, buffers);
+        set_property_from_patch(fill_opacities, patch, buffers);
+    }
+
+    template <class D>
+    inline void xlines<D>::serialize_state(nl::json& state, xeus::buffer_sequence& buffers) const
+    {
+        using xw::xwidgets_serialize;
+        base_type::serialize_state(state, buffers);
+
+        serialize_xy(state, buffers);
+        xwidgets_serialize(color, state["color"], buffers);
+        xwidgets_serialize(colors, state["colors"], buffers);
+        xwidgets_serialize(fill_colors, state["fill_colors"], buffers);
+        xwidgets_serialize(stroke_width, state["stroke_width"], buffers);
+        xwidgets_serialize(labels_visibility, state["labels_visibility"], buffers);
+        xwidgets_serialize(curves_subset, state["curves_subset"], buffers);
+        xwidgets_serialize(line_style, state["line_style"], buffers);
+        xwidgets_serialize(interpolation, state["interpolation"], buffers);
+        xwidgets_serialize(close_path, state["close_path"], buffers);
+        xwidgets_serialize(fill, state["fill"], buffers);
+        xwidgets_serialize(marker, state["marker"], buffers);
+        xwidgets_serialize(marker_size, state["marker_size"], buffers);
+        xwidgets_serialize(opacities, state["opacities"], buffers);
+        xwidgets_serialize(fill_opacities, state["fill_opacities"], buffers);
+    }
+
+    template <class D>
+    template <class XS, class YS>
+    inline xlines<D>::xlines(XS&& xs, YS&& ys)
+        : base_type()
+    {
+        set_defaults();
+
+        this->scales()["x"] = std::forward<XS>(xs);
+        this->scales()["y"] = std::forward<YS>(ys);
+    }
+
+    /**
+     * Appends xs and ys to x and y, keeping their max_length trailing
+     * values when max_length is not zero. This is a convenience setter:
+     * the front-end has no incremental update, so x and y are sent as a
+     * whole in a single patch and each call costs O(size) on the wire.
+     * Only the local storage, the extents and the pyramid are updated
+     * incrementally. A non-zero max_points bounds the sent points.
+     */
+    template <class D>
+    template <class XS, class YS>
+    inline void xlines<D>::append(const XS& xs, const YS& ys, std::size_t max_length)
+    {
+        if (detail::tail_size(xs) != detail::tail_size(ys))
+        {
+            throw std::invalid_argument("the appended x and y values must have the same size");
+        }
+        auto hold = this->hold_sync();
+        this->append_data(x, xs, max_length);
+        std::size_t dropped = this->append_data(y, ys, max_length);
+        if (m_has_pyramid)
+        {
+            const data_type& y_values = y();
+            m_pyramid.update(y_values.data(), y_values.size(), dropped);
+            m_pyramid_version = this->property_version("y");
+        }
+    }
+
+    /**
+     * When downsampling is enabled, changes of x and y are routed through
+     * the change tracker so that both are sent together, since the
+     * selected points depend on both.
+     */
+    template <class D>
+    template <class P>
+    inline void xlines<D>::notify(const P& property) const
+    {
+        const void* p = &property;
+        if (p == &selected_points)
+        {
+            // The full resolution selection stays on the server.
+            return;
+        }
+        if (is_downsampling_property(&property))
+        {
+            auto hold = this->hold_sync();
+            base_type::notify(property);
+        }
+        else
+        {
+            base_type::notify(property);
+        }
+    }
+
+    template <class D>
+    template <class P>
+    inline void xlines<D>::serialize_property(const P& property, nl::json& state, xeus::buffer_sequence& buffers) const
+    {
+        if (is_downsampling_property(&property))
+        {
+            // The properties of the group are serialized once per patch.
+            if (state.find("x") == state.end())
+            {
+                serialize_xy(state, buffers);
+            }
+        }
+        else
+        {
+            base_type::serialize_property(property, state, buffers);
+        }
+    }
+
+    /**
+     * Returns whether x and y are downsampled or sliced on the wire, in
+     * which case the front-end only holds a subset of the points.
+     */
+    template <class D>
+    inline bool xlines<D>::is_downsampled() const noexcept
+    {
+        return max_points() != 0 && (std::min)(x().size(), y().size()) > max_points();
+    }
+
+    template <class D>
+    inline bool xlines<D>::is_downsampling_property(const void* property) const noexcept
+    {
+        return property == &max_points || property == &downsampling ||
+            (max_points() != 0 && (property == &x || property == &y));
+    }
+
+    /**
+     * Serializes x and y. When max_points is non-zero and the curve has
+     * more points, only the points selected by the downsampling method are
+     * sent; the full resolution data is kept in x and y.
+     *
+     * Once the domain of the x scale is known, e.g. after a pan-zoom
+     * interaction, only the visible slice of the curve and a margin of
+     * half its width on each side are sent, with max_points points for
+     * the visible part.
+     */
+    template <class D>
+    inline void xlines<D>::serialize_xy(nl::json& state, xeus::buffer_sequence& buffers) const
+    {
+        using xw::xwidgets_serialize;
+        const data_type& x_values = x();
+        const data_type& y_values = y();
+        std::size_t size = (std::min)(x_values.size(), y_values.size());
+        if (max_points() == 0 || size <= max_points())
+        {
+            m_viewport.first = 0;
+            m_viewport.last = size;
+            m_viewport.visible = size;
+            xwidgets_serialize(x, state["x"], buffers);
+            xwidgets_serialize(y, state["y"], buffers);
+            return;
+        }
+
+        watch_x_domain();
+        std::size_t first = 0;
+        std::size_t last = size;
+        std::size_t visible = size;
+        std::size_t lo, hi;
+        if (visible_range(size, lo, hi))
+        {
+            visible = (std::max)(hi - lo, std::size_t(1));
+            std::size_t margin = visible / 2;
+            first = lo > margin ? lo - margin : 0;
+            last = (std::min)(hi + margin, size);
+        }
+        m_viewport.first = first;
+        m_viewport.last = last;
+        m_viewport.visible = visible;
+
+        std::size_t slice_size = last - first;
+        std::size_t budget = static_cast<std::size_t>(
+            static_cast<double>(max_points()) * static_cast<double>(slice_size) / static_cast<double>(visible));
+        if (slice_size <= budget)
+        {
+            serialize_data_range(x_values.data() + first, slice_size, state["x"], buffers);
+            serialize_data_range(y_values.data() + first, slice_size, state["y"], buffers);
+            return;
+        }
+
+        // The pyramid returns indices in the whole curve, the kernels
+        // indices in the slice.
+        std::vector<std::size_t> indices;
+        std::size_t offset = first;
+        xdownsampling_method method = downsampling_method(downsampling());
+        if (m_has_pyramid && method != xdownsampling_method::lttb)
+        {
+            sync_pyramid();
+            offset = 0;
+            if (method == xdownsampling_method::minmax)
+            {
+                m_pyramid.minmax_indices(y_values.data(), first, last, (std::max)(budget / 2, std::size_t(1)), indices);
+            }
+            else
+            {
+                m_pyramid.m4_indices(y_values.data(), first, last, (std::max)(budget / 4, std::size_t(1)), indices);
+            }
+        }
+        else
+        {
+            downsample_indices(method, x_values.data() + first, y_values.data() + first, slice_size, budget, indices);
+        }
+        std::vector<double> values;
+        gather(x_values.data() + offset, indices, values);
+        serialize_data_range(values.data(), values.size(), state["x"], buffers);
+        gather(y_values.data() + offset, indices, values);
+        serialize_data_range(values.data(), values.size(), state["y"], buffers);
+    }
+
+    /**
+     * Attaches a min/max pyramid to y, so that the minmax and m4
+     * downsampling methods select the points of any range in
+     * O(max_points log n) instead of scanning it. The pyramid is kept up
+     * to date when y is assigned or appended to; its memory usage is
+     * reported by pyramid().memory_usage().
+     */
+    template <class D>
+    inline void xlines<D>::build_pyramid(std::size_t block_size)
+    {
+        const data_type& y_values = y();
+        m_pyramid = pyramid_type(block_size);
+        m_pyramid.build(y_values.data(), y_values.size());
+        m_pyramid_version = this->property_version("y");
+        m_has_pyramid = true;
+    }
+
+    template <class D>
+    inline void xlines<D>::drop_pyramid()
+    {
+        m_pyramid = pyramid_type(m_pyramid.block_size());
+        m_has_pyramid = false;
+    }
+
+    template <class D>
+    inline bool xlines<D>::has_pyramid() const noexcept
+    {
+        return m_has_pyramid;
+    }
+
+    template <class D>
+    inline auto xlines<D>::pyramid() const noexcept -> const pyramid_type&
+    {
+        return m_pyramid;
+    }
+
+    /**
+     * Builds the pyramid again when y was assigned since it was last
+     * updated; values appended through the y accessor are indexed
+     * incrementally.
+     */
+    template <class D>
+    inline void xlines<D>::sync_pyramid() const
+    {
+        const data_type& y_values = y();
+        xsync_state::version_type version = this->property_version("y");
+        if (version != m_pyramid_version)
+        {
+            m_pyramid.build(y_values.data(), y_values.size());
+            m_pyramid_version = version;
+        }
+        else if (y_values.size() != m_pyramid.size())
+        {
+            m_pyramid.update(y_values.data(), y_values.size());
+        }
+    }
+
+    template <class D>
+    inline void xlines<D>::watch_x_domain() const
+    {
+        xeus::xguid id = this->scale_id("x");
+        if (!m_x_domain.subscribed() || m_x_domain.scale_id() != id)
+        {
+            m_x_domain.subscribe(id, [this](const xtl::xoptional<double>& min, const xtl::xoptional<double>& max) {
+                on_x_domain(min, max);
+            }, [this]() { this->defer_sync(); }, [this]() { this->resume_sync(); });
+        }
+    }
+
+    /**
+     * Sends the curve again when the domain of the x scale changed enough
+     * for the sent points not to cover the visible range, or to be too
+     * coarse for it. The sent slice is twice as wide as the visible range
+     * and twice as dense as needed, so that the successive events of a
+     * fast pan or wheel zoom only trigger a recomputation each time the
+     * view leaves the slice or is zoomed in twice as much.
+     */
+    template <class D>
+    inline void xlines<D>::on_x_domain(const xtl::xoptional<double>& min, const xtl::xoptional<double>& max) const
+    {
+        if (max_points() == 0 || m_x_domain.scale_id() != this->scale_id("x"))
+        {
+            return;
+        }
+
+        m_viewport.has_domain = min.has_value() && max.has_value();
+        if (m_viewport.has_domain)
+        {
+            m_viewport.min = (std::min)(min.value(), max.value());
+            m_viewport.max = (std::max)(min.value(), max.value());
+        }
+
+        if (needs_refresh())
+        {
+            this->resend(x);
+        }
+    }
+
+    template <class D>
+    inline bool xlines<D>::is_x_sorted(const data_type& x_values, std::size_t size) const
+    {
+        xsync_state::version_type version = this->property_version("x");
+        if (m_viewport.sorted_size != size || m_viewport.sorted_version != version)
+        {
+            m_viewport.sorted = std::is_sorted(x_values.begin(), x_values.begin() + static_cast<std::ptrdiff_t>(size));
+            m_viewport.sorted_size = size;
+            m_viewport.sorted_version = version;
+        }
+        return m_viewport.sorted;
+    }
+
+    /**
+     * Computes the range of indices of the points inside the domain of the
+     * x scale, including one point on each side so that the segments
+     * crossing the edges are drawn. Returns false when the domain is not
+     * known or when x is not sorted.
+     */
+    template <class D>
+    inline bool xlines<D>::visible_range(std::size_t size, std::size_t& first, std::size_t& last) const
+    {
+        const data_type& x_values = x();
+        if (!m_viewport.has_domain || !is_x_sorted(x_values, size))
+        {
+            return false;
+        }
+        auto begin = x_values.begin();
+        auto end = begin + static_cast<std::ptrdiff_t>(size);
+        first = static_cast<std::size_t>(std::lower_bound(begin, end, m_viewport.min) - begin);
+        last = static_cast<std::size_t>(std::upper_bound(begin, end, m_viewport.max) - begin);
+        first = first > 0 ? first - 1 : 0;
+        last = (std::min)(last + 1, size);
+        return true;
+    }
+
+    template <class D>
+    inline bool xlines<D>::needs_refresh() const
+    {
+        const data_type& x_values = x();
+        const data_type& y_values = y();
+        std::size_t size = (std::min)(x_values.size(), y_values.size());
+        if (size <= max_points())
+        {
+            return false;
+        }
+        std::size_t first = 0;
+        std::size_t last = size;
+        visible_range(size, first, last);
+        std::size_t visible = (std::max)(last - first, std::size_t(1));
+        bool covered = first >= m_viewport.first && last <= m_viewport.last;
+        bool detailed = 2 * visible >= m_viewport.visible;
+        return !(covered && detailed);
+    }
+
+    template <class D>
+    inline void xlines<D>::set_defaults()
+    {
+        this->_model_name() = "LinesModel";
+        this->_view_name() = "Lines";
+        this->add_data_buffer_paths({"x", "y"});
+        this->scales_metadata() = {
+            {"x", {{"orientation", "horizontal"}, {"dimension", "x"}}},
+            {"y", {{"orientation", "vertical"}, {"dimension", "y"}}},
+            {"color", {{"dimension", "color"}}}};
+    }
+
+    /********************************
+     * xscatter_base implementation *
+     ********************************/
+
+    template <class D>
+    inline void xscatter_base<D>::apply_patch(const nl::json& patch, const xeus::buffer_sequence& buffers)
+    {
+        using xw::set_property_from_patch;
+        base_type::apply_patch(patch, buffers);
+
+        set_property_from_patch(x, patch, buffers);
+        set_property_from_patch(y, patch, buffers);
+        set_property_from_patch(color, patch, buffers);
+        set_property_from_patch(opacity, patch, buffers);
+        set_property_from_patch(size, patch, buffers);
+        set_property_from_patch(rotation, patch, buffers);
+        set_property_from_patch(default_opacities, patch, buffers);
+        set_property_from_patch(hovered_style, patch, buffers);
+        set_property_from_patch(unhovered_style, patch, buffers);
+        set_property_from_patch(hovered_point, patch, buffers);
+        set_property_from_patch(enable_move, patch, buffers);
+        set_property_from_patch(enable_delete, patch, buffers);
+        set_property_from_patch(restrict_x, patch, buffers);
+        set_property_from_patch(restrict_y, patch, buffers);
+        set_property_from_patch(update_on_move, patch, buffers);
+        this->apply_selection_patch(selected, patch, buffers);
+    }
+
+    template <class D>
+    inline void xscatter_base<D>::serialize_state(nl::json& state, xeus::buffer_sequence& buffers) const
+    {
+        using xw::xwidgets_serialize;
+        base_type::serialize_state(state, buffers);
+
+        xwidgets_serialize(x, state["x"], buffers);
+        xwidgets_serialize(y, state["y"], buffers);
+        xwidgets_serialize(color, state["color"], buffers);
+        xwidgets_serialize(opacity, state["opacity"], buffers);
+        xwidgets_serialize(size, state["size"], buffers);
+        xwidgets_serialize(rotation, state["rotation"], buffers);
+        xwidgets_serialize(default_opacities, state["default_opacities"], buffers);
+        xwidgets_serialize(hovered_style, state["hovered_style"], buffers);
+        xwidgets_serialize(unhovered_style, state["unhovered_style"], buffers);
+        xwidgets_serialize(hovered_point, state["hovered_point"], buffers);
+        xwidgets_serialize(enable_move, state["enable_move"], buffers);
+        xwidgets_serialize(enable_delete, state["enable_delete"], buffers);
+        xwidgets_serialize(restrict_x, state["restrict_x"], buffers);
+        xwidgets_serialize(restrict_y, state["restrict_y"], buffers);
+        xwidgets_serialize(update_on_move, state["update_on_move"], buffers);
+        xwidgets_serialize(selected, state["selected"], buffers);
+    }
+
+    template <class D>
+    template <class XS, class YS>
+    inline xscatter_base<D>::xscatter_base(XS&& xs, YS&& ys)
+        : base_type()
+    {
+        set_defaults();
+
+        this->scales()["x"] = std::forward<XS>(xs);
+        this->scales()["y"] = std::forward<YS>(ys);
+    }
+
+    template <class D>
+    template <class XS, class YS, class CS>
+    inline xscatter_base<D>::xscatter_base(XS&& xs, YS&& ys, CS&& cs)
+        : base_type()
+    {
+        set_defaults();
+
+        this->scales()["x"] = std::forward<XS>(xs);
+        this->scales()["y"] = std::forward<YS>(ys);
+        this->scales()["color"] = std::forward<CS>(cs);
+    }
+
+    template <class D>
+    template <class XS, class YS, class SS, class OS>
+    inline xscatter_base<D>::xscatter_base(XS&& xs, YS&& ys, SS&& ss, OS&& os)
+        : base_type()
+    {
+        set_defaults();
+
+        this->scales()["x"] = std::forward<XS>(xs);
+        this->scales()["y"] = std::forward<YS>(ys);
+        this->scales()["size"] = std::forward<SS>(ss);
+        this->scales()["opacities"] = std::forward<OS>(os);
+    }
+
+    template <class D>
+    inline void xscatter_base<D>::set_defaults()
     {
         this->scales_metadata() = {
             {"x", {{"orientation", "horizontal"}, {"dimension", "x"}}},
@@ -899,6 +1937,25 @@ namespace xpl
             {"size", {{"dimension", "size"}}},
             {"opacity", {{"dimension", "opacity"}}},
             {"rotation", {{"dimension", "rotation"}}}};
+        this->add_data_buffer_paths({"x", "y", "color", "opacity", "size", "rotation"});
+    }
+
+    /**
+     * Appends xs and ys to x and y, keeping their max_length trailing
+     * values when max_length is not zero. As for xlines, x and y are sent
+     * as a whole in a single patch.
+     */
+    template <class D>
+    template <class XS, class YS>
+    inline void xscatter_base<D>::append(const XS& xs, const YS& ys, std::size_t max_length)
+    {
+        if (detail::tail_size(xs) != detail::tail_size(ys))
+        {
+            throw std::invalid_argument("the appended x and y values must have the same size");
+        }
+        auto hold = this->hold_sync();
+        this->append_data(x, xs, max_length);
+        this->append_data(y, ys, max_length);
     }
 
     template <class D>
@@ -1021,6 +2078,7 @@ namespace xpl
     {
         this->_model_name() = "ScatterModel";
         this->_view_name() = "Scatter";
+        this->add_data_buffer_paths({"skew"});
     }
 
     /***********************
@@ -1091,6 +2149,7 @@ namespace xpl
     {
         this->_view_name() = "Pie";
         this->_model_name() = "PieModel";
+        this->add_data_buffer_paths({"color", "sizes"});
     }
 
     /*************************
@@ -1139,6 +2198,26 @@ namespace xpl
         set_defaults();
     }
 
+    /**
+     * Appends xs, ys and texts to x, y and text, keeping their max_length
+     * trailing values when max_length is not zero. The three properties
+     * are sent as a whole in a single patch.
+     */
+    template <class D>
+    template <class XS, class YS, class TS>
+    inline void xlabel<D>::append(const XS& xs, const YS& ys, const TS& texts, std::size_t max_length)
+    {
+        std::size_t size = detail::tail_size(xs);
+        if (detail::tail_size(ys) != size || detail::tail_size(texts) != size)
+        {
+            throw std::invalid_argument("the appended x, y and text values must have the same size");
+        }
+        auto hold = this->hold_sync();
+        this->append_data(this->x, xs, max_length);
+        this->append_data(this->y, ys, max_length);
+        this->append_data(text, texts, max_length);
+    }
+
     template <class D>
     inline void xlabel<D>::set_defaults()
     {
@@ -1201,6 +2280,7 @@ namespace xpl
         this->scales_metadata() = {
             {"sample", {{"orientation", "horizontal"}, {"dimension", "x"}}},
             {"count", {{"orientation", "vertical"}, {"dimension", "y"}}}};
+        this->add_data_buffer_paths({"count", "sample"});
     }
 
     /***************************
@@ -1218,7 +2298,11 @@ namespace xpl
         set_property_from_patch(scales_metadata, patch, buffers);
         set_property_from_patch(stroke, patch, buffers);
         set_property_from_patch(x, patch, buffers);
-        set_property_from_patch(y, patch, buffers);
+        // In summary mode, the front-end only holds synthetic samples.
+        if (!server_summary() && !m_streaming)
+        {
+            set_property_from_patch(y, patch, buffers);
+        }
     }
 
     template <class D>
@@ -1232,7 +2316,161 @@ namespace xpl
         xwidgets_serialize(scales_metadata, state["scales_metadata"], buffers);
         xwidgets_serialize(stroke, state["stroke"], buffers);
         xwidgets_serialize(x, state["x"], buffers);
-        xwidgets_serialize(y, state["y"], buffers);
+        serialize_y(state, buffers);
+    }
+
+    /**
+     * Returns the summaries of the boxes, computed from y, or from the
+     * sketches in streaming mode.
+     */
+    template <class D>
+    inline std::vector<xbox_summary> xboxplot<D>::summaries() const
+    {
+        if (m_streaming)
+        {
+            std::vector<xbox_summary> res(m_sketches.size());
+            parallel_for(0, m_sketches.size(), 1, [this, &res](std::size_t first, std::size_t last) {
+                for (std::size_t i = first; i < last; ++i)
+                {
+                    res[i] = m_sketches[i].summary();
+                }
+            });
+            return res;
+        }
+        const std::vector<std::vector<double>>& boxes = y();
+        return box_summaries(boxes, max_outliers());
+    }
+
+    /**
+     * Switches to streaming mode with nb_boxes boxes: the observations
+     * passed to add_samples or merge_samples are summarized by sketches
+     * retaining O(k + max_outliers) values per box instead of being stored
+     * in y, and only the summaries are sent.
+     */
+    template <class D>
+    inline void xboxplot<D>::start_streaming(std::size_t nb_boxes, std::size_t k)
+    {
+        m_sketches.assign(nb_boxes, xbox_sketch(k, max_outliers()));
+        m_streaming = true;
+        this->notify(y);
+    }
+
+    /**
+     * Leaves streaming mode, the sketches are dropped and y is sent again.
+     */
+    template <class D>
+    inline void xboxplot<D>::stop_streaming()
+    {
+        m_sketches.clear();
+        m_streaming = false;
+        this->notify(y);
+    }
+
+    template <class D>
+    inline bool xboxplot<D>::streaming() const noexcept
+    {
+        return m_streaming;
+    }
+
+    template <class D>
+    inline auto xboxplot<D>::sketches() const noexcept -> const sketches_type&
+    {
+        return m_sketches;
+    }
+
+    /**
+     * Adds contiguous observations to a box in streaming mode and sends the
+     * updated summaries.
+     */
+    template <class D>
+    template <class S>
+    inline void xboxplot<D>::add_samples(std::size_t box, const S& samples)
+    {
+        if (!m_streaming)
+        {
+            throw std::logic_error("add_samples requires the streaming mode of xboxplot");
+        }
+        m_sketches.at(box).update(samples.data(), samples.size());
+        this->notify(y);
+    }
+
+    /**
+     * Merges a sketch built elsewhere, e.g. by another process, into a box
+     * in streaming mode and sends the updated summaries.
+     */
+    template <class D>
+    inline void xboxplot<D>::merge_samples(std::size_t box, const xbox_sketch& sketch)
+    {
+        if (!m_streaming)
+        {
+            throw std::logic_error("merge_samples requires the streaming mode of xboxplot");
+        }
+        m_sketches.at(box).merge(sketch);
+        this->notify(y);
+    }
+
+    /**
+     * Changes of the summary mode or of the number of outliers send y
+     * again, together with the property.
+     */
+    template <class D>
+    template <class P>
+    inline void xboxplot<D>::notify(const P& property) const
+    {
+        if (is_summary_property(&property))
+        {
+            auto hold = this->hold_sync();
+            base_type::notify(property);
+        }
+        else
+        {
+            base_type::notify(property);
+        }
+    }
+
+    template <class D>
+    template <class P>
+    inline void xboxplot<D>::serialize_property(const P& property, nl::json& state, xeus::buffer_sequence& buffers) const
+    {
+        if (is_summary_property(&property))
+        {
+            serialize_y(state, buffers);
+        }
+        else
+        {
+            base_type::serialize_property(property, state, buffers);
+        }
+    }
+
+    template <class D>
+    inline bool xboxplot<D>::is_summary_property(const void* property) const noexcept
+    {
+        return property == &server_summary || property == &max_outliers || property == &y;
+    }
+
+    /**
+     * In summary mode, each box is sent as a sample of at most
+     * 4 * max_outliers + 5 values with the same box plot as the
+     * observations, since the front-end computes the quartiles itself,
+     * and is serialized in the same form as y.
+     */
+    template <class D>
+    inline void xboxplot<D>::serialize_y(nl::json& state, xeus::buffer_sequence& buffers) const
+    {
+        using xw::xwidgets_serialize;
+        if (!server_summary() && !m_streaming)
+        {
+            xwidgets_serialize(y, state["y"], buffers);
+            return;
+        }
+
+        std::vector<xbox_summary> boxes = summaries();
+        std::vector<std::vector<double>> samples(boxes.size());
+        for (std::size_t i = 0; i < boxes.size(); ++i)
+        {
+            samples[i] = box_sample(boxes[i]);
+        }
+        xwidgets_serialize(data_type_y(std::move(samples)), state["y"], buffers);
     }
 
     template <class D>
@@ -1247,77 +2485,304 @@ namespace xpl
     }
 
     template <class D>
-    inline void xboxplot<D>::set_defaults()
+    inline void xboxplot<D>::set_defaults()
+    {
+        this->_view_name() = "Boxplot";
+        this->_model_name() = "BoxplotModel";
+        this->scales_metadata() = {
+            {"x", {{"orientation", "horizontal"}, {"dimension", "x"}}},
+            {"y", {{"orientation", "vertical"}, {"dimension", "y"}}}};
+        this->add_data_buffer_paths({"x"});
+    }
+
+    /************************
+     * xbars implementation *
+     ************************/
+
+    template <class D>
+    inline void xbars<D>::apply_patch(const nl::json& patch, const xeus::buffer_sequence& buffers)
+    {
+        using xw::set_property_from_patch;
+        base_type::apply_patch(patch, buffers);
+        set_property_from_patch(align, patch, buffers);
+        set_property_from_patch(color, patch, buffers);
+        set_property_from_patch(color_mode, patch, buffers);
+        set_property_from_patch(colors, patch, buffers);
+        set_property_from_patch(opacities, patch, buffers);
+        set_property_from_patch(orientation, patch, buffers);
+        set_property_from_patch(padding, patch, buffers);
+        set_property_from_patch(scales_metadata, patch, buffers);
+        set_property_from_patch(stroke, patch, buffers);
+        set_property_from_patch(type, patch, buffers);
+        set_property_from_patch(x, patch, buffers);
+        set_property_from_patch(y, patch, buffers);
+    }
+
+    template <class D>
+    inline void xbars<D>::serialize_state(nl::json& state, xeus::buffer_sequence& buffers) const
+    {
+        using xw::xwidgets_serialize;
+        base_type::serialize_state(state, buffers);
+        xwidgets_serialize(align, state["align"], buffers);
+        xwidgets_serialize(color, state["color"], buffers);
+        xwidgets_serialize(color_mode, state["color_mode"], buffers);
+        xwidgets_serialize(colors, state["colors"], buffers);
+        xwidgets_serialize(opacities, state["opacities"], buffers);
+        xwidgets_serialize(orientation, state["orientation"], buffers);
+        xwidgets_serialize(padding, state["padding"], buffers);
+        xwidgets_serialize(scales_metadata, state["scales_metadata"], buffers);
+        xwidgets_serialize(stroke, state["stroke"], buffers);
+        xwidgets_serialize(type, state["type"], buffers);
+        xwidgets_serialize(x, state["x"], buffers);
+        xwidgets_serialize(y, state["y"], buffers);
+    }
+
+    template <class D>
+    template <class XS, class YS>
+    inline xbars<D>::xbars(XS&& xs, YS&& ys)
+        : base_type()
+    {
+        set_defaults();
+
+        this->scales()["x"] = std::forward<XS>(xs);
+        this->scales()["y"] = std::forward<YS>(ys);
+    }
+
+    template <class D>
+    inline void xbars<D>::set_defaults()
+    {
+        this->_view_name() = "Bars";
+        this->_model_name() = "BarsModel";
+        this->scales_metadata() = {
+            {"x", {{"orientation", "horizontal"}, {"dimension", "x"}}},
+            {"y", {{"orientation", "vertical"}, {"dimension", "y"}}},
+            {"color", {{"dimension", "color"}}}};
+        this->add_data_buffer_paths({"x", "y"});
+    }
+
+    /*******************************
+     * xbinned_hist implementation *
+     *******************************/
+
+    template <class D>
+    inline void xbinned_hist<D>::apply_patch(const nl::json& patch, const xeus::buffer_sequence& buffers)
+    {
+        using xw::set_property_from_patch;
+        base_type::apply_patch(patch, buffers);
+        set_property_from_patch(bins, patch, buffers);
+        set_property_from_patch(normalized, patch, buffers);
+    }
+
+    /**
+     * The sample is not part of the state, the front-end only receives
+     * the bins.
+     */
+    template <class D>
+    inline void xbinned_hist<D>::serialize_state(nl::json& state, xeus::buffer_sequence& buffers) const
+    {
+        using xw::xwidgets_serialize;
+        base_type::serialize_state(state, buffers);
+        xwidgets_serialize(bins, state["bins"], buffers);
+        xwidgets_serialize(normalized, state["normalized"], buffers);
+    }
+
+    /**
+     * Switches to streaming mode: the samples passed to add_samples are
+     * binned with the fixed bins of histogram, which may decay its counts
+     * or restrict them to a time window, in O(k) for k samples. The
+     * samples are appended to sample only if retain_samples
+     * is true, so that the memory used does not grow with the stream.
+     * This sets bins to the number of bins of histogram.
+     */
+    template <class D>
+    inline void xbinned_hist<D>::start_streaming(const xstreaming_histogram& histogram, bool retain_samples)
+    {
+        auto hold = this->hold_sync();
+        m_streaming = false;
+        std::vector<double>& values = this->sample();
+        values.clear();
+        bins = static_cast<int>(histogram.bins());
+        m_stream = histogram;
+        m_streaming = true;
+        m_retain_samples = retain_samples;
+        rebin();
+    }
+
+    /**
+     * Leaves streaming mode and bins the retained samples.
+     */
+    template <class D>
+    inline void xbinned_hist<D>::stop_streaming()
+    {
+        auto hold = this->hold_sync();
+        m_streaming = false;
+        rebin();
+    }
+
+    template <class D>
+    inline bool xbinned_hist<D>::streaming() const noexcept
+    {
+        return m_streaming;
+    }
+
+    template <class D>
+    inline const xstreaming_histogram& xbinned_hist<D>::streaming_histogram() const noexcept
+    {
+        return m_stream;
+    }
+
+    template <class D>
+    template <class S>
+    inline void xbinned_hist<D>::add_samples(const S& samples)
+    {
+        add_samples(samples, xstreaming_histogram::clock_type::now());
+    }
+
+    /**
+     * Adds contiguous samples to the streaming histogram at time now. The
+     * counts are sent in a regular patch of y only when some changed.
+     */
+    template <class D>
+    template <class S>
+    inline void xbinned_hist<D>::add_samples(const S& samples, time_point now)
+    {
+        if (!m_streaming)
+        {
+            throw std::logic_error("add_samples requires the streaming mode of xbinned_hist");
+        }
+
+        std::vector<std::size_t> changed;
+        m_stream.add(samples.data(), samples.size(), now, changed);
+        if (m_retain_samples)
+        {
+            std::vector<double>& values = this->sample();
+            values.insert(values.end(), std::begin(samples), std::end(samples));
+        }
+
+        if (!changed.empty())
+        {
+            set_stream_counts();
+        }
+    }
+
+    /**
+     * The sample is never sent: its changes only rebin. A change of the
+     * number of bins or of the normalization is sent with the new bins.
+     * In streaming mode, a change of the sample or of the number of bins
+     * restarts the stream from the sample.
+     */
+    template <class D>
+    template <class P>
+    inline void xbinned_hist<D>::notify(const P& property) const
+    {
+        const void* p = &property;
+        if (p == &sample || p == &bins || p == &normalized)
+        {
+            auto hold = this->hold_sync();
+            if (p != &sample)
+            {
+                base_type::notify(property);
+            }
+            if (m_streaming && p != &normalized)
+            {
+                restart_stream();
+            }
+            rebin();
+        }
+        else
+        {
+            base_type::notify(property);
+        }
+    }
+
+    /**
+     * Bins the sample in bins equal-width bins over its range, or takes
+     * the counts of the streaming histogram in streaming mode.
+     */
+    template <class D>
+    inline void xbinned_hist<D>::rebin() const
     {
-        this->_view_name() = "Boxplot";
-        this->_model_name() = "BoxplotModel";
-        this->scales_metadata() = {
-            {"x", {{"orientation", "horizontal"}, {"dimension", "x"}}},
-            {"y", {{"orientation", "vertical"}, {"dimension", "y"}}}};
-    }
+        if (m_streaming)
+        {
+            set_stream_counts();
+            return;
+        }
 
-    /************************
-     * xbars implementation *
-     ************************/
+        const data_type& values = sample();
+        std::size_t nb_bins = bins() > 0 ? static_cast<std::size_t>(bins()) : std::size_t(1);
+        double min = 0.;
+        double max = 1.;
+        if (histogram_range(values.data(), values.size(), min, max) && min == max)
+        {
+            min -= 0.5;
+            max += 0.5;
+        }
 
+        std::vector<double> counts;
+        histogram_counts(values.data(), values.size(), min, max, nb_bins, counts);
+        if (normalized())
+        {
+            normalize_histogram(min, max, counts);
+        }
+        std::vector<double> centers;
+        histogram_midpoints(min, max, nb_bins, centers);
+
+        // notify is const by convention, the widget itself is not.
+        derived_type& self = const_cast<derived_type&>(this->derived_cast());
+        auto hold = this->hold_sync();
+        self.x = std::move(centers);
+        self.y = std::move(counts);
+    }
+
+    /**
+     * Resizes the streaming histogram to bins and adds the sample to it,
+     * all the samples being considered as added now.
+     */
     template <class D>
-    inline void xbars<D>::apply_patch(const nl::json& patch, const xeus::buffer_sequence& buffers)
+    inline void xbinned_hist<D>::restart_stream() const
     {
-        using xw::set_property_from_patch;
-        base_type::apply_patch(patch, buffers);
-        set_property_from_patch(align, patch, buffers);
-        set_property_from_patch(color, patch, buffers);
-        set_property_from_patch(color_mode, patch, buffers);
-        set_property_from_patch(colors, patch, buffers);
-        set_property_from_patch(opacities, patch, buffers);
-        set_property_from_patch(orientation, patch, buffers);
-        set_property_from_patch(padding, patch, buffers);
-        set_property_from_patch(scales_metadata, patch, buffers);
-        set_property_from_patch(stroke, patch, buffers);
-        set_property_from_patch(type, patch, buffers);
-        set_property_from_patch(x, patch, buffers);
-        set_property_from_patch(y, patch, buffers);
+        m_stream.resize(bins() > 0 ? static_cast<std::size_t>(bins()) : std::size_t(1));
+        const data_type& values = sample();
+        std::vector<std::size_t> changed;
+        m_stream.add(values.data(), values.size(), xstreaming_histogram::clock_type::now(), changed);
     }
 
     template <class D>
-    inline void xbars<D>::serialize_state(nl::json& state, xeus::buffer_sequence& buffers) const
+    inline void xbinned_hist<D>::set_stream_counts() const
     {
-        using xw::xwidgets_serialize;
-        base_type::serialize_state(state, buffers);
-        xwidgets_serialize(align, state["align"], buffers);
-        xwidgets_serialize(color, state["color"], buffers);
-        xwidgets_serialize(color_mode, state["color_mode"], buffers);
-        xwidgets_serialize(colors, state["colors"], buffers);
-        xwidgets_serialize(opacities, state["opacities"], buffers);
-        xwidgets_serialize(orientation, state["orientation"], buffers);
-        xwidgets_serialize(padding, state["padding"], buffers);
-        xwidgets_serialize(scales_metadata, state["scales_metadata"], buffers);
-        xwidgets_serialize(stroke, state["stroke"], buffers);
-        xwidgets_serialize(type, state["type"], buffers);
-        xwidgets_serialize(x, state["x"], buffers);
-        xwidgets_serialize(y, state["y"], buffers);
+        std::vector<double> counts = m_stream.counts();
+        if (normalized())
+        {
+            normalize_histogram(m_stream.min(), m_stream.max(), counts);
+        }
+        std::vector<double> centers;
+        histogram_midpoints(m_stream.min(), m_stream.max(), m_stream.bins(), centers);
+
+        auto hold = this->hold_sync();
+        derived_type& self = const_cast<derived_type&>(this->derived_cast());
+        const std::vector<double>& xs = self.x();
+        if (centers != xs)
+        {
+            self.x = std::move(centers);
+        }
+        self.y = std::move(counts);
     }
 
     template <class D>
     template <class XS, class YS>
-    inline xbars<D>::xbars(XS&& xs, YS&& ys)
-        : base_type()
+    inline xbinned_hist<D>::xbinned_hist(XS&& xs, YS&& ys)
+        : base_type(std::forward<XS>(xs), std::forward<YS>(ys))
     {
         set_defaults();
-
-        this->scales()["x"] = std::forward<XS>(xs);
-        this->scales()["y"] = std::forward<YS>(ys);
     }
 
+    /**
+     * The bars of the histogram are adjacent.
+     */
     template <class D>
-    inline void xbars<D>::set_defaults()
+    inline void xbinned_hist<D>::set_defaults()
     {
-        this->_view_name() = "Bars";
-        this->_model_name() = "BarsModel";
-        this->scales_metadata() = {
-            {"x", {{"orientation", "horizontal"}, {"dimension", "x"}}},
-            {"y", {{"orientation", "vertical"}, {"dimension", "y"}}},
-            {"color", {{"dimension", "color"}}}};
+        this->padding() = 0.;
     }
 
     /****************************
@@ -1352,6 +2817,28 @@ namespace xpl
     template <class XS, class YS, class CS>
     inline xheat_map<D>::xheat_map(std::vector<std::vector<double>>& color_,
                                    XS&& xs, YS&& ys, CS&& cs)
+        : xheat_map(data_type(color_), std::forward<XS>(xs), std::forward<YS>(ys), std::forward<CS>(cs))
+    {
+    }
+
+    template <class D>
+    template <class XS, class YS, class CS>
+    inline xheat_map<D>::xheat_map(std::vector<double>& x_,
+                                   std::vector<double>& y_,
+                                   std::vector<std::vector<double>>& color_,
+                                   XS&& xs, YS&& ys, CS&& cs)
+        : xheat_map(x_, y_, data_type(color_), std::forward<XS>(xs), std::forward<YS>(ys), std::forward<CS>(cs))
+    {
+    }
+
+    /**
+     * Takes the color matrix by value, so that a matrix passed as an
+     * rvalue, or a view, is not copied.
+     */
+    template <class D>
+    template <class XS, class YS, class CS>
+    inline xheat_map<D>::xheat_map(data_type color_,
+                                   XS&& xs, YS&& ys, CS&& cs)
         : base_type()
     {
         set_defaults();
@@ -1359,11 +2846,11 @@ namespace xpl
         this->scales()["x"] = std::forward<XS>(xs);
         this->scales()["y"] = std::forward<YS>(ys);
         this->scales()["color"] = std::forward<CS>(cs);
-        color = color_;
-        std::vector<double> x_(color_.size());
+        std::vector<double> x_(color_.rows());
         std::iota(x_.begin(), x_.end(), 0);
-        std::vector<double> y_(color_[0].size());
+        std::vector<double> y_(color_.columns());
         std::iota(y_.begin(), y_.end(), 0);
+        this->color() = std::move(color_);
         this->x() = x_;
         this->y() = y_;
     }
@@ -1372,7 +2859,7 @@ namespace xpl
     template <class XS, class YS, class CS>
     inline xheat_map<D>::xheat_map(std::vector<double>& x_,
                                    std::vector<double>& y_,
-                                   std::vector<std::vector<double>>& color_,
+                                   data_type color_,
                                    XS&& xs, YS&& ys, CS&& cs)
         : base_type()
     {
@@ -1381,7 +2868,7 @@ namespace xpl
         this->scales()["x"] = std::forward<XS>(xs);
         this->scales()["y"] = std::forward<YS>(ys);
         this->scales()["color"] = std::forward<CS>(cs);
-        this->color() = color_;
+        this->color() = std::move(color_);
         this->x() = x_;
         this->y() = y_;
     }
@@ -1395,6 +2882,7 @@ namespace xpl
             {"x", {{"orientation", "horizontal"}, {"dimension", "x"}}},
             {"y", {{"orientation", "vertical"}, {"dimension", "y"}}},
             {"color", {{"dimension", "color"}}}};
+        this->add_data_buffer_paths({"x", "y", "color"});
     }
 
     /*********************************
@@ -1407,6 +2895,28 @@ namespace xpl
                                              std::vector<double>& column_,
                                              std::vector<std::vector<double>>& color_,
                                              XS&& xs, YS&& ys, CS&& cs)
+        : xgrid_heat_map(row_, column_, data2d_type(color_), std::forward<XS>(xs), std::forward<YS>(ys), std::forward<CS>(cs))
+    {
+    }
+
+    template <class D>
+    template <class XS, class YS, class CS>
+    inline xgrid_heat_map<D>::xgrid_heat_map(std::vector<std::vector<double>>& color_,
+                                             XS&& xs, YS&& ys, CS&& cs)
+        : xgrid_heat_map(data2d_type(color_), std::forward<XS>(xs), std::forward<YS>(ys), std::forward<CS>(cs))
+    {
+    }
+
+    /**
+     * Takes the color matrix by value, so that a matrix passed as an
+     * rvalue, or a view, is not copied.
+     */
+    template <class D>
+    template <class XS, class YS, class CS>
+    inline xgrid_heat_map<D>::xgrid_heat_map(std::vector<double>& row_,
+                                             std::vector<double>& column_,
+                                             data2d_type color_,
+                                             XS&& xs, YS&& ys, CS&& cs)
         : base_type()
     {
         set_defaults();
@@ -1414,14 +2924,14 @@ namespace xpl
         this->scales()["column"] = std::forward<XS>(xs);
         this->scales()["row"] = std::forward<YS>(ys);
         this->scales()["color"] = std::forward<CS>(cs);
-        this->color() = color_;
+        this->color() = std::move(color_);
         this->row() = row_;
         this->column() = column_;
     }
 
     template <class D>
     template <class XS, class YS, class CS>
-    inline xgrid_heat_map<D>::xgrid_heat_map(std::vector<std::vector<double>>& color_,
+    inline xgrid_heat_map<D>::xgrid_heat_map(data2d_type color_,
                                              XS&& xs, YS&& ys, CS&& cs)
         : base_type()
     {
@@ -1430,11 +2940,11 @@ namespace xpl
         this->scales()["column"] = std::forward<XS>(xs);
         this->scales()["row"] = std::forward<YS>(ys);
         this->scales()["color"] = std::forward<CS>(cs);
-        this->color() = color_;
-        std::vector<double> row_(color_.size());
+        std::vector<double> row_(color_.rows());
         std::iota(row_.begin(), row_.end(), 0);
-        std::vector<double> column_(color_[0].size());
+        std::vector<double> column_(color_.columns());
         std::iota(column_.begin(), column_.end(), 0);
+        this->color() = std::move(color_);
         this->row() = row_;
         this->column() = column_;
     }
@@ -1445,12 +2955,16 @@ namespace xpl
         using xw::set_property_from_patch;
         base_type::apply_patch(patch, buffers);
         set_property_from_patch(anchor_style, patch, buffers);
-        set_property_from_patch(color, patch, buffers);
-        set_property_from_patch(column, patch, buffers);
+        // In tiling mode, the front-end only holds the sent tiles.
+        if (!tiling_enabled())
+        {
+            set_property_from_patch(color, patch, buffers);
+            set_property_from_patch(column, patch, buffers);
+            set_property_from_patch(row, patch, buffers);
+        }
         set_property_from_patch(column_align, patch, buffers);
         set_property_from_patch(null_color, patch, buffers);
         set_property_from_patch(opacity, patch, buffers);
-        set_property_from_patch(row, patch, buffers);
         set_property_from_patch(row_align, patch, buffers);
         set_property_from_patch(scales_metadata, patch, buffers);
         set_property_from_patch(stroke, patch, buffers);
@@ -1463,16 +2977,315 @@ namespace xpl
         using xw::xwidgets_serialize;
         base_type::serialize_state(state, buffers);
         xwidgets_serialize(anchor_style, state["anchor_style"], buffers);
-        xwidgets_serialize(color, state["color"], buffers);
-        xwidgets_serialize(column, state["column"], buffers);
-        xwidgets_serialize(column_align, state["column"], buffers);
-        xwidgets_serialize(null_color, state["column_align"], buffers);
+        xwidgets_serialize(column_align, state["column_align"], buffers);
+        xwidgets_serialize(null_color, state["null_color"], buffers);
         xwidgets_serialize(opacity, state["opacity"], buffers);
-        xwidgets_serialize(row, state["row"], buffers);
         xwidgets_serialize(row_align, state["row_align"], buffers);
         xwidgets_serialize(scales_metadata, state["scales_metadata"], buffers);
         xwidgets_serialize(stroke, state["stroke"], buffers);
         xwidgets_serialize(selected, state["selected"], buffers);
+        serialize_tiles(state, buffers);
+    }
+
+    template <class D>
+    inline auto xgrid_heat_map<D>::pyramid() const noexcept -> const pyramid_type&
+    {
+        return m_pyramid;
+    }
+
+    /**
+     * Returns the level of the pyramid of the sent cells, 0 when the
+     * cells of the matrix are sent.
+     */
+    template <class D>
+    inline std::size_t xgrid_heat_map<D>::tile_level() const noexcept
+    {
+        return m_tile_level;
+    }
+
+    /**
+     * When tiling is enabled, changes of color, row and column are routed
+     * through the change tracker so that they are sent together.
+     */
+    template <class D>
+    template <class P>
+    inline void xgrid_heat_map<D>::notify(const P& property) const
+    {
+        if (is_tiling_property(&property))
+        {
+            auto hold = this->hold_sync();
+            base_type::notify(property);
+        }
+        else
+        {
+            base_type::notify(property);
+        }
+    }
+
+    template <class D>
+    template <class P>
+    inline void xgrid_heat_map<D>::serialize_property(const P& property, nl::json& state, xeus::buffer_sequence& buffers) const
+    {
+        if (is_tiling_property(&property))
+        {
+            // The properties of the group are serialized once per patch.
+            if (state.find("color") == state.end())
+            {
+                serialize_tiles(state, buffers);
+            }
+        }
+        else
+        {
+            base_type::serialize_property(property, state, buffers);
+        }
+    }
+
+    template <class D>
+    inline bool xgrid_heat_map<D>::tiling_enabled() const noexcept
+    {
+        return max_rows() != 0 || max_columns() != 0;
+    }
+
+    template <class D>
+    inline bool xgrid_heat_map<D>::is_tiling_property(const void* property) const noexcept
+    {
+        return property == &max_rows || property == &max_columns || property == &pooling ||
+            (tiling_enabled() && (property == &color || property == &row || property == &column));
+    }
+
+    namespace detail
+    {
+        /**
+         * Computes the range [level_first, level_last) of the cells of a
+         * level covering the visible range [first, last) of the matrix and
+         * a margin of half its size on each side, rounded to whole tiles.
+         */
+        inline void tile_range(std::size_t first, std::size_t last, std::size_t size, std::size_t level,
+                               std::size_t tile_size, std::size_t& level_first, std::size_t& level_last)
+        {
+            std::size_t margin = (last - first) / 2;
+            first = first > margin ? first - margin : 0;
+            last = (std::min)(last + margin, size);
+            std::size_t cell = std::size_t(1) << level;
+            std::size_t level_size = (size + cell - 1) / cell;
+            level_first = first / cell / tile_size * tile_size;
+            level_last = (std::min)(((last + cell - 1) / cell + tile_size - 1) / tile_size * tile_size, level_size);
+        }
+
+        /**
+         * Computes the coordinates of the cells [first, last) of a level,
+         * which are the coordinates of their first cell in the matrix, and
+         * the end of the last cell when coords holds the size + 1 cell
+         * boundaries.
+         */
+        template <class C>
+        inline void tile_coordinates(const C& coords, std::size_t size, std::size_t level,
+                                     std::size_t first, std::size_t last, std::vector<double>& res)
+        {
+            res.clear();
+            auto coordinate = [&coords, size](std::size_t i) {
+                return coords.size() >= size ? coords[(std::min)(i, coords.size() - 1)] : static_cast<double>(i);
+            };
+            for (std::size_t k = first; k < last; ++k)
+            {
+                res.push_back(coordinate((std::min)(k << level, size - 1)));
+            }
+            if (coords.size() > size)
+            {
+                res.push_back(coordinate((std::min)(last << level, size)));
+            }
+        }
+
+        /**
+         * Computes the range of the cells of the sorted coords whose
+         * start is within [min, max], with one cell on each side.
+         */
+        template <class C>
+        inline void visible_cells(const C& coords, std::size_t size, double min, double max,
+                                  std::size_t& first, std::size_t& last)
+        {
+            auto begin = coords.begin();
+            auto end = begin + static_cast<std::ptrdiff_t>(size);
+            first = static_cast<std::size_t>(std::upper_bound(begin, end, min) - begin);
+            last = static_cast<std::size_t>(std::lower_bound(begin, end, max) - begin);
+            first = first > 1 ? first - 2 : 0;
+            last = (std::min)(last + 1, size);
+            last = (std::max)(last, (std::min)(first + 1, size));
+        }
+    }
+
+    /**
+     * Serializes color, row and column. When max_rows or max_columns is
+     * non-zero and the matrix is larger, the cells of the domains of the
+     * row and column scales, with a margin, are sent from the coarsest
+     * level of the pyramid with at most max_rows x max_columns visible
+     * cells; the full resolution matrix is kept in color.
+     */
+    template <class D>
+    inline void xgrid_heat_map<D>::serialize_tiles(nl::json& state, xeus::buffer_sequence& buffers) const
+    {
+        using xw::xwidgets_serialize;
+        const data2d_type& values = color();
+        std::size_t nb_rows = values.rows();
+        std::size_t nb_columns = values.columns();
+        bool fits = (max_rows() == 0 || nb_rows <= max_rows()) && (max_columns() == 0 || nb_columns <= max_columns());
+        if (!tiling_enabled() || fits || nb_columns == 0)
+        {
+            m_tile_level = 0;
+            m_row_view.first = 0;
+            m_row_view.last = nb_rows;
+            m_column_view.first = 0;
+            m_column_view.last = nb_columns;
+            xwidgets_serialize(color, state["color"], buffers);
+            xwidgets_serialize(column, state["column"], buffers);
+            xwidgets_serialize(row, state["row"], buffers);
+            return;
+        }
+
+        watch_domains();
+        sync_pyramid();
+        std::size_t first_row, last_row, first_column, last_column;
+        visible_ranges(nb_rows, nb_columns, first_row, last_row, first_column, last_column);
+        std::size_t level = m_pyramid.level_for(last_row - first_row, last_column - first_column, max_rows(), max_columns());
+
+        std::size_t level_first_row, level_last_row, level_first_column, level_last_column;
+        detail::tile_range(first_row, last_row, nb_rows, level, tile_size, level_first_row, level_last_row);
+        detail::tile_range(first_column, last_column, nb_columns, level, tile_size, level_first_column, level_last_column);
+        m_tile_level = level;
+        m_row_view.first = level_first_row << level;
+        m_row_view.last = (std::min)(level_last_row << level, nb_rows);
+        m_column_view.first = level_first_column << level;
+        m_column_view.last = (std::min)(level_last_column << level, nb_columns);
+
+        data2d_type tiles;
+        m_pyramid.extract(level, level_first_row, level_last_row, level_first_column, level_last_column,
+                          [&values](std::size_t i, std::size_t j) { return values(i, j); }, tiles);
+        xwidgets_serialize(tiles, state["color"], buffers);
+
+        std::vector<double> coords;
+        const data1d_type& column_values = column();
+        detail::tile_coordinates(column_values, nb_columns, level, level_first_column, level_last_column, coords);
+        serialize_data_range(coords.data(), coords.size(), state["column"], buffers);
+        const data1d_type& row_values = row();
+        detail::tile_coordinates(row_values, nb_rows, level, level_first_row, level_last_row, coords);
+        serialize_data_range(coords.data(), coords.size(), state["row"], buffers);
+    }
+
+    template <class D>
+    inline void xgrid_heat_map<D>::watch_domains() const
+    {
+        xeus::xguid row_id = this->scale_id("row");
+        if (!m_row_domain.subscribed() || m_row_domain.scale_id() != row_id)
+        {
+            m_row_domain.subscribe(row_id, [this](const xtl::xoptional<double>& min, const xtl::xoptional<double>& max) {
+                on_domain(m_row_view, min, max);
+            }, [this]() { this->defer_sync(); }, [this]() { this->resume_sync(); });
+        }
+        xeus::xguid column_id = this->scale_id("column");
+        if (!m_column_domain.subscribed() || m_column_domain.scale_id() != column_id)
+        {
+            m_column_domain.subscribe(column_id, [this](const xtl::xoptional<double>& min, const xtl::xoptional<double>& max) {
+                on_domain(m_column_view, min, max);
+            }, [this]() { this->defer_sync(); }, [this]() { this->resume_sync(); });
+        }
+    }
+
+    /**
+     * Sends the tiles again when the domains of the scales changed enough
+     * for the sent cells not to cover the visible ones, or to be coarser
+     * than needed. As for xlines, the margin around the visible cells
+     * absorbs the successive events of a pan or zoom.
+     */
+    template <class D>
+    inline void xgrid_heat_map<D>::on_domain(axis_viewport_type& view, const xtl::xoptional<double>& min,
+                                             const xtl::xoptional<double>& max) const
+    {
+        if (!tiling_enabled())
+        {
+            return;
+        }
+        view.has_domain = min.has_value() && max.has_value();
+        if (view.has_domain)
+        {
+            view.min = (std::min)(min.value(), max.value());
+            view.max = (std::max)(min.value(), max.value());
+        }
+        if (needs_refresh())
+        {
+            this->resend(color);
+        }
+    }
+
+    /**
+     * Computes the visible cells of the matrix, that is all the cells
+     * along a dimension whose scale domain is unknown or whose coordinates
+     * are not sorted.
+     */
+    template <class D>
+    inline void xgrid_heat_map<D>::visible_ranges(std::size_t nb_rows, std::size_t nb_columns,
+                                                  std::size_t& first_row, std::size_t& last_row,
+                                                  std::size_t& first_column, std::size_t& last_column) const
+    {
+        // The sortedness of the coordinates is cached until they change.
+        auto visible = [](axis_viewport_type& view, const data1d_type& coords, std::size_t size,
+                          xsync_state::version_type version, std::size_t& first, std::size_t& last) {
+            first = 0;
+            last = size;
+            if (!view.has_domain || coords.size() < size)
+            {
+                return;
+            }
+            if (view.sorted_size != size || view.sorted_version != version)
+            {
+                view.sorted = std::is_sorted(coords.begin(), coords.begin() + static_cast<std::ptrdiff_t>(size));
+                view.sorted_size = size;
+                view.sorted_version = version;
+            }
+            if (view.sorted)
+            {
+                detail::visible_cells(coords, size, view.min, view.max, first, last);
+            }
+        };
+        visible(m_row_view, row(), nb_rows, this->property_version("row"), first_row, last_row);
+        visible(m_column_view, column(), nb_columns, this->property_version("column"), first_column, last_column);
+    }
+
+    template <class D>
+    inline bool xgrid_heat_map<D>::needs_refresh() const
+    {
+        const data2d_type& values = color();
+        std::size_t nb_rows = values.rows();
+        std::size_t nb_columns = values.columns();
+        if ((max_rows() == 0 || nb_rows <= max_rows()) && (max_columns() == 0 || nb_columns <= max_columns()))
+        {
+            return false;
+        }
+        std::size_t first_row, last_row, first_column, last_column;
+        visible_ranges(nb_rows, nb_columns, first_row, last_row, first_column, last_column);
+        bool covered = first_row >= m_row_view.first && last_row <= m_row_view.last &&
+            first_column >= m_column_view.first && last_column <= m_column_view.last;
+        std::size_t level = m_pyramid.level_for(last_row - first_row, last_column - first_column, max_rows(), max_columns());
+        return !covered || level < m_tile_level;
+    }
+
+    /**
+     * Builds the pyramid again when color or the pooling method changed
+     * since it was last built.
+     */
+    template <class D>
+    inline void xgrid_heat_map<D>::sync_pyramid() const
+    {
+        xsync_state::version_type version = this->property_version("color");
+        xpooling_method method = pooling_method(pooling());
+        if (m_pyramid_built && m_pyramid_version == version && m_pyramid.method() == method)
+        {
+            return;
+        }
+        const data2d_type& values = color();
+        m_pyramid = pyramid_type(method);
+        m_pyramid.build(values.rows(), values.columns(), [&values](std::size_t i, std::size_t j) { return values(i, j); });
+        m_pyramid_version = version;
+        m_pyramid_built = true;
     }
 
     template <class D>
@@ -1484,6 +3297,7 @@ namespace xpl
             {"column", {{"orientation", "horizontal"}, {"dimension", "x"}}},
             {"row", {{"orientation", "vertical"}, {"dimension", "y"}}},
             {"color", {{"dimension", "color"}}}};
+        this->add_data_buffer_paths({"column", "row", "color"});
     }
 
     /***********************
@@ -1495,7 +3309,7 @@ namespace xpl
     inline xmap<D>::xmap(xscale<GS>&& gs)
         : base_type()
     {
-        map_data = read_map(topo_load("WorldMap.json"));
+        load_map(topo_load("WorldMap.json"));
         set_defaults();
         this->scales()["projection"] = std::move(gs);
     }
@@ -1505,7 +3319,7 @@ namespace xpl
     inline xmap<D>::xmap(const xscale<GS>& gs)
         : base_type()
     {
-        map_data = read_map(topo_load("WorldMap.json"));
+        load_map(topo_load("WorldMap.json"));
         set_defaults();
         this->scales()["projection"] = gs;
     }
@@ -1515,7 +3329,7 @@ namespace xpl
     inline xmap<D>::xmap(std::string filename, GS&& gs)
         : base_type()
     {
-        map_data = read_map(filename);
+        load_map(filename);
         set_defaults();
         this->scales()["projection"] = std::forward<GS>(gs);
     }
@@ -1525,7 +3339,7 @@ namespace xpl
     inline xmap<D>::xmap(GS&& gs, CS&& cs)
         : base_type()
     {
-        map_data = read_map(topo_load("WorldMap.json"));
+        load_map(topo_load("WorldMap.json"));
         set_defaults();
         this->scales()["projection"] = std::forward<GS>(gs);
         this->scales()["color"] = std::forward<CS>(cs);
@@ -1536,7 +3350,7 @@ namespace xpl
     inline xmap<D>::xmap(std::string filename, GS&& gs, CS&& cs)
         : base_type()
     {
-        map_data = read_map(filename);
+        load_map(filename);
         set_defaults();
         this->scales()["projection"] = std::forward<GS>(gs);
         this->scales()["color"] = std::forward<CS>(cs);
@@ -1567,13 +3381,111 @@ namespace xpl
         xwidgets_serialize(colors, state["colors"], buffers);
         xwidgets_serialize(hover_highlight, state["hover_highlight"], buffers);
         xwidgets_serialize(hovered_styles, state["hovered_styles"], buffers);
-        xwidgets_serialize(map_data, state["map_data"], buffers);
+        serialize_map_data(state["map_data"], buffers);
         xwidgets_serialize(scales_metadata, state["scales_metadata"], buffers);
         xwidgets_serialize(selected, state["selected"], buffers);
         xwidgets_serialize(selected_styles, state["selected_styles"], buffers);
         xwidgets_serialize(stroke_color, state["stroke_color"], buffers);
     }
 
+    /**
+     * Returns the map file document shared with the other maps displaying
+     * the same file. It is sent as map_data as long as map_data is not
+     * assigned.
+     */
+    template <class D>
+    inline auto xmap<D>::map_document() const noexcept -> const map_document_ptr&
+    {
+        return m_document;
+    }
+
+    /**
+     * Restricts the displayed map to the features selected by filter,
+     * simplifying their geometry if required. The filtered topology is
+     * computed once per map file and filter and shared with the other
+     * maps using it. It is sent as map_data as long as map_data is not
+     * assigned.
+     */
+    template <class D>
+    inline void xmap<D>::set_map_filter(const xmap_filter& filter)
+    {
+        m_document = get_map_cache().load(m_filename, filter);
+        m_filter = filter;
+        notify(map_data);
+    }
+
+    template <class D>
+    inline auto xmap<D>::map_filter() const noexcept -> const xmap_filter&
+    {
+        return m_filter;
+    }
+
+    /**
+     * Sends the arcs of a map loaded from a binary map as typed buffers in
+     * the binary encodings, instead of the arcs of its TopoJSON topology.
+     * The typed arcs are not TopoJSON: they require a front-end decoding
+     * them, which the map model of bqplot does not.
+     */
+    template <class D>
+    inline void xmap<D>::set_typed_arcs(bool typed_arcs)
+    {
+        const xw::xjson_path_type points_path = {"map_data", "arcs", "points", "value"};
+        const xw::xjson_path_type offsets_path = {"map_data", "arcs", "offsets", "value"};
+        std::vector<xw::xjson_path_type> paths = this->buffer_paths();
+        paths.erase(std::remove_if(paths.begin(), paths.end(), [&](const xw::xjson_path_type& path) {
+            return path == points_path || path == offsets_path;
+        }), paths.end());
+        if (typed_arcs)
+        {
+            paths.push_back(points_path);
+            paths.push_back(offsets_path);
+        }
+        this->set_buffer_paths(std::move(paths));
+        m_typed_arcs = typed_arcs;
+        notify(map_data);
+    }
+
+    template <class D>
+    inline bool xmap<D>::typed_arcs() const noexcept
+    {
+        return m_typed_arcs;
+    }
+
+    /**
+     * Changes of map_data are routed through the change tracker so that
+     * the map document is sent when map_data is reset.
+     */
+    template <class D>
+    template <class P>
+    inline void xmap<D>::notify(const P& property) const
+    {
+        const void* p = &property;
+        if (p == &map_data)
+        {
+            auto hold = this->hold_sync();
+            base_type::notify(property);
+        }
+        else
+        {
+            base_type::notify(property);
+        }
+    }
+
+    template <class D>
+    template <class P>
+    inline void xmap<D>::serialize_property(const P& property, nl::json& state, xeus::buffer_sequence& buffers) const
+    {
+        const void* p = &property;
+        if (p == &map_data)
+        {
+            serialize_map_data(state["map_data"], buffers);
+        }
+        else
+        {
+            base_type::serialize_property(property, state, buffers);
+        }
+    }
+
     template <class D>
     inline void xmap<D>::set_defaults()
     {
@@ -1585,16 +3497,35 @@ namespace xpl
     }
 
     template <class D>
-    inline nl::json xmap<D>::read_map(std::string filename)
+    inline void xmap<D>::load_map(const std::string& filename)
     {
-        std::ifstream jsonfile(filename);
-
-        // TODO: we should do:
-        // return nl::json::parse(jsonfile);
+        m_filename = filename;
+        m_document = get_map_cache().load(filename);
+    }
 
-        std::string str((std::istreambuf_iterator<char>(jsonfile)),
-                        std::istreambuf_iterator<char>());
-        return nlohmann::json::parse(str);
+    /**
+     * Serializes map_data, or the shared map document when map_data is
+     * not assigned. The document is sent as plain JSON, the only form the
+     * map model decodes, unless typed arcs are enabled; the state being a
+     * JSON value, it is copied into each serialized state. Only the
+     * parsing of the file is shared.
+     */
+    template <class D>
+    inline void xmap<D>::serialize_map_data(nl::json& j, xeus::buffer_sequence& buffers) const
+    {
+        using xw::xwidgets_serialize;
+        if (!map_data().is_null() || m_document == nullptr)
+        {
+            xwidgets_serialize(map_data, j, buffers);
+        }
+        else if (m_typed_arcs && default_data_encoding() != xdata_encoding::json && m_document->binary() != nullptr)
+        {
+            m_document->binary()->serialize(j, buffers);
+        }
+        else
+        {
+            j = m_document->data();
+        }
     }
 }
 
@@ -1625,6 +3556,9 @@ namespace xpl
     extern template class xw::xmaterialize<xpl::xbars>;
     extern template class xw::xtransport<xw::xmaterialize<xpl::xbars>>;
 
+    extern template class xw::xmaterialize<xpl::xbinned_hist>;
+    extern template class xw::xtransport<xw::xmaterialize<xpl::xbinned_hist>>;
+
     extern template class xw::xmaterialize<xpl::xheat_map>;
     extern template class xw::xtransport<xw::xmaterialize<xpl::xheat_map>>;
 
@@ -0,0 +1,491 @@
+/***************************************************************************
+* Copyright (c) 2017, Sylvain Corlay and Johan Mabille                     *
+*                                                                          *
+* Distributed under the terms of the BSD 3-Clause License.                 *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#ifndef XPLOT_MATRIX_HPP
+#define XPLOT_MATRIX_HPP
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "nlohmann/json.hpp"
+
+#include "xtl/xoptional.hpp"
+
+#include "xboxed_container.hpp"
+
+namespace nl = nlohmann;
+
+namespace xpl
+{
+    /***********************
+     * xmatrix declaration *
+     ***********************/
+
+    /**
+     * Two-dimensional array with an explicit shape and strides.
+     *
+     * A matrix either owns a single row-major buffer, or is a read-only
+     * view of a buffer owned elsewhere, optionally kept alive by a shared
+     * pointer; views may have any strides, e.g. to view a column-major
+     * buffer or a block of a larger matrix. Copying a view copies the
+     * view. Values are read with operator() and written through
+     * mutable_data(), which first copies the values of a view in an owned
+     * buffer.
+     *
+     * With the binary data encoding, a matrix is serialized as a single
+     * typed buffer and its shape.
+     */
+    template <class T>
+    class xmatrix
+    {
+    public:
+
+        using value_type = T;
+        using size_type = std::size_t;
+        using difference_type = std::ptrdiff_t;
+        using shape_type = std::array<size_type, 2>;
+        using strides_type = std::array<difference_type, 2>;
+        using keep_alive_type = std::shared_ptr<const void>;
+
+        xmatrix() noexcept;
+        xmatrix(size_type rows, size_type columns, const value_type& value = value_type());
+        xmatrix(std::vector<value_type>&& data, size_type rows, size_type columns);
+
+        template <class U>
+        xmatrix(const std::vector<std::vector<U>>& rows);
+
+        ~xmatrix() = default;
+
+        xmatrix(const xmatrix&);
+        xmatrix(xmatrix&&) noexcept;
+
+        xmatrix& operator=(const xmatrix&);
+        xmatrix& operator=(xmatrix&&) noexcept;
+
+        static xmatrix view(const value_type* data, size_type rows, size_type columns);
+        static xmatrix view(const value_type* data, size_type rows, size_type columns,
+                            const strides_type& strides, keep_alive_type keep_alive = keep_alive_type());
+
+        size_type rows() const noexcept;
+        size_type columns() const noexcept;
+        size_type size() const noexcept;
+        bool empty() const noexcept;
+        shape_type shape() const noexcept;
+        strides_type strides() const noexcept;
+
+        bool is_view() const noexcept;
+        bool is_contiguous() const noexcept;
+
+        const value_type* data() const noexcept;
+        value_type* mutable_data();
+
+        const value_type& operator()(size_type row, size_type column) const noexcept;
+
+        void detach();
+
+    private:
+
+        void reset_data() noexcept;
+
+        std::vector<value_type> m_storage;
+        const value_type* p_data;
+        size_type m_rows;
+        size_type m_columns;
+        strides_type m_strides;
+        keep_alive_type m_keep_alive;
+        bool m_view;
+    };
+
+    template <class T>
+    void to_json(nl::json& j, const xmatrix<T>& o);
+    template <class T>
+    void from_json(const nl::json& j, xmatrix<T>& o);
+
+    template <class T>
+    void xwidgets_serialize(const xmatrix<T>& o, nl::json& j, xeus::buffer_sequence& buffers);
+    template <class T>
+    void xwidgets_deserialize(xmatrix<T>& o, const nl::json& j, const xeus::buffer_sequence& buffers);
+
+    template <class T>
+    void xwidgets_serialize(const xtl::xoptional<xmatrix<T>>& o, nl::json& j, xeus::buffer_sequence& buffers);
+    template <class T>
+    void xwidgets_deserialize(xtl::xoptional<xmatrix<T>>& o, const nl::json& j, const xeus::buffer_sequence& buffers);
+
+    /**************************
+     * xmatrix implementation *
+     **************************/
+
+    template <class T>
+    inline xmatrix<T>::xmatrix() noexcept
+        : p_data(nullptr), m_rows(0), m_columns(0), m_strides({0, 1}), m_view(false)
+    {
+    }
+
+    template <class T>
+    inline xmatrix<T>::xmatrix(size_type rows, size_type columns, const value_type& value)
+        : m_storage(rows * columns, value),
+          m_rows(rows),
+          m_columns(columns),
+          m_strides({static_cast<difference_type>(columns), 1}),
+          m_view(false)
+    {
+        reset_data();
+    }
+
+    /**
+     * Takes ownership of data, which holds the rows * columns values in
+     * row-major order.
+     */
+    template <class T>
+    inline xmatrix<T>::xmatrix(std::vector<value_type>&& data, size_type rows, size_type columns)
+        : m_storage(std::move(data)),
+          m_rows(rows),
+          m_columns(columns),
+          m_strides({static_cast<difference_type>(columns), 1}),
+          m_view(false)
+    {
+        if (m_storage.size() != rows * columns)
+        {
+            throw std::invalid_argument("xmatrix: the size of the data does not match the shape");
+        }
+        reset_data();
+    }
+
+    /**
+     * Copies nested rows, which must have the same size, in a single
+     * buffer.
+     */
+    template <class T>
+    template <class U>
+    inline xmatrix<T>::xmatrix(const std::vector<std::vector<U>>& rows)
+        : m_rows(rows.size()),
+          m_columns(rows.empty() ? 0 : rows.front().size()),
+          m_strides({static_cast<difference_type>(m_columns), 1}),
+          m_view(false)
+    {
+        m_storage.reserve(m_rows * m_columns);
+        for (const auto& row : rows)
+        {
+            if (row.size() != m_columns)
+            {
+                throw std::invalid_argument("xmatrix: the rows do not have the same size");
+            }
+            m_storage.insert(m_storage.end(), row.begin(), row.end());
+        }
+        reset_data();
+    }
+
+    template <class T>
+    inline xmatrix<T>::xmatrix(const xmatrix& rhs)
+        : m_storage(rhs.m_storage),
+          p_data(rhs.p_data),
+          m_rows(rhs.m_rows),
+          m_columns(rhs.m_columns),
+          m_strides(rhs.m_strides),
+          m_keep_alive(rhs.m_keep_alive),
+          m_view(rhs.m_view)
+    {
+        reset_data();
+    }
+
+    template <class T>
+    inline xmatrix<T>::xmatrix(xmatrix&& rhs) noexcept
+        : m_storage(std::move(rhs.m_storage)),
+          p_data(rhs.p_data),
+          m_rows(rhs.m_rows),
+          m_columns(rhs.m_columns),
+          m_strides(rhs.m_strides),
+          m_keep_alive(std::move(rhs.m_keep_alive)),
+          m_view(rhs.m_view)
+    {
+        reset_data();
+        rhs = xmatrix();
+    }
+
+    template <class T>
+    inline xmatrix<T>& xmatrix<T>::operator=(const xmatrix& rhs)
+    {
+        xmatrix tmp(rhs);
+        *this = std::move(tmp);
+        return *this;
+    }
+
+    template <class T>
+    inline xmatrix<T>& xmatrix<T>::operator=(xmatrix&& rhs) noexcept
+    {
+        m_storage = std::move(rhs.m_storage);
+        p_data = rhs.p_data;
+        m_rows = rhs.m_rows;
+        m_columns = rhs.m_columns;
+        m_strides = rhs.m_strides;
+        m_keep_alive = std::move(rhs.m_keep_alive);
+        m_view = rhs.m_view;
+        reset_data();
+        rhs.m_storage.clear();
+        rhs.p_data = nullptr;
+        rhs.m_rows = 0;
+        rhs.m_columns = 0;
+        rhs.m_view = false;
+        return *this;
+    }
+
+    /**
+     * Returns a view of the rows x columns row-major values starting at
+     * data, which must outlive the view and its copies.
+     */
+    template <class T>
+    inline xmatrix<T> xmatrix<T>::view(const value_type* data, size_type rows, size_type columns)
+    {
+        return view(data, rows, columns, {static_cast<difference_type>(columns), 1});
+    }
+
+    /**
+     * Returns a view of the values starting at data, the value (i, j)
+     * being at data + i * strides[0] + j * strides[1]. When keep_alive is
+     * not null, the view and its copies share the ownership of the data
+     * with it.
+     */
+    template <class T>
+    inline xmatrix<T> xmatrix<T>::view(const value_type* data, size_type rows, size_type columns,
+                                       const strides_type& strides, keep_alive_type keep_alive)
+    {
+        xmatrix res;
+        res.p_data = data;
+        res.m_rows = rows;
+        res.m_columns = columns;
+        res.m_strides = strides;
+        res.m_keep_alive = std::move(keep_alive);
+        res.m_view = true;
+        return res;
+    }
+
+    template <class T>
+    inline auto xmatrix<T>::rows() const noexcept -> size_type
+    {
+        return m_rows;
+    }
+
+    template <class T>
+    inline auto xmatrix<T>::columns() const noexcept -> size_type
+    {
+        return m_columns;
+    }
+
+    template <class T>
+    inline auto xmatrix<T>::size() const noexcept -> size_type
+    {
+        return m_rows * m_columns;
+    }
+
+    template <class T>
+    inline bool xmatrix<T>::empty() const noexcept
+    {
+        return size() == 0;
+    }
+
+    template <class T>
+    inline auto xmatrix<T>::shape() const noexcept -> shape_type
+    {
+        return {m_rows, m_columns};
+    }
+
+    template <class T>
+    inline auto xmatrix<T>::strides() const noexcept -> strides_type
+    {
+        return m_strides;
+    }
+
+    template <class T>
+    inline bool xmatrix<T>::is_view() const noexcept
+    {
+        return m_view;
+    }
+
+    /**
+     * Returns true if the values are stored row-major without gaps, so
+     * that data() points to size() consecutive values.
+     */
+    template <class T>
+    inline bool xmatrix<T>::is_contiguous() const noexcept
+    {
+        return m_rows <= 1 ? (m_columns <= 1 || m_strides[1] == 1)
+                           : (m_strides[1] == 1 && m_strides[0] == static_cast<difference_type>(m_columns));
+    }
+
+    template <class T>
+    inline auto xmatrix<T>::data() const noexcept -> const value_type*
+    {
+        return p_data;
+    }
+
+    /**
+     * Returns the row-major values of the matrix, detaching it first if it
+     * is a view.
+     */
+    template <class T>
+    inline auto xmatrix<T>::mutable_data() -> value_type*
+    {
+        detach();
+        return m_storage.data();
+    }
+
+    template <class T>
+    inline auto xmatrix<T>::operator()(size_type row, size_type column) const noexcept -> const value_type&
+    {
+        return p_data[static_cast<difference_type>(row) * m_strides[0] + static_cast<difference_type>(column) * m_strides[1]];
+    }
+
+    /**
+     * Copies the values of a view in an owned row-major buffer.
+     */
+    template <class T>
+    inline void xmatrix<T>::detach()
+    {
+        if (!m_view)
+        {
+            return;
+        }
+        std::vector<value_type> storage;
+        storage.reserve(size());
+        for (size_type i = 0; i < m_rows; ++i)
+        {
+            for (size_type j = 0; j < m_columns; ++j)
+            {
+                storage.push_back((*this)(i, j));
+            }
+        }
+        m_storage = std::move(storage);
+        m_strides = {static_cast<difference_type>(m_columns), 1};
+        m_keep_alive.reset();
+        m_view = false;
+        reset_data();
+    }
+
+    template <class T>
+    inline void xmatrix<T>::reset_data() noexcept
+    {
+        if (!m_view)
+        {
+            p_data = m_storage.data();
+        }
+    }
+
+    /**
+     * Serializes the matrix as nested rows, like a boxed vector of
+     * vectors.
+     */
+    template <class T>
+    inline void to_json(nl::json& j, const xmatrix<T>& o)
+    {
+        nl::json values = nl::json::array();
+        for (std::size_t i = 0; i < o.rows(); ++i)
+        {
+            nl::json row = nl::json::array();
+            for (std::size_t k = 0; k < o.columns(); ++k)
+            {
+                row.push_back(o(i, k));
+            }
+            values.push_back(std::move(row));
+        }
+        j = nl::json::object();
+        j["values"] = std::move(values);
+        j["type"] = type_to_string<T>();
+    }
+
+    template <class T>
+    inline void from_json(const nl::json& j, xmatrix<T>& o)
+    {
+        o = xmatrix<T>(j.at("values").get<std::vector<std::vector<T>>>());
+    }
+
+    namespace detail
+    {
+        template <class T>
+        inline void serialize_matrix(const xmatrix<T>& o, nl::json& j, xeus::buffer_sequence& buffers, std::true_type)
+        {
+            if (default_data_encoding() == xdata_encoding::json)
+            {
+                to_json(j, o);
+            }
+            else if (o.is_contiguous())
+            {
+                serialize_encoded(o.data(), {o.rows(), o.columns()}, j, buffers);
+            }
+            else
+            {
+                xmatrix<T> contiguous(o);
+                contiguous.detach();
+                serialize_encoded(contiguous.data(), {o.rows(), o.columns()}, j, buffers);
+            }
+        }
+
+        template <class T>
+        inline void serialize_matrix(const xmatrix<T>& o, nl::json& j, xeus::buffer_sequence&, std::false_type)
+        {
+            to_json(j, o);
+        }
+    }
+
+    template <class T>
+    inline void xwidgets_serialize(const xmatrix<T>& o, nl::json& j, xeus::buffer_sequence& buffers)
+    {
+        detail::serialize_matrix(o, j, buffers, is_typed_buffer_value<T>());
+    }
+
+    template <class T>
+    inline void xwidgets_deserialize(xmatrix<T>& o, const nl::json& j, const xeus::buffer_sequence& buffers)
+    {
+        if (is_typed_buffer(j))
+        {
+            std::vector<T> values;
+            deserialize_typed_buffer(values, j, buffers);
+            std::vector<std::size_t> shape = j.at("shape").get<std::vector<std::size_t>>();
+            std::size_t rows = shape.empty() ? 0 : shape[0];
+            std::size_t columns = shape.size() < 2 ? (rows == 0 ? 0 : values.size() / rows) : shape[1];
+            o = xmatrix<T>(std::move(values), rows, columns);
+        }
+        else
+        {
+            from_json(j, o);
+        }
+    }
+
+    template <class T>
+    inline void xwidgets_serialize(const xtl::xoptional<xmatrix<T>>& o, nl::json& j, xeus::buffer_sequence& buffers)
+    {
+        if (o.has_value())
+        {
+            xwidgets_serialize(o.value(), j, buffers);
+        }
+        else
+        {
+            j = nullptr;
+        }
+    }
+
+    template <class T>
+    inline void xwidgets_deserialize(xtl::xoptional<xmatrix<T>>& o, const nl::json& j, const xeus::buffer_sequence& buffers)
+    {
+        if (j.is_null())
+        {
+            o = xtl::missing<xmatrix<T>>();
+        }
+        else
+        {
+            xmatrix<T> value;
+            xwidgets_deserialize(value, j, buffers);
+            o = std::move(value);
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,107 @@
+/***************************************************************************
+* Copyright (c) 2017, Sylvain Corlay and Johan Mabille                     *
+*                                                                          *
+* Distributed under the terms of the BSD 3-Clause License.                 *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#ifndef XPLOT_PARALLEL_HPP
+#define XPLOT_PARALLEL_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+namespace xpl
+{
+    /**
+     * Returns the number of threads used by the parallel kernels, that is
+     * the number of hardware threads, or 1 when it cannot be determined.
+     */
+    inline std::size_t default_concurrency() noexcept
+    {
+        unsigned int n = std::thread::hardware_concurrency();
+        return n == 0u ? std::size_t(1) : static_cast<std::size_t>(n);
+    }
+
+    /**
+     * Calls f(begin, end) on contiguous chunks covering [first, last).
+     *
+     * The range is split in at most default_concurrency() chunks of at
+     * least grain elements; the first chunk runs on the calling thread.
+     * Ranges smaller than two grains are processed without spawning any
+     * thread. The first exception thrown by f is rethrown once all the
+     * chunks are done.
+     */
+    template <class F>
+    inline void parallel_for(std::size_t first, std::size_t last, std::size_t grain, F&& f)
+    {
+        if (last <= first)
+        {
+            return;
+        }
+
+        std::size_t size = last - first;
+        grain = (std::max)(grain, std::size_t(1));
+        std::size_t nb_chunks = (std::min)(default_concurrency(), size / grain);
+        if (nb_chunks < 2)
+        {
+            f(first, last);
+            return;
+        }
+
+        std::vector<std::exception_ptr> errors(nb_chunks);
+        std::vector<std::thread> workers;
+        workers.reserve(nb_chunks - 1);
+
+        auto chunk_begin = [first, size, nb_chunks](std::size_t i) {
+            return first + size * i / nb_chunks;
+        };
+        auto run = [&f, &errors, &chunk_begin](std::size_t i) {
+            try
+            {
+                f(chunk_begin(i), chunk_begin(i + 1));
+            }
+            catch (...)
+            {
+                errors[i] = std::current_exception();
+            }
+        };
+
+        // Chunks that cannot get a thread are processed on the calling one.
+        std::size_t spawned = 1;
+        try
+        {
+            for (; spawned < nb_chunks; ++spawned)
+            {
+                workers.emplace_back(run, spawned);
+            }
+        }
+        catch (const std::system_error&)
+        {
+        }
+        for (std::size_t i = spawned; i < nb_chunks; ++i)
+        {
+            run(i);
+        }
+        run(0);
+        for (auto& worker : workers)
+        {
+            worker.join();
+        }
+
+        for (const auto& error : errors)
+        {
+            if (error)
+            {
+                std::rethrow_exception(error);
+            }
+        }
+    }
+}
+
+#endif
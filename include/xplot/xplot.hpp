@@ -10,13 +10,16 @@
 #define XPLOT_PLOT_HPP
 
 #include <string>
+#include <vector>
 
 #include "nlohmann/json.hpp"
 
+#include "xwidgets/xbinary.hpp"
 #include "xwidgets/xmaterialize.hpp"
 #include "xwidgets/xobject.hpp"
 
 #include "xplot_config.hpp"
+#include "xsync.hpp"
 
 namespace nl = nlohmann;
 
@@ -29,11 +32,11 @@ namespace xpl
      *********************/
 
     template <class D>
-    class xplot : public xw::xobject<D>
+    class xplot : public xsynced<D, xw::xobject>
     {
     public:
 
-        using base_type = xw::xobject<D>;
+        using base_type = xsynced<D, xw::xobject>;
         using derived_type = D;
 
         void serialize_state(nl::json&, xeus::buffer_sequence&) const;
@@ -45,6 +48,8 @@ namespace xpl
 
         using base_type::base_type;
 
+        void add_data_buffer_paths(const std::vector<std::string>& names);
+
     private:
 
         void set_defaults();
@@ -75,6 +80,21 @@ namespace xpl
         set_defaults();
     }
 
+    /**
+     * Registers the data properties which may be sent as binary buffers,
+     * so that their ``value`` entry is extracted into the message buffers.
+     */
+    template <class D>
+    inline void xplot<D>::add_data_buffer_paths(const std::vector<std::string>& names)
+    {
+        std::vector<xw::xjson_path_type> paths = this->buffer_paths();
+        for (const auto& name : names)
+        {
+            paths.push_back({name, "value"});
+        }
+        this->set_buffer_paths(std::move(paths));
+    }
+
     template <class D>
     inline void xplot<D>::set_defaults()
     {
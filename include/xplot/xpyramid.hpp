@@ -0,0 +1,718 @@
+/***************************************************************************
+* Copyright (c) 2017, Sylvain Corlay and Johan Mabille                     *
+*                                                                          *
+* Distributed under the terms of the BSD 3-Clause License.                 *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#ifndef XPLOT_PYRAMID_HPP
+#define XPLOT_PYRAMID_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "xdecimation.hpp"
+#include "xmatrix.hpp"
+#include "xparallel.hpp"
+
+namespace xpl
+{
+    /*******************************
+     * xminmax_pyramid declaration *
+     *******************************/
+
+    /**
+     * Multi-resolution index of the minimum and maximum of a series.
+     *
+     * The first level holds the extrema of blocks of block_size values,
+     * each following level the extrema of pairs of nodes of the previous
+     * one. The minimum and the maximum of any range are then computed by
+     * combining O(log n) nodes and scanning at most two partial blocks, so
+     * that downsampling a range into p buckets costs O(p log n) whatever
+     * its length.
+     *
+     * The pyramid does not hold the values, which are passed to each
+     * method; its size is at most 2 * n / block_size nodes. Nodes are
+     * indexed from the start of the series as first built, so that
+     * dropping leading values only recomputes the nodes of the new first
+     * block.
+     */
+    template <class T>
+    class xminmax_pyramid
+    {
+    public:
+
+        using value_type = T;
+        using size_type = std::size_t;
+
+        explicit xminmax_pyramid(size_type block_size = 64);
+
+        void build(const value_type* values, size_type size);
+        void update(const value_type* values, size_type size);
+        void update(const value_type* values, size_type size, size_type dropped);
+        void clear();
+
+        size_type size() const noexcept;
+        size_type block_size() const noexcept;
+        size_type levels() const noexcept;
+        size_type memory_usage() const noexcept;
+
+        void argminmax(const value_type* values, size_type first, size_type last,
+                       size_type& imin, size_type& imax) const;
+
+        void minmax_indices(const value_type* values, size_type first, size_type last,
+                            size_type nb_buckets, std::vector<size_type>& indices) const;
+
+        void m4_indices(const value_type* values, size_type first, size_type last,
+                        size_type nb_buckets, std::vector<size_type>& indices) const;
+
+    private:
+
+        struct node_type
+        {
+            value_type min;
+            value_type max;
+            size_type imin;
+            size_type imax;
+        };
+
+        struct level_type
+        {
+            size_type first;
+            std::vector<node_type> nodes;
+        };
+
+        static bool is_nan(const value_type& v) noexcept;
+        static void combine(node_type& res, const node_type& other) noexcept;
+
+        const node_type& node(size_type level, size_type i) const noexcept;
+        void update_from(const value_type* values, size_type first_block, bool update_front = false);
+
+        size_type m_block_size;
+        size_type m_offset;
+        size_type m_size;
+        std::vector<level_type> m_levels;
+    };
+
+    /*******************************
+     * xmatrix_pyramid declaration *
+     *******************************/
+
+    /**
+     * Pooling of the cells of a matrix pyramid: the mean or the maximum
+     * of the non-NaN values of the pooled cells.
+     */
+    enum class xpooling_method
+    {
+        mean,
+        max
+    };
+
+    xpooling_method pooling_method(const std::string& name);
+
+    /**
+     * Multi-resolution levels of a matrix.
+     *
+     * Level 0 is the matrix itself, which is not held by the pyramid and
+     * is read through an accessor value(row, column); each following level
+     * pools the blocks of 2x2 cells of the previous one, so that a range
+     * of the matrix can be sent at any resolution by reading the cells of
+     * one level only. The levels are stored row-major and use about a
+     * third of the memory of the matrix.
+     *
+     * The mean of a level is the mean of the means of the previous one,
+     * which is the exact mean except along the edges of odd-sized levels
+     * and around NaNs.
+     */
+    class xmatrix_pyramid
+    {
+    public:
+
+        using size_type = std::size_t;
+
+        explicit xmatrix_pyramid(xpooling_method method = xpooling_method::mean);
+
+        template <class F>
+        void build(size_type nb_rows, size_type nb_columns, F&& value);
+
+        void clear();
+
+        xpooling_method method() const noexcept;
+        size_type levels() const noexcept;
+        size_type rows(size_type level) const noexcept;
+        size_type columns(size_type level) const noexcept;
+        size_type memory_usage() const noexcept;
+
+        size_type level_for(size_type nb_rows, size_type nb_columns,
+                            size_type max_rows, size_type max_columns) const noexcept;
+
+        template <class F>
+        void extract(size_type level, size_type first_row, size_type last_row,
+                     size_type first_column, size_type last_column, F&& value,
+                     xmatrix<double>& res) const;
+
+    private:
+
+        struct level_type
+        {
+            size_type rows;
+            size_type columns;
+            std::vector<double> values;
+        };
+
+        template <class F>
+        void pool(size_type nb_rows, size_type nb_columns, F&& value, level_type& res) const;
+
+        xpooling_method m_method;
+        size_type m_rows;
+        size_type m_columns;
+        std::vector<level_type> m_levels;
+    };
+
+    /**********************************
+     * xminmax_pyramid implementation *
+     **********************************/
+
+    template <class T>
+    inline xminmax_pyramid<T>::xminmax_pyramid(size_type block_size)
+        : m_block_size((std::max)(block_size, size_type(2))), m_offset(0), m_size(0)
+    {
+    }
+
+    /**
+     * Builds the pyramid of the size first values.
+     */
+    template <class T>
+    inline void xminmax_pyramid<T>::build(const value_type* values, size_type size)
+    {
+        clear();
+        m_size = size;
+        update_from(values, 0);
+    }
+
+    /**
+     * Updates the pyramid after values were appended to the series, only
+     * recomputing the nodes covering the new values. The series must not
+     * have changed before the previous size; if it shrank, the pyramid is
+     * built again.
+     */
+    template <class T>
+    inline void xminmax_pyramid<T>::update(const value_type* values, size_type size)
+    {
+        if (size < m_size)
+        {
+            build(values, size);
+            return;
+        }
+        size_type first_block = (m_offset + m_size) / m_block_size;
+        m_size = size;
+        update_from(values, first_block);
+    }
+
+    /**
+     * Updates the pyramid after the dropped first values of the series
+     * were removed and values were appended to it; values points to the
+     * new series of size values. Only the nodes covering the new first
+     * block and the new values are recomputed, and the nodes of the
+     * dropped blocks are released once they are the larger part of a
+     * level.
+     */
+    template <class T>
+    inline void xminmax_pyramid<T>::update(const value_type* values, size_type size, size_type dropped)
+    {
+        if (dropped == 0)
+        {
+            update(values, size);
+            return;
+        }
+        if (dropped > m_size || size + dropped < m_size)
+        {
+            build(values, size);
+            return;
+        }
+        size_type first_block = (m_offset + m_size) / m_block_size;
+        m_offset += dropped;
+        m_size = size;
+        update_from(values, first_block, true);
+    }
+
+    template <class T>
+    inline void xminmax_pyramid<T>::clear()
+    {
+        m_levels.clear();
+        m_offset = 0;
+        m_size = 0;
+    }
+
+    template <class T>
+    inline auto xminmax_pyramid<T>::size() const noexcept -> size_type
+    {
+        return m_size;
+    }
+
+    template <class T>
+    inline auto xminmax_pyramid<T>::block_size() const noexcept -> size_type
+    {
+        return m_block_size;
+    }
+
+    template <class T>
+    inline auto xminmax_pyramid<T>::levels() const noexcept -> size_type
+    {
+        return m_levels.size();
+    }
+
+    /**
+     * Returns the number of bytes allocated for the nodes of the pyramid.
+     */
+    template <class T>
+    inline auto xminmax_pyramid<T>::memory_usage() const noexcept -> size_type
+    {
+        size_type res = 0;
+        for (const auto& level : m_levels)
+        {
+            res += level.nodes.capacity() * sizeof(node_type);
+        }
+        return res;
+    }
+
+    /**
+     * Computes the indices of the minimum and the maximum of the values in
+     * [first, last), which must be a non-empty range of the indexed series.
+     */
+    template <class T>
+    inline void xminmax_pyramid<T>::argminmax(const value_type* values, size_type first, size_type last,
+                                              size_type& imin, size_type& imax) const
+    {
+        size_type first_block = (m_offset + first + m_block_size - 1) / m_block_size;
+        size_type last_block = (m_offset + (std::min)(last, m_size)) / m_block_size;
+        if (first_block >= last_block)
+        {
+            detail::argminmax(values, first, last, imin, imax);
+            return;
+        }
+
+        size_type head = first_block * m_block_size - m_offset;
+        size_type tail = last_block * m_block_size - m_offset;
+        node_type res;
+        bool found = false;
+        auto add = [&res, &found](const node_type& n) {
+            if (found)
+            {
+                combine(res, n);
+            }
+            else
+            {
+                res = n;
+                found = true;
+            }
+        };
+        auto add_range = [this, &add, values](size_type begin, size_type end) {
+            if (begin < end)
+            {
+                node_type n;
+                detail::argminmax(values, begin, end, n.imin, n.imax);
+                n.min = values[n.imin];
+                n.max = values[n.imax];
+                n.imin += m_offset;
+                n.imax += m_offset;
+                add(n);
+            }
+        };
+
+        add_range(first, head);
+        size_type l = first_block;
+        size_type r = last_block;
+        for (size_type level = 0; l < r; ++level)
+        {
+            if (l % 2 == 1)
+            {
+                add(node(level, l++));
+            }
+            if (r % 2 == 1)
+            {
+                add(node(level, --r));
+            }
+            l /= 2;
+            r /= 2;
+        }
+        add_range(tail, last);
+
+        imin = res.imin - m_offset;
+        imax = res.imax - m_offset;
+    }
+
+    /**
+     * Selects the indices of the minimum and the maximum of nb_buckets
+     * buckets of equal size covering [first, last), in increasing order.
+     */
+    template <class T>
+    inline void xminmax_pyramid<T>::minmax_indices(const value_type* values, size_type first, size_type last,
+                                                   size_type nb_buckets, std::vector<size_type>& indices) const
+    {
+        indices.clear();
+        size_type size = last - first;
+        nb_buckets = (std::min)((std::max)(nb_buckets, size_type(1)), size);
+        for (size_type b = 0; b < nb_buckets; ++b)
+        {
+            size_type begin = first + detail::bucket_begin(b, size, nb_buckets);
+            size_type end = first + detail::bucket_begin(b + 1, size, nb_buckets);
+            size_type imin, imax;
+            argminmax(values, begin, end, imin, imax);
+            indices.push_back((std::min)(imin, imax));
+            if (imin != imax)
+            {
+                indices.push_back((std::max)(imin, imax));
+            }
+        }
+    }
+
+    /**
+     * Selects the indices of the first, minimum, maximum and last values
+     * of nb_buckets buckets of equal size covering [first, last), in
+     * increasing order.
+     */
+    template <class T>
+    inline void xminmax_pyramid<T>::m4_indices(const value_type* values, size_type first, size_type last,
+                                               size_type nb_buckets, std::vector<size_type>& indices) const
+    {
+        size_type size = last - first;
+        nb_buckets = (std::min)((std::max)(nb_buckets, size_type(1)), size);
+        std::vector<size_type> slots;
+        slots.reserve(4 * nb_buckets);
+        for (size_type b = 0; b < nb_buckets; ++b)
+        {
+            size_type begin = first + detail::bucket_begin(b, size, nb_buckets);
+            size_type end = first + detail::bucket_begin(b + 1, size, nb_buckets);
+            size_type imin, imax;
+            argminmax(values, begin, end, imin, imax);
+            slots.push_back(begin);
+            slots.push_back((std::min)(imin, imax));
+            slots.push_back((std::max)(imin, imax));
+            slots.push_back(end - 1);
+        }
+        detail::compact_indices(slots, indices);
+    }
+
+    template <class T>
+    inline bool xminmax_pyramid<T>::is_nan(const value_type& v) noexcept
+    {
+        return v != v;
+    }
+
+    template <class T>
+    inline void xminmax_pyramid<T>::combine(node_type& res, const node_type& other) noexcept
+    {
+        if (is_nan(res.min) || other.min < res.min)
+        {
+            res.min = other.min;
+            res.imin = other.imin;
+        }
+        if (is_nan(res.max) || other.max > res.max)
+        {
+            res.max = other.max;
+            res.imax = other.imax;
+        }
+    }
+
+    template <class T>
+    inline auto xminmax_pyramid<T>::node(size_type level, size_type i) const noexcept -> const node_type&
+    {
+        const level_type& nodes = m_levels[level];
+        return nodes.nodes[i - nodes.first];
+    }
+
+    /**
+     * Recomputes the nodes covering the values following the block
+     * first_block, level by level, and the nodes covering the first block
+     * if update_front is true. Each level is computed in parallel.
+     */
+    template <class T>
+    inline void xminmax_pyramid<T>::update_from(const value_type* values, size_type first_block, bool update_front)
+    {
+        size_type first = m_offset / m_block_size;
+        size_type last = (m_offset + m_size + m_block_size - 1) / m_block_size;
+        if (first >= last)
+        {
+            m_levels.clear();
+            return;
+        }
+        first_block = (std::max)(first_block, first);
+
+        size_type level = 0;
+        size_type child_first = 0;
+        size_type child_last = 0;
+        while (true)
+        {
+            if (m_levels.size() == level)
+            {
+                m_levels.push_back(level_type{first, {}});
+            }
+            level_type& nodes = m_levels[level];
+            size_type dropped = first - nodes.first;
+            if (2 * dropped > nodes.nodes.size())
+            {
+                nodes.nodes.erase(nodes.nodes.begin(), nodes.nodes.begin() + (std::min)(dropped, nodes.nodes.size()));
+                nodes.first = first;
+            }
+            nodes.nodes.resize(last - nodes.first);
+
+            if (level == 0)
+            {
+                auto compute = [this, values, &nodes](size_type i) {
+                    node_type& n = nodes.nodes[i - nodes.first];
+                    size_type begin = (std::max)(i * m_block_size, m_offset) - m_offset;
+                    size_type end = (std::min)((i + 1) * m_block_size, m_offset + m_size) - m_offset;
+                    detail::argminmax(values, begin, end, n.imin, n.imax);
+                    n.min = values[n.imin];
+                    n.max = values[n.imax];
+                    n.imin += m_offset;
+                    n.imax += m_offset;
+                };
+                if (update_front && first < first_block)
+                {
+                    compute(first);
+                }
+                size_type grain = (std::max)(detail::downsampling_grain / m_block_size, size_type(1));
+                parallel_for(first_block, last, grain, [&compute](size_type begin, size_type end) {
+                    for (size_type i = begin; i < end; ++i)
+                    {
+                        compute(i);
+                    }
+                });
+            }
+            else
+            {
+                const level_type& children = m_levels[level - 1];
+                auto compute = [&children, &nodes, child_first, child_last](size_type i) {
+                    node_type& n = nodes.nodes[i - nodes.first];
+                    size_type begin = (std::max)(2 * i, child_first);
+                    size_type end = (std::min)(2 * i + 2, child_last);
+                    n = children.nodes[begin - children.first];
+                    if (begin + 1 < end)
+                    {
+                        combine(n, children.nodes[begin + 1 - children.first]);
+                    }
+                };
+                if (update_front && first < first_block)
+                {
+                    compute(first);
+                }
+                parallel_for(first_block, last, detail::downsampling_grain, [&compute](size_type begin, size_type end) {
+                    for (size_type i = begin; i < end; ++i)
+                    {
+                        compute(i);
+                    }
+                });
+            }
+
+            if (last - first <= 1)
+            {
+                break;
+            }
+            child_first = first;
+            child_last = last;
+            first /= 2;
+            last = (last + 1) / 2;
+            first_block /= 2;
+            ++level;
+        }
+        m_levels.resize(level + 1);
+    }
+
+    /**********************************
+     * xmatrix_pyramid implementation *
+     **********************************/
+
+    /**
+     * Returns the pooling method named name, that is "mean" or "max".
+     */
+    inline xpooling_method pooling_method(const std::string& name)
+    {
+        if (name == "mean")
+        {
+            return xpooling_method::mean;
+        }
+        else if (name == "max")
+        {
+            return xpooling_method::max;
+        }
+        throw std::invalid_argument("unknown pooling method: " + name);
+    }
+
+    inline xmatrix_pyramid::xmatrix_pyramid(xpooling_method method)
+        : m_method(method), m_rows(0), m_columns(0)
+    {
+    }
+
+    /**
+     * Builds the pooled levels of the nb_rows x nb_columns matrix whose
+     * cells are value(row, column), until a level has a single cell. The
+     * rows of each level are computed in parallel.
+     */
+    template <class F>
+    inline void xmatrix_pyramid::build(size_type nb_rows, size_type nb_columns, F&& value)
+    {
+        clear();
+        m_rows = nb_rows;
+        m_columns = nb_columns;
+        while (nb_rows > 1 || nb_columns > 1)
+        {
+            level_type level;
+            if (m_levels.empty())
+            {
+                pool(nb_rows, nb_columns, value, level);
+            }
+            else
+            {
+                const level_type& previous = m_levels.back();
+                pool(nb_rows, nb_columns, [&previous](size_type i, size_type j) {
+                    return previous.values[i * previous.columns + j];
+                }, level);
+            }
+            nb_rows = level.rows;
+            nb_columns = level.columns;
+            m_levels.push_back(std::move(level));
+        }
+    }
+
+    inline void xmatrix_pyramid::clear()
+    {
+        m_levels.clear();
+        m_rows = 0;
+        m_columns = 0;
+    }
+
+    inline xpooling_method xmatrix_pyramid::method() const noexcept
+    {
+        return m_method;
+    }
+
+    /**
+     * Returns the number of levels, including the matrix.
+     */
+    inline auto xmatrix_pyramid::levels() const noexcept -> size_type
+    {
+        return m_levels.size() + 1;
+    }
+
+    inline auto xmatrix_pyramid::rows(size_type level) const noexcept -> size_type
+    {
+        return level == 0 ? m_rows : m_levels[level - 1].rows;
+    }
+
+    inline auto xmatrix_pyramid::columns(size_type level) const noexcept -> size_type
+    {
+        return level == 0 ? m_columns : m_levels[level - 1].columns;
+    }
+
+    /**
+     * Returns the number of bytes allocated for the pooled levels.
+     */
+    inline auto xmatrix_pyramid::memory_usage() const noexcept -> size_type
+    {
+        size_type res = 0;
+        for (const auto& level : m_levels)
+        {
+            res += level.values.capacity() * sizeof(double);
+        }
+        return res;
+    }
+
+    /**
+     * Returns the finest level where nb_rows x nb_columns cells of the
+     * matrix are covered by at most max_rows x max_columns cells; a zero
+     * maximum does not constrain the corresponding dimension.
+     */
+    inline auto xmatrix_pyramid::level_for(size_type nb_rows, size_type nb_columns,
+                                           size_type max_rows, size_type max_columns) const noexcept -> size_type
+    {
+        size_type level = 0;
+        size_type last = levels() - 1;
+        auto fits = [](size_type size, size_type max, size_type l) {
+            return max == 0 || ((size + (size_type(1) << l) - 1) >> l) <= max;
+        };
+        while (level < last && !(fits(nb_rows, max_rows, level) && fits(nb_columns, max_columns, level)))
+        {
+            ++level;
+        }
+        return level;
+    }
+
+    /**
+     * Copies the cells [first_row, last_row) x [first_column, last_column)
+     * of a level in res, the indices being the ones of the level. value is
+     * the accessor of the matrix passed to build, used for level 0.
+     */
+    template <class F>
+    inline void xmatrix_pyramid::extract(size_type level, size_type first_row, size_type last_row,
+                                         size_type first_column, size_type last_column, F&& value,
+                                         xmatrix<double>& res) const
+    {
+        size_type nb_columns = last_column - first_column;
+        res = xmatrix<double>(last_row - first_row, nb_columns);
+        double* dst = res.mutable_data();
+        for (size_type i = first_row; i < last_row; ++i)
+        {
+            double* row = dst + (i - first_row) * nb_columns;
+            if (level == 0)
+            {
+                for (size_type j = first_column; j < last_column; ++j)
+                {
+                    row[j - first_column] = static_cast<double>(value(i, j));
+                }
+            }
+            else
+            {
+                const level_type& l = m_levels[level - 1];
+                const double* src = l.values.data() + i * l.columns;
+                std::copy(src + first_column, src + last_column, row);
+            }
+        }
+    }
+
+    template <class F>
+    inline void xmatrix_pyramid::pool(size_type nb_rows, size_type nb_columns, F&& value, level_type& res) const
+    {
+        res.rows = (nb_rows + 1) / 2;
+        res.columns = (nb_columns + 1) / 2;
+        res.values.resize(res.rows * res.columns);
+        size_type grain = (std::max)(detail::downsampling_grain / (std::max)(nb_columns, size_type(1)), size_type(1));
+        xpooling_method method = m_method;
+        parallel_for(0, res.rows, grain, [&](size_type first, size_type last) {
+            for (size_type i = first; i < last; ++i)
+            {
+                size_type row_end = (std::min)(2 * i + 2, nb_rows);
+                for (size_type j = 0; j < res.columns; ++j)
+                {
+                    size_type column_end = (std::min)(2 * j + 2, nb_columns);
+                    double sum = 0.;
+                    double max = std::nan("");
+                    size_type count = 0;
+                    for (size_type r = 2 * i; r < row_end; ++r)
+                    {
+                        for (size_type c = 2 * j; c < column_end; ++c)
+                        {
+                            double v = static_cast<double>(value(r, c));
+                            if (!std::isnan(v))
+                            {
+                                sum += v;
+                                max = count == 0 || v > max ? v : max;
+                                ++count;
+                            }
+                        }
+                    }
+                    double pooled = method == xpooling_method::mean ? sum / static_cast<double>(count) : max;
+                    res.values[i * res.columns + j] = count == 0 ? std::nan("") : pooled;
+                }
+            }
+        });
+    }
+}
+
+#endif
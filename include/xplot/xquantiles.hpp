@@ -0,0 +1,643 @@
+/***************************************************************************
+* Copyright (c) 2017, Sylvain Corlay and Johan Mabille                     *
+*                                                                          *
+* Distributed under the terms of the BSD 3-Clause License.                 *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#ifndef XPLOT_QUANTILES_HPP
+#define XPLOT_QUANTILES_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <functional>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "xparallel.hpp"
+
+namespace xpl
+{
+    /****************************
+     * xbox_summary declaration *
+     ****************************/
+
+    /**
+     * Summary drawn by a box of a box plot: the quartiles, the whiskers,
+     * which are the extreme values within 1.5 interquartile range of the
+     * box, and the values beyond them. outlier_count is the number of
+     * values beyond the whiskers, outliers only holding the most extreme
+     * ones when their number is capped.
+     */
+    struct xbox_summary
+    {
+        std::size_t count = 0;
+        double lower_whisker = 0.;
+        double q1 = 0.;
+        double median = 0.;
+        double q3 = 0.;
+        double upper_whisker = 0.;
+        std::size_t outlier_count = 0;
+        std::vector<double> outliers;
+    };
+
+    template <class T>
+    xbox_summary box_summary(const T* values, std::size_t size, std::size_t max_outliers);
+
+    template <class C>
+    std::vector<xbox_summary> box_summaries(const std::vector<C>& boxes, std::size_t max_outliers);
+
+    std::vector<double> box_sample(const xbox_summary& summary);
+
+    /***************************
+     * xkll_sketch declaration *
+     ***************************/
+
+    /**
+     * Mergeable quantile sketch (Karnin, Lang and Liberty).
+     *
+     * Values are stored in levels of compactors, values of level h
+     * standing for 2^h observations. When the sketch exceeds its capacity,
+     * the lowest full level is sorted and every other value is promoted to
+     * the next level. The capacity of a level decreases geometrically with
+     * its distance to the top level, so that the sketch retains O(k)
+     * values whatever the number of observations; the rank error is about
+     * 1.7 / k.
+     */
+    class xkll_sketch
+    {
+    public:
+
+        explicit xkll_sketch(std::size_t k = 200);
+
+        void update(double value);
+        void merge(const xkll_sketch& other);
+
+        double quantile(double p) const;
+
+        template <class F>
+        void for_each_value(F&& f) const;
+
+        std::size_t k() const noexcept;
+        std::size_t count() const noexcept;
+        std::size_t retained() const noexcept;
+        double min() const noexcept;
+        double max() const noexcept;
+
+    private:
+
+        std::size_t level_capacity(std::size_t level) const noexcept;
+        std::size_t capacity() const noexcept;
+        void compress();
+
+        std::size_t m_k;
+        std::vector<std::vector<double>> m_levels;
+        std::size_t m_count;
+        std::size_t m_retained;
+        double m_min;
+        double m_max;
+        bool m_odd_offset;
+    };
+
+    /***************************
+     * xbox_sketch declaration *
+     ***************************/
+
+    /**
+     * Streaming summary of a box: the quartiles and the whiskers are
+     * estimated with a KLL sketch, while the max_outliers lowest and
+     * highest values are tracked exactly so that the outliers are actual
+     * observations. Memory is bounded by O(k + max_outliers).
+     */
+    class xbox_sketch
+    {
+    public:
+
+        explicit xbox_sketch(std::size_t k = 200, std::size_t max_outliers = 100);
+
+        template <class T>
+        void update(const T* values, std::size_t size);
+
+        void merge(const xbox_sketch& other);
+
+        xbox_summary summary() const;
+
+        const xkll_sketch& quantiles() const noexcept;
+        std::size_t max_outliers() const noexcept;
+
+    private:
+
+        void add_extreme(double value);
+
+        xkll_sketch m_sketch;
+        std::size_t m_max_outliers;
+        // Max-heap of the lowest values and min-heap of the highest ones.
+        std::vector<double> m_lowest;
+        std::vector<double> m_highest;
+    };
+
+    /******************************
+     * box summary implementation *
+     ******************************/
+
+    namespace detail
+    {
+        /**
+         * Moves the value of rank k of [first, last) to k and returns it,
+         * with the value of the next rank in next. The range must hold
+         * the ranks first to last - 1 of the whole sequence.
+         */
+        inline double select_rank(std::vector<double>& values, std::size_t first, std::size_t k,
+                                  std::size_t last, double& next)
+        {
+            auto begin = values.begin();
+            std::nth_element(begin + static_cast<std::ptrdiff_t>(first), begin + static_cast<std::ptrdiff_t>(k),
+                             begin + static_cast<std::ptrdiff_t>(last));
+            double res = values[k];
+            next = k + 1 < last ? *std::min_element(begin + static_cast<std::ptrdiff_t>(k + 1),
+                                                    begin + static_cast<std::ptrdiff_t>(last))
+                                : res;
+            return res;
+        }
+
+        inline double interpolate_rank(double value, double next, double h)
+        {
+            double fraction = h - std::floor(h);
+            return fraction == 0. ? value : value + fraction * (next - value);
+        }
+
+        /**
+         * Keeps the nb_kept outliers farthest from [low, high].
+         */
+        inline void cap_outliers(std::vector<double>& outliers, double low, double high, std::size_t nb_kept)
+        {
+            if (outliers.size() > nb_kept)
+            {
+                auto distance = [low, high](double v) { return v < low ? low - v : v - high; };
+                std::nth_element(outliers.begin(), outliers.begin() + static_cast<std::ptrdiff_t>(nb_kept), outliers.end(),
+                                 [&distance](double a, double b) { return distance(a) > distance(b); });
+                outliers.resize(nb_kept);
+            }
+            std::sort(outliers.begin(), outliers.end());
+        }
+
+        inline void set_whiskers(xbox_summary& summary, double& low_fence, double& high_fence)
+        {
+            double iqr = summary.q3 - summary.q1;
+            low_fence = summary.q1 - 1.5 * iqr;
+            high_fence = summary.q3 + 1.5 * iqr;
+            summary.lower_whisker = summary.q1;
+            summary.upper_whisker = summary.q3;
+        }
+    }
+
+    /**
+     * Computes the summary of the non-NaN values with selection
+     * algorithms, in O(size). The quartiles are linearly interpolated
+     * between order statistics, like d3.quantile used by the front-end.
+     * At most max_outliers outliers, the farthest from the whiskers, are
+     * kept.
+     */
+    template <class T>
+    inline xbox_summary box_summary(const T* values, std::size_t size, std::size_t max_outliers)
+    {
+        std::vector<double> v;
+        v.reserve(size);
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            double value = static_cast<double>(values[i]);
+            if (!std::isnan(value))
+            {
+                v.push_back(value);
+            }
+        }
+
+        xbox_summary res;
+        res.count = v.size();
+        if (v.empty())
+        {
+            return res;
+        }
+
+        std::size_t n = v.size();
+        double h1 = 0.25 * static_cast<double>(n - 1);
+        double h2 = 0.5 * static_cast<double>(n - 1);
+        double h3 = 0.75 * static_cast<double>(n - 1);
+        auto k1 = static_cast<std::size_t>(h1);
+        auto k2 = static_cast<std::size_t>(h2);
+        auto k3 = static_cast<std::size_t>(h3);
+
+        // The median splits the values, the third quartile is selected in
+        // the upper part, which holds the median, then the first one in
+        // the lower part.
+        double next2;
+        double median = detail::select_rank(v, 0, k2, n, next2);
+        res.median = detail::interpolate_rank(median, next2, h2);
+        double next3;
+        double q3 = detail::select_rank(v, k2, k3, n, next3);
+        res.q3 = detail::interpolate_rank(q3, next3, h3);
+        if (k1 < k2)
+        {
+            double next1;
+            double q1 = detail::select_rank(v, 0, k1, k2, next1);
+            res.q1 = detail::interpolate_rank(q1, k1 + 1 < k2 ? next1 : median, h1);
+        }
+        else
+        {
+            res.q1 = detail::interpolate_rank(median, next2, h1);
+        }
+
+        double low_fence, high_fence;
+        detail::set_whiskers(res, low_fence, high_fence);
+        for (double value : v)
+        {
+            if (value < low_fence || value > high_fence)
+            {
+                res.outliers.push_back(value);
+            }
+            else
+            {
+                res.lower_whisker = (std::min)(res.lower_whisker, value);
+                res.upper_whisker = (std::max)(res.upper_whisker, value);
+            }
+        }
+        res.outlier_count = res.outliers.size();
+        detail::cap_outliers(res.outliers, low_fence, high_fence, max_outliers);
+        return res;
+    }
+
+    /**
+     * Computes the summaries of several boxes, one box per task.
+     */
+    template <class C>
+    inline std::vector<xbox_summary> box_summaries(const std::vector<C>& boxes, std::size_t max_outliers)
+    {
+        std::vector<xbox_summary> res(boxes.size());
+        parallel_for(0, boxes.size(), 1, [&](std::size_t first, std::size_t last) {
+            for (std::size_t i = first; i < last; ++i)
+            {
+                res[i] = box_summary(boxes[i].data(), boxes[i].size(), max_outliers);
+            }
+        });
+        return res;
+    }
+
+    /**
+     * Returns a sample whose box plot, as drawn by the front-end, is the
+     * one of summary. With t the largest number of outliers below or
+     * above the box plus one, the sample has 4t + 1 sorted values so that
+     * the quartiles fall on the values of rank t, 2t and 3t; the whiskers
+     * and the outliers are placed at both ends and the remaining ranks are
+     * filled with the quartiles.
+     */
+    inline std::vector<double> box_sample(const xbox_summary& summary)
+    {
+        std::vector<double> res;
+        if (summary.count == 0)
+        {
+            return res;
+        }
+
+        auto upper = std::upper_bound(summary.outliers.begin(), summary.outliers.end(), summary.median);
+        std::size_t nb_low = static_cast<std::size_t>(upper - summary.outliers.begin());
+        std::size_t nb_high = summary.outliers.size() - nb_low;
+        std::size_t t = (std::max)(nb_low, nb_high) + 1;
+
+        res.reserve(4 * t + 1);
+        res.insert(res.end(), summary.outliers.begin(), upper);
+        res.push_back(summary.lower_whisker);
+        res.resize(t, summary.q1);
+        res.push_back(summary.q1);
+        res.resize(2 * t, summary.median);
+        res.push_back(summary.median);
+        res.resize(3 * t, summary.q3);
+        res.push_back(summary.q3);
+        res.resize(4 * t - nb_high, summary.q3);
+        res.push_back(summary.upper_whisker);
+        res.insert(res.end(), upper, summary.outliers.end());
+        return res;
+    }
+
+    /******************************
+     * xkll_sketch implementation *
+     ******************************/
+
+    inline xkll_sketch::xkll_sketch(std::size_t k)
+        : m_k((std::max)(k, std::size_t(8))),
+          m_levels(1),
+          m_count(0),
+          m_retained(0),
+          m_min(std::numeric_limits<double>::infinity()),
+          m_max(-std::numeric_limits<double>::infinity()),
+          m_odd_offset(false)
+    {
+    }
+
+    /**
+     * Adds an observation; NaNs are ignored.
+     */
+    inline void xkll_sketch::update(double value)
+    {
+        if (std::isnan(value))
+        {
+            return;
+        }
+        m_levels.front().push_back(value);
+        ++m_count;
+        ++m_retained;
+        m_min = (std::min)(m_min, value);
+        m_max = (std::max)(m_max, value);
+        if (m_retained > capacity())
+        {
+            compress();
+        }
+    }
+
+    /**
+     * Adds the observations of other, as if they were added to this
+     * sketch.
+     */
+    inline void xkll_sketch::merge(const xkll_sketch& other)
+    {
+        if (other.m_levels.size() > m_levels.size())
+        {
+            m_levels.resize(other.m_levels.size());
+        }
+        for (std::size_t h = 0; h < other.m_levels.size(); ++h)
+        {
+            m_levels[h].insert(m_levels[h].end(), other.m_levels[h].begin(), other.m_levels[h].end());
+        }
+        m_count += other.m_count;
+        m_retained += other.m_retained;
+        m_min = (std::min)(m_min, other.m_min);
+        m_max = (std::max)(m_max, other.m_max);
+        while (m_retained > capacity())
+        {
+            compress();
+        }
+    }
+
+    /**
+     * Returns an estimate of the quantile p of the observations, which is
+     * one of them. The minimum and the maximum are exact.
+     */
+    inline double xkll_sketch::quantile(double p) const
+    {
+        if (m_count == 0)
+        {
+            return std::numeric_limits<double>::quiet_NaN();
+        }
+        if (p <= 0.)
+        {
+            return m_min;
+        }
+        if (p >= 1.)
+        {
+            return m_max;
+        }
+
+        std::vector<std::pair<double, std::size_t>> weighted;
+        weighted.reserve(m_retained);
+        for_each_value([&weighted](double value, std::size_t weight) { weighted.emplace_back(value, weight); });
+        std::sort(weighted.begin(), weighted.end());
+        double rank = p * static_cast<double>(m_count);
+        std::size_t cumulated = 0;
+        for (const auto& item : weighted)
+        {
+            cumulated += item.second;
+            if (static_cast<double>(cumulated) > rank)
+            {
+                return item.first;
+            }
+        }
+        return m_max;
+    }
+
+    /**
+     * Calls f(value, weight) on the retained values, weight being the
+     * number of observations a value stands for.
+     */
+    template <class F>
+    inline void xkll_sketch::for_each_value(F&& f) const
+    {
+        for (std::size_t h = 0; h < m_levels.size(); ++h)
+        {
+            std::size_t weight = std::size_t(1) << h;
+            for (double value : m_levels[h])
+            {
+                f(value, weight);
+            }
+        }
+    }
+
+    inline std::size_t xkll_sketch::k() const noexcept
+    {
+        return m_k;
+    }
+
+    inline std::size_t xkll_sketch::count() const noexcept
+    {
+        return m_count;
+    }
+
+    inline std::size_t xkll_sketch::retained() const noexcept
+    {
+        return m_retained;
+    }
+
+    inline double xkll_sketch::min() const noexcept
+    {
+        return m_min;
+    }
+
+    inline double xkll_sketch::max() const noexcept
+    {
+        return m_max;
+    }
+
+    inline std::size_t xkll_sketch::level_capacity(std::size_t level) const noexcept
+    {
+        std::size_t depth = m_levels.size() - 1 - level;
+        double res = std::ceil(static_cast<double>(m_k) * std::pow(2. / 3., static_cast<double>(depth)));
+        return (std::max)(static_cast<std::size_t>(res), std::size_t(2));
+    }
+
+    inline std::size_t xkll_sketch::capacity() const noexcept
+    {
+        std::size_t res = 0;
+        for (std::size_t h = 0; h < m_levels.size(); ++h)
+        {
+            res += level_capacity(h);
+        }
+        return res;
+    }
+
+    /**
+     * Compacts the lowest level exceeding its capacity: its values are
+     * sorted and every other one, starting at an alternating offset, is
+     * promoted to the next level. With an odd number of values, the
+     * smallest one stays in the level.
+     */
+    inline void xkll_sketch::compress()
+    {
+        for (std::size_t h = 0; h < m_levels.size(); ++h)
+        {
+            if (m_levels[h].size() < level_capacity(h))
+            {
+                continue;
+            }
+            if (h + 1 == m_levels.size())
+            {
+                m_levels.emplace_back();
+            }
+
+            std::vector<double>& level = m_levels[h];
+            std::sort(level.begin(), level.end());
+            std::size_t first = level.size() % 2;
+            std::size_t offset = m_odd_offset ? 1 : 0;
+            m_odd_offset = !m_odd_offset;
+            std::vector<double>& next = m_levels[h + 1];
+            for (std::size_t i = first + offset; i < level.size(); i += 2)
+            {
+                next.push_back(level[i]);
+            }
+            std::size_t nb_compacted = level.size() - first;
+            level.resize(first);
+            m_retained -= nb_compacted / 2;
+            return;
+        }
+    }
+
+    /******************************
+     * xbox_sketch implementation *
+     ******************************/
+
+    inline xbox_sketch::xbox_sketch(std::size_t k, std::size_t max_outliers)
+        : m_sketch(k), m_max_outliers(max_outliers)
+    {
+    }
+
+    template <class T>
+    inline void xbox_sketch::update(const T* values, std::size_t size)
+    {
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            double value = static_cast<double>(values[i]);
+            if (!std::isnan(value))
+            {
+                m_sketch.update(value);
+                add_extreme(value);
+            }
+        }
+    }
+
+    inline void xbox_sketch::merge(const xbox_sketch& other)
+    {
+        m_sketch.merge(other.m_sketch);
+        for (double value : other.m_lowest)
+        {
+            add_extreme(value);
+        }
+        for (double value : other.m_highest)
+        {
+            add_extreme(value);
+        }
+    }
+
+    /**
+     * Estimates the summary of the observations. The quartiles are
+     * estimated by the sketch, the whiskers are the extreme retained
+     * values within the fences, and the outliers are the tracked extreme
+     * values beyond them, so that outlier_count is at most max_outliers
+     * on each side.
+     */
+    inline xbox_summary xbox_sketch::summary() const
+    {
+        xbox_summary res;
+        res.count = m_sketch.count();
+        if (res.count == 0)
+        {
+            return res;
+        }
+
+        res.q1 = m_sketch.quantile(0.25);
+        res.median = m_sketch.quantile(0.5);
+        res.q3 = m_sketch.quantile(0.75);
+        double low_fence, high_fence;
+        detail::set_whiskers(res, low_fence, high_fence);
+
+        auto add_whisker = [&res, low_fence, high_fence](double value) {
+            if (value >= low_fence && value <= high_fence)
+            {
+                res.lower_whisker = (std::min)(res.lower_whisker, value);
+                res.upper_whisker = (std::max)(res.upper_whisker, value);
+            }
+        };
+        m_sketch.for_each_value([&add_whisker](double value, std::size_t) { add_whisker(value); });
+        for (double value : m_lowest)
+        {
+            add_whisker(value);
+            if (value < low_fence)
+            {
+                res.outliers.push_back(value);
+            }
+        }
+        for (double value : m_highest)
+        {
+            add_whisker(value);
+            if (value > high_fence)
+            {
+                res.outliers.push_back(value);
+            }
+        }
+        res.outlier_count = res.outliers.size();
+        std::sort(res.outliers.begin(), res.outliers.end());
+        return res;
+    }
+
+    inline const xkll_sketch& xbox_sketch::quantiles() const noexcept
+    {
+        return m_sketch;
+    }
+
+    inline std::size_t xbox_sketch::max_outliers() const noexcept
+    {
+        return m_max_outliers;
+    }
+
+    inline void xbox_sketch::add_extreme(double value)
+    {
+        if (m_max_outliers == 0)
+        {
+            return;
+        }
+        if (m_lowest.size() < m_max_outliers)
+        {
+            m_lowest.push_back(value);
+            std::push_heap(m_lowest.begin(), m_lowest.end());
+        }
+        else if (value < m_lowest.front())
+        {
+            std::pop_heap(m_lowest.begin(), m_lowest.end());
+            m_lowest.back() = value;
+            std::push_heap(m_lowest.begin(), m_lowest.end());
+        }
+
+        if (m_highest.size() < m_max_outliers)
+        {
+            m_highest.push_back(value);
+            std::push_heap(m_highest.begin(), m_highest.end(), std::greater<double>());
+        }
+        else if (value > m_highest.front())
+        {
+            std::pop_heap(m_highest.begin(), m_highest.end(), std::greater<double>());
+            m_highest.back() = value;
+            std::push_heap(m_highest.begin(), m_highest.end(), std::greater<double>());
+        }
+    }
+}
+
+#endif
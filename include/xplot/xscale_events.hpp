@@ -0,0 +1,428 @@
+/***************************************************************************
+* Copyright (c) 2017, Sylvain Corlay and Johan Mabille                     *
+*                                                                          *
+* Distributed under the terms of the BSD 3-Clause License.                 *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#ifndef XPLOT_SCALE_EVENTS_HPP
+#define XPLOT_SCALE_EVENTS_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "xtl/xoptional.hpp"
+
+#include "xeus/xguid.hpp"
+
+namespace xpl
+{
+    class xdomain_subscription;
+    class xhold_scale_events;
+
+    /********************************
+     * xscale_event_hub declaration *
+     ********************************/
+
+    /**
+     * Dispatches the changes of the domain of the scales, e.g. the ones
+     * made by a pan-zoom interaction, to the marks that subscribed to
+     * them. Scales are identified by their widget id since marks only hold
+     * references to their scales.
+     *
+     * The synchronization of the subscribers is deferred while an event is
+     * dispatched, so that a mark recomputed for several scales sends a
+     * single patch, and the patches of all the marks sharing a scale are
+     * sent in a burst once they are all recomputed. While the hub is held,
+     * events are queued and only the last domain of each scale is
+     * dispatched when the hold is released or the hub is flushed.
+     *
+     * The scales hold the hub while they apply a patch, so that the events
+     * of a patch are dispatched once, when it is applied. Coalescing the
+     * events of several patches, e.g. once per frame, is manual: the kernel
+     * has no frame clock, the caller holds the hub around the messages to
+     * coalesce, or flushes it from its own timer.
+     */
+    class xscale_event_hub
+    {
+    public:
+
+        using domain_bound_type = xtl::xoptional<double>;
+        using handler_type = std::function<void(const domain_bound_type&, const domain_bound_type&)>;
+        using sync_type = std::function<void()>;
+
+        void publish(const xeus::xguid& scale_id, const domain_bound_type& min, const domain_bound_type& max);
+
+        xhold_scale_events hold();
+        void flush();
+        bool held() const noexcept;
+
+    private:
+
+        struct subscriber_type
+        {
+            handler_type handler;
+            sync_type defer_sync;
+            sync_type resume_sync;
+        };
+
+        struct event_type
+        {
+            xeus::xguid scale_id;
+            domain_bound_type min;
+            domain_bound_type max;
+        };
+
+        using subscribers_type = std::map<const xdomain_subscription*, subscriber_type>;
+
+        void subscribe(const xeus::xguid& scale_id, const xdomain_subscription* key, subscriber_type subscriber);
+        void unsubscribe(const xeus::xguid& scale_id, const xdomain_subscription* key);
+
+        void defer() noexcept;
+        void resume();
+
+        void dispatch(const std::vector<event_type>& events);
+        void dispatch(const event_type& event);
+
+        std::map<xeus::xguid, subscribers_type> m_subscribers;
+        std::vector<event_type> m_pending;
+        std::map<const xdomain_subscription*, sync_type> m_deferred;
+        std::size_t m_hold_count = 0;
+
+        friend class xdomain_subscription;
+        friend class xhold_scale_events;
+    };
+
+    xscale_event_hub& get_scale_event_hub();
+
+    /**********************************
+     * xhold_scale_events declaration *
+     **********************************/
+
+    /**
+     * Scope guard holding the events of the scale event hub, which are
+     * dispatched when the outermost guard is destroyed.
+     */
+    class xhold_scale_events
+    {
+    public:
+
+        explicit xhold_scale_events(xscale_event_hub& hub);
+        ~xhold_scale_events();
+
+        xhold_scale_events(const xhold_scale_events&) = delete;
+        xhold_scale_events& operator=(const xhold_scale_events&) = delete;
+
+        xhold_scale_events(xhold_scale_events&& rhs) noexcept;
+        xhold_scale_events& operator=(xhold_scale_events&&) = delete;
+
+    private:
+
+        xscale_event_hub* p_hub;
+    };
+
+    /************************************
+     * xdomain_subscription declaration *
+     ************************************/
+
+    /**
+     * Subscription of a handler to the domain changes of a scale, removed
+     * when the subscription is destroyed. Copies and moves are not
+     * subscribed, since the handler usually refers to the object owning
+     * the subscription.
+     */
+    class xdomain_subscription
+    {
+    public:
+
+        using handler_type = xscale_event_hub::handler_type;
+        using sync_type = xscale_event_hub::sync_type;
+
+        xdomain_subscription() = default;
+        ~xdomain_subscription();
+
+        xdomain_subscription(const xdomain_subscription&) noexcept;
+        xdomain_subscription(xdomain_subscription&&) noexcept;
+
+        xdomain_subscription& operator=(const xdomain_subscription&);
+        xdomain_subscription& operator=(xdomain_subscription&&);
+
+        void subscribe(const xeus::xguid& scale_id, handler_type handler);
+        void subscribe(const xeus::xguid& scale_id, handler_type handler, sync_type defer_sync, sync_type resume_sync);
+        void reset();
+
+        bool subscribed() const noexcept;
+        const xeus::xguid& scale_id() const noexcept;
+
+    private:
+
+        xeus::xguid m_scale_id;
+        bool m_subscribed = false;
+    };
+
+    /***********************************
+     * xscale_event_hub implementation *
+     ***********************************/
+
+    /**
+     * Dispatches the new domain of the scale to its subscribers, or queues
+     * it while the hub is held.
+     */
+    inline void xscale_event_hub::publish(const xeus::xguid& scale_id, const domain_bound_type& min, const domain_bound_type& max)
+    {
+        if (m_hold_count == 0)
+        {
+            dispatch(std::vector<event_type>(1, event_type{scale_id, min, max}));
+            return;
+        }
+
+        auto it = std::find_if(m_pending.begin(), m_pending.end(), [&scale_id](const event_type& event) {
+            return event.scale_id == scale_id;
+        });
+        if (it != m_pending.end())
+        {
+            it->min = min;
+            it->max = max;
+        }
+        else
+        {
+            m_pending.push_back(event_type{scale_id, min, max});
+        }
+    }
+
+    inline xhold_scale_events xscale_event_hub::hold()
+    {
+        return xhold_scale_events(*this);
+    }
+
+    /**
+     * Dispatches the queued events, even if the hub is held.
+     */
+    inline void xscale_event_hub::flush()
+    {
+        std::vector<event_type> events;
+        events.swap(m_pending);
+        if (!events.empty())
+        {
+            dispatch(events);
+        }
+    }
+
+    inline bool xscale_event_hub::held() const noexcept
+    {
+        return m_hold_count != 0;
+    }
+
+    inline void xscale_event_hub::subscribe(const xeus::xguid& scale_id, const xdomain_subscription* key, subscriber_type subscriber)
+    {
+        m_subscribers[scale_id][key] = std::move(subscriber);
+    }
+
+    inline void xscale_event_hub::unsubscribe(const xeus::xguid& scale_id, const xdomain_subscription* key)
+    {
+        // The synchronization of a subscriber removed while an event is
+        // dispatched is not resumed, it is usually being destroyed.
+        m_deferred.erase(key);
+        auto it = m_subscribers.find(scale_id);
+        if (it != m_subscribers.end())
+        {
+            it->second.erase(key);
+            if (it->second.empty())
+            {
+                m_subscribers.erase(it);
+            }
+        }
+    }
+
+    inline void xscale_event_hub::defer() noexcept
+    {
+        ++m_hold_count;
+    }
+
+    inline void xscale_event_hub::resume()
+    {
+        if (m_hold_count != 0 && --m_hold_count == 0)
+        {
+            flush();
+        }
+    }
+
+    /**
+     * Defers the synchronization of the subscribers of the scales, calls
+     * their handlers, and resumes their synchronization. Handlers may
+     * subscribe, unsubscribe or publish while the events are dispatched.
+     */
+    inline void xscale_event_hub::dispatch(const std::vector<event_type>& events)
+    {
+        std::vector<const xdomain_subscription*> deferred;
+        for (const auto& event : events)
+        {
+            auto it = m_subscribers.find(event.scale_id);
+            if (it == m_subscribers.end())
+            {
+                continue;
+            }
+            for (const auto& subscriber : it->second)
+            {
+                const subscriber_type& s = subscriber.second;
+                if (s.defer_sync && m_deferred.find(subscriber.first) == m_deferred.end())
+                {
+                    m_deferred[subscriber.first] = s.resume_sync;
+                    deferred.push_back(subscriber.first);
+                    s.defer_sync();
+                }
+            }
+        }
+
+        for (const auto& event : events)
+        {
+            dispatch(event);
+        }
+
+        for (const xdomain_subscription* key : deferred)
+        {
+            auto it = m_deferred.find(key);
+            if (it != m_deferred.end())
+            {
+                sync_type resume_sync = std::move(it->second);
+                m_deferred.erase(it);
+                resume_sync();
+            }
+        }
+    }
+
+    inline void xscale_event_hub::dispatch(const event_type& event)
+    {
+        auto it = m_subscribers.find(event.scale_id);
+        if (it == m_subscribers.end())
+        {
+            return;
+        }
+
+        std::vector<const xdomain_subscription*> keys;
+        keys.reserve(it->second.size());
+        for (const auto& subscriber : it->second)
+        {
+            keys.push_back(subscriber.first);
+        }
+
+        for (const xdomain_subscription* key : keys)
+        {
+            auto subscribers = m_subscribers.find(event.scale_id);
+            if (subscribers == m_subscribers.end())
+            {
+                return;
+            }
+            auto subscriber = subscribers->second.find(key);
+            if (subscriber != subscribers->second.end())
+            {
+                handler_type handler = subscriber->second.handler;
+                handler(event.min, event.max);
+            }
+        }
+    }
+
+    inline xscale_event_hub& get_scale_event_hub()
+    {
+        static xscale_event_hub hub;
+        return hub;
+    }
+
+    /*************************************
+     * xhold_scale_events implementation *
+     *************************************/
+
+    inline xhold_scale_events::xhold_scale_events(xscale_event_hub& hub)
+        : p_hub(&hub)
+    {
+        p_hub->defer();
+    }
+
+    inline xhold_scale_events::~xhold_scale_events()
+    {
+        if (p_hub != nullptr)
+        {
+            p_hub->resume();
+        }
+    }
+
+    inline xhold_scale_events::xhold_scale_events(xhold_scale_events&& rhs) noexcept
+        : p_hub(rhs.p_hub)
+    {
+        rhs.p_hub = nullptr;
+    }
+
+    /***************************************
+     * xdomain_subscription implementation *
+     ***************************************/
+
+    inline xdomain_subscription::~xdomain_subscription()
+    {
+        reset();
+    }
+
+    inline xdomain_subscription::xdomain_subscription(const xdomain_subscription&) noexcept
+    {
+    }
+
+    inline xdomain_subscription::xdomain_subscription(xdomain_subscription&&) noexcept
+    {
+    }
+
+    inline xdomain_subscription& xdomain_subscription::operator=(const xdomain_subscription&)
+    {
+        reset();
+        return *this;
+    }
+
+    inline xdomain_subscription& xdomain_subscription::operator=(xdomain_subscription&&)
+    {
+        reset();
+        return *this;
+    }
+
+    inline void xdomain_subscription::subscribe(const xeus::xguid& scale_id, handler_type handler)
+    {
+        subscribe(scale_id, std::move(handler), nullptr, nullptr);
+    }
+
+    /**
+     * Subscribes the handler, defer_sync and resume_sync deferring and
+     * resuming the synchronization of the widget updated by the handler
+     * while events are dispatched.
+     */
+    inline void xdomain_subscription::subscribe(const xeus::xguid& scale_id, handler_type handler,
+                                                sync_type defer_sync, sync_type resume_sync)
+    {
+        reset();
+        get_scale_event_hub().subscribe(scale_id, this, {std::move(handler), std::move(defer_sync), std::move(resume_sync)});
+        m_scale_id = scale_id;
+        m_subscribed = true;
+    }
+
+    inline void xdomain_subscription::reset()
+    {
+        if (m_subscribed)
+        {
+            get_scale_event_hub().unsubscribe(m_scale_id, this);
+            m_subscribed = false;
+        }
+    }
+
+    inline bool xdomain_subscription::subscribed() const noexcept
+    {
+        return m_subscribed;
+    }
+
+    inline const xeus::xguid& xdomain_subscription::scale_id() const noexcept
+    {
+        return m_scale_id;
+    }
+}
+
+#endif
@@ -0,0 +1,558 @@
+/***************************************************************************
+* Copyright (c) 2017, Sylvain Corlay and Johan Mabille                     *
+*                                                                          *
+* Distributed under the terms of the BSD 3-Clause License.                 *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#ifndef XPLOT_SCALE_TRANSFORM_HPP
+#define XPLOT_SCALE_TRANSFORM_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace xpl
+{
+    /**
+     * Evaluation of the scales in C++, mapping data values to positions
+     * in a range of pixels as the front-end does. The transforms are
+     * plain values built from the properties of a scale, for instance
+     * with xlinear_scale::make_transform, and can be used from several
+     * threads.
+     *
+     * The batch methods are written as branch-free loops over contiguous
+     * arrays, which the compiler vectorizes.
+     */
+
+    /*********************************
+     * xlinear_transform declaration *
+     *********************************/
+
+    class xlinear_transform
+    {
+    public:
+
+        xlinear_transform(double domain_min, double domain_max, double range_min, double range_max);
+
+        double operator()(double value) const noexcept;
+        double invert(double position) const noexcept;
+
+        template <class T>
+        void transform(const T* values, std::size_t size, double* positions) const noexcept;
+        void invert(const double* positions, std::size_t size, double* values) const noexcept;
+
+        template <class C>
+        std::vector<double> transform(const C& values) const;
+        std::vector<double> invert(const std::vector<double>& positions) const;
+
+        double slope() const noexcept;
+        double offset() const noexcept;
+
+    private:
+
+        double m_slope;
+        double m_offset;
+        double m_inverse_slope;
+        double m_inverse_offset;
+    };
+
+    /******************************
+     * xlog_transform declaration *
+     ******************************/
+
+    class xlog_transform
+    {
+    public:
+
+        xlog_transform(double domain_min, double domain_max, double range_min, double range_max);
+
+        double operator()(double value) const noexcept;
+        double invert(double position) const noexcept;
+
+        template <class T>
+        void transform(const T* values, std::size_t size, double* positions) const noexcept;
+        void invert(const double* positions, std::size_t size, double* values) const noexcept;
+
+        template <class C>
+        std::vector<double> transform(const C& values) const;
+        std::vector<double> invert(const std::vector<double>& positions) const;
+
+    private:
+
+        xlinear_transform m_linear;
+    };
+
+    /**********************************
+     * xordinal_transform declaration *
+     **********************************/
+
+    /**
+     * Maps the values of the domain to the middle of equal bands dividing
+     * the range; values outside of the domain are mapped to NaN.
+     */
+    class xordinal_transform
+    {
+    public:
+
+        xordinal_transform(std::vector<double> domain, double range_min, double range_max);
+
+        double operator()(double value) const;
+        double invert(double position) const noexcept;
+        std::size_t index(double value) const;
+
+        template <class T>
+        void transform(const T* values, std::size_t size, double* positions) const;
+        void invert(const double* positions, std::size_t size, double* values) const noexcept;
+
+        template <class C>
+        std::vector<double> transform(const C& values) const;
+        std::vector<double> invert(const std::vector<double>& positions) const;
+
+        const std::vector<double>& domain() const noexcept;
+        double bandwidth() const noexcept;
+
+    private:
+
+        std::vector<double> m_domain;
+        std::unordered_map<double, std::size_t> m_index;
+        double m_range_min;
+        double m_bandwidth;
+    };
+
+    /********************************
+     * xcolor_transform declaration *
+     ********************************/
+
+    /**
+     * Maps values to colors interpolated in RGB between colors evenly
+     * spaced over [min, max], or over [min, mid] and [mid, max] when mid
+     * is set. Values outside of the domain are clamped. Colors are packed
+     * as 0xAARRGGBB, NaN being mapped to a transparent color.
+     */
+    class xcolor_transform
+    {
+    public:
+
+        using packed_color = std::uint32_t;
+
+        xcolor_transform(const std::vector<std::string>& colors, double min, double max, bool log = false);
+        xcolor_transform(const std::vector<std::string>& colors, double min, double mid, double max, bool log = false);
+
+        std::string operator()(double value) const;
+        packed_color packed(double value) const noexcept;
+
+        template <class T>
+        void transform(const T* values, std::size_t size, packed_color* colors) const noexcept;
+
+        template <class C>
+        std::vector<std::string> transform(const C& values) const;
+
+        const std::vector<packed_color>& colors() const noexcept;
+
+    private:
+
+        double normalize(double value) const noexcept;
+
+        std::vector<packed_color> m_colors;
+        bool m_log;
+        double m_min;
+        double m_mid;
+        double m_max;
+    };
+
+    std::uint32_t parse_color(const std::string& color);
+    std::string format_color(std::uint32_t color);
+
+    /************************************
+     * xlinear_transform implementation *
+     ************************************/
+
+    namespace detail
+    {
+        constexpr double nan = std::numeric_limits<double>::quiet_NaN();
+
+        // Coefficients of the affine map from [x0, x1] to [y0, y1]; a
+        // degenerate interval is mapped to the middle of the other one.
+        inline std::pair<double, double> affine_coefficients(double x0, double x1, double y0, double y1)
+        {
+            if (x0 == x1)
+            {
+                return {0., (y0 + y1) / 2.};
+            }
+            double slope = (y1 - y0) / (x1 - x0);
+            return {slope, y0 - slope * x0};
+        }
+    }
+
+    inline xlinear_transform::xlinear_transform(double domain_min, double domain_max, double range_min, double range_max)
+    {
+        std::tie(m_slope, m_offset) = detail::affine_coefficients(domain_min, domain_max, range_min, range_max);
+        std::tie(m_inverse_slope, m_inverse_offset) = detail::affine_coefficients(range_min, range_max, domain_min, domain_max);
+    }
+
+    inline double xlinear_transform::operator()(double value) const noexcept
+    {
+        return m_offset + m_slope * value;
+    }
+
+    inline double xlinear_transform::invert(double position) const noexcept
+    {
+        return m_inverse_offset + m_inverse_slope * position;
+    }
+
+    template <class T>
+    inline void xlinear_transform::transform(const T* values, std::size_t size, double* positions) const noexcept
+    {
+        const double slope = m_slope;
+        const double offset = m_offset;
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            positions[i] = offset + slope * static_cast<double>(values[i]);
+        }
+    }
+
+    inline void xlinear_transform::invert(const double* positions, std::size_t size, double* values) const noexcept
+    {
+        const double slope = m_inverse_slope;
+        const double offset = m_inverse_offset;
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            values[i] = offset + slope * positions[i];
+        }
+    }
+
+    template <class C>
+    inline std::vector<double> xlinear_transform::transform(const C& values) const
+    {
+        std::vector<double> res(values.size());
+        transform(values.data(), values.size(), res.data());
+        return res;
+    }
+
+    inline std::vector<double> xlinear_transform::invert(const std::vector<double>& positions) const
+    {
+        std::vector<double> res(positions.size());
+        invert(positions.data(), positions.size(), res.data());
+        return res;
+    }
+
+    inline double xlinear_transform::slope() const noexcept
+    {
+        return m_slope;
+    }
+
+    inline double xlinear_transform::offset() const noexcept
+    {
+        return m_offset;
+    }
+
+    /*********************************
+     * xlog_transform implementation *
+     *********************************/
+
+    /**
+     * The bounds of the domain must be positive; the positions of the
+     * values which are not are NaN.
+     */
+    inline xlog_transform::xlog_transform(double domain_min, double domain_max, double range_min, double range_max)
+        : m_linear(std::log(domain_min), std::log(domain_max), range_min, range_max)
+    {
+        if (!(domain_min > 0.) || !(domain_max > 0.))
+        {
+            throw std::invalid_argument("the domain of a log scale must be positive");
+        }
+    }
+
+    inline double xlog_transform::operator()(double value) const noexcept
+    {
+        return value > 0. ? m_linear(std::log(value)) : detail::nan;
+    }
+
+    inline double xlog_transform::invert(double position) const noexcept
+    {
+        return std::exp(m_linear.invert(position));
+    }
+
+    template <class T>
+    inline void xlog_transform::transform(const T* values, std::size_t size, double* positions) const noexcept
+    {
+        const double slope = m_linear.slope();
+        const double offset = m_linear.offset();
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            double value = static_cast<double>(values[i]);
+            positions[i] = value > 0. ? offset + slope * std::log(value) : detail::nan;
+        }
+    }
+
+    inline void xlog_transform::invert(const double* positions, std::size_t size, double* values) const noexcept
+    {
+        m_linear.invert(positions, size, values);
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            values[i] = std::exp(values[i]);
+        }
+    }
+
+    template <class C>
+    inline std::vector<double> xlog_transform::transform(const C& values) const
+    {
+        std::vector<double> res(values.size());
+        transform(values.data(), values.size(), res.data());
+        return res;
+    }
+
+    inline std::vector<double> xlog_transform::invert(const std::vector<double>& positions) const
+    {
+        std::vector<double> res(positions.size());
+        invert(positions.data(), positions.size(), res.data());
+        return res;
+    }
+
+    /*************************************
+     * xordinal_transform implementation *
+     *************************************/
+
+    inline xordinal_transform::xordinal_transform(std::vector<double> domain, double range_min, double range_max)
+        : m_domain(std::move(domain)), m_range_min(range_min),
+          m_bandwidth(m_domain.empty() ? 0. : (range_max - range_min) / static_cast<double>(m_domain.size()))
+    {
+        m_index.reserve(m_domain.size());
+        for (std::size_t i = 0; i < m_domain.size(); ++i)
+        {
+            m_index.emplace(m_domain[i], i);
+        }
+    }
+
+    inline double xordinal_transform::operator()(double value) const
+    {
+        std::size_t i = index(value);
+        return i == m_domain.size() ? detail::nan : m_range_min + m_bandwidth * (static_cast<double>(i) + 0.5);
+    }
+
+    /**
+     * Returns the value of the domain whose band holds position, NaN if
+     * there is none.
+     */
+    inline double xordinal_transform::invert(double position) const noexcept
+    {
+        double band = std::floor((position - m_range_min) / m_bandwidth);
+        return band >= 0. && band < static_cast<double>(m_domain.size()) ? m_domain[static_cast<std::size_t>(band)] : detail::nan;
+    }
+
+    /**
+     * Returns the index of value in the domain, the size of the domain if
+     * it does not belong to it. When the domain holds value several times,
+     * its first occurrence is used.
+     */
+    inline std::size_t xordinal_transform::index(double value) const
+    {
+        auto it = m_index.find(value);
+        return it == m_index.end() ? m_domain.size() : it->second;
+    }
+
+    template <class T>
+    inline void xordinal_transform::transform(const T* values, std::size_t size, double* positions) const
+    {
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            positions[i] = (*this)(static_cast<double>(values[i]));
+        }
+    }
+
+    inline void xordinal_transform::invert(const double* positions, std::size_t size, double* values) const noexcept
+    {
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            values[i] = invert(positions[i]);
+        }
+    }
+
+    template <class C>
+    inline std::vector<double> xordinal_transform::transform(const C& values) const
+    {
+        std::vector<double> res(values.size());
+        transform(values.data(), values.size(), res.data());
+        return res;
+    }
+
+    inline std::vector<double> xordinal_transform::invert(const std::vector<double>& positions) const
+    {
+        std::vector<double> res(positions.size());
+        invert(positions.data(), positions.size(), res.data());
+        return res;
+    }
+
+    inline const std::vector<double>& xordinal_transform::domain() const noexcept
+    {
+        return m_domain;
+    }
+
+    inline double xordinal_transform::bandwidth() const noexcept
+    {
+        return m_bandwidth;
+    }
+
+    /***********************************
+     * xcolor_transform implementation *
+     ***********************************/
+
+    inline xcolor_transform::xcolor_transform(const std::vector<std::string>& colors, double min, double max, bool log)
+        : xcolor_transform(colors, min, detail::nan, max, log)
+    {
+    }
+
+    inline xcolor_transform::xcolor_transform(const std::vector<std::string>& colors, double min, double mid, double max, bool log)
+        : m_log(log)
+    {
+        if (colors.empty())
+        {
+            throw std::invalid_argument("a color transform requires at least one color");
+        }
+        if (log && (!(min > 0.) || !(max > 0.) || mid <= 0.))
+        {
+            throw std::invalid_argument("the domain of a log scale must be positive");
+        }
+        m_colors.reserve(colors.size());
+        for (const auto& color : colors)
+        {
+            m_colors.push_back(parse_color(color));
+        }
+        m_min = log ? std::log(min) : min;
+        m_mid = log ? std::log(mid) : mid;
+        m_max = log ? std::log(max) : max;
+    }
+
+    inline std::string xcolor_transform::operator()(double value) const
+    {
+        return std::isnan(value) ? std::string("none") : format_color(packed(value));
+    }
+
+    inline auto xcolor_transform::packed(double value) const noexcept -> packed_color
+    {
+        double t = normalize(m_log ? std::log(value) : value);
+        if (std::isnan(t))
+        {
+            return 0u;
+        }
+        double position = std::min(std::max(t, 0.), 1.) * static_cast<double>(m_colors.size() - 1);
+        std::size_t i = std::min(static_cast<std::size_t>(position), m_colors.size() - 1);
+        std::size_t j = std::min(i + 1, m_colors.size() - 1);
+        double w = position - static_cast<double>(i);
+        packed_color res = 0xff000000u;
+        for (unsigned shift = 0; shift < 24; shift += 8)
+        {
+            double a = static_cast<double>((m_colors[i] >> shift) & 0xffu);
+            double b = static_cast<double>((m_colors[j] >> shift) & 0xffu);
+            res |= static_cast<packed_color>(std::lround(a + (b - a) * w)) << shift;
+        }
+        return res;
+    }
+
+    template <class T>
+    inline void xcolor_transform::transform(const T* values, std::size_t size, packed_color* colors) const noexcept
+    {
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            colors[i] = packed(static_cast<double>(values[i]));
+        }
+    }
+
+    template <class C>
+    inline std::vector<std::string> xcolor_transform::transform(const C& values) const
+    {
+        std::vector<std::string> res;
+        res.reserve(values.size());
+        for (std::size_t i = 0; i < values.size(); ++i)
+        {
+            res.push_back((*this)(static_cast<double>(values.data()[i])));
+        }
+        return res;
+    }
+
+    inline auto xcolor_transform::colors() const noexcept -> const std::vector<packed_color>&
+    {
+        return m_colors;
+    }
+
+    // Maps the domain to [0, 1], the middle value to 0.5 if any.
+    inline double xcolor_transform::normalize(double value) const noexcept
+    {
+        auto ratio = [](double v, double a, double b) { return a == b ? 0.5 : (v - a) / (b - a); };
+        if (std::isnan(m_mid))
+        {
+            return ratio(value, m_min, m_max);
+        }
+        return value < m_mid ? 0.5 * ratio(value, m_min, m_mid) : 0.5 + 0.5 * ratio(value, m_mid, m_max);
+    }
+
+    /********************************
+     * color parsing implementation *
+     ********************************/
+
+    /**
+     * Parses a color of the form #rgb or #rrggbb into 0xAARRGGBB.
+     */
+    inline std::uint32_t parse_color(const std::string& color)
+    {
+        auto digit = [&color](char c) -> std::uint32_t {
+            if (c >= '0' && c <= '9')
+            {
+                return static_cast<std::uint32_t>(c - '0');
+            }
+            c = static_cast<char>(c | 0x20);
+            if (c >= 'a' && c <= 'f')
+            {
+                return static_cast<std::uint32_t>(c - 'a' + 10);
+            }
+            throw std::invalid_argument("unsupported color: " + color);
+        };
+        std::uint32_t res = 0;
+        if (color.size() == 7 && color[0] == '#')
+        {
+            for (std::size_t i = 1; i < 7; ++i)
+            {
+                res = (res << 4) | digit(color[i]);
+            }
+        }
+        else if (color.size() == 4 && color[0] == '#')
+        {
+            for (std::size_t i = 1; i < 4; ++i)
+            {
+                std::uint32_t d = digit(color[i]);
+                res = (res << 8) | (d << 4) | d;
+            }
+        }
+        else
+        {
+            throw std::invalid_argument("unsupported color: " + color);
+        }
+        return 0xff000000u | res;
+    }
+
+    /**
+     * Formats a packed color as #rrggbb.
+     */
+    inline std::string format_color(std::uint32_t color)
+    {
+        static const char digits[] = "0123456789abcdef";
+        std::string res(7, '#');
+        for (std::size_t i = 0; i < 6; ++i)
+        {
+            res[6 - i] = digits[(color >> (4 * i)) & 0xfu];
+        }
+        return res;
+    }
+}
+
+#endif
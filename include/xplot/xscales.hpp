@@ -9,7 +9,10 @@
 #ifndef XPLOT_SCALES_HPP
 #define XPLOT_SCALES_HPP
 
+#include <algorithm>
+#include <stdexcept>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "nlohmann/json.hpp"
@@ -18,7 +21,11 @@
 
 #include "xproperty/xjson.hpp" 
 
+#include "xcolor_schemes.hpp"
+#include "xdomain_tracker.hpp"
 #include "xplot.hpp"
+#include "xscale_events.hpp"
+#include "xscale_transform.hpp"
 
 namespace nl = nlohmann;
 
@@ -48,6 +55,8 @@ namespace xpl
 
         using base_type::base_type;
 
+        void apply_reverse(double& range_min, double& range_max) const noexcept;
+
     private:
 
         void set_defaults();
@@ -77,6 +86,15 @@ namespace xpl
         void serialize_state(nl::json&, xeus::buffer_sequence&) const;
         void apply_patch(const nl::json&, const xeus::buffer_sequence&);
 
+        template <class P>
+        void notify(const P& property) const;
+
+        xlinear_transform make_transform(double range_min, double range_max) const;
+
+        void enable_domain_tracking();
+        void disable_domain_tracking();
+        bool tracks_domain() const noexcept;
+
         XPROPERTY(xtl::xoptional<double>, derived_type, min);
         XPROPERTY(xtl::xoptional<double>, derived_type, max);
         XPROPERTY(bool, derived_type, stabilized, false);
@@ -92,6 +110,10 @@ namespace xpl
     private:
 
         void set_defaults();
+        void set_tracked_domain(const xextent& domain);
+
+        bool m_applying_patch = false;
+        xdomain_listener m_tracked_domain;
     };
 
     using linear_scale = xw::xmaterialize<xlinear_scale>;
@@ -111,6 +133,15 @@ namespace xpl
         void serialize_state(nl::json&, xeus::buffer_sequence&) const;
         void apply_patch(const nl::json&, const xeus::buffer_sequence&);
 
+        template <class P>
+        void notify(const P& property) const;
+
+        xlog_transform make_transform(double range_min, double range_max) const;
+
+        void enable_domain_tracking();
+        void disable_domain_tracking();
+        bool tracks_domain() const noexcept;
+
         XPROPERTY(xtl::xoptional<double>, derived_type, min);
         XPROPERTY(xtl::xoptional<double>, derived_type, max);
 
@@ -123,6 +154,10 @@ namespace xpl
     private:
 
         void set_defaults();
+        void set_tracked_domain(const xextent& domain);
+
+        bool m_applying_patch = false;
+        xdomain_listener m_tracked_domain;
     };
 
     using log_scale = xw::xmaterialize<xlog_scale>;
@@ -142,6 +177,8 @@ namespace xpl
         void serialize_state(nl::json&, xeus::buffer_sequence&) const;
         void apply_patch(const nl::json&, const xeus::buffer_sequence&);
 
+        xordinal_transform make_transform(double range_min, double range_max) const;
+
         XPROPERTY(std::vector<double>, derived_type, domain);
 
     protected:
@@ -172,6 +209,13 @@ namespace xpl
         void serialize_state(nl::json&, xeus::buffer_sequence&) const;
         void apply_patch(const nl::json&, const xeus::buffer_sequence&);
 
+        xcolor_transform make_transform() const;
+        xcolormap make_colormap() const;
+
+        void enable_domain_tracking();
+        void disable_domain_tracking();
+        bool tracks_domain() const noexcept;
+
         XPROPERTY(std::vector<color_type>, derived_type, colors);
         XPROPERTY(xtl::xoptional<double>, derived_type, max);
         XPROPERTY(xtl::xoptional<double>, derived_type, mid);
@@ -188,6 +232,10 @@ namespace xpl
     private:
 
         void set_defaults();
+        void set_tracked_domain(const xextent& domain);
+        std::vector<color_type> scale_colors() const;
+
+        xdomain_listener m_tracked_domain;
     };
 
     using color_scale = xw::xmaterialize<xcolor_scale>;
@@ -421,6 +469,31 @@ namespace xpl
         this->_view_name() = "Scale";
     }
 
+    /**
+     * Swaps the bounds of the range of a reversed scale.
+     */
+    template <class D>
+    inline void xscale<D>::apply_reverse(double& range_min, double& range_max) const noexcept
+    {
+        if (reverse())
+        {
+            std::swap(range_min, range_max);
+        }
+    }
+
+    namespace detail
+    {
+        inline std::pair<double, double> scale_domain(const xtl::xoptional<double>& min,
+                                                      const xtl::xoptional<double>& max)
+        {
+            if (!min.has_value() || !max.has_value())
+            {
+                throw std::logic_error("the domain of the scale is not set");
+            }
+            return {min.value(), max.value()};
+        }
+    }
+
     /*******************************
      * linear_scale implementation *
      *******************************/
@@ -429,13 +502,86 @@ namespace xpl
     inline void xlinear_scale<D>::apply_patch(const nl::json& patch, const xeus::buffer_sequence& buffers)
     {
         using xw::set_property_from_patch;
+        // The events caused by the patch are dispatched once it is applied.
+        auto hold = get_scale_event_hub().hold();
         base_type::apply_patch(patch, buffers);
 
+        m_applying_patch = true;
         set_property_from_patch(min, patch, buffers);
         set_property_from_patch(max, patch, buffers);
         set_property_from_patch(stabilized, patch, buffers);
         set_property_from_patch(mid_range, patch, buffers);
         set_property_from_patch(min_range, patch, buffers);
+        m_applying_patch = false;
+
+        // A pan-zoom interaction updates both bounds in a single patch,
+        // they are published together.
+        if (patch.count("min") != 0 || patch.count("max") != 0)
+        {
+            get_scale_event_hub().publish(this->id(), min(), max());
+        }
+    }
+
+    template <class D>
+    template <class P>
+    inline void xlinear_scale<D>::notify(const P& property) const
+    {
+        base_type::notify(property);
+        const void* p = &property;
+        if (!m_applying_patch && (p == &min || p == &max))
+        {
+            get_scale_event_hub().publish(this->id(), min(), max());
+        }
+    }
+
+    /**
+     * Returns the transform mapping the domain of the scale to the range
+     * [range_min, range_max], reversed if the scale is. The bounds of the
+     * domain must be set.
+     */
+    template <class D>
+    inline xlinear_transform xlinear_scale<D>::make_transform(double range_min, double range_max) const
+    {
+        auto domain = detail::scale_domain(min(), max());
+        this->apply_reverse(range_min, range_max);
+        return xlinear_transform(domain.first, domain.second, range_min, range_max);
+    }
+
+    /**
+     * Sets min and max to the extent of the data bound to the scale by
+     * the marks, NaN values excluded, and keeps them up to date as the
+     * data changes.
+     */
+    template <class D>
+    inline void xlinear_scale<D>::enable_domain_tracking()
+    {
+        m_tracked_domain.subscribe(this->id(), [this](const xextent& domain) {
+            set_tracked_domain(domain);
+        });
+    }
+
+    template <class D>
+    inline void xlinear_scale<D>::disable_domain_tracking()
+    {
+        m_tracked_domain.reset();
+    }
+
+    template <class D>
+    inline bool xlinear_scale<D>::tracks_domain() const noexcept
+    {
+        return m_tracked_domain.subscribed();
+    }
+
+    template <class D>
+    inline void xlinear_scale<D>::set_tracked_domain(const xextent& domain)
+    {
+        // Both bounds are published together, as for a pan-zoom patch.
+        auto hold = this->hold_sync();
+        m_applying_patch = true;
+        min = domain.min;
+        max = domain.max;
+        m_applying_patch = false;
+        get_scale_event_hub().publish(this->id(), min(), max());
     }
 
     template <class D>
@@ -473,10 +619,86 @@ namespace xpl
     inline void xlog_scale<D>::apply_patch(const nl::json& patch, const xeus::buffer_sequence& buffers)
     {
         using xw::set_property_from_patch;
+        // The events caused by the patch are dispatched once it is applied.
+        auto hold = get_scale_event_hub().hold();
         base_type::apply_patch(patch, buffers);
 
+        m_applying_patch = true;
         set_property_from_patch(min, patch, buffers);
         set_property_from_patch(max, patch, buffers);
+        m_applying_patch = false;
+
+        // A pan-zoom interaction updates both bounds in a single patch,
+        // they are published together.
+        if (patch.count("min") != 0 || patch.count("max") != 0)
+        {
+            get_scale_event_hub().publish(this->id(), min(), max());
+        }
+    }
+
+    template <class D>
+    template <class P>
+    inline void xlog_scale<D>::notify(const P& property) const
+    {
+        base_type::notify(property);
+        const void* p = &property;
+        if (!m_applying_patch && (p == &min || p == &max))
+        {
+            get_scale_event_hub().publish(this->id(), min(), max());
+        }
+    }
+
+    /**
+     * Returns the transform mapping the domain of the scale to the range
+     * [range_min, range_max], reversed if the scale is. The bounds of the
+     * domain must be set.
+     */
+    template <class D>
+    inline xlog_transform xlog_scale<D>::make_transform(double range_min, double range_max) const
+    {
+        auto domain = detail::scale_domain(min(), max());
+        this->apply_reverse(range_min, range_max);
+        return xlog_transform(domain.first, domain.second, range_min, range_max);
+    }
+
+    /**
+     * Sets min and max to the extent of the data bound to the scale by
+     * the marks, as long as it is positive.
+     */
+    template <class D>
+    inline void xlog_scale<D>::enable_domain_tracking()
+    {
+        m_tracked_domain.subscribe(this->id(), [this](const xextent& domain) {
+            set_tracked_domain(domain);
+        });
+    }
+
+    template <class D>
+    inline void xlog_scale<D>::disable_domain_tracking()
+    {
+        m_tracked_domain.reset();
+    }
+
+    template <class D>
+    inline bool xlog_scale<D>::tracks_domain() const noexcept
+    {
+        return m_tracked_domain.subscribed();
+    }
+
+    template <class D>
+    inline void xlog_scale<D>::set_tracked_domain(const xextent& domain)
+    {
+        if (domain.min <= 0.)
+        {
+            return;
+        }
+        // Both bounds are published together, as for a pan-zoom patch.
+        auto hold = this->hold_sync();
+        m_applying_patch = true;
+        min = domain.min;
+        max = domain.max;
+        m_applying_patch = false;
+        get_scale_event_hub().publish(this->id(), min(), max());
     }
 
     template <class D>
@@ -515,6 +737,13 @@ namespace xpl
         set_property_from_patch(domain, patch, buffers);
     }
 
+    template <class D>
+    inline xordinal_transform xordinal_scale<D>::make_transform(double range_min, double range_max) const
+    {
+        this->apply_reverse(range_min, range_max);
+        return xordinal_transform(domain(), range_min, range_max);
+    }
+
     template <class D>
     inline void xordinal_scale<D>::serialize_state(nl::json& state, xeus::buffer_sequence& buffers) const
     {
@@ -554,6 +783,97 @@ namespace xpl
         set_property_from_patch(scheme, patch, buffers);
     }
 
+    /**
+     * Returns the transform mapping values to the colors of the scale,
+     * or to the colors of its scheme if they are not set. The bounds of
+     * the domain must be set.
+     */
+    template <class D>
+    inline xcolor_transform xcolor_scale<D>::make_transform() const
+    {
+        auto domain = detail::scale_domain(min(), max());
+        bool log = scale_type() == "log";
+        if (mid().has_value())
+        {
+            return xcolor_transform(scale_colors(), domain.first, mid().value(), domain.second, log);
+        }
+        return xcolor_transform(scale_colors(), domain.first, domain.second, log);
+    }
+
+    /**
+     * Returns the color map of the scale, to colorize data on the
+     * server. The lookup table of the scheme is used when the colors are
+     * not set.
+     */
+    template <class D>
+    inline xcolormap xcolor_scale<D>::make_colormap() const
+    {
+        auto domain = detail::scale_domain(min(), max());
+        xcolor_lut lut;
+        if (colors().empty() && !this->reverse())
+        {
+            lut = color_scheme_lut(scheme());
+        }
+        else
+        {
+            std::vector<std::uint32_t> packed;
+            for (const auto& color : scale_colors())
+            {
+                packed.push_back(parse_color(color));
+            }
+            lut = make_color_lut(packed.data(), packed.size());
+        }
+        bool log = scale_type() == "log";
+        if (mid().has_value())
+        {
+            return xcolormap(lut, domain.first, mid().value(), domain.second, log);
+        }
+        return xcolormap(lut, domain.first, domain.second, log);
+    }
+
+    template <class D>
+    inline std::vector<color_type> xcolor_scale<D>::scale_colors() const
+    {
+        std::vector<color_type> res = colors().empty() ? color_scheme_colors(scheme()) : colors();
+        if (this->reverse())
+        {
+            std::reverse(res.begin(), res.end());
+        }
+        return res;
+    }
+
+    /**
+     * Sets min and max to the extent of the data bound to the scale by
+     * the marks, NaN values excluded; mid is left unchanged.
+     */
+    template <class D>
+    inline void xcolor_scale<D>::enable_domain_tracking()
+    {
+        m_tracked_domain.subscribe(this->id(), [this](const xextent& domain) {
+            set_tracked_domain(domain);
+        });
+    }
+
+    template <class D>
+    inline void xcolor_scale<D>::disable_domain_tracking()
+    {
+        m_tracked_domain.reset();
+    }
+
+    template <class D>
+    inline bool xcolor_scale<D>::tracks_domain() const noexcept
+    {
+        return m_tracked_domain.subscribed();
+    }
+
+    template <class D>
+    inline void xcolor_scale<D>::set_tracked_domain(const xextent& domain)
+    {
+        auto hold = this->hold_sync();
+        min = domain.min;
+        max = domain.max;
+    }
+
     template <class D>
     inline void xcolor_scale<D>::serialize_state(nl::json& state, xeus::buffer_sequence& buffers) const
     {
@@ -0,0 +1,499 @@
+/***************************************************************************
+* Copyright (c) 2017, Sylvain Corlay and Johan Mabille                     *
+*                                                                          *
+* Distributed under the terms of the BSD 3-Clause License.                 *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#ifndef XPLOT_SYNC_HPP
+#define XPLOT_SYNC_HPP
+
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <string>
+#include <utility>
+
+#include "nlohmann/json.hpp"
+
+#include "xeus/xjson.hpp"
+
+#include "xwidgets/xobject.hpp"
+
+namespace nl = nlohmann;
+
+namespace xpl
+{
+    /***************************
+     * xsync_state declaration *
+     ***************************/
+
+    /**
+     * Tracks which properties of a widget changed since they were last
+     * synchronized with the front-end.
+     *
+     * Each change bumps a version counter; a property is dirty while its
+     * version is greater than the version it was last sent with. While
+     * the state is deferred, changes are only recorded, so that several
+     * assignments of the same property fold into a single patch entry.
+     *
+     * Copies and moves keep the versions but drop pending changes, since
+     * their serializers refer to the properties of the source widget.
+     */
+    class xsync_state
+    {
+    public:
+
+        using version_type = std::size_t;
+        using serializer_type = std::function<void(nl::json&, xeus::buffer_sequence&)>;
+
+        xsync_state() = default;
+        ~xsync_state() = default;
+
+        xsync_state(const xsync_state&);
+        xsync_state(xsync_state&&);
+
+        xsync_state& operator=(const xsync_state&);
+        xsync_state& operator=(xsync_state&&);
+
+        void touch(const std::string& name, serializer_type serializer);
+        void refresh(const std::string& name, serializer_type serializer);
+        void mark_synced(const std::string& name);
+        void mark_synced();
+
+        bool is_dirty(const std::string& name) const;
+        bool has_changes() const noexcept;
+        version_type version() const noexcept;
+        version_type property_version(const std::string& name) const;
+
+        void serialize_changes(nl::json& state, xeus::buffer_sequence& buffers) const;
+
+        void defer() noexcept;
+        bool resume() noexcept;
+        bool deferred() const noexcept;
+
+    private:
+
+        struct entry_type
+        {
+            version_type version = 0;
+            version_type synced_version = 0;
+            bool refreshed = false;
+            serializer_type serializer;
+
+            bool dirty() const noexcept;
+        };
+
+        void drop_pending();
+
+        std::map<std::string, entry_type> m_entries;
+        version_type m_version = 0;
+        std::size_t m_dirty_count = 0;
+        std::size_t m_defer_count = 0;
+    };
+
+    /**************************
+     * xhold_sync declaration *
+     **************************/
+
+    /**
+     * Scope guard deferring the synchronization of a widget.
+     *
+     * Property changes made while the guard is alive are coalesced and
+     * sent in a single patch when the outermost guard of the widget is
+     * destroyed. The widget must outlive the guard and must not be moved
+     * while it is held.
+     *
+     * The destructor does not throw: if sending the patch fails, the
+     * error is dropped and the properties that were not serialized are
+     * sent with the next patch. Call release to end the hold and get the
+     * error instead.
+     */
+    template <class W>
+    class xhold_sync
+    {
+    public:
+
+        using widget_type = W;
+
+        explicit xhold_sync(const widget_type& widget);
+        ~xhold_sync();
+
+        xhold_sync(const xhold_sync&) = delete;
+        xhold_sync& operator=(const xhold_sync&) = delete;
+
+        xhold_sync(xhold_sync&& rhs) noexcept;
+        xhold_sync& operator=(xhold_sync&&) = delete;
+
+        void release();
+
+    private:
+
+        const widget_type* p_widget;
+    };
+
+    /***********************
+     * xsynced declaration *
+     ***********************/
+
+    /**
+     * Base of the widgets tracking the changes of their properties with an
+     * xsync_state, inserted between the widget and its xwidgets base B.
+     *
+     * Changes are sent immediately unless the synchronization is deferred,
+     * in which case they are sent in a single patch by the outermost
+     * resume_sync. Derived widgets may hide serialize_property to send a
+     * property in a different form than its value.
+     */
+    template <class D, template <class> class B>
+    class xsynced : public B<D>
+    {
+    public:
+
+        using base_type = B<D>;
+        using derived_type = D;
+
+        using version_type = xsync_state::version_type;
+
+        void serialize_changed_state(nl::json&, xeus::buffer_sequence&) const;
+        void send_changed_state() const;
+        bool has_changed_state() const noexcept;
+        version_type property_version(const std::string& name) const;
+
+        template <class P>
+        void notify(const P& property) const;
+
+        template <class P>
+        void resend(const P& property) const;
+
+        template <class P>
+        void serialize_property(const P& property, nl::json& state, xeus::buffer_sequence& buffers) const;
+
+        xhold_sync<xsynced> hold_sync() const;
+
+    protected:
+
+        xsynced() = default;
+
+        using base_type::base_type;
+
+        void defer_sync() const noexcept;
+        void resume_sync() const;
+
+    private:
+
+        mutable xsync_state m_sync;
+
+        friend class xhold_sync<xsynced>;
+    };
+
+    /******************************
+     * xsync_state implementation *
+     ******************************/
+
+    inline xsync_state::xsync_state(const xsync_state& rhs)
+        : m_entries(rhs.m_entries), m_version(rhs.m_version)
+    {
+        drop_pending();
+    }
+
+    inline xsync_state::xsync_state(xsync_state&& rhs)
+        : m_entries(std::move(rhs.m_entries)), m_version(rhs.m_version)
+    {
+        drop_pending();
+    }
+
+    inline xsync_state& xsync_state::operator=(const xsync_state& rhs)
+    {
+        m_entries = rhs.m_entries;
+        m_version = rhs.m_version;
+        drop_pending();
+        return *this;
+    }
+
+    inline xsync_state& xsync_state::operator=(xsync_state&& rhs)
+    {
+        m_entries = std::move(rhs.m_entries);
+        m_version = rhs.m_version;
+        drop_pending();
+        return *this;
+    }
+
+    inline bool xsync_state::entry_type::dirty() const noexcept
+    {
+        return version != synced_version || refreshed;
+    }
+
+    inline void xsync_state::touch(const std::string& name, serializer_type serializer)
+    {
+        entry_type& entry = m_entries[name];
+        if (!entry.dirty())
+        {
+            ++m_dirty_count;
+        }
+        entry.version = ++m_version;
+        entry.serializer = std::move(serializer);
+    }
+
+    /**
+     * Marks the property name as to be sent again, without bumping its
+     * version: its value did not change, only the form it is sent in,
+     * e.g. the slice of the data matching the viewport.
+     */
+    inline void xsync_state::refresh(const std::string& name, serializer_type serializer)
+    {
+        entry_type& entry = m_entries[name];
+        if (!entry.dirty())
+        {
+            ++m_dirty_count;
+        }
+        entry.refreshed = true;
+        entry.serializer = std::move(serializer);
+    }
+
+    inline void xsync_state::mark_synced(const std::string& name)
+    {
+        auto it = m_entries.find(name);
+        if (it != m_entries.end() && it->second.dirty())
+        {
+            it->second.synced_version = it->second.version;
+            it->second.refreshed = false;
+            it->second.serializer = nullptr;
+            --m_dirty_count;
+        }
+    }
+
+    inline void xsync_state::mark_synced()
+    {
+        drop_pending();
+    }
+
+    inline bool xsync_state::is_dirty(const std::string& name) const
+    {
+        auto it = m_entries.find(name);
+        return it != m_entries.end() && it->second.dirty();
+    }
+
+    inline bool xsync_state::has_changes() const noexcept
+    {
+        return m_dirty_count != 0;
+    }
+
+    inline auto xsync_state::version() const noexcept -> version_type
+    {
+        return m_version;
+    }
+
+    inline auto xsync_state::property_version(const std::string& name) const -> version_type
+    {
+        auto it = m_entries.find(name);
+        return it != m_entries.end() ? it->second.version : version_type(0);
+    }
+
+    inline void xsync_state::serialize_changes(nl::json& state, xeus::buffer_sequence& buffers) const
+    {
+        for (const auto& item : m_entries)
+        {
+            const entry_type& entry = item.second;
+            if (entry.dirty() && entry.serializer)
+            {
+                entry.serializer(state, buffers);
+            }
+        }
+    }
+
+    inline void xsync_state::defer() noexcept
+    {
+        ++m_defer_count;
+    }
+
+    /**
+     * Ends one level of deferral and returns true when the outermost
+     * level was closed, i.e. when pending changes should be sent.
+     */
+    inline bool xsync_state::resume() noexcept
+    {
+        if (m_defer_count != 0)
+        {
+            --m_defer_count;
+        }
+        return m_defer_count == 0;
+    }
+
+    inline bool xsync_state::deferred() const noexcept
+    {
+        return m_defer_count != 0;
+    }
+
+    inline void xsync_state::drop_pending()
+    {
+        for (auto& item : m_entries)
+        {
+            item.second.synced_version = item.second.version;
+            item.second.refreshed = false;
+            item.second.serializer = nullptr;
+        }
+        m_dirty_count = 0;
+    }
+
+    /**************************
+     * xsynced implementation *
+     **************************/
+
+    /**
+     * Serializes the properties modified since they were last sent.
+     */
+    template <class D, template <class> class B>
+    inline void xsynced<D, B>::serialize_changed_state(nl::json& state, xeus::buffer_sequence& buffers) const
+    {
+        m_sync.serialize_changes(state, buffers);
+    }
+
+    /**
+     * Sends the properties modified since they were last sent, if any,
+     * in a single patch, through the send_patch method of the derived
+     * widget. The deferral of the synchronization is left unchanged.
+     */
+    template <class D, template <class> class B>
+    inline void xsynced<D, B>::send_changed_state() const
+    {
+        if (m_sync.has_changes())
+        {
+            nl::json state;
+            xeus::buffer_sequence buffers;
+            serialize_changed_state(state, buffers);
+            m_sync.mark_synced();
+            this->derived_cast().send_patch(std::move(state), std::move(buffers));
+        }
+    }
+
+    template <class D, template <class> class B>
+    inline bool xsynced<D, B>::has_changed_state() const noexcept
+    {
+        return m_sync.has_changes();
+    }
+
+    template <class D, template <class> class B>
+    inline auto xsynced<D, B>::property_version(const std::string& name) const -> version_type
+    {
+        return m_sync.property_version(name);
+    }
+
+    template <class D, template <class> class B>
+    template <class P>
+    inline void xsynced<D, B>::notify(const P& property) const
+    {
+        m_sync.touch(property.name(), [this, &property](nl::json& state, xeus::buffer_sequence& buffers) {
+            this->derived_cast().serialize_property(property, state, buffers);
+        });
+        if (!m_sync.deferred())
+        {
+            m_sync.mark_synced(property.name());
+            base_type::notify(property);
+        }
+    }
+
+    /**
+     * Sends the property again through the serialize_property method of
+     * the derived widget, without bumping its version nor notifying the
+     * derived widget, since its value did not change.
+     */
+    template <class D, template <class> class B>
+    template <class P>
+    inline void xsynced<D, B>::resend(const P& property) const
+    {
+        m_sync.refresh(property.name(), [this, &property](nl::json& state, xeus::buffer_sequence& buffers) {
+            this->derived_cast().serialize_property(property, state, buffers);
+        });
+        if (!m_sync.deferred())
+        {
+            send_changed_state();
+        }
+    }
+
+    /**
+     * Serializes a changed property into a patch.
+     */
+    template <class D, template <class> class B>
+    template <class P>
+    inline void xsynced<D, B>::serialize_property(const P& property, nl::json& state, xeus::buffer_sequence& buffers) const
+    {
+        using xw::xwidgets_serialize;
+        xwidgets_serialize(property(), state[property.name()], buffers);
+    }
+
+    /**
+     * Returns a guard deferring the synchronization of the widget until
+     * the end of its scope. All the property changes made meanwhile are
+     * sent in a single patch.
+     */
+    template <class D, template <class> class B>
+    inline auto xsynced<D, B>::hold_sync() const -> xhold_sync<xsynced>
+    {
+        return xhold_sync<xsynced>(*this);
+    }
+
+    template <class D, template <class> class B>
+    inline void xsynced<D, B>::defer_sync() const noexcept
+    {
+        m_sync.defer();
+    }
+
+    template <class D, template <class> class B>
+    inline void xsynced<D, B>::resume_sync() const
+    {
+        if (m_sync.resume())
+        {
+            send_changed_state();
+        }
+    }
+
+    /*****************************
+     * xhold_sync implementation *
+     *****************************/
+
+    template <class W>
+    inline xhold_sync<W>::xhold_sync(const widget_type& widget)
+        : p_widget(&widget)
+    {
+        p_widget->defer_sync();
+    }
+
+    template <class W>
+    inline xhold_sync<W>::~xhold_sync()
+    {
+        try
+        {
+            release();
+        }
+        catch (...)
+        {
+        }
+    }
+
+    template <class W>
+    inline xhold_sync<W>::xhold_sync(xhold_sync&& rhs) noexcept
+        : p_widget(rhs.p_widget)
+    {
+        rhs.p_widget = nullptr;
+    }
+
+    /**
+     * Ends the hold before the end of the scope, sending the coalesced
+     * changes if this is the outermost guard. Errors raised while sending
+     * them are propagated; the guard is released in any case.
+     */
+    template <class W>
+    inline void xhold_sync<W>::release()
+    {
+        if (p_widget != nullptr)
+        {
+            const widget_type* widget = p_widget;
+            p_widget = nullptr;
+            widget->resume_sync();
+        }
+    }
+}
+
+#endif
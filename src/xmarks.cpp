@@ -22,6 +22,9 @@ template class XPLOT_API xw::xtransport<xw::xmaterialize<xpl::xboxplot>>;
 template class XPLOT_API xw::xmaterialize<xpl::xbars>;
 template class XPLOT_API xw::xtransport<xw::xmaterialize<xpl::xbars>>;
 
+template class XPLOT_API xw::xmaterialize<xpl::xbinned_hist>;
+template class XPLOT_API xw::xtransport<xw::xmaterialize<xpl::xbinned_hist>>;
+
 template class XPLOT_API xw::xmaterialize<xpl::xheat_map>;
 template class XPLOT_API xw::xtransport<xw::xmaterialize<xpl::xheat_map>>;
 
@@ -0,0 +1,74 @@
+/***************************************************************************
+* Copyright (c) 2017, Sylvain Corlay and Johan Mabille                     *
+*                                                                          *
+* Distributed under the terms of the BSD 3-Clause License.                 *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#ifndef XPLOT_TEST_PATCH_PROBE_HPP
+#define XPLOT_TEST_PATCH_PROBE_HPP
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include "nlohmann/json.hpp"
+
+#include "xeus/xjson.hpp"
+
+#include "xwidgets/xmaterialize.hpp"
+
+namespace nl = nlohmann;
+
+namespace xpl
+{
+    /**
+     * Widget B recording the patches of changed state it sends, i.e. the
+     * patches sent at the end of a hold_sync scope or by
+     * send_changed_state.
+     */
+    template <template <class> class B>
+    struct patch_probe
+    {
+        struct patch_type
+        {
+            nl::json state;
+            std::size_t buffer_count;
+        };
+
+        template <class D>
+        class xprobe : public B<D>
+        {
+        public:
+
+            using base_type = B<D>;
+
+            void send_patch(nl::json&& state, xeus::buffer_sequence&& buffers) const
+            {
+                m_patches.push_back({state, buffers.size()});
+                base_type::send_patch(std::move(state), std::move(buffers));
+            }
+
+            const std::vector<patch_type>& patches() const noexcept
+            {
+                return m_patches;
+            }
+
+        protected:
+
+            using base_type::base_type;
+
+        private:
+
+            mutable std::vector<patch_type> m_patches;
+        };
+
+        using type = xw::xmaterialize<xprobe>;
+    };
+
+    template <template <class> class B>
+    using patch_probe_t = typename patch_probe<B>::type;
+}
+
+#endif
@@ -0,0 +1,229 @@
+/***************************************************************************
+* Copyright (c) 2016, Johan Mabille and Sylvain Corlay                     *
+*                                                                          *
+* Distributed under the terms of the BSD 3-Clause License.                 *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "xplot/xboxed_container.hpp"
+
+namespace xpl
+{
+    using boxed_type = xboxed_container<std::vector<double>>;
+
+    TEST(xboxed_container, json_encoding)
+    {
+        boxed_type c(std::vector<double>({1., 2., 3.}));
+        nl::json j;
+        xeus::buffer_sequence buffers;
+        xwidgets_serialize(c, j, buffers);
+        EXPECT_EQ(buffers.size(), 0u);
+        EXPECT_EQ(j["values"].size(), 3u);
+        EXPECT_EQ(j["type"], "float");
+    }
+
+    TEST(xboxed_container, binary_encoding)
+    {
+        default_data_encoding() = xdata_encoding::binary;
+        boxed_type c(std::vector<double>({1., 2., 3.}));
+        nl::json j;
+        xeus::buffer_sequence buffers;
+        xwidgets_serialize(c, j, buffers);
+        default_data_encoding() = xdata_encoding::json;
+
+        ASSERT_EQ(buffers.size(), 1u);
+        EXPECT_EQ(buffers[0].size(), 3 * sizeof(double));
+        EXPECT_EQ(j["dtype"], "float64");
+        EXPECT_EQ(j["shape"], nl::json({3}));
+        EXPECT_TRUE(is_typed_buffer(j));
+
+        boxed_type res;
+        xwidgets_deserialize(res, j, buffers);
+        const std::vector<double>& values = res;
+        EXPECT_EQ(values, std::vector<double>({1., 2., 3.}));
+    }
+
+    TEST(xboxed_container, decode_dtype)
+    {
+        std::vector<float> data = {1.5f, 2.5f};
+        nl::json j;
+        xeus::buffer_sequence buffers;
+        serialize_typed_buffer(data.data(), data.size(), j, buffers);
+        EXPECT_EQ(j["dtype"], "float32");
+
+        boxed_type res;
+        xwidgets_deserialize(res, j, buffers);
+        const std::vector<double>& values = res;
+        EXPECT_EQ(values, std::vector<double>({1.5, 2.5}));
+    }
+
+    TEST(xboxed_container, view)
+    {
+        std::vector<double> data = {1., 2., 3.};
+        boxed_type c = data_view(data.data(), data.size());
+        EXPECT_TRUE(c.is_view());
+        EXPECT_EQ(c.data(), data.data());
+        EXPECT_EQ(c.size(), 3u);
+        EXPECT_EQ(c[1], 2.);
+
+        boxed_type copy = c;
+        EXPECT_EQ(copy.data(), data.data());
+
+        const std::vector<double>& values = c;
+        EXPECT_FALSE(c.is_view());
+        EXPECT_NE(c.data(), data.data());
+        EXPECT_EQ(values, data);
+
+        c = std::vector<double>({4.});
+        EXPECT_EQ(c.size(), 1u);
+    }
+
+    TEST(xboxed_container, view_keep_alive)
+    {
+        auto owner = std::make_shared<std::vector<double>>(std::vector<double>({1., 2.}));
+        boxed_type c = data_view(owner);
+        std::weak_ptr<std::vector<double>> observer = owner;
+        owner.reset();
+        EXPECT_FALSE(observer.expired());
+        EXPECT_EQ(c[1], 2.);
+        c.detach();
+        EXPECT_TRUE(observer.expired());
+    }
+
+    TEST(xboxed_container, view_serialization)
+    {
+        std::vector<double> data = {1., 2., 3.};
+        boxed_type c = data_view(data.data(), data.size());
+
+        nl::json j;
+        xeus::buffer_sequence buffers;
+        xwidgets_serialize(c, j, buffers);
+        EXPECT_EQ(j["values"], nl::json({1., 2., 3.}));
+
+        default_data_encoding() = xdata_encoding::binary;
+        xwidgets_serialize(c, j, buffers);
+        default_data_encoding() = xdata_encoding::json;
+        ASSERT_EQ(buffers.size(), 1u);
+        EXPECT_EQ(buffers[0].size(), 3 * sizeof(double));
+        EXPECT_TRUE(c.is_view());
+
+        boxed_type res = data_view(data.data(), data.size());
+        xwidgets_deserialize(res, j, buffers);
+        EXPECT_FALSE(res.is_view());
+        EXPECT_EQ(res.size(), 3u);
+    }
+
+    TEST(xboxed_container, json_round_trip)
+    {
+        std::vector<double> data = {1., 2., 3.};
+        boxed_type c(data);
+        nl::json j = c;
+        EXPECT_EQ(j["values"], nl::json({1., 2., 3.}));
+
+        boxed_type res = data_view(data.data(), data.size());
+        from_json(j, res);
+        EXPECT_FALSE(res.is_view());
+        const std::vector<double>& values = res;
+        EXPECT_EQ(values, data);
+    }
+
+    TEST(xboxed_container, typed_data)
+    {
+        boxed_type c = typed_data(std::vector<std::int32_t>({1, 2, 3}));
+        EXPECT_EQ(c.source().dtype(), "int32");
+        EXPECT_EQ(c.size(), 3u);
+
+        nl::json j;
+        xeus::buffer_sequence buffers;
+        xwidgets_serialize(c, j, buffers);
+        EXPECT_EQ(j["values"], nl::json({1, 2, 3}));
+        EXPECT_EQ(j["type"], "float");
+
+        default_data_encoding() = xdata_encoding::binary;
+        xwidgets_serialize(c, j, buffers);
+        default_data_encoding() = xdata_encoding::json;
+        ASSERT_EQ(buffers.size(), 1u);
+        EXPECT_EQ(buffers[0].size(), 3 * sizeof(std::int32_t));
+        EXPECT_EQ(j["dtype"], "int32");
+        EXPECT_TRUE(c.is_view());
+
+        EXPECT_EQ(c[2], 3.);
+        EXPECT_FALSE(c.is_view());
+        const std::vector<double>& values = c;
+        EXPECT_EQ(values, std::vector<double>({1., 2., 3.}));
+    }
+
+    TEST(xboxed_container, wide_integers)
+    {
+        EXPECT_EQ(type_to_string<std::uint64_t>(), "float");
+        boxed_type c = typed_data(std::vector<std::int64_t>({1, -2, 3}));
+        EXPECT_EQ(c.source().dtype(), "int64");
+
+        nl::json j;
+        xeus::buffer_sequence buffers;
+        default_data_encoding() = xdata_encoding::binary;
+        xwidgets_serialize(c, j, buffers);
+        default_data_encoding() = xdata_encoding::json;
+        ASSERT_EQ(buffers.size(), 1u);
+        EXPECT_EQ(j["dtype"], "float64");
+        EXPECT_EQ(buffers[0].size(), 3 * sizeof(double));
+
+        boxed_type res;
+        xwidgets_deserialize(res, j, buffers);
+        const std::vector<double>& values = res;
+        EXPECT_EQ(values, std::vector<double>({1., -2., 3.}));
+    }
+
+    TEST(xboxed_container, typed_buffer_values)
+    {
+        static_assert(is_typed_buffer_value<double>::value, "");
+        static_assert(is_typed_buffer_value<std::int64_t>::value, "");
+        static_assert(is_typed_buffer_value<std::uint8_t>::value, "");
+        static_assert(!is_typed_buffer_value<bool>::value, "");
+        static_assert(!is_typed_buffer_value<char>::value, "");
+        static_assert(!is_typed_buffer_value<wchar_t>::value, "");
+        static_assert(!is_typed_buffer_value<long double>::value, "");
+        static_assert(is_typed_buffer_value<long long>::value == (std::is_same<long long, std::int64_t>::value), "");
+
+        xboxed_container<std::vector<long double>> c = std::vector<long double>({1., 2.});
+        nl::json j;
+        xeus::buffer_sequence buffers;
+        default_data_encoding() = xdata_encoding::binary;
+        xwidgets_serialize(c, j, buffers);
+        default_data_encoding() = xdata_encoding::json;
+        EXPECT_TRUE(buffers.empty());
+        EXPECT_EQ(j["values"], nl::json({1., 2.}));
+    }
+
+    TEST(xboxed_container, float32_encoding)
+    {
+        boxed_type c(std::vector<double>({1.5, 2.5}));
+        std::vector<double> data = {1., 2., 3.};
+        boxed_type view = data_view(data.data(), data.size());
+        nl::json j, k;
+        xeus::buffer_sequence buffers;
+        default_data_encoding() = xdata_encoding::binary_float32;
+        xwidgets_serialize(c, j, buffers);
+        xwidgets_serialize(view, k, buffers);
+        default_data_encoding() = xdata_encoding::json;
+
+        ASSERT_EQ(buffers.size(), 2u);
+        EXPECT_EQ(j["dtype"], "float32");
+        EXPECT_EQ(buffers[0].size(), 2 * sizeof(float));
+        EXPECT_EQ(k["dtype"], "float32");
+        EXPECT_EQ(buffers[1].size(), 3 * sizeof(float));
+
+        boxed_type res;
+        xwidgets_deserialize(res, j, buffers);
+        const std::vector<double>& values = res;
+        EXPECT_EQ(values, std::vector<double>({1.5, 2.5}));
+    }
+}
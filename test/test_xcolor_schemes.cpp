@@ -0,0 +1,86 @@
+/***************************************************************************
+* Copyright (c) 2017, Sylvain Corlay and Johan Mabille                     *
+*                                                                          *
+* Distributed under the terms of the BSD 3-Clause License.                 *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "xplot/xcolor_schemes.hpp"
+#include "xplot/xscales.hpp"
+
+namespace xpl
+{
+    namespace
+    {
+        constexpr std::uint32_t black_white[] = {0xff000000u, 0xffffffffu};
+        constexpr xcolor_lut gray_lut = make_color_lut(black_white, 2);
+        static_assert(gray_lut[0] == 0xff000000u, "the table starts with the first color");
+        static_assert(gray_lut[255] == 0xffffffffu, "the table ends with the last color");
+        static_assert(gray_lut[128] == 0xff808080u, "the colors are interpolated");
+    }
+
+    TEST(xcolor_schemes, lookup_tables)
+    {
+        const xcolor_lut& lut = color_scheme_lut("RdYlGn");
+        EXPECT_EQ(lut[0], 0xffa50026u);
+        EXPECT_EQ(lut[255], 0xff006837u);
+        // The middle color of an 11-class scheme falls halfway.
+        EXPECT_EQ(lut[127] & 0xff0000u, 0xff0000u);
+
+        EXPECT_EQ(color_scheme_lut("Greys")[0], 0xffffffffu);
+        EXPECT_THROW(color_scheme_lut("Unknown"), std::invalid_argument);
+
+        std::vector<std::string> colors = color_scheme_colors("Set1");
+        EXPECT_EQ(colors.size(), 9u);
+        EXPECT_EQ(colors.front(), "#e41a1c");
+        EXPECT_EQ(color_scheme_names().size(), 35u);
+    }
+
+    TEST(xcolor_schemes, colormap)
+    {
+        double nan = std::numeric_limits<double>::quiet_NaN();
+        xcolormap cmap(gray_lut, 0., 10.);
+        std::vector<double> values = {-5., 0., 5., 10., 20., nan};
+        std::vector<std::uint32_t> colors = cmap.colorize(values);
+        EXPECT_EQ(colors[0], 0xff000000u);
+        EXPECT_EQ(colors[1], 0xff000000u);
+        EXPECT_EQ(colors[2], 0xff808080u);
+        EXPECT_EQ(colors[3], 0xffffffffu);
+        EXPECT_EQ(colors[4], 0xffffffffu);
+        EXPECT_EQ(colors[5], 0u);
+
+        xcolormap diverging(gray_lut, 0., 1., 10.);
+        EXPECT_EQ(diverging(1.), 0xff808080u);
+        EXPECT_EQ(diverging(0.5), gray_lut[64]);
+
+        xcolormap log_cmap(gray_lut, 1., 100., true);
+        EXPECT_NEAR(static_cast<double>(log_cmap(10.) & 0xffu), 128., 1.);
+        EXPECT_EQ(log_cmap(100.), 0xffffffffu);
+        EXPECT_EQ(log_cmap(-1.), 0u);
+        EXPECT_THROW(xcolormap(gray_lut, 0., 1., true), std::invalid_argument);
+    }
+
+    TEST(xcolor_schemes, color_scale)
+    {
+        color_scale cs;
+        cs.min = 0.;
+        cs.max = 1.;
+        EXPECT_EQ(cs.make_colormap()(0.), 0xffa50026u);
+        EXPECT_EQ(cs.make_colormap()(1.), 0xff006837u);
+
+        cs.reverse = true;
+        EXPECT_EQ(cs.make_colormap()(0.), 0xff006837u);
+
+        cs.reverse = false;
+        cs.colors = std::vector<color_type>({"#000000", "#ffffff"});
+        EXPECT_EQ(cs.make_colormap()(0.5), 0xff808080u);
+    }
+}
@@ -0,0 +1,99 @@
+/***************************************************************************
+* Copyright (c) 2016, Johan Mabille and Sylvain Corlay                     *
+*                                                                          *
+* Distributed under the terms of the BSD 3-Clause License.                 *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "xplot/xdecimation.hpp"
+
+namespace xpl
+{
+    namespace
+    {
+        void make_curve(std::size_t size, std::vector<double>& x, std::vector<double>& y)
+        {
+            x.resize(size);
+            y.resize(size);
+            for (std::size_t i = 0; i < size; ++i)
+            {
+                x[i] = static_cast<double>(i);
+                y[i] = std::sin(0.01 * static_cast<double>(i));
+            }
+        }
+
+        bool is_increasing(const std::vector<std::size_t>& indices)
+        {
+            for (std::size_t i = 1; i < indices.size(); ++i)
+            {
+                if (indices[i] <= indices[i - 1])
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+    }
+
+    TEST(xdecimation, lttb)
+    {
+        std::vector<double> x, y;
+        make_curve(10000, x, y);
+        std::vector<std::size_t> indices;
+        lttb_indices(x.data(), y.data(), x.size(), 100, indices);
+        ASSERT_EQ(indices.size(), 100u);
+        EXPECT_EQ(indices.front(), 0u);
+        EXPECT_EQ(indices.back(), 9999u);
+        EXPECT_TRUE(is_increasing(indices));
+
+        lttb_indices(x.data(), y.data(), 50, 100, indices);
+        EXPECT_EQ(indices.size(), 50u);
+    }
+
+    TEST(xdecimation, minmax)
+    {
+        std::vector<double> x, y;
+        make_curve(10000, x, y);
+        y[1234] = 10.;
+        y[5678] = -10.;
+        std::vector<std::size_t> indices;
+        minmax_indices(y.data(), y.size(), 100, indices);
+        EXPECT_LE(indices.size(), 100u);
+        EXPECT_TRUE(is_increasing(indices));
+        EXPECT_NE(std::find(indices.begin(), indices.end(), 1234u), indices.end());
+        EXPECT_NE(std::find(indices.begin(), indices.end(), 5678u), indices.end());
+    }
+
+    TEST(xdecimation, m4)
+    {
+        std::vector<double> x, y;
+        make_curve(1000003, x, y);
+        y[777777] = 10.;
+        std::vector<std::size_t> indices;
+        m4_indices(y.data(), y.size(), 4000, indices);
+        EXPECT_LE(indices.size(), 4000u);
+        EXPECT_TRUE(is_increasing(indices));
+        EXPECT_EQ(indices.front(), 0u);
+        EXPECT_EQ(indices.back(), 1000002u);
+        EXPECT_NE(std::find(indices.begin(), indices.end(), 777777u), indices.end());
+    }
+
+    TEST(xdecimation, curves)
+    {
+        std::vector<double> x, y1, y2;
+        make_curve(5000, x, y1);
+        make_curve(5000, x, y2);
+        auto res = downsample_curves(xdownsampling_method::lttb, x.data(), {y1.data(), y2.data()}, x.size(), 200);
+        ASSERT_EQ(res.size(), 2u);
+        EXPECT_EQ(res[0], res[1]);
+        EXPECT_EQ(res[0].size(), 200u);
+    }
+}
@@ -0,0 +1,179 @@
+/***************************************************************************
+* Copyright (c) 2017, Sylvain Corlay and Johan Mabille                     *
+*                                                                          *
+* Distributed under the terms of the BSD 3-Clause License.                 *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "xplot/xdomain_tracker.hpp"
+#include "xplot/xmarks.hpp"
+#include "xplot/xscales.hpp"
+
+namespace xpl
+{
+    TEST(xdomain_tracker, compute_extent)
+    {
+        double nan = std::numeric_limits<double>::quiet_NaN();
+        std::vector<double> values = {nan, 3., -1., nan, 7., 2., nan, 0.5, 4.};
+        xextent extent = compute_extent(values.data(), values.size());
+        EXPECT_EQ(extent.min, -1.);
+        EXPECT_EQ(extent.max, 7.);
+
+        std::vector<double> missing = {nan, nan, nan, nan, nan};
+        EXPECT_TRUE(compute_extent(missing.data(), missing.size()).empty());
+        EXPECT_TRUE(compute_extent(values.data(), 0).empty());
+
+        std::vector<int> integers = {4, -2, 9};
+        xextent int_extent = compute_extent(integers.data(), integers.size());
+        EXPECT_EQ(int_extent.min, -2.);
+        EXPECT_EQ(int_extent.max, 9.);
+    }
+
+    TEST(xdomain_tracker, merge_marks)
+    {
+        linear_scale sx, sy;
+        sx.enable_domain_tracking();
+        EXPECT_TRUE(sx.tracks_domain());
+        {
+            lines line1(sx, sy);
+            line1.x = std::vector<double>({1., 2., 3.});
+            EXPECT_EQ(sx.min().value(), 1.);
+            EXPECT_EQ(sx.max().value(), 3.);
+            EXPECT_FALSE(sy.min().has_value());
+
+            scatter points(sx, sy);
+            points.x = std::vector<double>({-2., std::numeric_limits<double>::quiet_NaN(), 2.5});
+            EXPECT_EQ(sx.min().value(), -2.);
+            EXPECT_EQ(sx.max().value(), 3.);
+
+            line1.x = std::vector<double>({0., 10.});
+            EXPECT_EQ(sx.min().value(), -2.);
+            EXPECT_EQ(sx.max().value(), 10.);
+        }
+        // The marks are destroyed, the scale keeps its last domain.
+        EXPECT_TRUE(get_domain_tracker().domain(sx.id()).empty());
+        EXPECT_EQ(sx.max().value(), 10.);
+    }
+
+    TEST(xdomain_tracker, append)
+    {
+        linear_scale sx, sy;
+        sy.enable_domain_tracking();
+        lines line(sx, sy);
+        line.x = std::vector<double>({0., 1.});
+        line.y = std::vector<double>({5., 6.});
+        line.append(std::vector<double>({2., 3.}), std::vector<double>({8., 1.}));
+        EXPECT_EQ(sy.min().value(), 1.);
+        EXPECT_EQ(sy.max().value(), 8.);
+
+        // The values dropped by max_length no longer contribute.
+        line.append(std::vector<double>({4.}), std::vector<double>({7.}), 3);
+        EXPECT_EQ(line.extent("y").min, 1.);
+        EXPECT_EQ(line.extent("y").max, 8.);
+        line.append(std::vector<double>({5., 6.}), std::vector<double>({2., 3.}), 3);
+        EXPECT_EQ(sy.min().value(), 2.);
+        EXPECT_EQ(sy.max().value(), 7.);
+    }
+
+    TEST(xdomain_tracker, scales)
+    {
+        linear_scale sx1, sx2, sy;
+        lines line(sx1, sy);
+        line.x = std::vector<double>({1., 4.});
+
+        // A scale subscribing later receives the current domain.
+        sx1.enable_domain_tracking();
+        EXPECT_EQ(sx1.min().value(), 1.);
+        EXPECT_EQ(sx1.max().value(), 4.);
+
+        sx2.enable_domain_tracking();
+        line.scales = xmark_scales_type({{"x", sx2}, {"y", sy}});
+        EXPECT_EQ(sx2.min().value(), 1.);
+        EXPECT_EQ(sx2.max().value(), 4.);
+        EXPECT_TRUE(get_domain_tracker().domain(sx1.id()).empty());
+
+        sx2.disable_domain_tracking();
+        line.x = std::vector<double>({0., 8.});
+        EXPECT_EQ(sx2.max().value(), 4.);
+    }
+
+    TEST(xdomain_tracker, deferred)
+    {
+        linear_scale sx, sy;
+        sy.enable_domain_tracking();
+        lines line(sx, sy);
+        line.x = std::vector<double>({1., 4.});
+        line.append(std::vector<double>({6.}), std::vector<double>({2.}));
+
+        // The extents bound to a scale without listener are not computed.
+        EXPECT_TRUE(get_domain_tracker().domain(sx.id()).empty());
+        EXPECT_FALSE(get_domain_tracker().domain(sy.id()).empty());
+        EXPECT_EQ(line.extent("x").max, 6.);
+
+        sx.enable_domain_tracking();
+        EXPECT_EQ(sx.min().value(), 1.);
+        EXPECT_EQ(sx.max().value(), 6.);
+    }
+
+    TEST(xdomain_tracker, moved_marks)
+    {
+        linear_scale sx, sy;
+        sx.enable_domain_tracking();
+        std::vector<lines> marks;
+        {
+            lines line(sx, sy);
+            line.x = std::vector<double>({1., 4.});
+            marks.push_back(std::move(line));
+        }
+        EXPECT_EQ(get_domain_tracker().domain(sx.id()).min, 1.);
+        EXPECT_EQ(get_domain_tracker().domain(sx.id()).max, 4.);
+
+        lines copy(marks.front());
+        marks.clear();
+        EXPECT_EQ(get_domain_tracker().domain(sx.id()).max, 4.);
+
+        // The deferred extents are moved as well.
+        linear_scale sy2;
+        lines other(sx, sy2);
+        other.y = std::vector<double>({-3., 2.});
+        lines moved(std::move(other));
+        sy2.enable_domain_tracking();
+        EXPECT_EQ(sy2.min().value(), -3.);
+        EXPECT_EQ(sy2.max().value(), 2.);
+    }
+
+    TEST(xdomain_tracker, color_scale)
+    {
+        linear_scale sx, sy;
+        color_scale sc;
+        sc.enable_domain_tracking();
+        scatter points(sx, sy, sc);
+        points.color = std::vector<double>({0.25, 3., -1.});
+        EXPECT_EQ(sc.min().value(), -1.);
+        EXPECT_EQ(sc.max().value(), 3.);
+    }
+
+    TEST(xdomain_tracker, heat_map)
+    {
+        linear_scale sx, sy;
+        color_scale sc;
+        sc.enable_domain_tracking();
+        std::vector<std::vector<double>> values = {{1., -3.}, {5., 2.}};
+        heat_map map(values, sx, sy, sc);
+        map.color = xmatrix<double>(std::vector<std::vector<double>>({{0.5, 7.}, {-2., 1.}}));
+        EXPECT_EQ(sc.min().value(), -2.);
+        EXPECT_EQ(sc.max().value(), 7.);
+
+        grid_heat_map grid(values, sx, sy, sc);
+        grid.color = xmatrix<double>(values);
+        EXPECT_EQ(sc.min().value(), -3.);
+        EXPECT_EQ(sc.max().value(), 7.);
+    }
+}
@@ -35,4 +35,76 @@ namespace xpl
         f.add_axis(a3);
         EXPECT_EQ(f.axes().size(), 3);
     }
-}
\ No newline at end of file
+
+    TEST(xfigure, bulk_marks)
+    {
+        auto s = std::make_shared<linear_scale>();
+        std::vector<lines> ls;
+        for (int i = 0; i < 5; ++i)
+        {
+            ls.emplace_back(s, s);
+        }
+        auto shared = std::make_shared<lines>(s, s);
+        figure f;
+        f.add_marks(ls.begin(), ls.end());
+        f.add_mark(shared);
+        EXPECT_EQ(f.marks().size(), 6);
+
+        f.remove_marks(std::vector<xeus::xguid>({ls[1].id(), ls[3].id()}));
+        ASSERT_EQ(f.marks().size(), 4);
+        EXPECT_EQ(f.marks()[0].id(), ls[0].id());
+        EXPECT_EQ(f.marks()[1].id(), ls[2].id());
+        EXPECT_EQ(f.marks()[2].id(), ls[4].id());
+        EXPECT_EQ(f.marks()[3].id(), shared->id());
+
+        f.remove_mark(*shared);
+        f.remove_mark(ls[1]);
+        EXPECT_EQ(f.marks().size(), 3);
+
+        std::vector<std::shared_ptr<lines>> replacement = {shared};
+        f.replace_marks(replacement);
+        ASSERT_EQ(f.marks().size(), 1);
+        EXPECT_EQ(f.marks()[0].id(), shared->id());
+
+        f.marks = figure::marks_type();
+        f.add_marks(ls.begin(), ls.begin() + 2);
+        f.remove_mark(ls[0]);
+        ASSERT_EQ(f.marks().size(), 1);
+        EXPECT_EQ(f.marks()[0].id(), ls[1].id());
+    }
+
+    TEST(xfigure, alternate_marks)
+    {
+        auto s = std::make_shared<linear_scale>();
+        std::vector<lines> ls;
+        for (int i = 0; i < 4; ++i)
+        {
+            ls.emplace_back(s, s);
+        }
+        figure f;
+        f.add_mark(ls[0]);
+        f.add_mark(ls[1]);
+        f.remove_mark(ls[0]);
+        f.add_mark(ls[2]);
+        f.remove_mark(ls[1]);
+        f.add_mark(ls[3]);
+        f.remove_mark(ls[3]);
+        ASSERT_EQ(f.marks().size(), 1);
+        EXPECT_EQ(f.marks()[0].id(), ls[2].id());
+
+        auto version = f.property_version("marks");
+        f.remove_mark(ls[0]);
+        EXPECT_EQ(f.property_version("marks"), version + 1);
+        f.remove_mark(ls[2]);
+        EXPECT_TRUE(f.marks().empty());
+    }
+
+    TEST(xfigure, add_axes)
+    {
+        auto s = std::make_shared<linear_scale>();
+        std::vector<axis> as = {axis(s), axis(s)};
+        figure f;
+        f.add_axes(as.begin(), as.end());
+        EXPECT_EQ(f.axes().size(), 2);
+    }
+}
@@ -0,0 +1,118 @@
+/***************************************************************************
+* Copyright (c) 2016, Johan Mabille and Sylvain Corlay                     *
+*                                                                          *
+* Distributed under the terms of the BSD 3-Clause License.                 *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "xplot/xhistogram.hpp"
+
+namespace xpl
+{
+    TEST(xhistogram, counts)
+    {
+        std::vector<double> values = {0., 0.5, 1., 1.5, 2., 2.5, 3., 4., std::nan("")};
+        double min, max;
+        ASSERT_TRUE(histogram_range(values.data(), values.size(), min, max));
+        EXPECT_EQ(min, 0.);
+        EXPECT_EQ(max, 4.);
+
+        std::vector<double> counts;
+        histogram_counts(values.data(), values.size(), min, max, 4, counts);
+        EXPECT_EQ(counts, std::vector<double>({2., 2., 2., 2.}));
+
+        std::vector<double> midpoints;
+        histogram_midpoints(min, max, 4, midpoints);
+        EXPECT_EQ(midpoints, std::vector<double>({0.5, 1.5, 2.5, 3.5}));
+
+        normalize_histogram(min, max, counts);
+        EXPECT_DOUBLE_EQ(counts[0], 0.25);
+    }
+
+    TEST(xhistogram, parallel_counts)
+    {
+        std::vector<double> values(1000000);
+        for (std::size_t i = 0; i < values.size(); ++i)
+        {
+            values[i] = static_cast<double>(i % 100);
+        }
+        std::vector<double> counts;
+        histogram_counts(values.data(), values.size(), 0., 100., 10, counts);
+        for (double c : counts)
+        {
+            EXPECT_EQ(c, 100000.);
+        }
+    }
+
+    TEST(xhistogram, streaming)
+    {
+        using clock_type = xstreaming_histogram::clock_type;
+        clock_type::time_point t0;
+        xstreaming_histogram histogram(0., 4., 4);
+        std::vector<std::size_t> changed;
+        std::vector<double> values = {0.5, 0.7, 3.5, 5., std::nan("")};
+        histogram.add(values.data(), values.size(), t0, changed);
+        EXPECT_EQ(histogram.counts(), std::vector<double>({2., 0., 0., 1.}));
+        EXPECT_EQ(changed, std::vector<std::size_t>({0, 3}));
+        EXPECT_EQ(histogram.dropped(), 2u);
+
+        changed.clear();
+        std::vector<double> more = {1.5};
+        histogram.add(more.data(), more.size(), t0, changed);
+        EXPECT_EQ(changed, std::vector<std::size_t>({1}));
+    }
+
+    TEST(xhistogram, streaming_window)
+    {
+        using namespace std::chrono;
+        xstreaming_histogram::time_point t0;
+        xstreaming_histogram histogram(0., 2., 2);
+        histogram.set_window(seconds(10), 10);
+        std::vector<std::size_t> changed;
+        std::vector<double> first = {0.5, 0.5};
+        std::vector<double> second = {1.5};
+        histogram.add(first.data(), first.size(), t0, changed);
+        histogram.add(second.data(), second.size(), t0 + seconds(5), changed);
+        EXPECT_EQ(histogram.counts(), std::vector<double>({2., 1.}));
+
+        changed.clear();
+        histogram.advance(t0 + seconds(11), changed);
+        EXPECT_EQ(histogram.counts(), std::vector<double>({0., 1.}));
+        EXPECT_EQ(changed, std::vector<std::size_t>({0}));
+
+        changed.clear();
+        histogram.advance(t0 + seconds(100), changed);
+        EXPECT_EQ(histogram.counts(), std::vector<double>({0., 0.}));
+        EXPECT_EQ(changed, std::vector<std::size_t>({1}));
+    }
+
+    TEST(xhistogram, streaming_decay)
+    {
+        using namespace std::chrono;
+        xstreaming_histogram::time_point t0;
+        xstreaming_histogram histogram(0., 2., 2);
+        histogram.set_decay(seconds(1));
+        std::vector<std::size_t> changed;
+        std::vector<double> values = {0.5, 0.5, 1.5, 1.5};
+        histogram.add(values.data(), values.size(), t0, changed);
+        changed.clear();
+        histogram.advance(t0 + seconds(2), changed);
+        EXPECT_DOUBLE_EQ(histogram.counts()[0], 0.5);
+        EXPECT_DOUBLE_EQ(histogram.counts()[1], 0.5);
+        EXPECT_EQ(changed.size(), 2u);
+
+        changed.clear();
+        histogram.advance(t0 + seconds(3), changed);
+        EXPECT_DOUBLE_EQ(histogram.counts()[0], 0.25);
+        EXPECT_EQ(changed, std::vector<std::size_t>({0, 1}));
+    }
+}
@@ -0,0 +1,99 @@
+/***************************************************************************
+* Copyright (c) 2017, Sylvain Corlay and Johan Mabille                     *
+*                                                                          *
+* Distributed under the terms of the BSD 3-Clause License.                 *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#include <cstddef>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "xplot/xhit_test.hpp"
+
+namespace xpl
+{
+    namespace
+    {
+        bool naive_inside(double px, double py, const std::vector<double>& vx, const std::vector<double>& vy)
+        {
+            bool inside = false;
+            for (std::size_t i = 0, j = vx.size() - 1; i < vx.size(); j = i++)
+            {
+                if (((vy[i] > py) != (vy[j] > py)) &&
+                    (px < (vx[j] - vx[i]) * (py - vy[i]) / (vy[j] - vy[i]) + vx[i]))
+                {
+                    inside = !inside;
+                }
+            }
+            return inside;
+        }
+    }
+
+    TEST(xhit_test, select_interval)
+    {
+        double nan = std::numeric_limits<double>::quiet_NaN();
+        std::vector<double> values = {0.5, 3., nan, -1., 2., 1.};
+        std::vector<int> expected = {0, 4, 5};
+        EXPECT_EQ(select_interval(values.data(), values.size(), 0., 2.), expected);
+        EXPECT_EQ(select_interval(values.data(), values.size(), 2., 0.), expected);
+        EXPECT_TRUE(select_interval(values.data(), values.size(), 5., 6.).empty());
+
+        // Spans several blocks.
+        std::vector<int> integers(5000);
+        for (std::size_t i = 0; i < integers.size(); ++i)
+        {
+            integers[i] = static_cast<int>(i);
+        }
+        std::vector<int> res = select_interval(integers.data(), integers.size(), 1000., 3000.5);
+        ASSERT_EQ(res.size(), 2001u);
+        EXPECT_EQ(res.front(), 1000);
+        EXPECT_EQ(res.back(), 3000);
+    }
+
+    TEST(xhit_test, select_rectangle)
+    {
+        std::vector<double> x = {0., 1., 2., 3., 1.5};
+        std::vector<double> y = {0., 1., 2., 3., 5.};
+        std::vector<int> expected = {1, 2};
+        EXPECT_EQ(select_rectangle(x.data(), y.data(), x.size(), 2.5, 0.5, 0.5, 2.5), expected);
+    }
+
+    TEST(xhit_test, select_polygon)
+    {
+        // Concave polygon, a square with a notch on its right side.
+        std::vector<double> vx = {0., 4., 4., 2., 4., 0.};
+        std::vector<double> vy = {0., 0., 1., 2., 3., 3.};
+
+        std::vector<double> x, y;
+        for (int i = 0; i < 60; ++i)
+        {
+            for (int j = 0; j < 50; ++j)
+            {
+                x.push_back(-1. + i * 0.1 + 0.013);
+                y.push_back(-1. + j * 0.1 + 0.017);
+            }
+        }
+        std::vector<int> expected;
+        for (std::size_t i = 0; i < x.size(); ++i)
+        {
+            if (naive_inside(x[i], y[i], vx, vy))
+            {
+                expected.push_back(static_cast<int>(i));
+            }
+        }
+        std::vector<int> res = select_polygon(x.data(), y.data(), x.size(), vx, vy);
+        EXPECT_FALSE(res.empty());
+        EXPECT_EQ(res, expected);
+
+        std::vector<double> notch_x = {3.5}, notch_y = {2.};
+        EXPECT_TRUE(select_polygon(notch_x.data(), notch_y.data(), 1, vx, vy).empty());
+
+        EXPECT_TRUE(select_polygon(x.data(), y.data(), x.size(), {0., 1.}, {0., 1.}).empty());
+        EXPECT_THROW(select_polygon(x.data(), y.data(), x.size(), {0., 1., 2.}, {0., 1.}), std::invalid_argument);
+    }
+}
@@ -0,0 +1,158 @@
+/***************************************************************************
+* Copyright (c) 2017, Sylvain Corlay and Johan Mabille                     *
+*                                                                          *
+* Distributed under the terms of the BSD 3-Clause License.                 *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "xplot/xinteracts.hpp"
+#include "xplot/xmarks.hpp"
+#include "xplot/xscales.hpp"
+
+namespace xpl
+{
+    TEST(xinteracts, brush_interval_selector)
+    {
+        linear_scale sx, sy;
+        scatter points(sx, sy);
+        points.x = std::vector<double>({0., 1., 2., 3., 4.});
+        points.y = std::vector<double>({4., 3., 2., 1., 0.});
+        lines line(sx, sy);
+        line.x = std::vector<double>({0.5, 2.5});
+        line.y = std::vector<double>({0., 5.});
+
+        brush_interval_selector selector;
+        selector.scale = sx;
+        selector.add_mark(points);
+        selector.add_mark(line);
+        EXPECT_EQ(selector.marks().size(), 2u);
+
+        selector.selected = std::vector<double>({3.5, 0.8});
+        EXPECT_EQ(points.selected(), std::vector<int>({1, 2, 3}));
+        EXPECT_EQ(line.selected().value(), std::vector<int>({1}));
+
+        selector.orientation = "vertical";
+        EXPECT_EQ(points.selected(), std::vector<int>({1, 2, 3}));
+        EXPECT_TRUE(line.selected().value().empty());
+
+        selector.selected = std::vector<double>();
+        EXPECT_TRUE(points.selected().empty());
+        EXPECT_FALSE(line.selected().has_value());
+    }
+
+    TEST(xinteracts, brush_selector)
+    {
+        linear_scale sx, sy;
+        scatter points(sx, sy);
+        points.x = std::vector<double>({0., 1., 2., 3., 4.});
+        points.y = std::vector<double>({4., 3., 2., 1., 0.});
+
+        brush_selector selector;
+        selector.add_mark(points);
+        selector.selected_x = std::vector<double>({1., 4.});
+        EXPECT_EQ(points.selected(), std::vector<int>({1, 2, 3, 4}));
+        selector.selected_y = std::vector<double>({2.5, 0.5});
+        EXPECT_EQ(points.selected(), std::vector<int>({2, 3}));
+
+        selector.clear_marks();
+        EXPECT_TRUE(selector.marks().empty());
+        selector.selected_x = std::vector<double>();
+        EXPECT_EQ(points.selected(), std::vector<int>({2, 3}));
+    }
+
+    TEST(xinteracts, destroyed_mark)
+    {
+        linear_scale sx, sy;
+        scatter points(sx, sy);
+        points.x = std::vector<double>({0., 1., 2.});
+        points.y = std::vector<double>({0., 1., 2.});
+
+        brush_interval_selector selector;
+        selector.scale = sx;
+        selector.add_mark(points);
+        {
+            scatter other(sx, sy);
+            other.x = std::vector<double>({0.5});
+            other.y = std::vector<double>({0.5});
+            selector.add_mark(other);
+        }
+        // The destroyed mark is skipped.
+        selector.selected = std::vector<double>({0.5, 1.5});
+        EXPECT_EQ(points.selected(), std::vector<int>({1}));
+    }
+
+    TEST(xinteracts, downsampled_lines)
+    {
+        linear_scale sx, sy;
+        lines line(sx, sy);
+        std::vector<double> xs(100);
+        for (std::size_t i = 0; i < xs.size(); ++i)
+        {
+            xs[i] = static_cast<double>(i);
+        }
+        line.x = xs;
+        line.y = xs;
+
+        brush_interval_selector selector;
+        selector.scale = sx;
+        selector.add_mark(line);
+        selector.selected = std::vector<double>({10.5, 12.5});
+        EXPECT_EQ(line.selected().value(), std::vector<int>({11, 12}));
+        EXPECT_EQ(line.selected_points().value(), std::vector<int>({11, 12}));
+
+        // The front-end holds a subset of the points, the full resolution
+        // selection stays on the server.
+        line.max_points = 10;
+        EXPECT_TRUE(line.is_downsampled());
+        selector.selected = std::vector<double>({20.5, 22.5});
+        EXPECT_FALSE(line.selected().has_value());
+        EXPECT_EQ(line.selected_points().value(), std::vector<int>({21, 22}));
+    }
+
+    TEST(xinteracts, selection_owner)
+    {
+        linear_scale sx, sy;
+        scatter points(sx, sy);
+        points.x = std::vector<double>({0., 1., 2.});
+        points.y = std::vector<double>({0., 1., 2.});
+        xeus::buffer_sequence buffers;
+
+        // The selection computed by the front-end view is ignored.
+        brush_interval_selector selector;
+        selector.scale = sx;
+        selector.add_mark(points);
+        selector.selected = std::vector<double>({0.5, 2.5});
+        points.apply_patch({{"selected", {0}}}, buffers);
+        EXPECT_EQ(points.selected(), std::vector<int>({1, 2}));
+
+        selector.clear_marks();
+        points.apply_patch({{"selected", {0}}}, buffers);
+        EXPECT_EQ(points.selected(), std::vector<int>({0}));
+
+        // The lasso drawn in the front-end is not sent, its selection is kept.
+        lasso_selector lasso;
+        lasso.add_mark(points);
+        points.apply_patch({{"selected", {2}}}, buffers);
+        EXPECT_EQ(points.selected(), std::vector<int>({2}));
+    }
+
+    TEST(xinteracts, lasso_selector)
+    {
+        linear_scale sx, sy;
+        scatter points(sx, sy);
+        points.x = std::vector<double>({0.5, 1.5, 3.5, 2.5});
+        points.y = std::vector<double>({0.5, 1.5, 2., 2.5});
+
+        lasso_selector selector;
+        selector.add_mark(points);
+        selector.vertices_x = std::vector<double>({0., 4., 4., 2., 4., 0.});
+        EXPECT_TRUE(points.selected().empty());
+        selector.vertices_y = std::vector<double>({0., 0., 1., 2., 3., 3.});
+        EXPECT_EQ(points.selected(), std::vector<int>({0, 1, 3}));
+    }
+}
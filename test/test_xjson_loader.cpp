@@ -0,0 +1,105 @@
+/***************************************************************************
+* Copyright (c) 2016, Johan Mabille and Sylvain Corlay                     *
+*                                                                          *
+* Distributed under the terms of the BSD 3-Clause License.                 *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+#include "gtest/gtest.h"
+
+#include "xplot/xjson_loader.hpp"
+#include "xplot/xmarks.hpp"
+
+namespace xpl
+{
+    namespace
+    {
+        xtopology parse_topology(const std::string& str)
+        {
+            return xpl::parse_topology(str.data(), str.data() + str.size());
+        }
+
+        xjson_columns parse_json_columns(const std::string& str)
+        {
+            return xpl::parse_json_columns(str.data(), str.data() + str.size());
+        }
+    }
+
+    TEST(xjson_loader, topology)
+    {
+        std::string str = R"({
+            "type": "Topology",
+            "transform": {"scale": [0.5, 0.25], "translate": [-10, 20]},
+            "arcs": [[[0, 0], [10, 0], [0, 10]], [], [[10, 10], [-10, 0]]],
+            "objects": {"land": {"type": "LineString", "arcs": [0, 2], "properties": {"arcs": [[1, 2]]}}}
+        })";
+        xtopology topology = parse_topology(str);
+        EXPECT_EQ(topology.arc_count(), 3u);
+        EXPECT_EQ(topology.arc_offsets, std::vector<std::size_t>({0, 3, 3, 5}));
+        EXPECT_EQ(topology.arc_positions, std::vector<double>({0, 0, 10, 0, 0, 10, 10, 10, -10, 0}));
+        EXPECT_EQ(topology.header.count("arcs"), 0u);
+        EXPECT_EQ(topology.to_topojson(), nl::json::parse(str));
+        EXPECT_EQ(topology.to_topojson().dump(), nl::json::parse(str).dump());
+    }
+
+    TEST(xjson_loader, topology_positions)
+    {
+        std::string str = R"({
+            "type": "Topology",
+            "objects": {},
+            "arcs": [[[0.5, 1.5, 100], [2.5, 3.5]]]
+        })";
+        xtopology topology = parse_topology(str);
+        EXPECT_EQ(topology.arc_positions, std::vector<double>({0.5, 1.5, 2.5, 3.5}));
+    }
+
+    TEST(xjson_loader, topology_errors)
+    {
+        EXPECT_THROW(parse_topology(R"({"type": "Topology", "arcs": [[[0]]]})"), std::runtime_error);
+        EXPECT_THROW(parse_topology(R"({"type": "Topology", "arcs": [[0, 1]]})"), std::runtime_error);
+        EXPECT_THROW(parse_topology(R"({"type": "Topology", "arcs": 1})"), std::runtime_error);
+        EXPECT_THROW(parse_topology(R"({"type": "Topology", "arcs": [)"), std::runtime_error);
+        EXPECT_THROW(parse_topology(R"({"type": "FeatureCollection"})"), std::invalid_argument);
+    }
+
+    TEST(xjson_loader, topology_file)
+    {
+        std::string path = topo_load("WorldMap.json");
+        xtopology topology = load_topology_file(path);
+        EXPECT_EQ(topology.to_topojson(), load_json_file(path));
+    }
+
+    TEST(xjson_loader, columns)
+    {
+        xjson_columns columns = parse_json_columns(R"({"x": [0, 1, 2.5], "y": [-1, null, 3], "z": []})");
+        ASSERT_EQ(columns.size(), 3u);
+        EXPECT_EQ(columns["x"], std::vector<double>({0., 1., 2.5}));
+        EXPECT_EQ(columns["y"][0], -1.);
+        EXPECT_TRUE(std::isnan(columns["y"][1]));
+        EXPECT_TRUE(columns["z"].empty());
+
+        EXPECT_THROW(parse_json_columns(R"({"x": [[0]]})"), std::runtime_error);
+        EXPECT_THROW(parse_json_columns(R"({"x": ["a"]})"), std::runtime_error);
+        EXPECT_THROW(parse_json_columns(R"([0, 1])"), std::runtime_error);
+        EXPECT_THROW(parse_json_columns(R"({"x": 1})"), std::runtime_error);
+    }
+
+    TEST(xjson_loader, columns_file)
+    {
+        const std::string path = "test_xjson_loader_columns.json";
+        {
+            std::ofstream out(path);
+            out << R"({"x": [1, 2, 3]})";
+        }
+        EXPECT_EQ(load_json_columns(path)["x"], std::vector<double>({1., 2., 3.}));
+        std::remove(path.c_str());
+        EXPECT_THROW(load_json_columns(path), std::runtime_error);
+    }
+}
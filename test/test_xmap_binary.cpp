@@ -0,0 +1,163 @@
+/***************************************************************************
+* Copyright (c) 2016, Johan Mabille and Sylvain Corlay                     *
+*                                                                          *
+* Distributed under the terms of the BSD 3-Clause License.                 *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+#include "gtest/gtest.h"
+
+#include "xplot/xmap_binary.hpp"
+#include "xplot/xmap_cache.hpp"
+
+namespace xpl
+{
+    namespace
+    {
+        nl::json quantized_topology()
+        {
+            return nl::json::parse(R"({
+                "type": "Topology",
+                "transform": {"scale": [0.5, 0.25], "translate": [-10, 20]},
+                "objects": {
+                    "subunits": {
+                        "type": "GeometryCollection",
+                        "geometries": [
+                            {"type": "Polygon", "id": 4, "properties": {"name": "a"}, "arcs": [[0, -2]]},
+                            {"type": "MultiPolygon", "id": "b", "arcs": [[[1]], [[-1]]], "bbox": [0, 0, 1, 1]},
+                            {"type": "Point", "coordinates": [3, 4]},
+                            {"type": null}
+                        ]
+                    },
+                    "land": {"type": "LineString", "arcs": [0, 1]}
+                },
+                "arcs": [[[0, 0], [10, 0], [0, 10]], [[10, 10], [-10, 0]]]
+            })");
+        }
+
+        void write_file(const std::string& path, const std::string& content)
+        {
+            std::ofstream out(path, std::ios::binary);
+            out << content;
+        }
+    }
+
+    TEST(xmap_binary, round_trip)
+    {
+        nl::json topology = quantized_topology();
+        const std::string path = "test_xmap_binary.xmap";
+        {
+            std::ofstream out(path, std::ios::binary);
+            write_binary_map(topology, out, xmap_source{42, 7});
+        }
+
+        xbinary_map map(path);
+        EXPECT_TRUE(map.has_transform());
+        EXPECT_EQ(map.scale()[1], 0.25);
+        EXPECT_EQ(map.translate()[0], -10.);
+        EXPECT_EQ(map.source().size, 42u);
+        EXPECT_EQ(map.source().mtime, 7);
+        EXPECT_EQ(map.arc_count(), 2u);
+        EXPECT_EQ(map.point_count(), 5u);
+        EXPECT_EQ(map.arc_offsets()[1], 3u);
+        EXPECT_EQ(map.points()[8], -10);
+        EXPECT_EQ(map.to_topojson(), topology);
+
+        xmap_source source;
+        EXPECT_TRUE(read_binary_map_source(path, source));
+        EXPECT_EQ(source.size, 42u);
+        EXPECT_EQ(source.mtime, 7);
+        std::remove(path.c_str());
+    }
+
+    TEST(xmap_binary, quantization)
+    {
+        nl::json topology = nl::json::parse(R"({
+            "type": "Topology",
+            "objects": {"line": {"type": "LineString", "arcs": [0]}},
+            "arcs": [[[0.0, 0.0], [1.0, 2.0], [2.0, 4.0]]]
+        })");
+        const std::string path = "test_xmap_quantization.xmap";
+        {
+            xbinary_map_options options;
+            options.quantization = 3;
+            std::ofstream out(path, std::ios::binary);
+            write_binary_map(topology, out, xmap_source(), options);
+        }
+
+        xbinary_map map(path);
+        EXPECT_EQ(map.scale()[0], 1.);
+        EXPECT_EQ(map.scale()[1], 2.);
+        nl::json res = map.to_topojson();
+        EXPECT_EQ(res["arcs"], nl::json::parse("[[[0, 0], [1, 1], [1, 1]]]"));
+        EXPECT_EQ(res["objects"], topology["objects"]);
+        std::remove(path.c_str());
+    }
+
+    TEST(xmap_binary, serialize)
+    {
+        const std::string path = "test_xmap_serialize.xmap";
+        {
+            std::ofstream out(path, std::ios::binary);
+            write_binary_map(quantized_topology(), out);
+        }
+
+        xbinary_map map(path);
+        nl::json j;
+        xeus::buffer_sequence buffers;
+        map.serialize(j, buffers);
+        ASSERT_EQ(buffers.size(), 2u);
+        EXPECT_EQ(j["arcs"]["points"]["dtype"], "int32");
+        EXPECT_EQ(j["arcs"]["points"]["shape"], nl::json({5, 2}));
+        EXPECT_EQ(buffers[0].size(), 10 * sizeof(std::int32_t));
+        EXPECT_EQ(j["arcs"]["offsets"]["dtype"], "uint32");
+        EXPECT_EQ(j["objects"], quantized_topology()["objects"]);
+        std::remove(path.c_str());
+    }
+
+    TEST(xmap_binary, cache)
+    {
+        const std::string json_path = "test_xmap_cache_binary.json";
+        const std::string path = binary_map_path(json_path);
+        EXPECT_EQ(path, "test_xmap_cache_binary.xmap");
+        write_file(json_path, quantized_topology().dump());
+        convert_map_file(json_path, path);
+
+        xmap_cache cache;
+        map_document_ptr document = cache.load(json_path);
+        ASSERT_NE(document->binary(), nullptr);
+        EXPECT_EQ(document->data(), quantized_topology());
+
+        // The binary map is ignored once the TopoJSON file changes.
+        write_file(json_path, quantized_topology().dump(4));
+        document = cache.load(json_path);
+        EXPECT_EQ(document->binary(), nullptr);
+        EXPECT_EQ(document->data(), quantized_topology());
+
+        // A binary map converted from another version of the file of the
+        // same size is ignored as well.
+        xmap_source source;
+        ASSERT_TRUE(map_source_status(json_path, source));
+        source.mtime -= 1;
+        {
+            std::ofstream out(path, std::ios::binary);
+            write_binary_map(quantized_topology(), out, source);
+        }
+        xmap_cache other_cache;
+        EXPECT_EQ(other_cache.load(json_path)->binary(), nullptr);
+        source.mtime += 1;
+        {
+            std::ofstream out(path, std::ios::binary);
+            write_binary_map(quantized_topology(), out, source);
+        }
+        EXPECT_NE(xmap_cache().load(json_path)->binary(), nullptr);
+
+        std::remove(json_path.c_str());
+        std::remove(path.c_str());
+    }
+}
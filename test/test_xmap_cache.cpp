@@ -0,0 +1,52 @@
+/***************************************************************************
+* Copyright (c) 2016, Johan Mabille and Sylvain Corlay                     *
+*                                                                          *
+* Distributed under the terms of the BSD 3-Clause License.                 *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+#include "gtest/gtest.h"
+
+#include "xplot/xmap_cache.hpp"
+
+namespace xpl
+{
+    namespace
+    {
+        void write_file(const std::string& path, const std::string& content)
+        {
+            std::ofstream out(path);
+            out << content;
+        }
+    }
+
+    TEST(xmap_cache, load)
+    {
+        const std::string path = "test_xmap_cache.json";
+        write_file(path, "{\"type\": \"Topology\"}");
+
+        xmap_cache cache;
+        map_document_ptr first = cache.load(path);
+        map_document_ptr second = cache.load(path);
+        EXPECT_EQ(first, second);
+        EXPECT_EQ(cache.size(), 1u);
+        EXPECT_EQ(first->data()["type"], "Topology");
+
+        write_file(path, "{\"type\": \"Topology\", \"objects\": {}}");
+        map_document_ptr third = cache.load(path);
+        EXPECT_NE(first, third);
+        EXPECT_EQ(third->data().count("objects"), 1u);
+        EXPECT_EQ(cache.size(), 1u);
+
+        cache.clear();
+        EXPECT_EQ(cache.size(), 0u);
+        std::remove(path.c_str());
+        EXPECT_THROW(cache.load(path), std::runtime_error);
+    }
+}
@@ -0,0 +1,178 @@
+/***************************************************************************
+* Copyright (c) 2016, Johan Mabille and Sylvain Corlay                     *
+*                                                                          *
+* Distributed under the terms of the BSD 3-Clause License.                 *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#include <stdexcept>
+
+#include "gtest/gtest.h"
+
+#include "xplot/xmap_filter.hpp"
+
+namespace xpl
+{
+    namespace
+    {
+        // Two squares sharing the arc 1.
+        nl::json squares()
+        {
+            return nl::json::parse(R"({
+                "type": "Topology",
+                "transform": {"scale": [1, 1], "translate": [0, 0]},
+                "bbox": [0, 0, 2, 1],
+                "objects": {
+                    "subunits": {
+                        "type": "GeometryCollection",
+                        "geometries": [
+                            {"type": "Polygon", "id": 1, "arcs": [[0, 1]]},
+                            {"type": "Polygon", "id": 2, "arcs": [[2, -2]]}
+                        ]
+                    },
+                    "land": {"type": "LineString", "arcs": [0]}
+                },
+                "arcs": [
+                    [[1, 0], [-1, 0], [0, 1], [1, 0]],
+                    [[1, 1], [0, -1]],
+                    [[1, 1], [1, 0], [0, -1], [-1, 0]]
+                ]
+            })");
+        }
+
+        nl::json second_square()
+        {
+            return nl::json::parse(R"({
+                "type": "Topology",
+                "transform": {"scale": [1, 1], "translate": [0, 0]},
+                "bbox": [1, 0, 2, 1],
+                "objects": {
+                    "subunits": {
+                        "type": "GeometryCollection",
+                        "geometries": [
+                            {"type": "Polygon", "id": 2, "arcs": [[1, -1]]}
+                        ]
+                    },
+                    "land": {"type": null}
+                },
+                "arcs": [
+                    [[1, 1], [0, -1]],
+                    [[1, 1], [1, 0], [0, -1], [-1, 0]]
+                ]
+            })");
+        }
+    }
+
+    TEST(xmap_filter, empty)
+    {
+        xmap_filter filter;
+        EXPECT_TRUE(filter.empty());
+        EXPECT_EQ(filter_topology(squares(), filter), squares());
+
+        xmap_filter other;
+        other.ids = {1};
+        EXPECT_FALSE(other.empty());
+        EXPECT_NE(filter.key(), other.key());
+    }
+
+    TEST(xmap_filter, ids)
+    {
+        xmap_filter filter;
+        filter.ids = {2};
+        EXPECT_EQ(filter_topology(squares(), filter), second_square());
+    }
+
+    TEST(xmap_filter, bbox)
+    {
+        xmap_filter filter;
+        filter.bbox = {1.5, 0., 3., 1.};
+        EXPECT_EQ(filter_topology(squares(), filter), second_square());
+
+        filter.bbox = {0., 0., 1.};
+        EXPECT_THROW(filter_topology(squares(), filter), std::invalid_argument);
+    }
+
+    TEST(xmap_filter, multi_polygon_parts)
+    {
+        nl::json topology = nl::json::parse(R"({
+            "type": "Topology",
+            "objects": {"islands": {"type": "MultiPolygon", "id": "a", "arcs": [[[0]], [[1]]]}},
+            "arcs": [
+                [[0, 0], [1, 0], [1, 1], [0, 0]],
+                [[5, 5], [6, 5], [6, 6], [5, 5]]
+            ]
+        })");
+        xmap_filter filter;
+        filter.bbox = {4., 4., 7., 7.};
+        nl::json res = filter_topology(topology, filter);
+        EXPECT_EQ(res["objects"]["islands"]["arcs"], nl::json::parse("[[[0]]]"));
+        EXPECT_EQ(res["arcs"], nl::json::parse("[[[5, 5], [6, 5], [6, 6], [5, 5]]]"));
+    }
+
+    TEST(xmap_filter, simplification)
+    {
+        nl::json topology = nl::json::parse(R"({
+            "type": "Topology",
+            "objects": {
+                "line": {"type": "LineString", "arcs": [0]},
+                "square": {"type": "Polygon", "arcs": [[1]]}
+            },
+            "arcs": [
+                [[0, 0], [1, 0.01], [2, 0], [3, 1], [4, 0]],
+                [[0, 0], [0, 1], [1, 1], [1, 0.5], [1, 0], [0, 0]]
+            ]
+        })");
+        xmap_filter filter;
+        filter.simplification = 0.1;
+        nl::json res = filter_topology(topology, filter);
+        EXPECT_EQ(res["objects"], topology["objects"]);
+        EXPECT_EQ(res["arcs"][0], nl::json::parse("[[0, 0], [2, 0], [3, 1], [4, 0]]"));
+        EXPECT_EQ(res["arcs"][1], nl::json::parse("[[0, 0], [0, 1], [1, 1], [1, 0], [0, 0]]"));
+
+        // Rings keep at least 4 points.
+        filter.simplification = 10.;
+        res = filter_topology(topology, filter);
+        EXPECT_EQ(res["arcs"][0], nl::json::parse("[[0, 0], [4, 0]]"));
+        EXPECT_EQ(res["arcs"][1].size(), 4u);
+    }
+
+    TEST(xmap_filter, ring_of_several_arcs)
+    {
+        nl::json topology = nl::json::parse(R"({
+            "type": "Topology",
+            "objects": {
+                "square": {"type": "Polygon", "arcs": [[0, 1]]},
+                "squares": {"type": "MultiPolygon", "arcs": [[[-2, 2]]]}
+            },
+            "arcs": [
+                [[0, 0], [0, 1], [1, 1], [1, 0]],
+                [[1, 0], [0.5, 0.1], [0, 0]],
+                [[1, 0], [0.6, -1], [0.5, -1], [0, 0]]
+            ]
+        })");
+        xmap_filter filter;
+        filter.simplification = 10.;
+        nl::json res = filter_topology(topology, filter);
+        // Each ring gets back the points it needs to keep 4 points, from
+        // its first arcs.
+        EXPECT_EQ(res["arcs"][0].size(), 3u);
+        EXPECT_EQ(res["arcs"][1], nl::json::parse("[[1, 0], [0.5, 0.1], [0, 0]]"));
+        EXPECT_EQ(res["arcs"][2], nl::json::parse("[[1, 0], [0, 0]]"));
+    }
+
+    TEST(xmap_filter, quantized_simplification)
+    {
+        nl::json topology = nl::json::parse(R"({
+            "type": "Topology",
+            "transform": {"scale": [0.5, 0.5], "translate": [0, 0]},
+            "objects": {"line": {"type": "LineString", "arcs": [0]}},
+            "arcs": [[[0, 0], [2, 1], [2, 0], [2, 4]]]
+        })");
+        // The area of the point [2, 1] is 1 in quantized units, 0.25 on the map.
+        xmap_filter filter;
+        filter.simplification = 0.3;
+        nl::json res = filter_topology(topology, filter);
+        EXPECT_EQ(res["arcs"], nl::json::parse("[[[0, 0], [4, 1], [2, 4]]]"));
+    }
+}
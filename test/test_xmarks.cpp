@@ -8,8 +8,17 @@
 
 #include "gtest/gtest.h"
 
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
 #include "xplot/xmarks.hpp"
 
+#include "patch_probe.hpp"
+
 namespace xpl
 {
     TEST(xmarks, constructor)
@@ -41,4 +50,461 @@ namespace xpl
         int res = line.marker_size();
         EXPECT_EQ(64, res);
     }
+
+    TEST(xmarks, append)
+    {
+        linear_scale sx, sy;
+        lines line(sx, sy);
+        line.x = std::vector<double>({1., 2., 3.});
+        line.y = std::vector<double>({1., 2., 3.});
+        line.append(std::vector<double>({4., 5.}), std::vector<double>({4., 5.}), 4);
+        const std::vector<double>& x = line.x();
+        EXPECT_EQ(x, std::vector<double>({2., 3., 4., 5.}));
+        EXPECT_THROW(line.append(std::vector<double>({6.}), std::vector<double>()), std::invalid_argument);
+    }
+
+    TEST(xmarks, append_patch)
+    {
+        linear_scale sx, sy;
+        patch_probe_t<xscatter> points(sx, sy);
+        points.append(std::vector<double>({1., 2.}), std::vector<double>({3., 4.}));
+        ASSERT_EQ(points.patches().size(), 1u);
+        EXPECT_EQ(points.patches()[0].state["x"]["values"], nl::json({1., 2.}));
+        EXPECT_EQ(points.patches()[0].state["y"]["values"], nl::json({3., 4.}));
+
+        points.append(std::vector<double>({5.}), std::vector<double>({6.}), 2);
+        ASSERT_EQ(points.patches().size(), 2u);
+        EXPECT_EQ(points.patches()[1].state["x"]["values"], nl::json({2., 5.}));
+        EXPECT_EQ(points.patches()[1].state["y"]["values"], nl::json({4., 6.}));
+
+        patch_probe_t<xlabel> label(sx, sy);
+        label.append(std::vector<double>({1.}), std::vector<double>({2.}), std::vector<std::string>({"a"}));
+        ASSERT_EQ(label.patches().size(), 1u);
+        EXPECT_EQ(label.patches()[0].state["text"]["values"], nl::json({"a"}));
+        EXPECT_THROW(label.append(std::vector<double>({1.}), std::vector<double>({2.}), std::vector<std::string>()),
+                     std::invalid_argument);
+    }
+
+    TEST(xmarks, append_window)
+    {
+        linear_scale sx, sy;
+        scatter points(sx, sy);
+        std::vector<double> expected;
+        scatter::data_type first_window;
+        for (int i = 0; i < 50; ++i)
+        {
+            std::vector<double> tail(static_cast<std::size_t>(i % 4), static_cast<double>(i));
+            points.append(tail, tail, 10);
+            expected.insert(expected.end(), tail.begin(), tail.end());
+            if (expected.size() > 10)
+            {
+                expected.erase(expected.begin(), expected.end() - 10);
+            }
+            ASSERT_EQ(std::vector<double>(points.y().begin(), points.y().end()), expected);
+            if (i == 5)
+            {
+                first_window = points.y();
+            }
+        }
+        // Copies of the window are not modified by later appends.
+        EXPECT_EQ(std::vector<double>(first_window.begin(), first_window.end()),
+                  std::vector<double>({1., 2., 2., 3., 3., 3., 5.}));
+        EXPECT_EQ(points.extent("y").min, 43.);
+        EXPECT_EQ(points.extent("y").max, 49.);
+    }
+
+    TEST(xmarks, downsampling)
+    {
+        linear_scale sx, sy;
+        lines line(sx, sy);
+        std::vector<double> values(10000);
+        for (std::size_t i = 0; i < values.size(); ++i)
+        {
+            values[i] = static_cast<double>(i % 17);
+        }
+        line.x = values;
+        line.y = values;
+        line.max_points = 100;
+
+        nl::json state;
+        xeus::buffer_sequence buffers;
+        line.serialize_state(state, buffers);
+        EXPECT_EQ(state["x"]["values"].size(), 100u);
+        EXPECT_EQ(state["y"]["values"].size(), 100u);
+        const std::vector<double>& x = line.x();
+        EXPECT_EQ(x.size(), 10000u);
+
+        line.downsampling = "m4";
+        line.max_points = 0;
+        state = nl::json();
+        line.serialize_state(state, buffers);
+        EXPECT_EQ(state["x"]["values"].size(), 10000u);
+    }
+
+    TEST(xmarks, downsampling_patch)
+    {
+        linear_scale sx, sy;
+        patch_probe_t<xlines> line(sx, sy);
+        line.max_points = 100;
+        std::vector<double> values(10000);
+        for (std::size_t i = 0; i < values.size(); ++i)
+        {
+            values[i] = static_cast<double>(i % 17);
+        }
+
+        // x and y are serialized once in the patch of the append.
+        std::size_t count = line.patches().size();
+        default_data_encoding() = xdata_encoding::binary;
+        line.append(values, values);
+        default_data_encoding() = xdata_encoding::json;
+        ASSERT_EQ(line.patches().size(), count + 1);
+        const nl::json& state = line.patches().back().state;
+        EXPECT_EQ(line.patches().back().buffer_count, 2u);
+        EXPECT_EQ(state["x"]["value"], std::string(xw::xbuffer_reference_prefix()) + "0");
+        EXPECT_EQ(state["y"]["value"], std::string(xw::xbuffer_reference_prefix()) + "1");
+    }
+
+    TEST(xmarks, viewport_downsampling)
+    {
+        linear_scale sx, sy;
+        lines line(sx, sy);
+        std::vector<double> xs(100000), ys(100000);
+        for (std::size_t i = 0; i < xs.size(); ++i)
+        {
+            xs[i] = static_cast<double>(i);
+            ys[i] = static_cast<double>(i % 17);
+        }
+        line.x = xs;
+        line.y = ys;
+        line.max_points = 100;
+
+        nl::json state;
+        xeus::buffer_sequence buffers;
+        line.serialize_state(state, buffers);
+        EXPECT_EQ(state["x"]["values"].size(), 100u);
+        xsync_state::version_type version = line.property_version("x");
+
+        // Zooming on [1000, 2000] sends the visible slice and its margins.
+        sx.apply_patch({{"min", 1000.}, {"max", 2000.}}, buffers);
+        state = nl::json();
+        line.serialize_state(state, buffers);
+        const nl::json& sent = state["x"]["values"];
+        EXPECT_LE(sent.size(), 200u);
+        EXPECT_GE(sent.front().get<double>(), 400.);
+        EXPECT_LE(sent.back().get<double>(), 2600.);
+        EXPECT_LE(sent.front().get<double>(), 1000.);
+        EXPECT_GE(sent.back().get<double>(), 2000.);
+        EXPECT_EQ(line.property_version("x"), version);
+
+        // Resetting the domain sends the whole curve again.
+        sx.min = xtl::xoptional<double>();
+        sx.max = xtl::xoptional<double>();
+        state = nl::json();
+        line.serialize_state(state, buffers);
+        EXPECT_EQ(state["x"]["values"].back().get<double>(), 99999.);
+    }
+
+    TEST(xmarks, pyramid)
+    {
+        linear_scale sx, sy;
+        lines line(sx, sy);
+        std::vector<double> values(100000);
+        for (std::size_t i = 0; i < values.size(); ++i)
+        {
+            values[i] = static_cast<double>((i * 7919) % 10007);
+        }
+        line.x = values;
+        line.y = values;
+        line.max_points = 100;
+        line.downsampling = "minmax";
+
+        nl::json expected;
+        xeus::buffer_sequence buffers;
+        line.serialize_state(expected, buffers);
+
+        line.build_pyramid();
+        EXPECT_TRUE(line.has_pyramid());
+        nl::json state;
+        line.serialize_state(state, buffers);
+        EXPECT_EQ(state["y"], expected["y"]);
+
+        line.append(std::vector<double>({20000.}), std::vector<double>({20000.}));
+        EXPECT_EQ(line.pyramid().size(), 100001u);
+    }
+
+    TEST(xmarks, data_view)
+    {
+        linear_scale sx, sy;
+        lines line(sx, sy);
+        std::vector<double> values(10000);
+        for (std::size_t i = 0; i < values.size(); ++i)
+        {
+            values[i] = static_cast<double>(i);
+        }
+        line.x = data_view(values.data(), values.size());
+        line.y = data_view(values.data(), values.size());
+        line.max_points = 100;
+
+        nl::json state;
+        xeus::buffer_sequence buffers;
+        line.serialize_state(state, buffers);
+        EXPECT_TRUE(line.x().is_view());
+        EXPECT_TRUE(line.y().is_view());
+        EXPECT_EQ(line.x().data(), values.data());
+        EXPECT_LE(state["y"]["values"].size(), 200u);
+    }
+
+    TEST(xmarks, binned_hist)
+    {
+        linear_scale sx, sy;
+        binned_hist h(sx, sy);
+        EXPECT_EQ(h._model_name(), "BarsModel");
+        std::vector<double> values(1000);
+        for (std::size_t i = 0; i < values.size(); ++i)
+        {
+            values[i] = static_cast<double>(i);
+        }
+        h.sample = values;
+        const std::vector<double>& count = h.y();
+        EXPECT_EQ(count, std::vector<double>(10, 100.));
+        const std::vector<double>& midpoints = h.x();
+        ASSERT_EQ(midpoints.size(), 10u);
+        EXPECT_DOUBLE_EQ(midpoints[0], 49.95);
+
+        h.apply_patch({{"bins", 4}}, xeus::buffer_sequence());
+        const std::vector<double>& rebinned = h.y();
+        EXPECT_EQ(rebinned, std::vector<double>(4, 250.));
+
+        nl::json state;
+        xeus::buffer_sequence buffers;
+        h.serialize_state(state, buffers);
+        EXPECT_EQ(state.count("sample"), 0u);
+        EXPECT_EQ(state["y"]["values"].size(), 4u);
+        EXPECT_EQ(state["x"]["values"].size(), 4u);
+    }
+
+    TEST(xmarks, streaming_hist)
+    {
+        linear_scale sx, sy;
+        binned_hist h(sx, sy);
+        h.start_streaming(xstreaming_histogram(0., 10., 5));
+        EXPECT_TRUE(h.streaming());
+        EXPECT_EQ(h.bins(), 5);
+
+        std::vector<double> values = {1., 1.5, 9.};
+        h.add_samples(values);
+        const std::vector<double>& count = h.y();
+        EXPECT_EQ(count, std::vector<double>({2., 0., 0., 0., 1.}));
+        const std::vector<double>& sample = h.sample();
+        EXPECT_TRUE(sample.empty());
+
+        std::vector<double> more = {5.};
+        h.add_samples(more);
+        const std::vector<double>& updated = h.y();
+        EXPECT_EQ(updated, std::vector<double>({2., 0., 1., 0., 1.}));
+
+        h.stop_streaming();
+        EXPECT_THROW(h.add_samples(more), std::logic_error);
+
+        patch_probe_t<xbinned_hist> probe(sx, sy);
+        probe.start_streaming(xstreaming_histogram(0., 10., 5));
+        std::size_t count_before = probe.patches().size();
+        probe.add_samples(values);
+        ASSERT_EQ(probe.patches().size(), count_before + 1);
+        EXPECT_EQ(probe.patches().back().state["y"]["values"], nl::json({2., 0., 0., 0., 1.}));
+    }
+
+    TEST(xmarks, boxplot_summary)
+    {
+        linear_scale sx, sy;
+        boxplot b(sx, sy);
+        std::vector<std::vector<double>> boxes(2, std::vector<double>(1001));
+        for (std::size_t i = 0; i < 1001; ++i)
+        {
+            boxes[0][i] = static_cast<double>(i);
+            boxes[1][i] = static_cast<double>(1000 - i);
+        }
+        b.y = boxes;
+        b.server_summary = true;
+
+        nl::json state;
+        xeus::buffer_sequence buffers;
+        b.serialize_state(state, buffers);
+        const nl::json& y = state["y"]["values"];
+        ASSERT_EQ(y.size(), 2u);
+        EXPECT_EQ(y[0].size(), 5u);
+        EXPECT_EQ(y[0][2].get<double>(), 500.);
+        EXPECT_EQ(state["y"]["type"], state["x"]["type"]);
+    }
+
+    TEST(xmarks, boxplot_streaming)
+    {
+        linear_scale sx, sy;
+        boxplot b(sx, sy);
+        b.start_streaming(3);
+        std::vector<double> values = {1., 2., 3., 4., 5.};
+        b.add_samples(1, values);
+        EXPECT_EQ(b.sketches()[1].quantiles().count(), 5u);
+        std::vector<xbox_summary> summaries = b.summaries();
+        EXPECT_EQ(summaries[0].count, 0u);
+        EXPECT_EQ(summaries[1].median, 3.);
+
+        nl::json state;
+        xeus::buffer_sequence buffers;
+        b.serialize_state(state, buffers);
+        EXPECT_EQ(state["y"]["values"][1].size(), 5u);
+        EXPECT_THROW(b.add_samples(3, values), std::out_of_range);
+    }
+
+    TEST(xmarks, tiled_grid_heat_map)
+    {
+        linear_scale sx, sy;
+        color_scale sc;
+        std::vector<std::vector<double>> values(1000, std::vector<double>(1000));
+        for (std::size_t i = 0; i < values.size(); ++i)
+        {
+            for (std::size_t j = 0; j < values[i].size(); ++j)
+            {
+                values[i][j] = static_cast<double>(i + j);
+            }
+        }
+        grid_heat_map map(values, sx, sy, sc);
+        map.max_rows = 100;
+        map.max_columns = 100;
+
+        nl::json state;
+        xeus::buffer_sequence buffers;
+        map.serialize_state(state, buffers);
+        EXPECT_EQ(map.tile_level(), 4u);
+        EXPECT_EQ(state["color"]["values"].size(), 63u);
+        EXPECT_EQ(state["row"]["values"].size(), 63u);
+        EXPECT_EQ(state["color"]["values"][1][0].get<double>(), 23.5 + 7.5);
+
+        // Zooming on the first 200 x 200 cells sends finer tiles.
+        sx.apply_patch({{"min", 0.}, {"max", 199.}}, buffers);
+        sy.apply_patch({{"min", 0.}, {"max", 199.}}, buffers);
+        state = nl::json();
+        map.serialize_state(state, buffers);
+        EXPECT_EQ(map.tile_level(), 1u);
+        EXPECT_EQ(state["color"]["values"].size(), 160u);
+        EXPECT_EQ(state["column"]["values"][1].get<double>(), 2.);
+
+        EXPECT_EQ(map.color().rows(), 1000u);
+        // Tiles are sent again without changing the version of the data.
+        EXPECT_EQ(map.property_version("color"), 0u);
+
+        patch_probe_t<xgrid_heat_map> probe(values, sx, sy, sc);
+        probe.max_rows = 100;
+        std::size_t count = probe.patches().size();
+        default_data_encoding() = xdata_encoding::binary;
+        {
+            auto hold = probe.hold_sync();
+            probe.max_columns = 100;
+            probe.row = std::vector<double>(1000, 1.);
+        }
+        default_data_encoding() = xdata_encoding::json;
+        ASSERT_EQ(probe.patches().size(), count + 1);
+        EXPECT_EQ(probe.patches().back().buffer_count, 3u);
+    }
+
+    TEST(xmarks, heat_map_buffer_paths)
+    {
+        linear_scale sx, sy;
+        color_scale sc;
+        std::vector<std::vector<double>> values(2, std::vector<double>(3, 1.));
+        heat_map map(values, sx, sy, sc);
+        grid_heat_map grid(values, sx, sy, sc);
+
+        const xw::xjson_path_type color_path = {"color", "value"};
+        const auto& map_paths = map.buffer_paths();
+        const auto& grid_paths = grid.buffer_paths();
+        EXPECT_NE(std::find(map_paths.begin(), map_paths.end(), color_path), map_paths.end());
+        EXPECT_NE(std::find(grid_paths.begin(), grid_paths.end(), color_path), grid_paths.end());
+    }
+
+    TEST(xmarks, shared_map_document)
+    {
+        mercator sc1, sc2;
+        map map1(sc1);
+        map map2(sc2);
+        ASSERT_NE(map1.map_document(), nullptr);
+        EXPECT_EQ(map1.map_document(), map2.map_document());
+        EXPECT_TRUE(map1.map_data().is_null());
+
+        nl::json state;
+        xeus::buffer_sequence buffers;
+        map1.serialize_state(state, buffers);
+        EXPECT_EQ(state["map_data"], map1.map_document()->data());
+
+        default_data_encoding() = xdata_encoding::binary;
+        state = nl::json();
+        buffers.clear();
+        map2.serialize_state(state, buffers);
+        default_data_encoding() = xdata_encoding::json;
+        EXPECT_EQ(state["map_data"], map2.map_document()->data());
+        EXPECT_TRUE(buffers.empty());
+    }
+
+    TEST(xmarks, typed_arcs)
+    {
+        const std::string json_path = "test_xmarks_typed_arcs.json";
+        const std::string binary_path = binary_map_path(json_path);
+        nl::json topology = nl::json::parse(R"({
+            "type": "Topology",
+            "transform": {"scale": [1, 1], "translate": [0, 0]},
+            "objects": {"line": {"type": "LineString", "arcs": [0]}},
+            "arcs": [[[0, 0], [1, 2], [1, 2]]]
+        })");
+        {
+            std::ofstream out(json_path);
+            out << topology.dump();
+        }
+        convert_map_file(json_path, binary_path);
+
+        mercator sc;
+        map m(json_path, sc);
+        ASSERT_NE(m.map_document()->binary(), nullptr);
+        EXPECT_FALSE(m.typed_arcs());
+
+        nl::json state;
+        xeus::buffer_sequence buffers;
+        default_data_encoding() = xdata_encoding::binary;
+        m.serialize_state(state, buffers);
+        EXPECT_EQ(state["map_data"], topology);
+        EXPECT_TRUE(buffers.empty());
+
+        m.set_typed_arcs(true);
+        state = nl::json();
+        m.serialize_state(state, buffers);
+        default_data_encoding() = xdata_encoding::json;
+        EXPECT_EQ(buffers.size(), 2u);
+        EXPECT_EQ(state["map_data"]["arcs"]["encoding"], "delta");
+        EXPECT_EQ(m.buffer_paths().back(), xw::xjson_path_type({"map_data", "arcs", "offsets", "value"}));
+
+        std::remove(json_path.c_str());
+        std::remove(binary_path.c_str());
+    }
+
+    TEST(xmarks, map_filter)
+    {
+        mercator sc1, sc2;
+        map map1(sc1);
+        map map2(sc2);
+        xmap_filter filter;
+        filter.ids = {250, 276};
+        filter.simplification = 0.01;
+        map1.set_map_filter(filter);
+        map2.set_map_filter(filter);
+        EXPECT_EQ(map1.map_document(), map2.map_document());
+        EXPECT_EQ(map1.map_filter().key(), filter.key());
+
+        const nl::json& data = map1.map_document()->data();
+        EXPECT_EQ(data["objects"]["subunits"]["geometries"].size(), 2u);
+        EXPECT_LT(data["arcs"].size(), get_map_cache().load(topo_load("WorldMap.json"))->data()["arcs"].size());
+
+        nl::json state;
+        xeus::buffer_sequence buffers;
+        map1.serialize_state(state, buffers);
+        EXPECT_EQ(state["map_data"], data);
+    }
 }
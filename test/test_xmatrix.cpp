@@ -0,0 +1,77 @@
+/***************************************************************************
+* Copyright (c) 2016, Johan Mabille and Sylvain Corlay                     *
+*                                                                          *
+* Distributed under the terms of the BSD 3-Clause License.                 *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#include <memory>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "xplot/xmatrix.hpp"
+
+namespace xpl
+{
+    TEST(xmatrix, construction)
+    {
+        std::vector<std::vector<double>> rows = {{1., 2., 3.}, {4., 5., 6.}};
+        xmatrix<double> m(rows);
+        EXPECT_EQ(m.rows(), 2u);
+        EXPECT_EQ(m.columns(), 3u);
+        EXPECT_TRUE(m.is_contiguous());
+        EXPECT_FALSE(m.is_view());
+        EXPECT_EQ(m(1, 2), 6.);
+
+        std::vector<double> values = {1., 2., 3., 4.};
+        const double* data = values.data();
+        xmatrix<double> moved(std::move(values), 2, 2);
+        EXPECT_EQ(moved.data(), data);
+        EXPECT_THROW(xmatrix<double>(std::vector<double>(3), 2, 2), std::invalid_argument);
+        EXPECT_THROW(xmatrix<double>(std::vector<std::vector<double>>({{1.}, {1., 2.}})), std::invalid_argument);
+    }
+
+    TEST(xmatrix, view)
+    {
+        // Column-major 2 x 3 buffer.
+        auto buffer = std::make_shared<std::vector<double>>(std::vector<double>({1., 4., 2., 5., 3., 6.}));
+        xmatrix<double> v = xmatrix<double>::view(buffer->data(), 2, 3, {1, 2}, buffer);
+        EXPECT_TRUE(v.is_view());
+        EXPECT_FALSE(v.is_contiguous());
+        EXPECT_EQ(v(0, 2), 3.);
+        EXPECT_EQ(v(1, 0), 4.);
+
+        xmatrix<double> copy = v;
+        EXPECT_EQ(copy.data(), buffer->data());
+        copy.mutable_data()[0] = 10.;
+        EXPECT_FALSE(copy.is_view());
+        EXPECT_TRUE(copy.is_contiguous());
+        EXPECT_EQ(copy(0, 1), 2.);
+        EXPECT_EQ((*buffer)[0], 1.);
+    }
+
+    TEST(xmatrix, serialization)
+    {
+        xmatrix<double> m(std::vector<std::vector<double>>({{1., 2.}, {3., 4.}}));
+        nl::json j;
+        xeus::buffer_sequence buffers;
+        xwidgets_serialize(m, j, buffers);
+        EXPECT_EQ(j["values"][1][0].get<double>(), 3.);
+
+        default_data_encoding() = xdata_encoding::binary;
+        j = nl::json();
+        xwidgets_serialize(m, j, buffers);
+        default_data_encoding() = xdata_encoding::json;
+        ASSERT_EQ(buffers.size(), 1u);
+        EXPECT_EQ(buffers[0].size(), 4 * sizeof(double));
+        EXPECT_EQ(j["shape"], nl::json({2, 2}));
+        EXPECT_EQ(j["dtype"], "float64");
+
+        xmatrix<double> res;
+        xwidgets_deserialize(res, j, buffers);
+        EXPECT_EQ(res.rows(), 2u);
+        EXPECT_EQ(res(1, 1), 4.);
+    }
+}
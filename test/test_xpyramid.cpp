@@ -0,0 +1,158 @@
+/***************************************************************************
+* Copyright (c) 2016, Johan Mabille and Sylvain Corlay                     *
+*                                                                          *
+* Distributed under the terms of the BSD 3-Clause License.                 *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "xplot/xpyramid.hpp"
+
+namespace xpl
+{
+    namespace
+    {
+        std::vector<double> make_series(std::size_t size)
+        {
+            std::mt19937 gen(42);
+            std::normal_distribution<double> dist;
+            std::vector<double> res(size);
+            double value = 0.;
+            for (auto& v : res)
+            {
+                value += dist(gen);
+                v = value;
+            }
+            return res;
+        }
+    }
+
+    TEST(xpyramid, argminmax)
+    {
+        std::vector<double> values = make_series(100003);
+        xminmax_pyramid<double> pyramid(16);
+        pyramid.build(values.data(), values.size());
+        EXPECT_EQ(pyramid.size(), values.size());
+
+        std::mt19937 gen(0);
+        std::uniform_int_distribution<std::size_t> dist(0, values.size() - 1);
+        for (int i = 0; i < 200; ++i)
+        {
+            std::size_t a = dist(gen);
+            std::size_t b = dist(gen);
+            std::size_t first = (std::min)(a, b);
+            std::size_t last = (std::max)(a, b) + 1;
+            std::size_t imin, imax;
+            pyramid.argminmax(values.data(), first, last, imin, imax);
+            auto begin = values.begin();
+            EXPECT_EQ(values[imin], *std::min_element(begin + first, begin + last));
+            EXPECT_EQ(values[imax], *std::max_element(begin + first, begin + last));
+        }
+    }
+
+    TEST(xpyramid, update)
+    {
+        std::vector<double> values = make_series(50000);
+        xminmax_pyramid<double> incremental;
+        incremental.build(values.data(), 20001);
+        incremental.update(values.data(), 35000);
+        incremental.update(values.data(), values.size());
+
+        xminmax_pyramid<double> full;
+        full.build(values.data(), values.size());
+        EXPECT_EQ(incremental.levels(), full.levels());
+
+        std::vector<std::size_t> expected, indices;
+        full.m4_indices(values.data(), 0, values.size(), 500, expected);
+        incremental.m4_indices(values.data(), 0, values.size(), 500, indices);
+        EXPECT_EQ(indices, expected);
+    }
+
+    TEST(xpyramid, drop)
+    {
+        std::vector<double> values = make_series(60000);
+        xminmax_pyramid<double> sliding(16);
+        std::size_t first = 0;
+        std::size_t last = 10000;
+        sliding.build(values.data(), last);
+        for (std::size_t dropped : {1, 15, 16, 999, 4000, 33})
+        {
+            first += dropped;
+            last += 2 * dropped + 7;
+            sliding.update(values.data() + first, last - first, dropped);
+            EXPECT_EQ(sliding.size(), last - first);
+
+            const double* window = values.data() + first;
+            xminmax_pyramid<double> full(16);
+            full.build(window, last - first);
+            std::vector<std::size_t> expected, indices;
+            full.m4_indices(window, 0, last - first, 300, expected);
+            sliding.m4_indices(window, 0, last - first, 300, indices);
+            EXPECT_EQ(indices, expected);
+
+            std::size_t imin, imax;
+            sliding.argminmax(window, 3, last - first - 5, imin, imax);
+            EXPECT_EQ(window[imin], *std::min_element(window + 3, window + last - first - 5));
+            EXPECT_EQ(window[imax], *std::max_element(window + 3, window + last - first - 5));
+        }
+        EXPECT_LT(sliding.memory_usage(), 2 * 2 * 25000 / 16 * 4 * sizeof(double));
+    }
+
+    TEST(xpyramid, minmax_indices)
+    {
+        std::vector<double> values = make_series(100000);
+        xminmax_pyramid<double> pyramid;
+        pyramid.build(values.data(), values.size());
+
+        std::vector<std::size_t> expected, indices;
+        xpl::minmax_indices(values.data(), values.size(), 1000, expected);
+        pyramid.minmax_indices(values.data(), 0, values.size(), 500, indices);
+        EXPECT_EQ(indices, expected);
+
+        // Two nodes of 32 bytes at most per block of 64 doubles.
+        EXPECT_LE(pyramid.memory_usage(), values.size() * sizeof(double) / 4);
+    }
+
+    TEST(xpyramid, matrix_pyramid)
+    {
+        std::vector<std::vector<double>> values(5, std::vector<double>(3));
+        for (std::size_t i = 0; i < 5; ++i)
+        {
+            for (std::size_t j = 0; j < 3; ++j)
+            {
+                values[i][j] = static_cast<double>(i * 3 + j);
+            }
+        }
+        values[0][0] = std::nan("");
+        auto value = [&values](std::size_t i, std::size_t j) { return values[i][j]; };
+
+        xmatrix_pyramid mean(xpooling_method::mean);
+        mean.build(5, 3, value);
+        ASSERT_EQ(mean.levels(), 4u);
+        EXPECT_EQ(mean.rows(1), 3u);
+        EXPECT_EQ(mean.columns(1), 2u);
+        xmatrix<double> cells;
+        mean.extract(1, 0, 3, 0, 2, value, cells);
+        EXPECT_EQ(cells.rows(), 3u);
+        EXPECT_DOUBLE_EQ(cells(0, 0), 8. / 3.);
+        EXPECT_DOUBLE_EQ(cells(0, 1), 3.5);
+        EXPECT_DOUBLE_EQ(cells(2, 1), 14.);
+
+        xmatrix_pyramid max(xpooling_method::max);
+        max.build(5, 3, value);
+        max.extract(max.levels() - 1, 0, 1, 0, 1, value, cells);
+        EXPECT_EQ(cells(0, 0), 14.);
+
+        EXPECT_EQ(max.level_for(5, 3, 0, 0), 0u);
+        EXPECT_EQ(max.level_for(5, 3, 3, 0), 1u);
+        EXPECT_EQ(max.level_for(5, 3, 1, 1), 3u);
+    }
+}
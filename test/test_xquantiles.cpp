@@ -0,0 +1,119 @@
+/***************************************************************************
+* Copyright (c) 2016, Johan Mabille and Sylvain Corlay                     *
+*                                                                          *
+* Distributed under the terms of the BSD 3-Clause License.                 *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "xplot/xquantiles.hpp"
+
+namespace xpl
+{
+    namespace
+    {
+        double sorted_quantile(const std::vector<double>& sorted, double p)
+        {
+            double h = p * static_cast<double>(sorted.size() - 1);
+            std::size_t k = static_cast<std::size_t>(h);
+            double next = k + 1 < sorted.size() ? sorted[k + 1] : sorted[k];
+            return sorted[k] + (h - std::floor(h)) * (next - sorted[k]);
+        }
+    }
+
+    TEST(xquantiles, box_summary)
+    {
+        for (std::size_t n = 1; n < 40; ++n)
+        {
+            std::vector<double> values(n);
+            for (std::size_t i = 0; i < n; ++i)
+            {
+                values[i] = static_cast<double>((i * 7919) % 31);
+            }
+            xbox_summary summary = box_summary(values.data(), values.size(), 100);
+            std::sort(values.begin(), values.end());
+            EXPECT_EQ(summary.count, n);
+            EXPECT_DOUBLE_EQ(summary.q1, sorted_quantile(values, 0.25));
+            EXPECT_DOUBLE_EQ(summary.median, sorted_quantile(values, 0.5));
+            EXPECT_DOUBLE_EQ(summary.q3, sorted_quantile(values, 0.75));
+        }
+    }
+
+    TEST(xquantiles, outliers)
+    {
+        std::vector<double> values = {-100., -50., 1., 2., 3., 4., 5., 6., 7., 8., 1000., std::nan("")};
+        xbox_summary summary = box_summary(values.data(), values.size(), 2);
+        EXPECT_EQ(summary.count, 11u);
+        EXPECT_EQ(summary.outlier_count, 3u);
+        EXPECT_EQ(summary.outliers, std::vector<double>({-100., 1000.}));
+        EXPECT_EQ(summary.lower_whisker, 1.);
+        EXPECT_EQ(summary.upper_whisker, 8.);
+    }
+
+    TEST(xquantiles, box_sample)
+    {
+        xbox_summary summary;
+        summary.count = 1000;
+        summary.lower_whisker = 1.;
+        summary.q1 = 2.;
+        summary.median = 3.5;
+        summary.q3 = 4.;
+        summary.upper_whisker = 6.;
+        summary.outliers = {-10., -9., 20.};
+        std::vector<double> sample = box_sample(summary);
+        ASSERT_EQ(sample.size(), 13u);
+        EXPECT_TRUE(std::is_sorted(sample.begin(), sample.end()));
+        EXPECT_EQ(sorted_quantile(sample, 0.25), 2.);
+        EXPECT_EQ(sorted_quantile(sample, 0.5), 3.5);
+        EXPECT_EQ(sorted_quantile(sample, 0.75), 4.);
+        EXPECT_EQ(sample.front(), -10.);
+        EXPECT_EQ(sample.back(), 20.);
+    }
+
+    TEST(xquantiles, kll_sketch)
+    {
+        xkll_sketch sketch(200);
+        xkll_sketch other(200);
+        std::size_t n = 200000;
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            double value = static_cast<double>((i * 7919) % n);
+            (i % 2 == 0 ? sketch : other).update(value);
+        }
+        sketch.merge(other);
+        EXPECT_EQ(sketch.count(), n);
+        EXPECT_LT(sketch.retained(), 1000u);
+        EXPECT_EQ(sketch.min(), 0.);
+        EXPECT_EQ(sketch.max(), static_cast<double>(n - 1));
+        for (double p : {0.1, 0.25, 0.5, 0.75, 0.9})
+        {
+            EXPECT_NEAR(sketch.quantile(p) / static_cast<double>(n), p, 0.02);
+        }
+    }
+
+    TEST(xquantiles, box_sketch)
+    {
+        xbox_sketch sketch(200, 2);
+        std::vector<double> values(10000);
+        for (std::size_t i = 0; i < values.size(); ++i)
+        {
+            values[i] = static_cast<double>(i % 100);
+        }
+        values[0] = -1000.;
+        values[1] = -2000.;
+        values[2] = -3000.;
+        sketch.update(values.data(), values.size());
+        xbox_summary summary = sketch.summary();
+        EXPECT_EQ(summary.count, values.size());
+        EXPECT_NEAR(summary.median, 50., 3.);
+        EXPECT_EQ(summary.outliers, std::vector<double>({-3000., -2000.}));
+        EXPECT_EQ(summary.upper_whisker, 99.);
+    }
+}
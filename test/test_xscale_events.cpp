@@ -0,0 +1,162 @@
+/***************************************************************************
+* Copyright (c) 2017, Sylvain Corlay and Johan Mabille                     *
+*                                                                          *
+* Distributed under the terms of the BSD 3-Clause License.                 *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "xplot/xmarks.hpp"
+#include "xplot/xscale_events.hpp"
+#include "xplot/xscales.hpp"
+
+#include "patch_probe.hpp"
+
+namespace xpl
+{
+    using bound_type = xscale_event_hub::domain_bound_type;
+
+    TEST(xscale_events, hold)
+    {
+        xscale_event_hub& hub = get_scale_event_hub();
+        xdomain_subscription subscription;
+        std::vector<double> received;
+        subscription.subscribe("scale", [&received](const bound_type& min, const bound_type&) {
+            received.push_back(min.value());
+        });
+
+        {
+            auto hold = hub.hold();
+            EXPECT_TRUE(hub.held());
+            hub.publish("scale", 1., 2.);
+            hub.publish("scale", 3., 4.);
+            EXPECT_TRUE(received.empty());
+        }
+        EXPECT_FALSE(hub.held());
+        EXPECT_EQ(received, std::vector<double>({3.}));
+
+        // Flushing dispatches the queued events, e.g. from a timer.
+        auto hold = hub.hold();
+        hub.publish("scale", 5., 6.);
+        hub.flush();
+        hub.flush();
+        EXPECT_EQ(received, std::vector<double>({3., 5.}));
+    }
+
+    TEST(xscale_events, patch)
+    {
+        linear_scale sc;
+        xdomain_subscription subscription;
+        std::vector<double> received;
+        subscription.subscribe(sc.id(), [&received](const bound_type& min, const bound_type& max) {
+            received.push_back(min.value());
+            received.push_back(max.value());
+        });
+
+        // The bounds set by a patch are dispatched once it is applied.
+        xeus::buffer_sequence buffers;
+        sc.apply_patch({{"min", 1.}, {"max", 2.}}, buffers);
+        EXPECT_EQ(received, std::vector<double>({1., 2.}));
+
+        // Within a held hub, the patch is dispatched with the other events.
+        {
+            auto hold = get_scale_event_hub().hold();
+            sc.apply_patch({{"min", 3.}, {"max", 4.}}, buffers);
+            sc.apply_patch({{"min", 5.}, {"max", 6.}}, buffers);
+            EXPECT_EQ(received.size(), 2u);
+        }
+        EXPECT_EQ(received, std::vector<double>({1., 2., 5., 6.}));
+    }
+
+    TEST(xscale_events, deferred_sync)
+    {
+        xscale_event_hub& hub = get_scale_event_hub();
+        std::vector<std::string> log;
+        xdomain_subscription row, column, other;
+        auto handler = [&log](const std::string& name) {
+            return [&log, name](const bound_type&, const bound_type&) { log.push_back(name); };
+        };
+        auto hook = [&log](const std::string& name) {
+            return [&log, name]() { log.push_back(name); };
+        };
+        row.subscribe("row", handler("row"), hook("defer row"), hook("resume row"));
+        column.subscribe("column", handler("column"), hook("defer column"), hook("resume column"));
+        other.subscribe("row", handler("other"), hook("defer other"), hook("resume other"));
+
+        {
+            auto hold = hub.hold();
+            hub.publish("row", 0., 1.);
+            hub.publish("column", 0., 1.);
+        }
+        // All the subscribers are deferred before the handlers run, and
+        // resumed once they all ran.
+        ASSERT_EQ(log.size(), 9u);
+        for (std::size_t i = 0; i < 3; ++i)
+        {
+            EXPECT_EQ(log[i].substr(0, 5), "defer");
+            EXPECT_EQ(log[i + 6].substr(0, 6), "resume");
+        }
+        EXPECT_EQ(log[5], "column");
+
+        // A subscriber removed during the dispatch is not resumed.
+        log.clear();
+        other.subscribe("row", [](const bound_type&, const bound_type&) {}, hook("defer other"), hook("resume other"));
+        row.subscribe("row", [&other](const bound_type&, const bound_type&) { other.reset(); },
+                      hook("defer row"), hook("resume row"));
+        hub.publish("row", 0., 2.);
+        ASSERT_EQ(log.size(), 3u);
+        EXPECT_EQ(log.back(), "resume row");
+    }
+
+    TEST(xscale_events, shared_scale)
+    {
+        linear_scale sx, sy;
+        std::vector<double> xs(10000), ys(10000);
+        for (std::size_t i = 0; i < xs.size(); ++i)
+        {
+            xs[i] = static_cast<double>(i);
+            ys[i] = static_cast<double>(i % 7);
+        }
+        std::vector<patch_probe_t<xlines>> marks;
+        marks.reserve(4);
+        for (std::size_t i = 0; i < 4; ++i)
+        {
+            marks.emplace_back(sx, sy);
+            auto& line = marks.back();
+            line.x = xs;
+            line.y = ys;
+            line.max_points = 50;
+            nl::json state;
+            xeus::buffer_sequence buffers;
+            line.serialize_state(state, buffers);
+        }
+
+        xeus::buffer_sequence buffers;
+        std::vector<std::size_t> counts;
+        std::vector<xsync_state::version_type> versions;
+        for (const auto& line : marks)
+        {
+            counts.push_back(line.patches().size());
+            versions.push_back(line.property_version("x"));
+        }
+        {
+            auto hold = get_scale_event_hub().hold();
+            sx.apply_patch({{"min", 1000.}, {"max", 2000.}}, buffers);
+            sx.apply_patch({{"min", 5000.}, {"max", 6000.}}, buffers);
+        }
+        for (std::size_t i = 0; i < marks.size(); ++i)
+        {
+            // Each mark is sent once, for the last domain, without
+            // changing the version of its data.
+            ASSERT_EQ(marks[i].patches().size(), counts[i] + 1);
+            EXPECT_EQ(marks[i].property_version("x"), versions[i]);
+            EXPECT_FALSE(marks[i].has_changed_state());
+            EXPECT_GE(marks[i].patches().back().state["x"]["values"].back().get<double>(), 6000.);
+        }
+    }
+}
@@ -0,0 +1,118 @@
+/***************************************************************************
+* Copyright (c) 2016, Johan Mabille and Sylvain Corlay                     *
+*                                                                          *
+* Distributed under the terms of the BSD 3-Clause License.                 *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "xplot/xscales.hpp"
+
+namespace xpl
+{
+    TEST(xscale_transform, linear)
+    {
+        xlinear_transform t(0., 10., 100., 300.);
+        EXPECT_DOUBLE_EQ(t(5.), 200.);
+        EXPECT_DOUBLE_EQ(t.invert(250.), 7.5);
+
+        std::vector<int> values = {0, 10, -10};
+        EXPECT_EQ(t.transform(values), std::vector<double>({100., 300., -100.}));
+        EXPECT_EQ(t.invert(std::vector<double>({100., 300.})), std::vector<double>({0., 10.}));
+
+        xlinear_transform degenerate(1., 1., 0., 100.);
+        EXPECT_DOUBLE_EQ(degenerate(3.), 50.);
+    }
+
+    TEST(xscale_transform, log)
+    {
+        xlog_transform t(1., 1000., 0., 300.);
+        EXPECT_DOUBLE_EQ(t(100.), 200.);
+        EXPECT_NEAR(t.invert(100.), 10., 1e-12);
+        std::vector<double> res = t.transform(std::vector<double>({10., 0., -1.}));
+        EXPECT_DOUBLE_EQ(res[0], 100.);
+        EXPECT_TRUE(std::isnan(res[1]));
+        EXPECT_TRUE(std::isnan(res[2]));
+        EXPECT_THROW(xlog_transform(0., 10., 0., 1.), std::invalid_argument);
+    }
+
+    TEST(xscale_transform, ordinal)
+    {
+        xordinal_transform t({3., 1., 2., 1.}, 0., 400.);
+        EXPECT_DOUBLE_EQ(t.bandwidth(), 100.);
+        EXPECT_EQ(t.index(1.), 1u);
+        EXPECT_EQ(t.index(5.), 4u);
+        EXPECT_DOUBLE_EQ(t(2.), 250.);
+        EXPECT_TRUE(std::isnan(t(5.)));
+        EXPECT_EQ(t.invert(120.), 1.);
+        EXPECT_TRUE(std::isnan(t.invert(401.)));
+        EXPECT_TRUE(std::isnan(t.invert(-1.)));
+
+        std::vector<double> res = t.transform(std::vector<float>({3.f, 1.f}));
+        EXPECT_EQ(res, std::vector<double>({50., 150.}));
+    }
+
+    TEST(xscale_transform, colors)
+    {
+        EXPECT_EQ(parse_color("#ff8000"), 0xffff8000u);
+        EXPECT_EQ(parse_color("#F80"), 0xffff8800u);
+        EXPECT_EQ(format_color(0xff0a0b0cu), "#0a0b0c");
+        EXPECT_THROW(parse_color("red"), std::invalid_argument);
+        EXPECT_THROW(parse_color("#ggg"), std::invalid_argument);
+
+        xcolor_transform t({"#000000", "#ffffff"}, 0., 10.);
+        EXPECT_EQ(t(5.), "#808080");
+        EXPECT_EQ(t(-5.), "#000000");
+        EXPECT_EQ(t(20.), "#ffffff");
+        EXPECT_EQ(t(std::nan("")), "none");
+        EXPECT_EQ(t.packed(std::nan("")), 0u);
+
+        xcolor_transform diverging({"#ff0000", "#ffffff", "#0000ff"}, 0., 1., 10.);
+        EXPECT_EQ(diverging(1.), "#ffffff");
+        EXPECT_EQ(diverging(0.5), "#ff8080");
+        EXPECT_EQ(diverging(5.5), "#8080ff");
+
+        std::vector<std::uint32_t> packed(2);
+        std::vector<double> values = {0., 10.};
+        t.transform(values.data(), values.size(), packed.data());
+        EXPECT_EQ(packed, std::vector<std::uint32_t>({0xff000000u, 0xffffffffu}));
+    }
+
+    TEST(xscale_transform, scales)
+    {
+        linear_scale ls;
+        EXPECT_THROW(ls.make_transform(0., 100.), std::logic_error);
+        ls.min = 0.;
+        ls.max = 10.;
+        EXPECT_DOUBLE_EQ(ls.make_transform(0., 100.)(2.), 20.);
+        ls.reverse = true;
+        EXPECT_DOUBLE_EQ(ls.make_transform(0., 100.)(2.), 80.);
+
+        log_scale lg;
+        lg.min = 1.;
+        lg.max = 100.;
+        EXPECT_DOUBLE_EQ(lg.make_transform(0., 100.)(10.), 50.);
+
+        ordinal_scale os;
+        os.domain = std::vector<double>({1., 2.});
+        EXPECT_DOUBLE_EQ(os.make_transform(0., 100.)(2.), 75.);
+
+        color_scale cs;
+        cs.min = 0.;
+        cs.max = 1.;
+        EXPECT_EQ(cs.make_transform()(0.), "#a50026");
+        cs.scheme = "Unknown";
+        EXPECT_THROW(cs.make_transform(), std::invalid_argument);
+        cs.colors = std::vector<color_type>({"#000000", "#ffffff"});
+        EXPECT_EQ(cs.make_transform()(1.), "#ffffff");
+        cs.reverse = true;
+        EXPECT_EQ(cs.make_transform()(1.), "#000000");
+    }
+}
@@ -0,0 +1,175 @@
+/***************************************************************************
+* Copyright (c) 2016, Johan Mabille and Sylvain Corlay                     *
+*                                                                          *
+* Distributed under the terms of the BSD 3-Clause License.                 *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#include <stdexcept>
+
+#include "gtest/gtest.h"
+
+#include "xplot/xfigure.hpp"
+#include "xplot/xmarks.hpp"
+#include "xplot/xsync.hpp"
+
+#include "patch_probe.hpp"
+
+namespace xpl
+{
+    template <class D>
+    class xfailing_lines : public xlines<D>
+    {
+    public:
+
+        using base_type = xlines<D>;
+
+        void send_patch(nl::json&& state, xeus::buffer_sequence&& buffers) const
+        {
+            if (fail)
+            {
+                throw std::runtime_error("send_patch");
+            }
+            base_type::send_patch(std::move(state), std::move(buffers));
+        }
+
+        bool fail = false;
+
+    protected:
+
+        using base_type::base_type;
+    };
+
+    using failing_lines = xw::xmaterialize<xfailing_lines>;
+
+    TEST(xsync, sync_state)
+    {
+        xsync_state s;
+        int calls = 0;
+        auto serializer = [&calls](nl::json& state, xeus::buffer_sequence&) {
+            ++calls;
+            state["p"] = calls;
+        };
+
+        s.defer();
+        s.touch("p", serializer);
+        s.touch("p", serializer);
+        EXPECT_TRUE(s.is_dirty("p"));
+        EXPECT_TRUE(s.has_changes());
+        EXPECT_EQ(s.property_version("p"), 2u);
+
+        nl::json state;
+        xeus::buffer_sequence buffers;
+        s.serialize_changes(state, buffers);
+        EXPECT_EQ(calls, 1);
+        EXPECT_TRUE(s.resume());
+
+        s.mark_synced();
+        EXPECT_FALSE(s.is_dirty("p"));
+        EXPECT_FALSE(s.has_changes());
+    }
+
+    TEST(xsync, refresh)
+    {
+        xsync_state s;
+        auto serializer = [](nl::json& state, xeus::buffer_sequence&) { state["p"] = 1; };
+        s.touch("p", serializer);
+        s.mark_synced();
+
+        // A refreshed property is sent again with the same version.
+        s.refresh("p", serializer);
+        EXPECT_TRUE(s.is_dirty("p"));
+        EXPECT_TRUE(s.has_changes());
+        EXPECT_EQ(s.property_version("p"), 1u);
+        s.mark_synced("p");
+        EXPECT_FALSE(s.is_dirty("p"));
+        EXPECT_FALSE(s.has_changes());
+    }
+
+    TEST(xsync, property_version)
+    {
+        linear_scale sx, sy;
+        lines line(sx, sy);
+        EXPECT_EQ(line.property_version("x"), 0u);
+        line.x = std::vector<double>({1., 2.});
+        line.y = std::vector<double>({1., 2.});
+        line.x = std::vector<double>({1., 2., 3.});
+        EXPECT_GT(line.property_version("x"), line.property_version("y"));
+        EXPECT_FALSE(line.has_changed_state());
+    }
+
+    TEST(xsync, hold_sync)
+    {
+        linear_scale sx, sy;
+        patch_probe_t<xlines> line(sx, sy);
+        {
+            auto hold = line.hold_sync();
+            line.x = std::vector<double>({1., 2.});
+            line.y = std::vector<double>({1., 2.});
+            {
+                auto nested = line.hold_sync();
+                line.x = std::vector<double>({1., 2., 3.});
+            }
+            EXPECT_TRUE(line.has_changed_state());
+            EXPECT_TRUE(line.patches().empty());
+        }
+        EXPECT_FALSE(line.has_changed_state());
+        ASSERT_EQ(line.patches().size(), 1u);
+        EXPECT_EQ(line.patches()[0].state["x"]["values"].size(), 3u);
+        EXPECT_EQ(line.patches()[0].state["y"]["values"].size(), 2u);
+
+        figure fig;
+        {
+            auto hold = fig.hold_sync();
+            fig.add_mark(line);
+            fig.title = "held";
+            EXPECT_TRUE(fig.has_changed_state());
+        }
+        EXPECT_FALSE(fig.has_changed_state());
+        EXPECT_EQ(fig.marks().size(), 1u);
+    }
+
+    TEST(xsync, send_changed_state)
+    {
+        linear_scale sx, sy;
+        patch_probe_t<xlines> line(sx, sy);
+        {
+            auto hold = line.hold_sync();
+            line.x = std::vector<double>({1., 2.});
+            line.send_changed_state();
+            EXPECT_EQ(line.patches().size(), 1u);
+
+            // Sending the changes does not end the hold.
+            line.y = std::vector<double>({1., 2.});
+            line.stroke_width = 3.;
+            EXPECT_TRUE(line.has_changed_state());
+            EXPECT_EQ(line.patches().size(), 1u);
+        }
+        ASSERT_EQ(line.patches().size(), 2u);
+        EXPECT_EQ(line.patches()[1].state.size(), 2u);
+        EXPECT_EQ(line.patches()[1].state["stroke_width"], 3.);
+    }
+
+    TEST(xsync, hold_sync_errors)
+    {
+        linear_scale sx, sy;
+        failing_lines line(sx, sy);
+        line.fail = true;
+        {
+            auto hold = line.hold_sync();
+            line.x = std::vector<double>({1., 2.});
+            EXPECT_THROW(hold.release(), std::runtime_error);
+            // The released guard no longer defers the synchronization.
+            hold.release();
+        }
+        EXPECT_NO_THROW({
+            auto hold = line.hold_sync();
+            line.y = std::vector<double>({1., 2.});
+        });
+
+        line.fail = false;
+        line.stroke_width = 3.;
+        EXPECT_FALSE(line.has_changed_state());
+    }
+}
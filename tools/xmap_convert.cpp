@@ -0,0 +1,70 @@
+/***************************************************************************
+* Copyright (c) 2017, Sylvain Corlay and Johan Mabille                     *
+*                                                                          *
+* Distributed under the terms of the BSD 3-Clause License.                 *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+// Converts TopoJSON map files to the binary map format.
+//
+// usage: xmap_convert input.json [output.xmap] [--quantization n]
+//
+// The output defaults to the input path with the .xmap extension, which
+// is where xmap looks for the binary version of a map file.
+
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+#include "xplot/xmap_binary.hpp"
+
+int main(int argc, char* argv[])
+{
+    std::string input;
+    std::string output;
+    xpl::xbinary_map_options options;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--quantization" && i + 1 < argc)
+        {
+            options.quantization = std::stoul(argv[++i]);
+        }
+        else if (input.empty())
+        {
+            input = arg;
+        }
+        else if (output.empty())
+        {
+            output = arg;
+        }
+        else
+        {
+            input.clear();
+            break;
+        }
+    }
+
+    if (input.empty())
+    {
+        std::cerr << "usage: xmap_convert input.json [output.xmap] [--quantization n]" << std::endl;
+        return EXIT_FAILURE;
+    }
+    if (output.empty())
+    {
+        output = xpl::binary_map_path(input);
+    }
+
+    try
+    {
+        xpl::convert_map_file(input, output, options);
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "xmap_convert: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}